@@ -0,0 +1,110 @@
+/**
+ * @file ActivityMonitor.h
+ * @brief Integer activity features over the IMU FIFO sample stream
+ *
+ * Per sample (raw int16 from IMU FIFO mode, no floats, no sqrt):
+ *
+ *   1. accel → mg; gravity tracked per axis by a slow IIR low-pass and
+ *      subtracted (high-pass), leaving the dynamic acceleration d.
+ *   2. |d|² against a squared threshold decides "moving" for the sample.
+ *   3. Orientation-free magnitude deviation m = (|a|² − 1 g²) / 2 g, which
+ *      is |a| − 1 g to first order — the signal step counting runs on.
+ *   4. Step detector: m smoothed, hysteresis between ±ACTIVITY_STEP_*_MG
+ *      and a minimum step interval.
+ *
+ * Samples are summed in blocks of `blockSamples`; the last ACTIVITY_BLOCKS
+ * blocks form a sliding window (2 s at 200 Hz by default).  Each completed
+ * block yields one ActivityFeatures from the whole window — the stream is
+ * downsampled by the block length — with mean/std of m, RMS of d and of the
+ * gyro rate, steps and a 0–100 activity level.  The only square roots are
+ * the three FixedMath::isqrt per block.
+ */
+
+#ifndef ACTIVITY_MONITOR_H
+#define ACTIVITY_MONITOR_H
+
+#include <Arduino.h>
+#include "IMU.h"
+
+#define ACTIVITY_BLOCKS           8      // blocks per sliding window
+#define ACTIVITY_GRAVITY_SHIFT    8      // gravity IIR: 1/256 per sample (~1.3 s at 200 Hz)
+#define ACTIVITY_SMOOTH_SHIFT     3      // step signal IIR: 1/8 per sample
+#define ACTIVITY_MOTION_MG        60     // |d| above this counts as moving
+#define ACTIVITY_MOVING_PERCENT   10     // of window samples, to report moving
+#define ACTIVITY_STEP_HIGH_MG     90
+#define ACTIVITY_STEP_LOW_MG      (-40)
+#define ACTIVITY_STEP_MIN_MS      250    // at most 4 steps/s
+#define ACTIVITY_LEVEL_FULL_MG    500    // RMS of d that reads as level 100
+
+/** Window features, emitted once per block. */
+struct ActivityFeatures {
+    uint32_t timestampMs;     // end of the window
+    uint16_t windowMs;
+    uint16_t samples;
+    int16_t  meanMg;          // mean of m (≈ 0 at rest in any orientation)
+    uint16_t stdMg;           // standard deviation of m
+    uint16_t accelRmsMg;      // RMS of gravity-free acceleration
+    uint16_t gyroRmsDpsX10;   // RMS angular rate, 0.1 °/s
+    uint16_t steps;           // steps inside the window
+    uint8_t  level;           // 0–100
+    bool     moving;
+};
+
+class ActivityMonitor {
+public:
+    /** @param blockSamples  samples per block (output rate = sample rate / this) */
+    explicit ActivityMonitor(uint16_t blockSamples = IMU_FIFO_RATE_HZ / 4);
+
+    /** Restart: forget gravity, window and step state (totals are kept). */
+    void reset();
+
+    /**
+     * Feed one sample.
+     * @return true if a block completed and `out` holds fresh features
+     */
+    bool add(const ImuSample& s, ActivityFeatures& out);
+
+    /** The last features emitted. */
+    const ActivityFeatures& getFeatures() const { return last; }
+
+    /** Current sample: dynamic acceleration above the motion threshold. */
+    bool isMovingNow() const { return movingNow; }
+
+    uint32_t getTotalSteps() const  { return totalSteps; }
+    uint32_t getSampleCount() const { return sampleCount; }
+    /** Cycle cost of the last add() that completed a block, and of a plain one. */
+    uint32_t getLastBlockCycles() const  { return blockCycles; }
+    uint32_t getLastSampleCycles() const { return sampleCycles; }
+
+private:
+    struct Block {
+        int32_t  sumM;
+        int64_t  sumM2;
+        uint64_t sumD2;     // Σ|d|²  (mg²)
+        uint64_t sumW2;     // Σ|ω|²  (raw LSB²)
+        uint16_t n;
+        uint16_t moving;    // samples above the motion threshold
+        uint16_t steps;
+        uint32_t startUs;
+    };
+
+    uint16_t blockSamples;
+    Block    blocks[ACTIVITY_BLOCKS];
+    uint8_t  current;         // block being filled
+    uint8_t  filled;          // completed blocks in the window
+    int32_t  gravityQ8[3];    // mg × 256
+    bool     gravityValid;
+    int32_t  smoothM;
+    bool     stepArmed;       // went below the low threshold since the last step
+    uint32_t lastStepUs;
+    bool     movingNow;
+    uint32_t totalSteps;
+    uint32_t sampleCount;
+    uint32_t blockCycles;
+    uint32_t sampleCycles;
+    ActivityFeatures last;
+
+    void finishWindow(uint32_t endUs, ActivityFeatures& out);
+};
+
+#endif // ACTIVITY_MONITOR_H
@@ -4,6 +4,12 @@
  * 
  * This module provides Bluetooth Low Energy interface for configuring
  * beacon settings via mobile app.
+ *
+ * Characteristics and command codes are in BLEProtocol.h.
+ * CONFIG holds the DeviceConfig wire record (see DeviceConfig.h): read it,
+ * change fields, write it back.  The record is validated and applied at
+ * once, and the outcome and apply times are notified on STATUS as text.
+ * COMMAND takes [u8 BLE_COMMAND_VERSION][u8 BLECommand].
  */
 
 #ifndef BLE_CONFIG_H
@@ -11,20 +17,12 @@
 
 #include <Arduino.h>
 #include <NimBLEDevice.h>
+#include "BLEProtocol.h"
+#include "BLEStream.h"
+#include "DeviceConfig.h"
 
-// BLE Service and Characteristic UUIDs
-#define SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
-#define CONFIG_UUID         "beb5483e-36e1-4688-b7f5-ea07361b26a8"
-#define STATUS_UUID         "1c95d5e3-d8f7-413a-bf3d-7a2e5d7be87e"
-#define COMMAND_UUID        "d8de624e-140f-4a22-8594-e2216b84a5f2"
-
-struct BLEConfigData {
-    uint16_t loraFrequency;
-    uint8_t loraPower;
-    uint16_t gpsInterval;
-    uint16_t telemetryInterval;
-    char deviceName[32];
-};
+// msys mbufs left free for ATT responses and STATUS while streaming
+#define BLE_STREAM_MBUF_RESERVE 4
 
 class BLEConfig {
 public:
@@ -52,16 +50,22 @@ public:
     bool isConnected();
 
     /**
-     * @brief Get configuration data
-     * @return BLEConfigData structure
+     * @brief Settings read and written through CONFIG
+     * @param deviceConfig Applies, persists and reports changes
+     */
+    void setDeviceConfig(DeviceConfig* deviceConfig);
+
+    /**
+     * @brief Get the settings in force
+     * @return DeviceSettings structure (build defaults without a DeviceConfig)
      */
-    BLEConfigData getConfig();
+    DeviceSettings getConfig();
 
     /**
-     * @brief Set configuration data
-     * @param config BLEConfigData structure to set
+     * @brief Apply new settings as if written to CONFIG
+     * @param config DeviceSettings structure to apply
      */
-    void setConfig(const BLEConfigData& config);
+    void setConfig(const DeviceSettings& config);
 
     /**
      * @brief Send status update to connected client
@@ -79,17 +83,64 @@ public:
      */
     void stopAdvertising();
 
+    /**
+     * @brief Tables streamed on STREAM_UUID (see BLEStream.h); a dump
+     *        starts whenever a client subscribes to it
+     */
+    void setStreamSources(const PeerTable* peers, const TrackLog* track);
+
+    /**
+     * @brief Queue a dump of the neighbour table and track backlog now
+     */
+    void startDump();
+
+    const BLEStream& getStream() const { return stream; }
+
 private:
     BLEServer* pServer;
     BLEService* pService;
     BLECharacteristic* pConfigCharacteristic;
     BLECharacteristic* pStatusCharacteristic;
     BLECharacteristic* pCommandCharacteristic;
-    BLEConfigData config;
+    BLECharacteristic* pStreamCharacteristic;
+    DeviceConfig* deviceConfig;
     bool initialized;
     bool clientConnected;
 
+    // Streaming.  Connection, MTU, subscribe and write callbacks run on
+    // the NimBLE host task; onStatus() runs inside notify() on the loop.
+    // Either way they only post events here and update() applies them, so
+    // the stream and the tables it reads are only touched from the loop.
+    // Credits come back when the msys pool recovers (reclaimCredits()),
+    // not when notify() returns.
+    BLEStream stream;
+    const PeerTable* peerSource;
+    const TrackLog* trackSource;
+    volatile bool connectionChanged;
+    volatile bool dumpRequested;
+    volatile bool notifyRefused;
+    volatile uint16_t negotiatedMtu;
+    uint8_t notifiesPending;             // handed to the host, credit not returned
+    int mbufBaseline;                    // free msys mbufs before the first of them
+    bool dumpReported;
+
+    // CONFIG / COMMAND writes, posted by the host task like the above
+    uint8_t pendingConfig[CONFIG_WIRE_LEN + 1];
+    uint8_t pendingConfigLen;
+    volatile bool configWritten;
+    uint8_t pendingCommand[2];
+    uint8_t pendingCommandLen;
+    volatile bool commandWritten;
+
+    void pumpStream();
+    void reclaimCredits();
+    void handleCommand(const uint8_t* data, size_t len);
+    void reportConfig(const ConfigReport& report);
+    void publishConfig();
+
     class ServerCallbacks;
+    class StreamCallbacks;
+    class WriteCallbacks;
 };
 
 #endif // BLE_CONFIG_H
@@ -0,0 +1,39 @@
+/**
+ * @file BLEProtocol.h
+ * @brief GATT UUIDs, connection parameters and COMMAND codes of the BRAVO service
+ *
+ * Shared by BLEConfig (NimBLE) and PicoBLE (BTstack) so one phone app
+ * talks to either, and kept free of both stacks' headers.
+ *
+ *   CONFIG   read/write  DeviceConfig wire record (DeviceConfig.h)
+ *   STATUS   read/notify apply outcome and command replies, as text
+ *   COMMAND  write       [u8 BLE_COMMAND_VERSION][u8 BLECommand]
+ *   STREAM   notify      BLEStream dumps (BLEStream.h)
+ */
+
+#ifndef BLE_PROTOCOL_H
+#define BLE_PROTOCOL_H
+
+#include <stdint.h>
+
+// BLE Service and Characteristic UUIDs
+#define SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
+#define CONFIG_UUID         "beb5483e-36e1-4688-b7f5-ea07361b26a8"
+#define STATUS_UUID         "1c95d5e3-d8f7-413a-bf3d-7a2e5d7be87e"
+#define COMMAND_UUID        "d8de624e-140f-4a22-8594-e2216b84a5f2"
+#define STREAM_UUID         "6e1a7c52-3b9d-4f0e-a4c8-90d2f35e1b67"
+
+// Connection parameters requested for bulk transfer (units of 1.25 ms / 10 ms)
+#define BLE_CONN_INTERVAL_MIN   6       // 7.5 ms
+#define BLE_CONN_INTERVAL_MAX   12      // 15 ms
+#define BLE_CONN_TIMEOUT        400     // 4 s supervision timeout
+
+#define BLE_COMMAND_VERSION     1
+
+enum BLECommand : uint8_t {
+    BLE_CMD_DEFAULTS = 0x01,    // apply and save the build defaults
+    BLE_CMD_DUMP     = 0x02,    // stream peers and track again
+    BLE_CMD_REPORT   = 0x03     // repeat the last apply report on STATUS
+};
+
+#endif // BLE_PROTOCOL_H
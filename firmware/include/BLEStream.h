@@ -0,0 +1,137 @@
+/**
+ * @file BLEStream.h
+ * @brief Bulk neighbour-table and track transfer over BLE notifications
+ *
+ * Records are queued in a byte ring in the same [type][len][data] layout
+ * as a LOG_BATCH frame:
+ *
+ *   BLE_REC_PEER   u16 addr, i32 latE6, i32 lonE6, u16 speedKmhX10,
+ *                  u16 courseDeg, u8 sats, i16 rssi, i16 snrX10,
+ *                  u32 ageMs, u8 flags (bit 0: has position)
+ *   BLE_REC_TRACK  u32 first sequence, TrackLog compact form
+ *   BLE_REC_MARK   u8 BLE_MARK_*, u16 count (brackets a dump)
+ *
+ * Each notification is [u16 sequence][next bytes of the ring], as many as
+ * the negotiated ATT MTU allows (MTU − 3 − 2); records may continue in the
+ * next notification, so nothing is wasted on padding and the phone simply
+ * concatenates payloads in sequence order.
+ *
+ * Flow control: at most BLE_STREAM_IN_FLIGHT notifications are handed to
+ * the stack before one is reported sent (onSent()); a notification the
+ * stack refuses is given back with unsend() and retried later.  Credits
+ * that never come back (link lost mid-transfer) are reclaimed after
+ * BLE_STREAM_CREDIT_TIMEOUT_MS.
+ *
+ * startDump() queues the whole neighbour table and the kept track; the
+ * track is moved into the ring in chunks by refill() as space frees, so
+ * a backlog larger than the ring streams without stalling the loop.
+ * Transport-agnostic: PicoBLE (BTstack) and BLEConfig (NimBLE) drive it,
+ * each calling onSent() once a notification has left its stack.
+ */
+
+#ifndef BLE_STREAM_H
+#define BLE_STREAM_H
+
+#include <Arduino.h>
+#include "PeerTable.h"
+#include "TrackLog.h"
+
+#define BLE_STREAM_RING              2048    // bytes, power of two
+#define BLE_STREAM_DEFAULT_MTU       23      // until the exchange completes
+#define BLE_STREAM_MAX_MTU           517     // largest ATT MTU
+#define BLE_STREAM_HEADER            2       // u16 sequence
+#define BLE_STREAM_MAX_NOTIFY        (BLE_STREAM_MAX_MTU - 3)
+#define BLE_STREAM_IN_FLIGHT         6       // notifications not yet out of the stack
+#define BLE_STREAM_CREDIT_TIMEOUT_MS 2000
+#define BLE_STREAM_PEER_LEN          24
+#define BLE_STREAM_TRACK_CHUNK       160     // compact track bytes per record
+
+enum BLEStreamRecordType : uint8_t {
+    BLE_REC_PEER  = 0x01,
+    BLE_REC_TRACK = 0x02,
+    BLE_REC_MARK  = 0x03
+};
+
+enum BLEStreamMark : uint8_t {
+    BLE_MARK_DUMP_START = 0x01,
+    BLE_MARK_PEERS_END  = 0x02,   // count = peers sent
+    BLE_MARK_DUMP_END   = 0x03    // count = track points sent
+};
+
+struct BLEStreamStats {
+    uint32_t notifications;
+    uint32_t bytes;            // notification payload, headers included
+    uint32_t records;
+    uint32_t dropped;          // push() with the ring full
+    uint32_t creditWaits;      // data queued but every credit in flight
+    uint32_t refused;          // unsend()
+    uint32_t timeouts;         // credits reclaimed
+    uint32_t firstSentMs;      // of the current dump
+    uint32_t lastDoneMs;       // last onSent()
+};
+
+class BLEStream {
+public:
+    BLEStream();
+
+    /** New connection: empty ring, all credits, default MTU. */
+    void reset();
+
+    /** ATT MTU agreed with the client. */
+    void setMtu(uint16_t attMtu);
+
+    /** Bytes per notification at the current MTU, header included. */
+    uint16_t getNotifySize() const { return notifySize; }
+
+    /** Queue one record; false (and counted) if the ring has no room. */
+    bool push(uint8_t type, const uint8_t* data, uint8_t len);
+
+    /** Queue the neighbour table now and the track from its oldest point. */
+    void startDump(const PeerTable& peers, const TrackLog& track, uint32_t now);
+
+    /** Move more of a running dump into the ring; call before next(). */
+    void refill();
+
+    /**
+     * Build the next notification into `buf` (at least getNotifySize()
+     * bytes) and take a credit.
+     * @return length, 0 if nothing is queued or no credit is left
+     */
+    size_t next(uint8_t* buf, size_t cap, uint32_t now);
+
+    /** The stack refused the notification next() just built. */
+    void unsend();
+
+    /** The stack reports a notification sent. */
+    void onSent(uint32_t now);
+
+    bool     dumping() const      { return track != nullptr; }
+    bool     idle() const         { return !dumping() && queued() == 0 && inFlight == 0; }
+    uint16_t queued() const       { return (uint16_t)(head - tail); }
+    uint8_t  getInFlight() const  { return inFlight; }
+    const BLEStreamStats& getStats() const { return stats; }
+
+    /** Payload rate of the current dump (bytes/s), 0 before it started. */
+    uint32_t bytesPerSecond() const;
+
+private:
+    uint8_t         ring[BLE_STREAM_RING];
+    uint16_t        head;             // free-running, masked on access
+    uint16_t        tail;
+    uint16_t        notifySize;
+    uint16_t        seq;
+    uint8_t         inFlight;
+    uint16_t        lastLen;          // ring bytes in the last next()
+    uint32_t        lastSentMs;
+    uint32_t        dumpBytes;
+    const TrackLog* track;            // dump in progress
+    uint32_t        trackSeq;
+    uint16_t        trackPoints;
+    BLEStreamStats  stats;
+
+    uint16_t space() const { return (uint16_t)(BLE_STREAM_RING - queued()); }
+    void     copyIn(const uint8_t* data, uint16_t len);
+    void     pushMark(uint8_t mark, uint16_t count);
+};
+
+#endif // BLE_STREAM_H
@@ -0,0 +1,22 @@
+/**
+ * @file Checksum.h
+ * @brief CRC helpers shared by the flash stores and radio framing
+ *
+ * Both are small table-less bitwise implementations: they run over at most
+ * a few KB at a time, so 256-entry tables are not worth the flash.
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <Arduino.h>
+
+/** CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).  Pass a previous result
+ *  as `crc` to continue over several buffers. */
+uint16_t crc16(const void* data, size_t len, uint16_t crc = 0xFFFF);
+
+/** CRC-32 (IEEE 802.3, reflected).  Pass a previous result as `crc` to
+ *  continue over several buffers. */
+uint32_t crc32(const void* data, size_t len, uint32_t crc = 0);
+
+#endif // CHECKSUM_H
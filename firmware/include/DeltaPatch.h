@@ -0,0 +1,113 @@
+/**
+ * @file DeltaPatch.h
+ * @brief Streaming binary-delta applier for firmware updates
+ *
+ * A patch (made on the host by tools/ota_delta.py) rebuilds a new image
+ * from the one already running, bsdiff-style:
+ *
+ *   header   u32 magic "BDLT", u32 oldSize, u32 newSize,
+ *            sha256(old)[32], sha256(new)[32]
+ *   records  until newSize bytes are out:
+ *              varint diffLen, varint extraLen, zigzag varint seek
+ *              diff   diffLen bytes of old + delta, coded as pairs of
+ *                     varint zeroRun (copied unchanged) and varint n,
+ *                     n delta bytes (added mod 256)
+ *              extra  extraLen literal bytes
+ *              then the old position moves by seek
+ *
+ * Code that only moved shifts its addresses by a constant, so most diff
+ * bytes are zero and cost nothing but a run length.
+ *
+ * The applier takes the patch in chunks of any size and writes the new
+ * image to a Print (a LittleFS file) through one page-sized buffer; it
+ * holds no more than that, the header and a SHA-256 state.  The old image
+ * is read in place (on the Pico through XIP, no copy).
+ */
+
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include <Arduino.h>
+#include "Sha256.h"
+
+#define DELTA_MAGIC        0x544C4442UL   // "BDLT"
+#define DELTA_HEADER_LEN   (12 + 2 * SHA256_DIGEST_SIZE)
+#define DELTA_OUT_BUFFER   256
+
+struct DeltaHeader {
+    uint32_t oldSize;
+    uint32_t newSize;
+    uint8_t  oldSha256[SHA256_DIGEST_SIZE];
+    uint8_t  newSha256[SHA256_DIGEST_SIZE];
+};
+
+enum DeltaResult : uint8_t {
+    DELTA_OK,             // keep feeding
+    DELTA_DONE,           // image complete and its hash matches
+    DELTA_BAD_PATCH,      // malformed, or reads/writes out of bounds
+    DELTA_WRONG_BASE,     // the patch was made against another image
+    DELTA_WRITE_FAILED,
+    DELTA_BAD_HASH        // rebuilt image does not hash to newSha256
+};
+
+class DeltaPatcher {
+public:
+    DeltaPatcher();
+
+    /** Parse a patch header; false if `p` does not start with one. */
+    static bool parseHeader(const uint8_t* p, size_t len, DeltaHeader& h);
+
+    /** Hash `image` and compare it with the patch's base (blocking, one pass). */
+    static bool matchesBase(const DeltaHeader& h, const uint8_t* image, uint32_t imageSize);
+
+    /**
+     * Start applying against `oldImage` (which must stay readable
+     * throughout); the new image goes to `out`.
+     */
+    void begin(const uint8_t* oldImage, uint32_t oldImageSize, Print& out);
+
+    /** Feed the next patch bytes, in order. */
+    DeltaResult write(const uint8_t* data, size_t len);
+
+    /** The patch has ended: DELTA_DONE if it rebuilt the whole image. */
+    DeltaResult finish();
+
+    const DeltaHeader& getHeader() const { return header; }
+    uint32_t getWritten() const          { return newPos; }
+
+    static const char* resultName(DeltaResult r);
+
+private:
+    enum Phase : uint8_t {
+        PH_HEADER, PH_DIFF_LEN, PH_EXTRA_LEN, PH_SEEK, PH_ZERO_RUN, PH_DELTA_LEN,
+        PH_DELTA, PH_EXTRA, PH_DONE, PH_ERROR
+    };
+
+    const uint8_t* oldImage;
+    uint32_t       oldImageSize;
+    Print*         out;
+    DeltaHeader    header;
+    uint8_t        headerBuf[DELTA_HEADER_LEN];
+    uint8_t        headerLen;
+    Phase          phase;
+    DeltaResult    error;
+    uint32_t       varint;
+    uint8_t        varintShift;
+    uint32_t       diffLeft;       // of the current record
+    uint32_t       extraLeft;
+    uint32_t       runLeft;        // delta bytes left in the current run
+    int32_t        seek;
+    uint32_t       oldPos;
+    uint32_t       newPos;
+    uint8_t        buf[DELTA_OUT_BUFFER];
+    uint16_t       bufLen;
+    Sha256         hasher;
+
+    bool takeVarint(uint8_t b);
+    bool emit(const uint8_t* data, size_t len);
+    bool flush();
+    DeltaResult fail(DeltaResult r);
+    void endRecord();
+};
+
+#endif // DELTA_PATCH_H
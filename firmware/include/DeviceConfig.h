@@ -0,0 +1,180 @@
+/**
+ * @file DeviceConfig.h
+ * @brief Runtime address / radio / GPS / heartbeat settings: wire format, apply, persist
+ *
+ * Settings travel as one packed, versioned record (little-endian), the
+ * value of the BLE CONFIG characteristic and the content of CONFIG_FILE:
+ *
+ *   u8  version (CONFIG_WIRE_VERSION)    u8  reserved (0)
+ *   u32 loraFreqHz                       AT+BAND
+ *   u8  loraSf, loraBw, loraCr, loraPreamble   AT+PARAMETER
+ *   u8  loraPowerDbm                     AT+CRFOP
+ *   u16 gpsRateMs                        UBX-CFG-RATE measurement period
+ *   u16 heartbeatMs                      TxPolicy check cadence
+ *   u32 keepaliveCapMs                   0 = speed-band table as built
+ *   u16 address                          AT+ADDRESS, this unit's identity
+ *   u16 target                           where heartbeats and logs go
+ *   u16 crc16 of the bytes before it
+ *
+ * A record is rejected whole if its length, version, CRC or any field is
+ * out of range; nothing is applied then.  A valid record is compared with
+ * the settings in force and only the groups that changed are re-applied,
+ * each timed, so retuning the GPS rate does not cost an AT+PARAMETER round
+ * trip.  A group the hardware refuses keeps its old value; what was
+ * applied is saved (temp file + rename) and re-applied by begin() at boot.
+ *
+ * The address pair lives here rather than in the build so that one image
+ * (an OTA multicast, a delta patch) fits every unit.  DEVICE_ADDRESS and
+ * TARGET_ADDRESS only seed defaults(); begin() saves them the first time
+ * it finds no record, which pins the unit's identity across later images.
+ * A version 1 record (no addresses) is still accepted: written at runtime
+ * it keeps the addresses in force, found in CONFIG_FILE at boot it takes
+ * the build defaults for them.
+ */
+
+#ifndef DEVICE_CONFIG_H
+#define DEVICE_CONFIG_H
+
+#include <Arduino.h>
+#include "LoRaComm.h"
+#include "GPS.h"
+#include "TxPolicy.h"
+
+// Identity of a unit flashed for the first time (see above)
+#ifndef DEVICE_ADDRESS
+#define DEVICE_ADDRESS 1
+#endif
+#ifndef TARGET_ADDRESS
+#define TARGET_ADDRESS 2
+#endif
+
+#define CONFIG_WIRE_VERSION         2
+#define CONFIG_WIRE_LEN             25
+#define CONFIG_WIRE_LEN_V1          21
+#define CONFIG_FILE                 "/config.bin"
+#define CONFIG_DEFAULT_POWER_DBM    15      // RYLR896 factory setting
+#define CONFIG_DEFAULT_GPS_RATE_MS  GPS_DEFAULT_RATE_MS
+#define CONFIG_DEFAULT_HEARTBEAT_MS 1000
+
+struct DeviceSettings {
+    uint32_t loraFreqHz;
+    uint8_t  loraSf;
+    uint8_t  loraBw;
+    uint8_t  loraCr;
+    uint8_t  loraPreamble;
+    uint8_t  loraPowerDbm;
+    uint16_t gpsRateMs;
+    uint16_t heartbeatMs;
+    uint32_t keepaliveCapMs;
+    uint16_t address;
+    uint16_t target;
+};
+
+enum ConfigResult : uint8_t {
+    CONFIG_OK,
+    CONFIG_BAD_LENGTH,
+    CONFIG_BAD_VERSION,
+    CONFIG_BAD_CRC,
+    CONFIG_OUT_OF_RANGE,     // ConfigReport::field names the first offender
+    CONFIG_APPLY_FAILED,     // some group refused, see ConfigReport::failed
+    CONFIG_SAVE_FAILED
+};
+
+enum ConfigField : uint8_t {
+    CONFIG_FIELD_NONE,
+    CONFIG_FIELD_FREQ,
+    CONFIG_FIELD_SF,
+    CONFIG_FIELD_BW,
+    CONFIG_FIELD_CR,
+    CONFIG_FIELD_PREAMBLE,
+    CONFIG_FIELD_POWER,
+    CONFIG_FIELD_GPS_RATE,
+    CONFIG_FIELD_HEARTBEAT,
+    CONFIG_FIELD_KEEPALIVE,
+    CONFIG_FIELD_ADDRESS,
+    CONFIG_FIELD_TARGET
+};
+
+// Groups applied together (ConfigReport::changed / failed)
+#define CONFIG_GROUP_BAND       0x01
+#define CONFIG_GROUP_PARAMETER  0x02
+#define CONFIG_GROUP_POWER      0x04
+#define CONFIG_GROUP_GPS        0x08
+#define CONFIG_GROUP_HEARTBEAT  0x10
+#define CONFIG_GROUP_ADDRESS    0x20
+#define CONFIG_GROUP_TARGET     0x40
+
+/** Outcome of one apply, with where the time went. */
+struct ConfigReport {
+    ConfigResult result;
+    ConfigField  field;
+    uint8_t      changed;
+    uint8_t      failed;
+    bool         saved;
+    uint32_t     radioUs;       // AT+ADDRESS / AT+BAND / AT+PARAMETER / AT+CRFOP round trips
+    uint32_t     gpsUs;
+    uint32_t     heartbeatUs;
+    uint32_t     saveUs;
+    uint32_t     totalUs;
+};
+
+class DeviceConfig {
+public:
+    /**
+     * @param heartbeatMs  the loop's TxPolicy check interval, retuned in place
+     */
+    DeviceConfig(LoRaComm& lora, GPS& gps, TxPolicy& policy, uint32_t& heartbeatMs);
+
+    /**
+     * Load CONFIG_FILE and apply whatever differs from the build defaults;
+     * with no valid file the defaults are saved as this unit's settings.
+     * Call once LoRaComm and GPS are up.
+     * @return false if there was no valid saved configuration
+     */
+    bool begin();
+
+    /** Validate, apply the groups that changed and save. */
+    const ConfigReport& apply(const DeviceSettings& next);
+
+    /** Decode a wire record and apply() it. */
+    const ConfigReport& applyWire(const uint8_t* data, size_t len);
+
+    const DeviceSettings& get() const          { return current; }
+    uint16_t              address() const      { return current.address; }
+    uint16_t              target() const       { return current.target; }
+    const ConfigReport&   getLastReport() const { return report; }
+
+    static DeviceSettings defaults();
+
+    /** @return CONFIG_WIRE_LEN, or 0 if `cap` is too small */
+    static size_t encode(const DeviceSettings& s, uint8_t* buf, size_t cap);
+
+    /**
+     * Parse and range-check a wire record; `field` names a bad field.
+     * A version 1 record has no addresses and leaves those of `out` as given.
+     */
+    static ConfigResult decode(const uint8_t* buf, size_t len, DeviceSettings& out,
+                               ConfigField& field);
+
+    static ConfigField validate(const DeviceSettings& s);
+
+    /** One line, e.g. "ok: radio 412 ms, gps 2 ms, save 31 ms". */
+    static String describe(const ConfigReport& r);
+
+    static const char* resultName(ConfigResult r);
+    static const char* fieldName(ConfigField f);
+
+private:
+    LoRaComm&      lora;
+    GPS&           gps;
+    TxPolicy&      policy;
+    uint32_t&      heartbeatMs;
+    DeviceSettings current;
+    ConfigReport   report;
+
+    const ConfigReport& applyChanges(const DeviceSettings& next, bool persist);
+    uint8_t             applyRadio(const DeviceSettings& next, uint8_t groups);
+    bool                save();
+};
+
+#endif // DEVICE_CONFIG_H
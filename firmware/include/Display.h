@@ -5,6 +5,35 @@
  * I2C0: GP4 SDA, GP5 SCL  (set in PinConfig.h)
  * Power: Pin 36 (3V3 OUT) supplies 3.3V; any GND pin provides ground
  * No external reset pin — pass -1 to Adafruit_SSD1306 constructor.
+ *
+ * Frames are not pushed with Adafruit_SSD1306::display().  flush() diffs the
+ * framebuffer against a shadow copy of what the panel already shows and
+ * sends, per 8-row page, only the column range that changed — using SSD1306
+ * column/page addressing (0x21/0x22) to position the write.
+ *
+ * The dirty windows are encoded as a stream of I2C0 DATA_CMD words (byte +
+ * STOP flag) and handed to a DMA channel paced by the I2C TX DREQ, so the
+ * bus transfer runs while the main loop keeps parsing GPS and LoRa.  The GFX
+ * framebuffer is the back buffer the screens draw into; the command stream
+ * is the front buffer in flight.  A DMA IRQ flags completion, poll() reaps
+ * it, and a frame requested while one is in flight is coalesced and sent as
+ * soon as the bus is free.  Without a free DMA channel flush() falls back to
+ * blocking Wire writes.
+ *
+ * The GPS and radio screens are composed from fixed layouts (TextRenderer):
+ * labels are drawn once when a screen is entered, and each value field is
+ * formatted into a stack buffer and re-rasterised only if its text changed.
+ * No String objects or heap are involved in a refresh.
+ *
+ * The radar screen plots every peer with a position around the local fix,
+ * north up, on a 64×64 scope that auto-scales to the farthest peer.  The
+ * rings are drawn once and cached; each frame restores them and plots the
+ * markers, so the flush only carries the pixels that moved.
+ *
+ * The link screen draws RSSI and SNR sparklines for the most recently heard
+ * peer on fixed scales.  Each new sample shifts the plot one column left
+ * and draws a single new column; the full plot is only rebuilt when the
+ * peer changes or the screen is entered.
  */
 
 #ifndef DISPLAY_H
@@ -16,10 +45,50 @@
 #include <Adafruit_SSD1306.h>
 #include "GPS.h"
 #include "PinConfig.h"
+#include "TextRenderer.h"
+#include "PeerTable.h"
 
-// Display update interval (ms)
+// Refresh interval of updateStatus() (ms); the main screens are paced by UIScheduler
 #define DISPLAY_UPDATE_INTERVAL 1000
 
+#define DISPLAY_PAGES       (SCREEN_HEIGHT / 8)
+#define DISPLAY_BUFFER_SIZE (SCREEN_WIDTH * DISPLAY_PAGES)
+// Data bytes per I2C transaction on the blocking path (Wire buffer holds 32
+// incl. control byte)
+#define DISPLAY_I2C_CHUNK   31
+// DMA stream: per page a 7-byte window command + control byte + 128 data bytes
+#define DISPLAY_STREAM_WORDS (DISPLAY_PAGES * (7 + 1 + SCREEN_WIDTH))
+
+// Value fields per layout and their longest text
+#define DISPLAY_MAX_FIELDS  6
+#define DISPLAY_FIELD_CHARS 16
+
+enum DisplayLayout : uint8_t {
+    LAYOUT_NONE = 0,    // free-form GFX screen (splash, messages)
+    LAYOUT_GPS,
+    LAYOUT_RADIO,
+    LAYOUT_RADAR,
+    LAYOUT_LINK
+};
+
+// Radar scope: left 64×64 square of the panel
+#define RADAR_SIZE          64
+#define RADAR_CENTER        31
+#define RADAR_RADIUS        30
+#define RADAR_REFRESH_MS    200        // ~5 fps while the radar is shown
+#define RADAR_FRESH_MS      30000      // solid marker: heard within 30 s
+#define RADAR_AGED_MS       180000     // hollow marker: within 3 min, dot after
+
+// Link sparklines: one column per sample, fixed vertical scales
+#define SPARK_WIDTH         PEER_LINK_HISTORY
+#define SPARK_PAGES         3          // 24 px tall
+#define SPARK_RSSI_PAGE     1
+#define SPARK_SNR_PAGE      5
+#define SPARK_RSSI_MIN      -130       // dBm
+#define SPARK_RSSI_MAX      -30
+#define SPARK_SNR_MIN_X4    (-20 * 4)  // dB × 4
+#define SPARK_SNR_MAX_X4    (15 * 4)
+
 class Display {
 public:
     /**
@@ -58,6 +127,19 @@ public:
                          int rssi, float snr,
                          const String& lastMsg);
 
+    /**
+     * Screen C: peer radar — range/bearing of every peer from the local fix.
+     * @param haveFix  false if latE6/lonE6 is not a usable own position
+     */
+    void showRadarScreen(const PeerTable& peers, bool haveFix,
+                         int32_t latE6, int32_t lonE6, uint32_t now);
+
+    /**
+     * Screen D: link quality — RSSI/SNR sparklines and min/avg/max for the
+     * peer heard most recently.
+     */
+    void showLinkScreen(const PeerTable& peers);
+
     void updateStatus(const GPSData& gpsData, const char* deviceId,
                      const char* deviceType);
 
@@ -65,10 +147,92 @@ public:
     void showMessage(const char* message);
     bool shouldUpdate();
 
+    /**
+     * Reap a finished DMA transfer and start a coalesced pending frame.
+     * Call once per loop iteration; never blocks.
+     */
+    void poll();
+
+    /** True while a frame is still on the bus. */
+    bool isFlushing() const { return dmaActive; }
+    bool isAsync()    const { return dmaChannel >= 0; }
+
+    /** Bytes put on the I2C bus by the last flush (address + control + payload). */
+    uint32_t getLastFlushBytes()  const { return lastFlushBytes; }
+    /** Bytes put on the bus by all flushes since boot. */
+    uint32_t getTotalFlushBytes() const { return totalFlushBytes; }
+    /** Submit-to-complete time of the last finished frame in µs. */
+    uint32_t getLastFlushMicros() const { return lastFlushUs; }
+    /** CPU time the caller spent in the last flush() (diff + encode) in µs. */
+    uint32_t getLastSubmitMicros() const { return lastSubmitUs; }
+    /** CPU cycles spent composing the last GPS/radio screen (before flush). */
+    uint32_t getLastRenderCycles() const { return lastRenderCycles; }
+    /** Frames folded into a later one because the bus was still busy. */
+    uint32_t getCoalescedFrames() const { return coalescedFrames; }
+    /** Transfers aborted by the I2C controller (e.g. NACK). */
+    uint32_t getFlushErrors()     const { return flushErrors; }
+
 private:
     Adafruit_SSD1306 display;   // Stack-allocated (no dynamic allocation)
     bool             initialized;
     unsigned long    lastUpdate;
+
+    // What the panel currently shows (page-major, same layout as the GFX buffer)
+    uint8_t          shadow[DISPLAY_BUFFER_SIZE];
+    bool             shadowValid;       // false → next flush resends every page
+    uint32_t         lastFlushBytes;
+    uint32_t         totalFlushBytes;
+    uint32_t         lastFlushUs;
+    uint32_t         lastSubmitUs;
+
+    // DMA front buffer: I2C DATA_CMD words for the frame in flight
+    uint16_t         stream[DISPLAY_STREAM_WORDS];
+    uint16_t         streamLen;
+    int              dmaChannel;        // -1 → blocking Wire fallback
+    volatile bool    dmaDone;           // set by the DMA IRQ
+    bool             dmaActive;
+    bool             flushPending;
+    uint32_t         transferStartUs;
+    uint32_t         coalescedFrames;
+    uint32_t         flushErrors;
+
+    // Layout state: which field texts are already in the framebuffer
+    uint8_t          layout;            // DisplayLayout
+    char             fieldText[DISPLAY_MAX_FIELDS][DISPLAY_FIELD_CHARS + 1];
+    uint32_t         lastRenderCycles;
+
+    // Radar rings, cached as RADAR_SIZE columns per page
+    uint8_t          radarBackdrop[DISPLAY_PAGES * RADAR_SIZE];
+
+    // Link sparklines: which peer/samples are already in the framebuffer
+    uint16_t         sparkAddr;
+    uint32_t         sparkSeq;          // next sample to draw
+    bool             sparkValid;
+
+    /**
+     * Switch to a layout: clear, draw its labels, forget field contents.
+     * @return true if the layout changed
+     */
+    bool useLayout(uint8_t id);
+    /** Set one value field of the current layout; rasterises only on change. */
+    void setField(uint8_t slot, const char* text);
+    /** Leave layout mode before a free-form GFX screen. */
+    void beginFreeform();
+    void drawRadarBackdrop();
+    void drawSparkSample(uint8_t x, int8_t rssi, int8_t snrX4);
+    void clearSparklines();
+
+    /** Push only the changed page/column ranges of the framebuffer. */
+    void flush();
+    void emitWindow(uint8_t page, uint8_t first, uint8_t last, const uint8_t* data);
+    void sendCommands(const uint8_t* cmds, uint8_t len);
+    void sendData(const uint8_t* data, uint16_t len);
+    void streamBytes(const uint8_t* bytes, uint16_t len, bool stop);
+
+    bool beginDma();
+    void startDma();
+    bool reapDma();
+    static void dmaIrqHandler();
 };
 
 #endif // DISPLAY_H
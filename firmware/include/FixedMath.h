@@ -0,0 +1,114 @@
+/**
+ * @file FixedMath.h
+ * @brief Integer trig / geometry helpers for B.R.A.V.O. on the RP2040 (M0+)
+ *
+ * The Cortex-M0+ has no FPU, so anything that runs per fix or per sample
+ * uses these table-driven integer routines instead of sin/cos/atan2/sqrt.
+ *
+ * Conventions:
+ *   Angles      binary angle units (BAM): 65536 per full turn, 0 = north,
+ *               increasing clockwise (same sense as a GPS course).
+ *   Fractions   Q15 (32768 = 1.0).
+ *   Positions   latitude/longitude in microdegrees (int32, 1e-6 deg).
+ *   Distances   millimetres in a local east/north tangent plane.
+ */
+
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+#include <Arduino.h>
+
+// 1 microdegree of latitude ≈ 111.195 mm (mean Earth radius 6371 km); Q16 so
+// mm = (microdeg * FM_MM_PER_UDEG_Q16) >> 16.
+#define FM_MM_PER_UDEG_Q16  7287271L   // 111.1949 mm * 65536
+
+#define FM_BAM_PER_TURN     65536UL
+#define FM_Q15_ONE          32768
+
+namespace FixedMath {
+
+/** sin(angle) in Q15 (−32767..32767). */
+int16_t sinQ15(uint16_t bam);
+
+/** cos(angle) in Q15 (−32767..32767). */
+inline int16_t cosQ15(uint16_t bam) { return sinQ15((uint16_t)(bam + 16384)); }
+
+/** atan2 returned as a compass bearing: atan2Bam(east, north). */
+uint16_t atan2Bam(int32_t east, int32_t north);
+
+/** Integer square roots (floor). */
+uint32_t isqrt32(uint32_t v);
+uint32_t isqrt64(uint64_t v);
+
+/**
+ * 2^31 / sqrt(v) (table seed + one Newton step, < 1e-4 relative).
+ * Normalises a vector without a square root or a division:
+ * x · rsqrtQ31(|x|²) >> 1 is the Q30 unit component.  v = 0 → UINT32_MAX.
+ */
+uint32_t rsqrtQ31(uint32_t v);
+
+/** Degrees (float, e.g. GPS course) → BAM. */
+inline uint16_t degToBam(float deg) {
+    return (uint16_t)(int32_t)(deg * (65536.0f / 360.0f));
+}
+
+/** BAM → whole degrees 0..359. */
+inline uint16_t bamToDeg(uint16_t bam) {
+    return (uint16_t)(((uint32_t)bam * 360UL + 32768UL) >> 16) % 360;
+}
+
+/** Degrees (double) → microdegrees, rounded. */
+inline int32_t toMicroDeg(double deg) {
+    return (int32_t)(deg * 1e6 + (deg >= 0 ? 0.5 : -0.5));
+}
+
+/** cos(latitude) in Q15 for a microdegree latitude — used to scale longitude. */
+inline int16_t cosLatQ15(int32_t latE6) {
+    // 1 µdeg = 65536 / 360e6 BAM; fold through int64 to avoid overflow.
+    return cosQ15((uint16_t)(((int64_t)latE6 * 65536) / 360000000LL));
+}
+
+/**
+ * Project (latE6, lonE6) into an east/north plane around an origin.
+ * Equirectangular — accurate to well under 0.1 % within tens of km.
+ */
+inline void toLocalMm(int32_t latE6, int32_t lonE6,
+                      int32_t originLatE6, int32_t originLonE6,
+                      int16_t cosOriginQ15,
+                      int32_t& eastMm, int32_t& northMm) {
+    int64_t dLat = (int64_t)latE6 - originLatE6;
+    int64_t dLon = (int64_t)lonE6 - originLonE6;
+    if (dLon >  180000000LL) dLon -= 360000000LL;
+    if (dLon < -180000000LL) dLon += 360000000LL;
+    northMm = (int32_t)((dLat * FM_MM_PER_UDEG_Q16) >> 16);
+    eastMm  = (int32_t)((((dLon * FM_MM_PER_UDEG_Q16) >> 16) * cosOriginQ15) >> 15);
+}
+
+/** Inverse of toLocalMm(). */
+inline void fromLocalMm(int32_t eastMm, int32_t northMm,
+                        int32_t originLatE6, int32_t originLonE6,
+                        int16_t cosOriginQ15,
+                        int32_t& latE6, int32_t& lonE6) {
+    latE6 = originLatE6 + (int32_t)(((int64_t)northMm << 16) / FM_MM_PER_UDEG_Q16);
+    int64_t scale = ((int64_t)FM_MM_PER_UDEG_Q16 * (cosOriginQ15 ? cosOriginQ15 : 1)) >> 15;
+    if (scale == 0) scale = 1;
+    lonE6 = originLonE6 + (int32_t)(((int64_t)eastMm << 16) / scale);
+}
+
+/** Squared ground distance in mm² between two microdegree points. */
+int64_t distanceSqMm(int32_t lat1E6, int32_t lon1E6,
+                     int32_t lat2E6, int32_t lon2E6);
+
+/** Ground distance in mm between two microdegree points. */
+inline uint32_t distanceMm(int32_t lat1E6, int32_t lon1E6,
+                           int32_t lat2E6, int32_t lon2E6) {
+    return isqrt64((uint64_t)distanceSqMm(lat1E6, lon1E6, lat2E6, lon2E6));
+}
+
+/** Compass bearing (BAM) from point 1 to point 2. */
+uint16_t bearingBam(int32_t lat1E6, int32_t lon1E6,
+                    int32_t lat2E6, int32_t lon2E6);
+
+} // namespace FixedMath
+
+#endif // FIXED_MATH_H
@@ -0,0 +1,169 @@
+/**
+ * @file FlashLog.h
+ * @brief Append-only store-and-forward log on raw flash
+ *
+ * Everything worth keeping while the relay is out of range (own positions,
+ * alerts — TelemetryCodec binary records) is appended here and drained
+ * over LoRa once the link is back.
+ *
+ * Layout: the LogFlash region is a ring of 4 KB segments, one per erase
+ * sector, used strictly in turn so every sector wears at the same rate.
+ * Segment N (a running sequence number) lives in sector N % count:
+ *
+ *   [header 16 B: magic, seq, drain cursor, crc16] [record]... [0xFF...]
+ *   record = [len][type][crc16 of type+data][data]
+ *
+ * Records are batched in a one-page RAM buffer and programmed a whole page
+ * at a time, when the page fills or on flush() (every FLASH_LOG_FLUSH_MS
+ * from service()).  A partly filled page is padded with 0xFF and never
+ * re-programmed; a reader that meets 0xFF skips to the next page, and 0xFF
+ * at a page boundary is the end of the segment's data.  A power cut loses
+ * at most the unflushed page.
+ *
+ * The drain cursor (what has been delivered) is persisted lazily: as an
+ * ACK record ahead of the next appended record (or on flush) and in each
+ * new segment header.
+ * After a reset some already-sent records may be sent again, never fewer.
+ *
+ * Boot recovery reads only the segment headers plus the newest segment;
+ * a record whose CRC fails (torn write) ends that segment.
+ *
+ * When the ring is full the oldest segment is erased, undelivered or not.
+ * service() erases the next sector ahead of time once the current segment
+ * is half full, so append() itself never blocks on a 45 ms erase.
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <Arduino.h>
+#include "LogFlash.h"
+
+#define FLASH_LOG_MAGIC          0x474F4C42UL   // "BLOG"
+#define FLASH_LOG_HEADER_SIZE    16
+#define FLASH_LOG_RECORD_HEADER  4
+#define FLASH_LOG_MAX_RECORD     200            // data bytes per record
+#define FLASH_LOG_FLUSH_MS       30000
+#define FLASH_LOG_AIRTIME_SHARE  10             // % of airtime the drain may use
+
+enum LogRecordType : uint8_t {
+    LOG_TELEMETRY = 0x01,   // one TelemetryCodec binary record
+    LOG_ACK       = 0x7F    // internal: persisted drain cursor
+};
+
+/** Position in the log: segment sequence number and byte offset in it. */
+struct LogCursor {
+    uint32_t segment;
+    uint16_t offset;
+};
+
+struct FlashLogStats {
+    uint32_t appended;         // records
+    uint32_t appendedBytes;    // record data bytes
+    uint32_t pagesWritten;
+    uint32_t segmentsErased;
+    uint32_t segmentsLost;     // erased while still holding undelivered records
+    uint32_t corruptRecords;   // CRC failures met by recovery or the drain
+    uint32_t drainedRecords;
+    uint32_t drainedBytes;
+    uint32_t batchesSent;
+};
+
+class FlashLog {
+public:
+    FlashLog();
+
+    /**
+     * Attach to `flash` and recover the log it holds (or start an empty one).
+     * @return false if the region is unusable
+     */
+    bool begin(LogFlash& flash);
+
+    /** Buffer one record; it reaches flash when its page fills or on flush(). */
+    bool append(uint8_t type, const uint8_t* data, uint8_t len);
+
+    /** Program the partly filled page (and the drain cursor if it moved). */
+    bool flush();
+
+    /** Timed flush and sector erase-ahead; call from the main loop. */
+    void service(uint32_t now);
+
+    // ── Draining ─────────────────────────────────────────────────────────────
+
+    /** Undelivered records exist in flash (unflushed records wait for a flush). */
+    bool hasBacklog() const;
+
+    /** Undelivered bytes (approximate: includes padding and headers). */
+    uint32_t backlogBytes() const;
+
+    /**
+     * Pack undelivered records as [type][len][data]... into `buf`.
+     * @param next  cursor after the last packed record, for onBatchSent()
+     * @return bytes packed, 0 if there is nothing to send
+     */
+    size_t readBatch(uint8_t* buf, size_t cap, LogCursor& next);
+
+    /**
+     * A readBatch() batch went out.  Marks it delivered and, given the
+     * frame's airtime, holds the next batch back so the drain uses at
+     * most the configured share of airtime.
+     */
+    void onBatchSent(const LogCursor& next, uint32_t airtimeMs, uint32_t now);
+
+    /** May the next batch go out now? */
+    bool drainDue(uint32_t now) const { return (int32_t)(now - nextDrainAt) >= 0; }
+
+    void setAirtimeShare(uint8_t percent) { airtimeShare = constrain(percent, 1, 100); }
+
+    /**
+     * append() a record that already went out live.  It counts as delivered
+     * only if everything before it was, so records still waiting (in flash
+     * or the RAM page) are never skipped; otherwise it is drained as usual.
+     */
+    bool appendSent(uint8_t type, const uint8_t* data, uint8_t len);
+
+    const FlashLogStats& getStats() const { return stats; }
+    uint16_t getSegmentCount() const { return segCount; }
+    LogCursor getHead() const { return LogCursor{ headSeq, writeOff }; }
+    LogCursor getDrainCursor() const { return drained; }
+
+private:
+    LogFlash* flash;
+    uint16_t  segCount;
+    bool      started;         // at least one segment exists
+    bool      open;            // head segment has room and a header
+    uint32_t  headSeq;
+    uint16_t  writeOff;        // next record offset in the head segment
+    uint16_t  pageStart;       // segment offset of the RAM page
+    uint16_t  pageLen;         // bytes buffered in the RAM page
+    uint8_t   page[LOG_FLASH_PAGE_SIZE];
+    bool      erasedAhead;     // sector for headSeq + 1 is already erased
+    LogCursor drained;         // first undelivered byte
+    bool      ackDirty;
+    uint32_t  lastFlush;
+    uint32_t  nextDrainAt;
+    uint8_t   airtimeShare;
+    uint16_t  batchRecords;    // in the last readBatch()
+    uint16_t  batchBytes;
+    FlashLogStats stats;
+
+    uint32_t sectorOf(uint32_t seq) const {
+        return (seq % segCount) * (uint32_t)LOG_FLASH_SECTOR_SIZE;
+    }
+    uint32_t oldestSeq() const { return headSeq >= segCount ? headSeq - segCount + 1 : 0; }
+    uint16_t flushedEnd(uint32_t seq) const {
+        return seq == headSeq ? pageStart : (uint16_t)LOG_FLASH_SECTOR_SIZE;
+    }
+    bool readHeader(uint32_t seq, LogCursor& ack);
+    void eraseFor(uint32_t seq);
+    bool openSegment();
+    void put(const uint8_t* data, size_t len);
+    void programPage();
+    bool appendRaw(uint8_t type, const uint8_t* data, uint8_t len);
+    void writeAck();
+    void recoverHead();
+    bool nextRecord(LogCursor& c, uint8_t& type, uint8_t* data, uint8_t& len);
+    void setDrained(const LogCursor& c);
+};
+
+#endif // FLASH_LOG_H
@@ -6,6 +6,11 @@
  * PPS interrupt:    GP15 rising edge = 1 Hz timing pulse
  * Power:            Pin 36 (3V3 OUT), any GND pin
  * Baud rate:        9600 (NEO-7m default NMEA output)
+ *
+ * Warm start: begin() replays the last fix and the almanac/ephemeris saved
+ * in flash (GPSAidCache) via UBX-AID-INI/ALM/EPH, and update() re-polls and
+ * re-saves them periodically once a fix is held.  The boot-to-fix time
+ * (TTFF) is measured and logged on every boot.
  */
 
 #ifndef GPS_H
@@ -14,6 +19,23 @@
 #include <Arduino.h>
 #include <TinyGPSPlus.h>
 #include "PinConfig.h"
+#include "GPSAidCache.h"
+#include "GpsPowerMode.h"
+
+// First aiding save this long after the first fix (ephemerides need ~30 s
+// of tracking to download), then every GPS_AID_SAVE_INTERVAL.
+#define GPS_AID_FIRST_SAVE_DELAY  60000UL
+#define GPS_AID_SAVE_INTERVAL     1800000UL   // 30 min
+#define GPS_AID_CAPTURE_TIMEOUT   15000UL
+// Largest UBX payload we need to capture (AID-EPH)
+#define GPS_UBX_MAX_PAYLOAD       GPS_AID_EPH_LEN
+// UART RX FIFO — big enough to ride out a blocking LoRa AT exchange while
+// ~5 KB of AID poll responses stream in at 9600 baud
+#define GPS_RX_FIFO_SIZE          1024
+// A location older than this is no fix (the receiver may have been in
+// backup); at slow measurement rates, older than three periods (fixMaxAgeMs())
+#define GPS_FIX_MAX_AGE_MS        3000UL
+#define GPS_DEFAULT_RATE_MS       1000      // NEO-7m factory measurement period
 
 struct GPSData {
     double latitude;
@@ -24,7 +46,7 @@ struct GPSData {
     uint8_t satellites;
     uint32_t hdop;
     bool valid;
-    uint32_t timestamp;
+    uint32_t timestamp;     // millis() the receiver delivered this fix, not of the snapshot
 };
 
 class GPS {
@@ -78,8 +100,8 @@ public:
     uint8_t getSatellites();
 
     /**
-     * @brief Check if GPS has valid fix
-     * @return true if GPS has fix, false otherwise
+     * @brief Check if GPS has a valid, current fix
+     * @return true if the last location is valid and younger than fixMaxAgeMs()
      */
     bool hasFix();
 
@@ -101,6 +123,15 @@ public:
      */
     uint32_t getFailedChecksums();
 
+    /** Boot-to-first-fix time in ms (0 until the first fix this boot). */
+    uint32_t getTTFF() const { return ttffMs; }
+
+    /** True if aiding data from flash was injected at boot. */
+    bool isWarmStart() const { return warmStart; }
+
+    /** Poll and persist aiding data now instead of waiting for the schedule. */
+    void saveAidingNow() { nextAidSave = millis(); }
+
     /** True when a PPS pulse has arrived since last call to clearPPS() */
     bool hasPPS() const { return ppsFlag; }
     void clearPPS()     { ppsFlag = false; }
@@ -109,10 +140,55 @@ public:
      *  forward the call.  Do not call directly from application code. */
     void onPPS() { ppsFlag = true; }
 
+    /**
+     * Switch receiver power mode.  Leaving backup wakes the receiver
+     * with UART activity first; it then hot-starts from its kept state.
+     */
+    void setPowerMode(GpsPowerMode mode);
+    GpsPowerMode getPowerMode() const { return powerMode; }
+
+    /**
+     * Set the measurement period (UBX-CFG-RATE, 100–10000 ms).  In backup
+     * mode the receiver cannot hear it; it is sent on the next wake.
+     */
+    bool setRate(uint16_t periodMs);
+    uint16_t getRateMs() const { return rateMs; }
+
+    /**
+     * Age at which a location stops counting as a fix: GPS_FIX_MAX_AGE_MS,
+     * or three measurement periods when the rate is slower than 1 Hz, so a
+     * 10 s rate does not drop the fix between solutions.
+     */
+    uint32_t fixMaxAgeMs() const { return max(GPS_FIX_MAX_AGE_MS, 3UL * rateMs); }
+
 private:
     TinyGPSPlus gps;
     bool        initialized;
     volatile bool ppsFlag;
+    GpsPowerMode powerMode;
+    uint16_t    rateMs;          // measurement period in force (or pending)
+    uint16_t    ratePendingMs;   // CFG-RATE to send on leaving backup, 0 = none
+
+    // Aiding / TTFF
+    GPSAidCache aidCache;
+    uint32_t    bootMillis;
+    uint32_t    ttffMs;
+    bool        warmStart;
+    uint32_t    nextAidSave;     // 0 = not scheduled (no fix yet)
+    bool        capturing;
+    uint32_t    captureStart;
+
+    // UBX frame parser (runs alongside TinyGPS on the same byte stream)
+    uint8_t     ubxState;
+    uint8_t     ubxClass, ubxId;
+    uint16_t    ubxLen, ubxPos;
+    uint8_t     ubxCkA, ubxCkB;
+    uint8_t     ubxBuf[GPS_UBX_MAX_PAYLOAD];
+
+    void sendUBX(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len);
+    void feedUBX(uint8_t c);
+    void injectAiding();
+    void maintainAidCache();
 };
 
 #endif // GPS_H
@@ -0,0 +1,112 @@
+/**
+ * @file GPSAidCache.h
+ * @brief Flash-persisted NEO-7m aiding data for faster time-to-first-fix
+ *
+ * The NEO-7m loses everything it knows on power-down, so every boot is a
+ * cold start.  This cache keeps, in a LittleFS file on the Pico W flash:
+ *   - the last good fix (lat/lon/alt + accuracy) and its UTC date/time
+ *   - the receiver's almanac   (UBX-AID-ALM, valid for weeks)
+ *   - the receiver's ephemeris (UBX-AID-EPH, valid for a few hours)
+ *   - the TTFF measured on the previous boot, for fleet comparison
+ *
+ * The GPS module fills it by polling AID-ALM/AID-EPH and feeding the
+ * responses to onUbx(), and replays it with UBX-AID-INI/ALM/EPH on boot.
+ *
+ * File layout: GPSAidHeader, then almCount × GPS_AID_ALM_LEN bytes, then
+ * ephCount × GPS_AID_EPH_LEN bytes.  header.crc covers the header fields
+ * before it and every record after it.
+ */
+
+#ifndef GPS_AID_CACHE_H
+#define GPS_AID_CACHE_H
+
+#include <Arduino.h>
+
+#define GPS_AID_FILE        "/gps_aid.bin"
+#define GPS_AID_MAGIC       0x44494142UL   // "BAID"
+#define GPS_AID_VERSION     2
+
+#define GPS_AID_MAX_SV      32
+#define GPS_AID_ALM_LEN     40    // AID-ALM payload with almanac words
+#define GPS_AID_EPH_LEN     104   // AID-EPH payload with subframes 1-3
+
+// UBX class/ids used for aiding
+#define UBX_CLASS_AID       0x0B
+#define UBX_ID_AID_INI      0x01
+#define UBX_ID_AID_ALM      0x30
+#define UBX_ID_AID_EPH      0x31
+
+struct GPSAidHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t  almCount;
+    uint8_t  ephCount;
+    int32_t  latE7;           // deg × 1e7 (UBX-AID-INI LLA units)
+    int32_t  lonE7;
+    int32_t  altCm;
+    uint32_t posAccCm;
+    uint16_t utcYear;         // 0 if no date was known
+    uint8_t  utcMonth, utcDay, utcHour, utcMinute, utcSecond;
+    uint8_t  lastStartWarm;   // 1 if lastTtffMs was measured after aiding
+    uint32_t lastTtffMs;      // 0 if the previous boot never got a fix
+    uint32_t crc;             // CRC-32 of the fields above + almanac + ephemeris
+};
+
+class GPSAidCache {
+public:
+    GPSAidCache();
+
+    /** Mount LittleFS (if needed) and read the cache file. */
+    bool load();
+
+    /** Write the cache file (header + records). */
+    bool save();
+
+    /** True once load() succeeded or a fix has been recorded. */
+    bool hasPosition() const { return header.posAccCm != 0; }
+
+    const GPSAidHeader& getHeader() const { return header; }
+
+    /** Record the latest fix and its UTC time. */
+    void setFix(double lat, double lon, double altM, uint32_t hdopX100,
+                uint16_t year, uint8_t month, uint8_t day,
+                uint8_t hour, uint8_t minute, uint8_t second);
+
+    /** Record the TTFF of the current boot so the next boot can report it. */
+    void setTTFF(uint32_t ttffMs, bool warm) {
+        header.lastTtffMs    = ttffMs;
+        header.lastStartWarm = warm ? 1 : 0;
+    }
+
+    /** Start collecting fresh AID-ALM/AID-EPH poll responses. */
+    void beginCapture();
+
+    /**
+     * Offer a received UBX frame.  AID-ALM/AID-EPH frames carrying data are
+     * stored (replacing older records for the same SV).
+     * @return true if the frame was consumed
+     */
+    bool onUbx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len);
+
+    /** Number of AID-ALM / AID-EPH poll responses seen since beginCapture(). */
+    uint8_t getResponsesSeen() const { return responsesSeen; }
+
+    uint8_t        getAlmanacCount()   const { return header.almCount; }
+    uint8_t        getEphemerisCount() const { return header.ephCount; }
+    const uint8_t* getAlmanac(uint8_t i)   const { return alm[i]; }
+    const uint8_t* getEphemeris(uint8_t i) const { return eph[i]; }
+
+private:
+    GPSAidHeader header;
+    uint8_t      alm[GPS_AID_MAX_SV][GPS_AID_ALM_LEN];
+    uint8_t      eph[GPS_AID_MAX_SV][GPS_AID_EPH_LEN];
+    uint8_t      responsesSeen;
+    bool         freshAlm;   // next ALM record replaces the stored set
+    bool         freshEph;
+
+    uint32_t fileCrc(const GPSAidHeader& h) const;
+    static void storeRecord(uint8_t* table, size_t stride, uint8_t& count,
+                            const uint8_t* payload);
+};
+
+#endif // GPS_AID_CACHE_H
@@ -0,0 +1,148 @@
+/**
+ * @file Geofence.h
+ * @brief Fixed-point geofence engine — circles and polygons in microdegrees
+ *
+ * Fences live in one flat array of compact structs with the bounding box
+ * first, so the per-fix scan is a linear walk that rejects almost every
+ * fence with four integer compares.  Only fences whose (margin-expanded)
+ * box contains the fix get the exact test:
+ *   circle   squared distance in mm vs radius²           (no sqrt)
+ *   polygon  crossing-number test on int64 cross products (no division)
+ *
+ * Enter/exit use hysteresis so GPS jitter along a boundary does not chatter:
+ *   - a fix must be GEOFENCE_MARGIN_MM past the boundary to count as "out"
+ *     once inside (entry is at the boundary itself), and
+ *   - the new side must be seen on `confirmFixes` consecutive fixes.
+ * Confirmed transitions are queued as GeofenceEvent for the caller.
+ */
+
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include <Arduino.h>
+
+#define GEOFENCE_MAX_FENCES     64
+#define GEOFENCE_MAX_VERTICES   512
+#define GEOFENCE_EVENT_QUEUE    16
+#define GEOFENCE_MARGIN_MM      10000   // exit hysteresis band (10 m)
+#define GEOFENCE_CONFIRM_FIXES  3
+#define GEOFENCE_CONFIRM_MAX    127     // Fence::pending is 7 bits
+
+enum FenceShape : uint8_t {
+    FENCE_CIRCLE  = 0,
+    FENCE_POLYGON = 1
+};
+
+enum GeofenceEventType : uint8_t {
+    GEOFENCE_ENTER = 0,
+    GEOFENCE_EXIT  = 1
+};
+
+struct GeofenceEvent {
+    uint16_t          fenceId;
+    GeofenceEventType type;
+    uint32_t          timestamp;
+    int32_t           latE6;
+    int32_t           lonE6;
+};
+
+/** One fence — 36 bytes, scan-order fields first. */
+struct Fence {
+    // Bounding box expanded by the exit margin (µdeg)
+    int32_t  minLat, maxLat;
+    int32_t  minLon, maxLon;
+
+    uint16_t id;
+    uint8_t  shape;           // FenceShape
+    uint8_t  inside  : 1;     // confirmed state
+    uint8_t  pending : 7;     // consecutive fixes disagreeing with `inside`
+
+    union {
+        struct {
+            int32_t  latE6;
+            int32_t  lonE6;
+            uint32_t radiusMm;
+        } circle;
+        struct {
+            uint16_t first;   // index into the vertex pool
+            uint16_t count;
+        } poly;
+    };
+    int16_t  cosQ15;          // cos(latitude) of the fence, for mm distances
+};
+
+class Geofence {
+public:
+    Geofence();
+
+    /** Remove all fences and pending events. */
+    void clear();
+
+    /**
+     * Add a circular fence.
+     * @return fence index, or -1 if the table is full
+     */
+    int addCircle(uint16_t id, int32_t latE6, int32_t lonE6, uint32_t radiusMm);
+
+    /**
+     * Add a polygon fence (vertices in order, not closed — the last vertex
+     * connects back to the first).
+     * @return fence index, or -1 if the table or vertex pool is full
+     */
+    int addPolygon(uint16_t id, const int32_t* latE6, const int32_t* lonE6, uint16_t count);
+
+    /**
+     * Set a fence's confirmed side from a known position without queuing an
+     * event — e.g. a fence dropped around the current fix starts "inside".
+     * Fences start "outside" otherwise.
+     */
+    void seed(int index, int32_t latE6, int32_t lonE6);
+
+    /**
+     * Hysteresis tuning.  `confirmFixes` is clamped to 1..GEOFENCE_CONFIRM_MAX,
+     * the most a fence's pending count can hold.
+     */
+    void setHysteresis(uint32_t marginMm, uint8_t confirmFixes);
+
+    /**
+     * Test a new fix against every fence and queue confirmed transitions.
+     * @return number of events queued by this call
+     */
+    uint8_t update(int32_t latE6, int32_t lonE6, uint32_t timestamp);
+
+    /** Pop the oldest pending event. */
+    bool pollEvent(GeofenceEvent& out);
+
+    uint8_t      getFenceCount() const { return fenceCount; }
+    const Fence& getFence(uint8_t index) const { return fences[index]; }
+
+    /** Cost of the last update(): wall time and how many fences needed the exact test. */
+    uint32_t getLastUpdateMicros() const { return lastUpdateUs; }
+    uint8_t  getLastExactTests()   const { return lastExactTests; }
+    uint32_t getDroppedEvents()    const { return droppedEvents; }
+
+private:
+    Fence    fences[GEOFENCE_MAX_FENCES];
+    int32_t  vertLat[GEOFENCE_MAX_VERTICES];
+    int32_t  vertLon[GEOFENCE_MAX_VERTICES];
+    uint8_t  fenceCount;
+    uint16_t vertexCount;
+
+    uint32_t marginMm;
+    uint8_t  confirmFixes;
+
+    GeofenceEvent events[GEOFENCE_EVENT_QUEUE];
+    uint8_t  evHead, evCount;
+    uint32_t droppedEvents;
+
+    uint32_t lastUpdateUs;
+    uint8_t  lastExactTests;
+
+    bool pointInPolygon(const Fence& f, int32_t latE6, int32_t lonE6) const;
+    bool withinMmOfEdge(const Fence& f, int32_t latE6, int32_t lonE6, uint32_t mm) const;
+    bool containsWithHysteresis(const Fence& f, int32_t latE6, int32_t lonE6) const;
+    void computeBox(Fence& f) const;
+    void pushEvent(const GeofenceEvent& ev);
+};
+
+#endif // GEOFENCE_H
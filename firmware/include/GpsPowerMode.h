@@ -0,0 +1,21 @@
+/**
+ * @file GpsPowerMode.h
+ * @brief NEO-7m power modes, shared by GPS and PowerManager
+ *
+ * Kept apart from GPS.h so that PowerManager (and its host tests) do not
+ * pull in TinyGPSPlus and the UART driver for one enum.
+ */
+
+#ifndef GPS_POWER_MODE_H
+#define GPS_POWER_MODE_H
+
+#include <stdint.h>
+
+/** Receiver power modes (UBX-CFG-RXM / UBX-RXM-PMREQ). */
+enum GpsPowerMode : uint8_t {
+    GPS_POWER_CONTINUOUS,   // full tracking, ~35 mA
+    GPS_POWER_SAVE,         // cyclic tracking at 1 Hz, ~11 mA once settled
+    GPS_POWER_BACKUP        // off except RTC/ephemerides; woken by UART activity
+};
+
+#endif // GPS_POWER_MODE_H
@@ -1,21 +1,50 @@
 /**
  * @file IMU.h
  * @brief IMU (Inertial Measurement Unit) module for B.R.A.V.O. beacon
- * 
+ *
  * This module handles accelerometer and gyroscope data from the MPU6050
  * for activity tracking and motion detection.
+ *
+ * Two ways to read it:
+ *   readSensor()  one getEvent() per call — a handful of small I2C
+ *                 transactions and float conversions, fine for a few Hz.
+ *   FIFO mode     beginFifo() lets the MPU6050 sample on its own clock
+ *                 (1 kHz / (1 + SMPLRT_DIV)) into its 1 KB FIFO; pollFifo()
+ *                 drains it in bursts of up to IMU_FIFO_BURST bytes and
+ *                 decodes raw int16 samples, each with a timestamp, into a
+ *                 ring buffer.  One poll every ~50 ms keeps up at 1 kHz.
+ *
+ * Wake-on-motion: enableMotionInterrupt() arms the MPU6050 motion detector
+ * (high-passed accel above a threshold for a minimum time) on its INT pin,
+ * wired to PIN_IMU_INT.  The ISR in main.cpp calls onMotionInterrupt();
+ * the INT_STATUS read in pollFifo() catches the same event when the pin is
+ * not wired.
  */
 
 #ifndef IMU_H
 #define IMU_H
 
 #include <Arduino.h>
+#include <Wire.h>
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
+#include "PinConfig.h"
 
-// IMU I2C pins for Heltec WiFi LoRa 32 V3
-#define IMU_SDA_PIN 41  // GPIO41 - I2C SDA
-#define IMU_SCL_PIN 42  // GPIO42 - I2C SCL
+// FIFO frame: accel XYZ then gyro XYZ, big-endian int16 (temperature not queued)
+#define IMU_FIFO_FRAME     12
+#define IMU_FIFO_SIZE      1024
+// Largest read that fits the Wire buffer in whole frames
+#define IMU_FIFO_BURST     ((WIRE_BUFFER_SIZE / IMU_FIFO_FRAME) * IMU_FIFO_FRAME)
+#define IMU_RING_SIZE      256    // samples; power of two
+#define IMU_FIFO_RATE_HZ   200
+
+// Wake-on-motion detector (MOT_THR: 2 mg/LSB, MOT_DUR: 1 ms/LSB)
+#define IMU_MOTION_THRESHOLD_MG  40
+#define IMU_MOTION_DURATION_MS   20
+
+// Raw scale at the ranges set by begin() (±8 g, ±500 °/s)
+#define IMU_ACCEL_LSB_PER_G       4096
+#define IMU_GYRO_LSB_PER_DPS_X10  655
 
 struct IMUData {
     float accelX;
@@ -28,6 +57,13 @@ struct IMUData {
     uint32_t timestamp;
 };
 
+/** One FIFO sample in sensor units (see IMU_ACCEL_LSB_PER_G / IMU_GYRO_LSB_PER_DPS_X10). */
+struct ImuSample {
+    uint32_t timestampUs;   // micros() at which the sample was taken
+    int16_t  accel[3];
+    int16_t  gyro[3];
+};
+
 class IMU {
 public:
     /**
@@ -47,6 +83,56 @@ public:
      */
     bool readSensor();
 
+    /**
+     * @brief Switch to FIFO sampling at `rateHz` (4–1000 Hz)
+     *
+     * Enables the 1 kHz internal rate, sets SMPLRT_DIV for the nearest
+     * achievable rate and queues accel + gyro.  Call after begin().
+     * @return true if the sensor acknowledged the configuration
+     */
+    bool beginFifo(uint16_t rateHz = IMU_FIFO_RATE_HZ);
+
+    /**
+     * @brief Drain the sensor FIFO into the sample ring; call every loop
+     *
+     * On a FIFO overflow the FIFO is reset (its contents are no longer
+     * frame-aligned) and the overflow counter incremented.
+     * @return number of samples added
+     */
+    size_t pollFifo();
+
+    /** Samples waiting in the ring buffer. */
+    size_t available() const { return (size_t)(ringHead - ringTail); }
+
+    /** Take the oldest buffered sample. */
+    bool popSample(ImuSample& out);
+
+    /**
+     * @brief Stop/restart queueing samples (e.g. while the unit sleeps)
+     *
+     * The sensor keeps running, so the motion detector stays armed.
+     */
+    void setFifoEnabled(bool enabled);
+
+    /** Arm the hardware motion detector on the INT pin. */
+    bool enableMotionInterrupt(uint16_t thresholdMg = IMU_MOTION_THRESHOLD_MG,
+                               uint8_t  durationMs  = IMU_MOTION_DURATION_MS);
+
+    /** Call from the PIN_IMU_INT rising-edge ISR. */
+    void onMotionInterrupt() { motionFlag = true; }
+
+    /** Motion detected since the last call (clears the flag). */
+    bool takeMotion();
+
+    bool     isFifoMode() const          { return fifoMode; }
+    uint16_t getSampleRateHz() const     { return sampleRateHz; }
+    uint32_t getFifoOverflows() const    { return fifoOverflows; }   // sensor FIFO filled up
+    uint32_t getRingOverflows() const    { return ringOverflows; }   // consumer fell behind
+    uint32_t getSampleCount() const      { return sampleCount; }
+    uint32_t getBurstCount() const       { return burstCount; }
+    uint32_t getLastPollMicros() const   { return lastPollMicros; }
+    uint32_t getMotionEvents() const     { return motionEvents; }
+
     /**
      * @brief Get acceleration values
      * @param x Reference to store X acceleration (m/s²)
@@ -92,6 +178,31 @@ private:
     Adafruit_MPU6050 mpu;
     IMUData currentData;
     bool initialized;
+
+    // FIFO mode
+    bool      fifoMode;
+    uint16_t  sampleRateHz;
+    uint32_t  samplePeriodUs;
+    uint32_t  nextSampleUs;      // timestamp the next decoded sample gets
+    bool      timeLocked;        // nextSampleUs follows a previous burst
+    ImuSample ring[IMU_RING_SIZE];
+    uint32_t  ringHead;          // free-running; index with & (IMU_RING_SIZE - 1)
+    uint32_t  ringTail;
+    uint32_t  fifoOverflows;
+    uint32_t  ringOverflows;
+    uint32_t  sampleCount;
+    uint32_t  burstCount;
+    uint32_t  lastPollMicros;
+
+    // Wake-on-motion
+    uint8_t   intEnable;         // INT_ENABLE shadow
+    volatile bool motionFlag;
+    uint32_t  motionEvents;
+
+    bool writeReg(uint8_t reg, uint8_t value);
+    bool readRegs(uint8_t reg, uint8_t* out, size_t len);
+    void resetFifo();
+    void pushSample(const uint8_t* frame, uint32_t timestampUs);
 };
 
 #endif // IMU_H
@@ -0,0 +1,83 @@
+/**
+ * @file JsonWriter.h
+ * @brief Streaming JSON serializer — no document tree, no heap
+ *
+ * Writes JSON tokens straight into a caller-provided char buffer or any
+ * Print (Serial, a LoRa/BLE adapter, a File).  Keys are precomputed
+ * literals that already include their quotes and colon, so emitting a key
+ * is one copy; numbers are written from integers (fixed-point for
+ * fractional values) without going through float formatting.
+ *
+ *   static constexpr JsonKey K_LAT = JSON_KEY("lat");
+ *   char buf[128];
+ *   JsonWriter w(buf, sizeof(buf));
+ *   w.beginObject();
+ *   w.addFixed(K_LAT, latE6, 6);
+ *   w.endObject();
+ *   if (!w.overflowed()) send(buf, w.length());
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+/** A key rendered as `"name":` — build with JSON_KEY("name"). */
+struct JsonKey {
+    const char* text;
+    uint8_t     len;
+};
+
+#define JSON_KEY(name) JsonKey{ "\"" name "\":", (uint8_t)(sizeof("\"" name "\":") - 1) }
+
+#define JSON_WRITER_MAX_DEPTH 8
+
+class JsonWriter {
+public:
+    /** Serialize into `buf` (always NUL-terminated if cap > 0). */
+    JsonWriter(char* buf, size_t cap);
+
+    /** Serialize into a Print sink. */
+    explicit JsonWriter(Print& out);
+
+    void beginObject();
+    void beginObject(const JsonKey& key);
+    void endObject();
+
+    void addInt(const JsonKey& key, int32_t value);
+    void addUInt(const JsonKey& key, uint32_t value);
+    void addBool(const JsonKey& key, bool value);
+    void addString(const JsonKey& key, const char* value);
+
+    /**
+     * `value` scaled by 10^decimals, e.g. addFixed(k, 37123456, 6) → 37.123456.
+     * Trailing zeros are dropped (1250, 3 → 1.25; 2000, 3 → 2) so numbers read
+     * as ArduinoJson wrote them.
+     */
+    void addFixed(const JsonKey& key, int32_t value, uint8_t decimals);
+
+    /** Rounds `value` to `decimals` (≤ 6) and writes it as fixed-point. */
+    void addFloat(const JsonKey& key, float value, uint8_t decimals);
+
+    /** Characters produced so far (including any that did not fit). */
+    size_t length() const { return len; }
+
+    /** True if a buffer sink ran out of room; the output is then incomplete. */
+    bool overflowed() const { return overflow; }
+
+private:
+    char*    buf;
+    size_t   cap;
+    Print*   out;
+    size_t   len;
+    bool     overflow;
+    uint8_t  depth;
+    uint16_t needComma;   // bit per nesting level
+
+    void put(const char* s, size_t n);
+    void put(char c) { put(&c, 1); }
+    void putKey(const JsonKey& key);
+    void putUInt(uint32_t v);
+};
+
+#endif // JSON_WRITER_H
@@ -11,6 +11,7 @@
  *   AT+NETWORKID=<n>                  set network ID    (0–9, 18)
  *   AT+BAND=<hz>                      carrier frequency in Hz
  *   AT+PARAMETER=<SF>,<BW>,<CR>,<PP>  RF parameters
+ *   AT+CRFOP=<dBm>                    output power (0–15)
  *   AT+SEND=<addr>,<len>,<payload>    transmit
  *   → incoming: +RCV=<addr>,<len>,<payload>,<RSSI>,<SNR>
  */
@@ -24,6 +25,25 @@
 // Maximum AT payload the RYLR896 can accept (bytes)
 #define RYLR_MAX_PAYLOAD 240
 
+// Binary frames travel as '~' + base64 so that no byte can be mistaken for
+// the CR/LF that terminates a +RCV line.  Raw bytes per packet:
+#define LORA_BINARY_MARKER '~'
+#define RYLR_MAX_BINARY    (((RYLR_MAX_PAYLOAD - 1) / 4) * 3)   // 177
+#define LORA_BINARY_TEXT_LEN(n) (1 + 4 * (((n) + 2) / 3))   // payload chars on air
+
+// First byte of every binary frame
+enum LoRaFrameType : uint8_t {
+    FRAME_TRACK            = 0x01,   // TrackLog compact upload: type, u16 src, u32 seq, track
+    FRAME_TELEMETRY        = 0x02,   // type, then one TelemetryCodec binary record
+    FRAME_TELEMETRY_STREAM = 0x03,   // type, then a TelemetryStream keyframe/delta
+    FRAME_TELEMETRY_RESYNC = 0x04,   // type, TelemetryType whose keyframe is wanted
+    FRAME_LOG_BATCH        = 0x05,   // type, u16 src, FlashLog records [type][len][data]...
+    FRAME_OTA_OFFER        = 0x06,   // LoRaOta image announcement (broadcast)
+    FRAME_OTA_BLOCK        = 0x07,   // LoRaOta image block (broadcast)
+    FRAME_OTA_POLL         = 0x08,   // LoRaOta end of round, NACKs wanted (broadcast)
+    FRAME_OTA_NACK         = 0x09,   // LoRaOta missing-block bitmap / status (to the relay)
+};
+
 struct LoRaPacket {
     uint16_t srcAddress;
     String   payload;
@@ -51,6 +71,39 @@ public:
      */
     bool sendMessage(uint16_t targetAddress, const String& message);
 
+    /**
+     * Send a binary frame (base64-wrapped, see LORA_BINARY_MARKER).
+     * @param len  At most RYLR_MAX_BINARY bytes
+     */
+    bool sendBinary(uint16_t targetAddress, const uint8_t* data, size_t len);
+
+    /** True if the payload carries a binary frame. */
+    static bool isBinary(const String& payload) {
+        return payload.length() > 0 && payload[0] == LORA_BINARY_MARKER;
+    }
+
+    /**
+     * Unwrap a binary frame payload.
+     * @return number of bytes written to `out`, or -1 if malformed/too large
+     */
+    static int decodeBinary(const String& payload, uint8_t* out, size_t cap);
+
+    /**
+     * Retune at runtime (DeviceConfig); each waits for the module's +OK.
+     * Every unit on the network has to use the same band and parameters;
+     * the address is per unit.
+     */
+    bool setAddress(uint16_t address);
+    bool setFrequency(uint32_t hz);
+    bool setRfParameters(uint8_t sf, uint8_t bw, uint8_t cr, uint8_t preamble);
+    bool setOutputPower(uint8_t dbm);
+
+    /**
+     * Time on air of a payload of `payloadLen` characters with the RF
+     * parameters in force (Semtech AN1200.13, explicit header, CRC on).
+     */
+    static uint32_t airtimeMs(size_t payloadLen);
+
     /**
      * Poll the UART receive buffer for an incoming +RCV packet.
      * Non-blocking; call every loop iteration.
@@ -63,11 +116,20 @@ public:
     int  getLastRSSI() const { return lastRSSI; }
     /** Last packet SNR  (dB)  */
     float getLastSNR()  const { return lastSNR;  }
-    /** Returns true if begin() succeeded */
-    bool isReady()      const { return initialized; }
+    /**
+     * Put the module in AT+MODE=1 sleep (no RX) / bring it back.
+     * While asleep isReady() is false, so callers skip TX and RX polling.
+     */
+    bool sleep();
+    bool wake();
+    bool isSleeping()   const { return sleeping; }
+
+    /** Returns true if begin() succeeded and the module is awake */
+    bool isReady()      const { return initialized && !sleeping; }
 
 private:
     bool     initialized;
+    bool     sleeping;
     int      lastRSSI;
     float    lastSNR;
     String   rxBuffer;
@@ -0,0 +1,324 @@
+/**
+ * @file LoRaOta.h
+ * @brief Chunked, resumable firmware distribution over LoRa
+ *
+ * A relay that holds an image (/ota.bin in LittleFS) multicasts it to every
+ * unit in range; each unit streams the blocks straight into an inactive
+ * image slot in raw flash and answers polls with what it is still missing.
+ *
+ * Frames (binary, broadcast to LORA_BROADCAST_ADDR unless noted):
+ *
+ *   FRAME_OTA_OFFER  u16 session, u32 size, u16 blocks, u32 version,
+ *                    sha256[32], mac[OTA_MAC_SIZE]     — image announcement
+ *   FRAME_OTA_BLOCK  u16 session, u16 index, u16 crc16, data[≤ OTA_BLOCK_SIZE]
+ *   FRAME_OTA_POLL   u16 session, u8 round, u8 slots, u16 slotMs
+ *   FRAME_OTA_NACK   u16 session, u8 flags, u16 have, u16 first,
+ *                    bitmap[≤ OTA_NACK_WINDOW_BYTES]   — unicast to the relay;
+ *                    bit j set = block first + j still missing
+ *
+ * One round = OFFER, every block anyone reported missing (all of them in
+ * the first round; the OFFER repeated every OTA_OFFER_EVERY blocks so a
+ * unit that missed it or came into range late joins mid-round), POLL.  Receivers answer a POLL in their own time slot
+ * (address % slots, each as long as a full NACK takes on air at the radio
+ * settings in force plus OTA_NACK_GUARD_MS), so NACKs from many units do
+ * not collide, and the next
+ * round resends the union of their gaps once for all of them.  The relay
+ * paces itself to OTA_AIRTIME_SHARE % of airtime.
+ *
+ * Slot layout (OTA_SLOT_SIZE bytes of raw flash, see PicoLogFlash):
+ *
+ *   sector 0, page 0   session header (OtaImageInfo + CRC-32) and a
+ *                      status byte whose OTA_FLAG_* bits are cleared one by one
+ *   sector 0, page 1+  image-sector-erased bitmap
+ *   sector 1           received-block bitmap
+ *   sector 2…          image
+ *
+ * NOR flash can clear bits without an erase, so a block is recorded by
+ * reprogramming its bitmap byte with one more 0 bit: no erase, no wear, and
+ * after a power loss begin() reloads the bitmap and the download resumes
+ * where it stopped.  Image sectors are erased lazily, right before the
+ * first block that lands in them (marked the same way).
+ *
+ * Once every block is in, the whole image is re-read and hashed (SHA-256,
+ * OTA_HASH_CHUNK bytes per service() call); a match marks the slot
+ * verified and install() stages it through OtaImageWriter for the
+ * arduino-pico OTA bootloader.
+ *
+ * Every unit on the network id could otherwise push a higher version to all
+ * of them, so an OFFER carries an HMAC-SHA256 (truncated to OTA_MAC_SIZE)
+ * of everything before it, under the network key in OTA_KEY_FILE.  The MAC
+ * binds version, size and SHA-256; the hash then binds every byte of the
+ * image.  A receiver drops an offer whose MAC does not match before it
+ * touches the slot, and a unit without a key neither sends nor accepts
+ * images.
+ *
+ * The payload may also be a DeltaPatch against the running image (made by
+ * tools/ota_delta.py), much smaller than the image when code only moved.
+ * Its header is in block 0: a unit running another build rejects the
+ * session as soon as that block lands, and install() rebuilds the full image from the
+ * running one and the patch while staging it.
+ */
+
+#ifndef LORA_OTA_H
+#define LORA_OTA_H
+
+#include <Arduino.h>
+#include "LogFlash.h"
+#include "Sha256.h"
+#include "OtaImageWriter.h"
+
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION 1            // set via build flags; offers ≤ this are ignored
+#endif
+
+#define LORA_BROADCAST_ADDR     0
+
+#define OTA_SLOT_SIZE           (512UL * 1024)
+#define OTA_BLOCK_SIZE          128                       // half a flash page
+#define OTA_IMAGE_OFFSET        (2UL * LOG_FLASH_SECTOR_SIZE)
+#define OTA_MAX_BLOCKS          ((OTA_SLOT_SIZE - OTA_IMAGE_OFFSET) / OTA_BLOCK_SIZE)   // 4032
+#define OTA_BITMAP_BYTES        ((OTA_MAX_BLOCKS + 7) / 8)
+#define OTA_OFFER_EVERY         32                        // blocks between repeated OFFERs
+#define OTA_NACK_WINDOW_BYTES   128                       // 1024 blocks per NACK
+#define OTA_NACK_SLOTS          8
+#define OTA_NACK_GUARD_MS       300                       // NACK slot beyond its airtime
+#define OTA_AIRTIME_SHARE       30                        // % the relay may use
+#define OTA_REOFFER_MS          600000UL                  // late joiners, after a finished session
+#define OTA_HASH_CHUNK          4096
+#define OTA_MAX_RECEIVERS       16
+#define OTA_FILE                "/ota.bin"
+#define OTA_VERSION_FILE        "/ota.ver"
+#define OTA_KEY_FILE            "/ota.key"                // network key, raw bytes
+#define OTA_KEY_MIN             16
+#define OTA_KEY_MAX             64
+#define OTA_MAC_SIZE            16                        // truncated HMAC-SHA256
+
+// Slot status / NACK flags — bits are cleared in flash, set on air
+#define OTA_FLAG_COMPLETE       0x01
+#define OTA_FLAG_VERIFIED       0x02
+#define OTA_FLAG_BAD_HASH       0x04
+#define OTA_FLAG_INSTALLED      0x08
+#define OTA_FLAG_WRONG_BASE     0x10      // a patch made against another build
+
+#define OTA_OFFER_LEN           (1 + 2 + 4 + 2 + 4 + SHA256_DIGEST_SIZE + OTA_MAC_SIZE)
+#define OTA_BLOCK_HEADER        7
+#define OTA_POLL_LEN            7
+#define OTA_NACK_HEADER         8
+
+struct OtaImageInfo {
+    uint16_t session;                       // first two bytes of the hash
+    uint32_t size;
+    uint16_t blocks;
+    uint32_t version;
+    uint8_t  sha256[SHA256_DIGEST_SIZE];
+};
+
+enum OtaState : uint8_t {
+    OTA_IDLE,          // no session in the slot
+    OTA_RECEIVING,
+    OTA_VERIFYING,     // all blocks in, hashing the slot
+    OTA_READY,         // verified, waiting for install()
+    OTA_FAILED,        // hash mismatch — waits for a new offer
+    OTA_INSTALLED,     // this image was handed to the bootloader
+    OTA_REJECTED       // a patch for another build — waits for a new offer
+};
+
+struct OtaReceiverStats {
+    uint32_t badOffers;       // MAC mismatch
+    uint32_t blocksWritten;
+    uint32_t duplicates;
+    uint32_t crcErrors;       // block CRC or read-back mismatch
+    uint32_t sectorsErased;
+    uint32_t nacksSent;
+    uint32_t resumedBlocks;   // found in the bitmap at begin()
+    uint32_t hashMs;          // wall time of the verification pass
+};
+
+/** Network key shared by every unit that may send or install images. */
+class OtaKey {
+public:
+    /** Read OTA_KEY_MIN…OTA_KEY_MAX raw bytes; false leaves the key unset. */
+    bool load(const char* path = OTA_KEY_FILE);
+    bool isSet() const { return len != 0; }
+
+    /** The OFFER MAC over `data`. */
+    void mac(const uint8_t* data, size_t dataLen, uint8_t out[OTA_MAC_SIZE]) const;
+    /** Constant-time check of `expected` against mac(data). */
+    bool verify(const uint8_t* data, size_t dataLen, const uint8_t* expected) const;
+
+private:
+    uint8_t bytes[OTA_KEY_MAX];
+    uint8_t len = 0;
+};
+
+// ── Receiver (every unit) ────────────────────────────────────────────────────
+
+class OtaReceiver {
+public:
+    OtaReceiver();
+
+    /**
+     * Attach the slot and resume whatever session it holds.
+     * @param ownAddress  picks this unit's NACK slot
+     * @param key         authenticates offers; must be set and outlive us
+     */
+    bool begin(LogFlash& slot, uint16_t ownAddress, const OtaKey& key);
+
+    /** This unit's address changed at runtime (DeviceConfig). */
+    void setAddress(uint16_t ownAddress)  { address = ownAddress; }
+
+    /**
+     * Handle an OTA frame (any FRAME_OTA_* type, starting at the type byte).
+     * @return true if the frame belonged to OTA
+     */
+    bool onFrame(uint16_t src, const uint8_t* frame, size_t len, uint32_t now);
+
+    /** Hash pass while VERIFYING; call every loop. */
+    void service(uint32_t now);
+
+    /** A NACK/status report is due (our POLL slot came, or the state changed). */
+    bool nackDue(uint32_t now) const { return nackAt != 0 && (int32_t)(now - nackAt) >= 0; }
+    /** Fill a FRAME_OTA_NACK; send it unicast to getRelay(). */
+    size_t buildNack(uint8_t* out, size_t cap);
+    void   onNackSent() { nackAt = 0; stats.nacksSent++; }
+
+    /**
+     * Stage the verified image (or the image a verified patch rebuilds)
+     * through `writer` for the arduino-pico OTA bootloader.  Reboots on
+     * success; returns false otherwise.
+     */
+    bool install(OtaImageWriter& writer);
+
+    OtaState getState() const             { return state; }
+    const OtaImageInfo& getImage() const  { return image; }
+    uint16_t getRelay() const             { return relay; }
+    uint16_t getReceivedBlocks() const    { return have; }
+    const OtaReceiverStats& getStats() const { return stats; }
+    static const char* stateName(OtaState s);
+
+private:
+    LogFlash*        flash;
+    const OtaKey*    key;
+    uint16_t         address;
+    OtaState         state;
+    OtaImageInfo     image;
+    uint16_t         relay;
+    uint16_t         have;
+    uint8_t          flags;          // OTA_FLAG_* as they would go on air
+    uint8_t          received[OTA_BITMAP_BYTES];
+    uint8_t          erased[OTA_SLOT_SIZE / LOG_FLASH_SECTOR_SIZE / 8];   // image sectors
+    uint32_t         nackAt;         // 0 = none due
+    Sha256           hasher;
+    uint32_t         hashPos;
+    uint32_t         hashStart;
+    OtaReceiverStats stats;
+
+    bool startSession(const OtaImageInfo& info);
+    bool loadSession();
+    bool writeBlock(uint16_t index, const uint8_t* data, size_t len);
+    void clearBit(uint32_t offset, uint8_t bit);
+    void setFlag(uint8_t flag);
+    void checkBase(const uint8_t* block, size_t len, uint32_t now);
+    bool isReceived(uint16_t i) const { return received[i >> 3] & (1 << (i & 7)); }
+};
+
+// ── Sender (relay) ───────────────────────────────────────────────────────────
+
+/** Random-access image the sender reads blocks from. */
+class OtaSource {
+public:
+    virtual ~OtaSource() {}
+    virtual uint32_t size() const = 0;
+    virtual bool read(uint32_t offset, uint8_t* out, size_t len) = 0;
+};
+
+/** OTA_FILE in LittleFS, with its version from OTA_VERSION_FILE (decimal). */
+class FileOtaSource : public OtaSource {
+public:
+    bool     open(const char* path = OTA_FILE);
+    uint32_t size() const override { return fileSize; }
+    bool     read(uint32_t offset, uint8_t* out, size_t len) override;
+    /** 0 if the version file is missing; such an image is not offered. */
+    uint32_t getVersion() const { return version; }
+private:
+    String   path;
+    uint32_t fileSize = 0;
+    uint32_t version  = 0;
+};
+
+struct OtaReceiverStatus {
+    uint16_t address;
+    uint8_t  flags;
+    uint16_t have;
+    uint32_t lastHeard;
+};
+
+struct OtaSenderStats {
+    uint32_t rounds;
+    uint32_t blocksSent;
+    uint32_t framesSent;
+    uint32_t nacksHeard;
+    uint32_t airtimeMs;
+};
+
+class OtaSender {
+public:
+    OtaSender();
+
+    /**
+     * Hash the image (blocking, one pass), sign the offer with `key` and
+     * prepare the session.  Refuses without a key or a version (receivers
+     * ignore version 0).
+     */
+    bool begin(OtaSource& src, uint32_t version, const OtaKey& key);
+
+    /**
+     * Next frame to broadcast, if the pacing allows one now.
+     * @return frame length (0 = nothing to send yet)
+     */
+    size_t nextFrame(uint8_t* out, size_t cap, uint32_t now);
+
+    /** The frame from nextFrame() went out, taking `airtimeMs`. */
+    void onSent(uint32_t airtimeMs, uint32_t now);
+
+    /** A FRAME_OTA_NACK arrived from `src`. */
+    void onNack(uint16_t src, const uint8_t* frame, size_t len, uint32_t now);
+
+    bool isActive() const  { return src != nullptr; }
+    bool isDone() const    { return phase == PHASE_DONE; }
+    const OtaImageInfo& getImage() const { return image; }
+    const OtaSenderStats& getStats() const { return stats; }
+    uint8_t getReceiverCount() const { return receiverCount; }
+    const OtaReceiverStatus& getReceiver(uint8_t i) const { return receivers[i]; }
+    /** Receivers whose last report said verified or installed. */
+    uint8_t getVerifiedCount() const;
+
+    /** One POLL answer slot: a full NACK's airtime now, plus a guard. */
+    static uint16_t nackSlotMs();
+
+private:
+    enum Phase : uint8_t { PHASE_OFFER, PHASE_BLOCKS, PHASE_POLL, PHASE_COLLECT, PHASE_DONE };
+
+    OtaSource*        src;
+    OtaImageInfo      image;
+    uint8_t           offerMac[OTA_MAC_SIZE];
+    Phase             phase;
+    uint8_t           round;
+    uint16_t          cursor;         // next block to consider in PHASE_BLOCKS
+    uint8_t           sinceOffer;     // blocks sent since the last OFFER
+    uint8_t           pending[OTA_BITMAP_BYTES];   // blocks to (re)send this round
+    uint8_t           missing[OTA_BITMAP_BYTES];   // union of NACKs for the next round
+    bool              resendAll;      // a receiver failed the hash: start over
+    uint32_t          nextTxAt;
+    uint32_t          collectUntil;
+    uint16_t          slotMs;         // NACK slot announced by the last POLL
+    uint32_t          doneAt;
+    OtaReceiverStatus receivers[OTA_MAX_RECEIVERS];
+    uint8_t           receiverCount;
+    OtaSenderStats    stats;
+
+    void startRound(bool all);
+    void buildOffer(uint8_t* out) const;   // all but the MAC
+};
+
+#endif // LORA_OTA_H
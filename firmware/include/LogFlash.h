@@ -0,0 +1,114 @@
+/**
+ * @file LogFlash.h
+ * @brief Raw NOR flash region used by FlashLog, on the Pico or simulated
+ *
+ * LogFlash is the three operations FlashLog needs — erase a 4 KB sector,
+ * program whole 256-byte pages, read anything — over a region addressed
+ * from 0.  Two implementations:
+ *
+ *   PicoLogFlash  a region of the Pico W's QSPI flash below the LittleFS
+ *                 partition (FLASH_LOG_SIZE bytes right under it for the
+ *                 log, the OTA image slot further down).  Erase/program run
+ *                 with interrupts off (XIP is suspended meanwhile); a sector
+ *                 erase blocks for ~45 ms, a page program for ~0.5 ms.
+ *   SimLogFlash   a RAM buffer with NOR semantics (program can only clear
+ *                 bits) that counts operations, per-sector erases and the
+ *                 busy time real flash would have taken, so write
+ *                 throughput and wear can be measured on a host.
+ */
+
+#ifndef LOG_FLASH_H
+#define LOG_FLASH_H
+
+#include <Arduino.h>
+
+#define LOG_FLASH_SECTOR_SIZE  4096
+#define LOG_FLASH_PAGE_SIZE    256
+#define FLASH_LOG_SIZE         (256UL * 1024)   // Pico region: 64 sectors
+
+// Typical W25Q16 timings, used by SimLogFlash
+#define LOG_FLASH_ERASE_US     45000
+#define LOG_FLASH_PROGRAM_US   700
+
+#define SIM_LOG_FLASH_MAX_SECTORS 256
+
+class LogFlash {
+public:
+    virtual ~LogFlash() {}
+
+    /** Region size in bytes (a whole number of sectors). */
+    virtual uint32_t size() const = 0;
+
+    /** Erase the sector starting at `offset` (sector-aligned) to 0xFF. */
+    virtual bool eraseSector(uint32_t offset) = 0;
+
+    /** Program one page at `offset` (page-aligned) from `data[LOG_FLASH_PAGE_SIZE]`. */
+    virtual bool programPage(uint32_t offset, const uint8_t* data) = 0;
+
+    virtual void read(uint32_t offset, uint8_t* out, size_t len) = 0;
+};
+
+class PicoLogFlash : public LogFlash {
+public:
+    /**
+     * @param regionSize  bytes (whole sectors)
+     * @param gapBelowFs  bytes between the end of the region and LittleFS
+     */
+    explicit PicoLogFlash(uint32_t regionSize = FLASH_LOG_SIZE, uint32_t gapBelowFs = 0);
+
+    /** Locate the region; false if it would overlap the firmware image. */
+    bool begin();
+
+    uint32_t size() const override { return regionSize; }
+    bool     eraseSector(uint32_t offset) override;
+    bool     programPage(uint32_t offset, const uint8_t* data) override;
+    void     read(uint32_t offset, uint8_t* out, size_t len) override;
+
+private:
+    uint32_t base;         // offset of the region in flash
+    uint32_t regionSize;   // 0 until begin() succeeds
+    uint32_t wantSize;
+    uint32_t gapBelowFs;
+};
+
+class SimLogFlash : public LogFlash {
+public:
+    /** Simulate flash on `mem` (size a multiple of the sector size). */
+    SimLogFlash(uint8_t* mem, uint32_t size);
+
+    uint32_t size() const override { return memSize; }
+    bool     eraseSector(uint32_t offset) override;
+    bool     programPage(uint32_t offset, const uint8_t* data) override;
+    void     read(uint32_t offset, uint8_t* out, size_t len) override;
+
+    /**
+     * Power cut: after `pages` more page programs the next one only
+     * half-lands and the flash ignores everything after it.
+     */
+    void tearAfter(uint32_t pages) { tearBudget = pages; tearArmed = true; }
+
+    /** Power back: operations land again (contents are left as they are). */
+    void powerOn() { tearArmed = false; }
+
+    uint32_t getErases()    const { return erases; }
+    uint32_t getPrograms()  const { return programs; }
+    uint32_t getBusyUs()    const { return busyUs; }   // time real flash would have blocked
+    /** A program tried to set a 0 bit back to 1 (needs an erase first). */
+    uint32_t getViolations() const { return violations; }
+    uint32_t getSectorErases(uint16_t sector) const { return sectorErases[sector]; }
+    uint32_t getMaxSectorErases() const;
+    uint32_t getMinSectorErases() const;
+
+private:
+    uint8_t* mem;
+    uint32_t memSize;
+    uint32_t erases;
+    uint32_t programs;
+    uint32_t busyUs;
+    uint32_t violations;
+    uint32_t tearBudget;
+    bool     tearArmed;
+    uint32_t sectorErases[SIM_LOG_FLASH_MAX_SECTORS];
+};
+
+#endif // LOG_FLASH_H
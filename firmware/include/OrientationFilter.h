@@ -0,0 +1,100 @@
+/**
+ * @file OrientationFilter.h
+ * @brief Fixed-point Mahony attitude filter over the IMU FIFO sample stream
+ *
+ * Per sample (raw int16 from IMU FIFO mode, at the FIFO's fixed rate):
+ *
+ *   1. Accel normalised with FixedMath::rsqrtQ31 (no sqrt, no divide) —
+ *      skipped when |a| is outside ORIENT_ACCEL_GATE_* (the collar is
+ *      accelerating, so the vector is not gravity).
+ *   2. Error e = a × v, v = gravity direction predicted by q.
+ *   3. Corrected rate ω + Kp·e + Ki·∫e (the integral is the gyro bias).
+ *   4. q += ½ q ⊗ (0, ω·dt), then renormalised with one Newton step
+ *      (q stays within ~1e-6 of unit length, so no table is needed).
+ *
+ * The quaternion is Q30 and every product goes through int64, so the
+ * Cortex-M0+ needs no float at all; gains and the gyro scale are folded
+ * into per-sample Q30 coefficients once in begin().
+ *
+ * The MPU6050 has no magnetometer: roll and pitch are gravity-referenced,
+ * yaw is integrated gyro and drifts slowly.  setHeading() re-aligns it
+ * from an external reference (e.g. a GPS course while walking straight).
+ *
+ * Sensor frame: MPU6050 axes, z up when lying flat.  Angles are BAM
+ * (FixedMath conventions); heading is clockwise from the reference like a
+ * compass, i.e. minus the right-handed yaw about z.
+ */
+
+#ifndef ORIENTATION_FILTER_H
+#define ORIENTATION_FILTER_H
+
+#include <Arduino.h>
+#include "IMU.h"
+
+#define ORIENT_KP_X1000          1000   // proportional gain (rad/s per unit error)
+#define ORIENT_KI_X1000          100    // integral gain (gyro bias tracking)
+#define ORIENT_ACCEL_GATE_LO_MG  750    // trust accel only inside this band
+#define ORIENT_ACCEL_GATE_HI_MG  1250
+
+#define ORIENT_Q30_ONE           (1L << 30)
+
+/** Unit quaternion, Q30 (1073741824 = 1.0). */
+struct QuatQ30 {
+    int32_t w, x, y, z;
+};
+
+/** Euler angles (ZYX: yaw, then pitch, then roll), BAM. */
+struct EulerBam {
+    int16_t  roll;      // about x, ±32768 = ±180°
+    int16_t  pitch;     // about y, ±16384 = ±90°
+    uint16_t heading;   // clockwise about z from the heading reference
+};
+
+class OrientationFilter {
+public:
+    OrientationFilter();
+
+    /** Set the sample rate (the IMU's achieved FIFO rate) and reset. */
+    void begin(uint16_t rateHz = IMU_FIFO_RATE_HZ);
+
+    /** Level, heading 0, bias forgotten; re-seeds from the next sample. */
+    void reset();
+
+    /** Feed one FIFO sample. */
+    void update(const ImuSample& s);
+
+    const QuatQ30& getQuaternion() const { return q; }
+    EulerBam getEuler() const;
+
+    /** Re-align yaw so the current heading reads `headingBam`. */
+    void setHeading(uint16_t headingBam);
+
+    uint32_t getUpdateCount() const     { return updates; }
+    uint32_t getAccelRejected() const   { return accelRejected; }   // gated samples
+    uint32_t getLastUpdateCycles() const { return lastCycles; }
+    uint32_t getMaxUpdateCycles() const  { return maxCycles; }
+
+    /**
+     * Time `n` updates of a scratch filter on a synthetic rotating sample.
+     * @return mean cycles per update on this core
+     */
+    static uint32_t benchmark(uint16_t n = 1000);
+
+private:
+    QuatQ30  q;
+    int64_t  biasQ46[3];        // ∫ Ki·e, half-angle per sample, Q46
+    int32_t  gyroHalfQ30;       // raw gyro LSB → half-angle per sample
+    int32_t  kpHalfQ30;         // Kp·dt/2
+    int64_t  kiHalfQ46;         // Ki·dt²/2
+    uint16_t headingOffset;     // heading = offset − yaw
+    bool     seeded;
+    uint32_t updates;
+    uint32_t accelRejected;
+    uint32_t lastCycles;
+    uint32_t maxCycles;
+
+    void seed(const int32_t a[3]);
+    void normalise();
+};
+
+#endif // ORIENTATION_FILTER_H
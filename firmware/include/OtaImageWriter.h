@@ -0,0 +1,104 @@
+/**
+ * @file OtaImageWriter.h
+ * @brief Block-buffered, hash-checked staging of a firmware image
+ *
+ * Whatever brings the image in (a LoRaOta slot, a DeltaPatch rebuilding
+ * one, a network stream) writes it here in pieces of any size.  Bytes are
+ * hashed (SHA-256) as they arrive, if the caller has a digest, and
+ * collected in an OTA_WRITER_BUFFER buffer that goes to LittleFS as one
+ * block-aligned write when full.  There is no second buffer to fill
+ * meanwhile: programming the RP2040's flash stalls execute-in-place on
+ * both cores, so nothing could run during the write anyway.
+ *
+ * The image goes to OTA_WRITER_TEMP.  commit() checks size and hash, then
+ * renames it over OTA_WRITER_FILE (atomic in LittleFS) and queues it for
+ * the arduino-pico OTA bootloader, which flashes it on the next reboot;
+ * any failure, or abort(), removes the temporary file and leaves the
+ * running firmware and a previously staged image untouched.
+ */
+
+#ifndef OTA_IMAGE_WRITER_H
+#define OTA_IMAGE_WRITER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "Sha256.h"
+
+#define OTA_WRITER_BUFFER   4096              // one LittleFS block per write
+#define OTA_WRITER_TEMP     "/firmware.tmp"
+#define OTA_WRITER_FILE     "/firmware.bin"
+
+enum OtaWriterResult : uint8_t {
+    OTA_WRITE_OK,
+    OTA_WRITE_NOT_OPEN,
+    OTA_WRITE_NO_SPACE,
+    OTA_WRITE_IO_ERROR,
+    OTA_WRITE_SIZE_MISMATCH,
+    OTA_WRITE_BAD_HASH,
+    OTA_WRITE_BOOTLOADER       // the OTA bootloader refused the file
+};
+
+/** Where the time went, begin() to commit(). */
+struct OtaWriterTiming {
+    uint32_t totalMs;
+    uint32_t hashUs;          // SHA-256 of incoming bytes
+    uint32_t flashUs;         // buffer writes to LittleFS (erase + program)
+    uint32_t commitUs;        // last flush, rename, bootloader hand-off
+};
+
+class OtaImageWriter : public Print {
+public:
+    OtaImageWriter();
+
+    /**
+     * Start a new image.
+     * @param size    exact image size
+     * @param sha256  expected digest, or nullptr if the caller verifies
+     *                the content itself (e.g. DeltaPatcher)
+     */
+    bool begin(uint32_t size, const uint8_t* sha256 = nullptr);
+
+    /** Take image bytes; returns 0 once an error is latched. */
+    size_t write(const uint8_t* data, size_t len) override;
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    using Print::write;
+
+    /** Read whatever `in` has available straight into the buffer. */
+    size_t feed(Stream& in);
+
+    /** Finish, verify and hand over to the bootloader (blocking). */
+    OtaWriterResult commit();
+
+    /** Drop the image; the staged file is removed. */
+    void abort();
+
+    bool     isOpen() const      { return open; }
+    uint32_t getWritten() const  { return received; }
+    uint32_t getSize() const     { return size; }
+    /** 0–100; safe for any size, including 0. */
+    uint8_t  getProgress() const;
+    OtaWriterResult getError() const         { return error; }
+    const OtaWriterTiming& getTiming() const { return timing; }
+
+    static const char* resultName(OtaWriterResult r);
+
+private:
+    File            file;
+    bool            open;
+    bool            checkHash;
+    uint8_t         expected[SHA256_DIGEST_SIZE];
+    Sha256          hasher;
+    uint32_t        size;
+    uint32_t        received;
+    uint8_t         buf[OTA_WRITER_BUFFER];
+    uint16_t        fillLen;
+    OtaWriterResult error;
+    uint32_t        startMs;
+    OtaWriterTiming timing;
+
+    bool writeBuffer();
+    void take(size_t n);
+    OtaWriterResult fail(OtaWriterResult r);
+};
+
+#endif // OTA_IMAGE_WRITER_H
@@ -0,0 +1,111 @@
+/**
+ * @file PeerTable.h
+ * @brief Last known position and link stats of every unit heard over LoRa
+ *
+ * Heartbeats ("ADDR|lat|lon|sats|speed|course") are parsed in place — no
+ * String splitting — into the same TxSnapshot the sender's TxPolicy keeps,
+ * so estimate() can dead-reckon a peer with TxPolicy::extrapolate() exactly
+ * as the sender assumes its receivers do.  Any other packet only refreshes
+ * the peer's last-heard time and link quality.
+ *
+ * Every packet also appends an RSSI/SNR sample to the peer's fixed-size
+ * link history ring.  Samples carry a running sequence number so a viewer
+ * can fetch just the ones it has not drawn yet.
+ *
+ * The table is a small fixed array; when it is full the peer heard least
+ * recently is replaced.
+ */
+
+#ifndef PEER_TABLE_H
+#define PEER_TABLE_H
+
+#include <Arduino.h>
+#include "TxPolicy.h"
+
+#define PEER_MAX            16
+#define PEER_EXPIRE_MS      1800000UL   // forget a peer after 30 min of silence
+#define PEER_EXTRAPOLATE_MS 120000UL    // stop dead-reckoning a stale heartbeat
+#define PEER_LINK_HISTORY   64          // link samples kept per peer
+
+/** Per-packet RSSI/SNR ring; int8 keeps 16 peers × 64 samples in 2 KB. */
+struct LinkHistory {
+    int8_t   rssi[PEER_LINK_HISTORY];    // dBm
+    int8_t   snrX4[PEER_LINK_HISTORY];   // 0.25 dB
+    uint8_t  head;                       // next write slot
+    uint8_t  count;
+    uint32_t seq;                        // samples ever added
+    int32_t  rssiSum;                    // over the samples held
+    int32_t  snrX4Sum;
+};
+
+struct LinkStats {
+    uint8_t samples;
+    int16_t minRssi,  avgRssi,  maxRssi;
+    int16_t minSnrX4, avgSnrX4, maxSnrX4;
+};
+
+struct PeerInfo {
+    uint16_t   addr;
+    bool       used;
+    bool       hasPosition;   // at least one heartbeat with a position
+    TxSnapshot pos;           // as received; sentAt = receive time (millis)
+    uint8_t    satellites;
+    uint32_t   lastHeard;     // any packet
+    uint32_t   packets;
+    int16_t    rssi;          // last packet
+    int16_t    snrX10;
+    LinkHistory link;
+};
+
+class PeerTable {
+public:
+    PeerTable();
+
+    void clear();
+
+    /**
+     * Record any packet from `addr`.  If `payload` is a position heartbeat
+     * the peer's position is updated too.
+     * @return index of the peer entry
+     */
+    uint8_t onPacket(uint16_t addr, const char* payload,
+                     int rssi, float snr, uint32_t now);
+
+    /** Drop peers silent for longer than PEER_EXPIRE_MS. */
+    void expire(uint32_t now);
+
+    /**
+     * Best position of peer `index` at `now`: the heartbeat position
+     * dead-reckoned by speed/course for up to PEER_EXTRAPOLATE_MS.
+     */
+    bool estimate(uint8_t index, uint32_t now, int32_t& latE6, int32_t& lonE6) const;
+
+    /**
+     * Link sample number `seq` of peer `index` (seq < link.seq).
+     * @return false if it has already been overwritten
+     */
+    bool getLinkSample(uint8_t index, uint32_t seq, int8_t& rssi, int8_t& snrX4) const;
+
+    /** Min/avg/max over the link samples currently held for peer `index`. */
+    LinkStats getLinkStats(uint8_t index) const;
+
+    /** Index of the peer heard most recently, or -1 if the table is empty. */
+    int8_t mostRecent() const;
+
+    uint8_t         capacity() const { return PEER_MAX; }
+    uint8_t         count() const;
+    const PeerInfo& get(uint8_t index) const { return peers[index]; }
+
+    /**
+     * Parse a heartbeat payload.
+     * @return false if `payload` is not a well-formed position heartbeat
+     */
+    static bool parseHeartbeat(const char* payload, TxSnapshot& out, uint8_t& sats);
+
+private:
+    PeerInfo peers[PEER_MAX];
+
+    uint8_t slotFor(uint16_t addr);
+};
+
+#endif // PEER_TABLE_H
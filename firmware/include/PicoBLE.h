@@ -0,0 +1,138 @@
+/**
+ * @file PicoBLE.h
+ * @brief BLE GATT service on the Pico W's CYW43 radio (BTstack)
+ *
+ * The Pico W side of BLEConfig, which is written for NimBLE on the ESP32
+ * and not built here.  It offers the same service, characteristics and
+ * commands (BLEProtocol.h), so one phone app talks to either:
+ *
+ *   CONFIG   read/write  DeviceConfig wire record; a write is applied and
+ *                        saved, and CONFIG then reads back what is in force
+ *   STATUS   read/notify "cfg ok: ..." after each apply, command replies
+ *   COMMAND  write       DEFAULTS (addresses kept) / DUMP / REPORT
+ *   STREAM   notify      BLEStream dumps of the neighbour table and track;
+ *                        subscribing starts one
+ *
+ * BTstack runs in the background on arduino-pico's async context.  Its
+ * callbacks only post events here (connection, MTU, subscriptions, writes,
+ * packets completed); update() takes them with the BTstack lock held, so
+ * the stream and the tables it reads are only touched by the loop.  A
+ * CONFIG write is applied after the lock is released again: it waits on
+ * AT round trips and a flash write.
+ *
+ * Flow control is tied to the controller, not to the host queue.  A
+ * notification is handed to BTstack only when att_server_can_send_packet_now()
+ * says the controller has an ACL buffer for it, and its BLEStream credit
+ * comes back when the controller reports the packet sent (HCI Number Of
+ * Completed Packets for the connection, counted in ACL fragments of
+ * hci_max_acl_le_data_packet_length()).  ATT responses complete on the same
+ * connection; the few during a dump only return a credit early, and the
+ * buffer check still holds the next notification back.
+ *
+ * Needs -D PIO_FRAMEWORK_ARDUINO_ENABLE_BLUETOOTH (platformio.ini); without
+ * it begin() returns false and the rest does nothing.
+ */
+
+#ifndef PICO_BLE_H
+#define PICO_BLE_H
+
+#include <Arduino.h>
+#include "BLEProtocol.h"
+#include "BLEStream.h"
+#include "DeviceConfig.h"
+
+#define PICO_BLE_ADV_INTERVAL   800     // 500 ms, units of 0.625 ms
+#define PICO_BLE_STATUS_MAX     96      // STATUS text, bytes
+
+class PicoBLE {
+public:
+    PicoBLE();
+
+    /**
+     * Build the GATT database, start BTstack and advertise.
+     * @param deviceName  sent in the scan response
+     */
+    bool begin(const char* deviceName);
+
+    /** Apply posted events and writes, move the stream along; call every loop. */
+    void update();
+
+    bool isConnected() const { return conn != PICO_BLE_NO_CONN; }
+
+    /** Settings read and written through CONFIG; set before begin(). */
+    void setDeviceConfig(DeviceConfig* cfg) { deviceConfig = cfg; }
+
+    /** Tables streamed on STREAM; a dump starts whenever a client subscribes. */
+    void setStreamSources(const PeerTable* peers, const TrackLog* track);
+
+    /** Queue a dump of the neighbour table and track backlog now. */
+    void startDump();
+
+    /** Set STATUS and notify it to a subscribed client. */
+    void sendStatus(const String& status);
+
+    const BLEStream& getStream() const { return stream; }
+
+private:
+    static const uint16_t PICO_BLE_NO_CONN = 0xFFFF;
+
+    bool             initialized;
+    uint16_t         conn;             // HCI connection handle, loop's copy
+    uint16_t         attMtu;
+    uint16_t         configHandle;     // value handles; a notify CCCD follows its value
+    uint16_t         statusHandle;
+    uint16_t         commandHandle;
+    uint16_t         streamHandle;
+    DeviceConfig*    deviceConfig;
+    BLEStream        stream;
+    const PeerTable* peerSource;
+    const TrackLog*  trackSource;
+    bool             dumpReported;
+
+    // One entry per ACL packet train handed to the controller, oldest first
+    uint8_t          sentFrags[BLE_STREAM_IN_FLIGHT];
+    uint8_t          sentHead;
+    uint8_t          sentCount;
+    uint16_t         fragsDone;        // completed, not yet matched to a notification
+
+    // CONFIG and STATUS as the client reads them; written by the loop
+    // with the lock held
+    uint8_t          configValue[CONFIG_WIRE_LEN];
+    uint8_t          configLen;
+    char             statusValue[PICO_BLE_STATUS_MAX];
+    uint8_t          statusLen;
+    bool             statusPending;    // notify once the lock is held
+    bool             configDirty;      // re-encode configValue
+
+    // Posted by BTstack callbacks, taken by update()
+    volatile uint16_t postedConn;
+    volatile bool     connectionChanged;
+    volatile uint16_t negotiatedMtu;
+    volatile bool     streamSubscribed;
+    volatile bool     statusSubscribed;
+    volatile bool     dumpRequested;
+    volatile uint16_t completedFrags;
+    // One spare byte so an oversized record still fails as too long
+    uint8_t           pendingConfig[CONFIG_WIRE_LEN + 1];
+    uint8_t           pendingConfigLen;
+    volatile bool     configWritten;
+    uint8_t           pendingCommand[2];
+    uint8_t           pendingCommandLen;
+    volatile bool     commandWritten;
+
+    void takeEvents();
+    void pumpStream();
+    void onCompleted();
+    void notifyStatus();
+    void handleCommand(const uint8_t* data, size_t len);
+    void reportConfig(const ConfigReport& report);
+
+    static PicoBLE* instance;
+    static void     onPacket(uint8_t type, uint16_t channel, uint8_t* packet, uint16_t size);
+    static uint16_t onRead(uint16_t conn, uint16_t handle, uint16_t offset,
+                           uint8_t* buf, uint16_t size);
+    static int      onWrite(uint16_t conn, uint16_t handle, uint16_t mode, uint16_t offset,
+                            uint8_t* buf, uint16_t size);
+};
+
+#endif // PICO_BLE_H
@@ -15,6 +15,8 @@
  *   UART1 (GP8 TX, GP9 RX)  -> GPS NEO-7m          (9600 baud NMEA)
  *   GP14                     -> RYLR896 NRESET      (active LOW reset)
  *   GP15                     -> GPS PPS              (1 Hz rising edge)
+ *   I2C1  (GP6 SDA, GP7 SCL) -> MPU6050 IMU          (I2C addr 0x68)
+ *   GP17                     <- MPU6050 INT          (motion interrupt)
  */
 
 #pragma once
@@ -30,6 +32,8 @@
 #define OLED_I2C_ADDR   0x3C
 #define SCREEN_WIDTH    128
 #define SCREEN_HEIGHT   64
+#define OLED_I2C_CLOCK  1000000      // Fast-mode Plus; drop to 400000 if the
+                                     // panel or its pull-ups can't keep up
 // No hardware reset pin on this OLED; pass -1 to Adafruit_SSD1306 constructor
 
 // ── GPS NEO-7m (UART1) ────────────────────────────────────────────────────
@@ -38,6 +42,13 @@
 #define PIN_GPS_PPS     15   // GP15 ← NEO-7m PPS    (1 Hz rising edge)
 #define GPS_BAUD        9600
 
+// ── IMU MPU6050 (I2C1) ────────────────────────────────────────────────────
+#define PIN_IMU_SDA     6    // GP6  ↔ MPU6050 SDA
+#define PIN_IMU_SCL     7    // GP7  → MPU6050 SCL
+#define PIN_IMU_INT     17   // GP17 ← MPU6050 INT   (wake-on-motion pulse)
+#define IMU_I2C_ADDR    0x68         // AD0 tied low
+#define IMU_I2C_CLOCK   400000       // MPU6050 maximum (Fast-mode)
+
 // ── User Input ────────────────────────────────────────────────────────────
 #define PIN_BUTTON      16   // GP16 — momentary push-button, active LOW
                              // Wire: GP16 → button → GND  (INPUT_PULLUP)
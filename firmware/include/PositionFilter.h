@@ -0,0 +1,123 @@
+/**
+ * @file PositionFilter.h
+ * @brief Fixed-point constant-velocity Kalman filter for NEO-7m fixes
+ *
+ * Smooths the several-metre jitter of raw fixes and dead-reckons between
+ * them.  Runs entirely in integer arithmetic (no FPU on the M0+) and holds
+ * all state inline, so a beacon can filter its own fixes and a relay can keep
+ * one instance per peer without touching the heap.
+ *
+ * Model: two independent axes (east, north) in a local tangent plane around
+ * the first fix, each with state [position mm, velocity mm/s].  Both axes see
+ * the same measurement noise (HDOP-scaled), so they share one symmetric 2×2
+ * covariance:  P = | pp  pv |  in mm², mm²/s, mm²/s².
+ *                  | pv  vv |
+ *
+ * Each GPSData fix contributes a position update (σ = HDOP × UERE) and, when
+ * the receiver reports speed/course, a velocity update.
+ */
+
+#ifndef POSITION_FILTER_H
+#define POSITION_FILTER_H
+
+#include <Arduino.h>
+#include "GPS.h"
+
+// User-equivalent range error used to turn HDOP into a position σ (mm)
+#ifndef KF_UERE_MM
+#define KF_UERE_MM          4000
+#endif
+// Process noise: white acceleration σ (mm/s²).  ~0.5 m/s² suits a walking
+// or slowly-driven asset; raise it for vehicles that brake/turn hard.
+#ifndef KF_ACCEL_SIGMA_MMS2
+#define KF_ACCEL_SIGMA_MMS2 500
+#endif
+// σ of the NEO-7m Doppler speed (mm/s)
+#define KF_VEL_SIGMA_MMS    300
+// Below this speed the reported course is noise — skip the velocity update
+#define KF_MIN_COURSE_SPEED_KMH 1.0f
+// Predictions further than this past the last fix are clamped
+#define KF_MAX_PREDICT_MS   120000UL
+// Re-centre the tangent plane once the track wanders this far from it
+#define KF_REORIGIN_MM      20000000L   // 20 km
+
+/** Snapshot of the filter — position in microdegrees, velocity in mm/s. */
+struct FilterState {
+    int32_t  latE6;
+    int32_t  lonE6;
+    int32_t  velEastMms;
+    int32_t  velNorthMms;
+    uint32_t posSigmaMm;     // √pp — 1σ horizontal position uncertainty (per axis)
+    uint32_t velSigmaMms;    // √vv
+    uint32_t timestamp;      // millis() of the fix this state belongs to
+    bool     valid;
+};
+
+/** Raw covariance terms, for callers that want more than the σ summary. */
+struct FilterCovariance {
+    int64_t pp;   // mm²
+    int64_t pv;   // mm²/s
+    int64_t vv;   // mm²/s²
+};
+
+class PositionFilter {
+public:
+    PositionFilter();
+
+    /** Forget all state; the next valid fix re-initialises the filter. */
+    void reset();
+
+    /**
+     * Propagate to fix.timestamp and fuse the fix.
+     * @return false if the fix is invalid or not newer than the last one
+     *         fused (state is left untouched)
+     */
+    bool update(const GPSData& fix);
+
+    /**
+     * Dead-reckoned position at an arbitrary millis() timestamp.
+     * Does not modify the filter.
+     * @return false until the filter has seen a valid fix
+     */
+    bool predict(uint32_t timestamp, int32_t& latE6, int32_t& lonE6) const;
+
+    /** Predicted 1σ position uncertainty (mm) at `timestamp`. */
+    uint32_t predictSigmaMm(uint32_t timestamp) const;
+
+    /** Smoothed state at the last fix. */
+    FilterState getState() const;
+
+    /** Covariance at the last fix. */
+    FilterCovariance getCovariance() const { return { pp, pv, vv }; }
+
+    /**
+     * Distance (mm) between the raw position of the last fix and where the
+     * filter predicted it would be — the innovation magnitude.  Small values
+     * mean the dead-reckoning model is tracking the asset well.
+     */
+    uint32_t getLastInnovationMm() const { return lastInnovationMm; }
+
+    bool isValid() const { return initialized; }
+
+private:
+    bool     initialized;
+    int32_t  originLatE6;
+    int32_t  originLonE6;
+    int16_t  cosOriginQ15;
+
+    // Per-axis state (mm, mm/s) in the tangent plane
+    int32_t  posE, posN;
+    int32_t  velE, velN;
+    // Shared covariance
+    int64_t  pp, pv, vv;
+
+    uint32_t lastTimestamp;
+    uint32_t lastInnovationMm;
+
+    void     setOrigin(int32_t latE6, int32_t lonE6);
+    void     propagate(uint32_t dtMs);
+    void     fusePosition(int32_t zE, int32_t zN, int64_t r);
+    void     fuseVelocity(int32_t zE, int32_t zN, int64_t r);
+};
+
+#endif // POSITION_FILTER_H
@@ -0,0 +1,113 @@
+/**
+ * @file PowerManager.h
+ * @brief Motion-gated power states for the GPS and LoRa radio
+ *
+ * A stationary asset does not need a 1 Hz fix or a listening radio.  The
+ * manager only decides; main.cpp applies each state to the hardware:
+ *
+ *   ACTIVE     moving or recently moved   GPS continuous, radio on
+ *   IDLE       still for IDLE_AFTER       GPS power save, radio on
+ *   SLEEP      still for SLEEP_AFTER      GPS backup, radio AT+MODE sleep
+ *   KEEPALIVE  SLEEP timer expired        GPS continuous, radio on until a
+ *                                         heartbeat is out (or a timeout),
+ *                                         then back to SLEEP
+ *
+ * Motion (the IMU's wake-on-motion interrupt, or IMU::isInMotion() when it
+ * is not wired) returns to ACTIVE from any state.  The manager is plain
+ * logic on millis() timestamps with no Arduino dependency, so
+ * test/test_power_manager replays motion traces through it on the host
+ * (pio test -e native).
+ *
+ * Time in each state is accumulated, and weighted with per-state supply
+ * current estimates (POWER_CURRENT_*_MA_X10, datasheet typicals for
+ * Pico W + NEO-7m + RYLR896 + MPU6050) to give an average current.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include "GpsPowerMode.h"
+
+#define POWER_IDLE_AFTER_MS        120000UL    // 2 min still → IDLE
+#define POWER_SLEEP_AFTER_MS       600000UL    // 10 min still → SLEEP
+#define POWER_KEEPALIVE_MS         900000UL    // SLEEP wakes every 15 min
+#define POWER_KEEPALIVE_FIX_MS     60000UL     // wait this long for a fix
+#define POWER_KEEPALIVE_MAX_MS     120000UL    // give up and sleep again
+#define POWER_KEEPALIVE_LISTEN_MS  5000UL      // stay on after the heartbeat
+
+// Estimated supply current per state, mA × 10
+#define POWER_CURRENT_ACTIVE_MA_X10     850    // MCU 30 + GPS 35 + RX 16 + IMU 4
+#define POWER_CURRENT_IDLE_MA_X10       610    // GPS power save ~11
+#define POWER_CURRENT_SLEEP_MA_X10      340    // GPS backup, radio sleep
+#define POWER_CURRENT_KEEPALIVE_MA_X10  850
+
+enum PowerState : uint8_t {
+    POWER_ACTIVE,
+    POWER_IDLE,
+    POWER_SLEEP,
+    POWER_KEEPALIVE,
+    POWER_STATE_COUNT
+};
+
+/** Timeouts; the defaults are the POWER_* macros above. */
+struct PowerTimings {
+    uint32_t idleAfterMs;
+    uint32_t sleepAfterMs;
+    uint32_t keepaliveMs;
+    uint32_t keepaliveFixMs;
+    uint32_t keepaliveMaxMs;
+    uint32_t keepaliveListenMs;
+};
+
+class PowerManager {
+public:
+    PowerManager();
+
+    void setTimings(const PowerTimings& t) { timings = t; }
+
+    /** Start in ACTIVE at `now`. */
+    void begin(uint32_t now);
+
+    /** Motion seen: back to ACTIVE and restart the stillness timers. */
+    void onMotion(uint32_t now);
+
+    /**
+     * Advance the timers.
+     * @return true if the state changed (apply gpsMode()/radioOn())
+     */
+    bool update(uint32_t now);
+
+    /** In KEEPALIVE: a heartbeat should go out now (have a fix, or gave up waiting). */
+    bool keepaliveDue(uint32_t now, bool haveFix) const;
+
+    /** The KEEPALIVE heartbeat was sent; sleep again after the listen window. */
+    void onKeepaliveSent(uint32_t now);
+
+    PowerState   getState() const { return state; }
+    GpsPowerMode gpsMode() const;
+    bool         radioOn() const { return state != POWER_SLEEP; }
+    /** Sample the IMU FIFO (only while there is motion worth analysing). */
+    bool         imuStreaming() const { return state == POWER_ACTIVE; }
+
+    /** ms spent in `s` so far, including the current stay. */
+    uint32_t getTimeInState(PowerState s, uint32_t now) const;
+    uint32_t getTransitions() const { return transitions; }
+    /** Average supply current since begin(), mA × 10, from the estimates. */
+    uint32_t getAverageCurrentMaX10(uint32_t now) const;
+
+    static const char* stateName(PowerState s);
+
+private:
+    PowerTimings timings;
+    PowerState   state;
+    uint32_t     enteredAt;
+    uint32_t     lastMotion;
+    uint32_t     keepaliveSentAt;   // 0 = not yet in this KEEPALIVE
+    uint32_t     timeIn[POWER_STATE_COUNT];
+    uint32_t     transitions;
+
+    void enter(PowerState s, uint32_t now);
+};
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,43 @@
+/**
+ * @file Sha256.h
+ * @brief Incremental SHA-256 (FIPS 180-4) and HMAC-SHA256 for firmware images
+ *
+ * Small and table-light (the 64 round constants only): images are hashed
+ * a few KB per loop iteration, so throughput matters less than flash and
+ * RAM.  update() may be called with any split of the input.
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <Arduino.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE  64
+
+class Sha256 {
+public:
+    Sha256() { reset(); }
+
+    void reset();
+    void update(const void* data, size_t len);
+    /** Write the digest; the object must be reset() before reuse. */
+    void finish(uint8_t out[SHA256_DIGEST_SIZE]);
+
+    /** One-shot convenience. */
+    static void hash(const void* data, size_t len, uint8_t out[SHA256_DIGEST_SIZE]);
+
+    /** HMAC-SHA256 (RFC 2104) of `data` under `key`. */
+    static void hmac(const uint8_t* key, size_t keyLen, const void* data, size_t len,
+                     uint8_t out[SHA256_DIGEST_SIZE]);
+
+private:
+    uint32_t state[8];
+    uint64_t totalLen;
+    uint8_t  block[SHA256_BLOCK_SIZE];
+    uint8_t  blockLen;
+
+    void compress(const uint8_t* p);
+};
+
+#endif // SHA256_H
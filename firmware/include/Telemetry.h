@@ -4,23 +4,40 @@
  * 
  * This module handles formatting of sensor data into JSON for transmission
  * to cloud services and mobile apps.
+ *
+ * Sensor data is first converted to the fixed-point records of
+ * TelemetryCodec, whose schemas drive both output formats:
+ *   write*Telemetry()  stream JSON through a JsonWriter (buffer or Print)
+ *   create*Telemetry() the same JSON as a String
+ *   pack*Telemetry()   the compact binary form, for LoRa
+ *   stream*Telemetry() keyframe/delta packets (TelemetryStream.h) for
+ *                      periodic updates over LoRa
+ * Numbers are fixed-point: lat/lon 6 decimals, alt/speed/course/temp 2,
+ * accel/gyro 3.
+ *
+ * Incoming JSON is decoded in place by TelemetryCodec straight into the same
+ * records (no JSON document); toGPSData()/toIMUData() convert back to the
+ * sensor structs.  Parse counts, failures, bytes and time are kept per
+ * packet type.
  */
 
 #ifndef TELEMETRY_H
 #define TELEMETRY_H
 
 #include <Arduino.h>
-#include <ArduinoJson.h>
 #include "GPS.h"
 #include "IMU.h"
+#include "JsonWriter.h"
+#include "TelemetryStream.h"
 
-// Telemetry packet types
-enum TelemetryType {
-    TELEMETRY_FULL,      // Complete telemetry with all sensors
-    TELEMETRY_GPS,       // GPS data only
-    TELEMETRY_IMU,       // IMU data only
-    TELEMETRY_STATUS,    // Status/health data
-    TELEMETRY_ALERT      // Alert/event data
+// Largest packet create*Telemetry() can return (a full packet is ~280 chars)
+#define TELEMETRY_JSON_MAX 384
+
+struct TelemetryParseStats {
+    uint32_t packets;   // decoded successfully
+    uint32_t errors;
+    uint32_t bytes;     // input bytes, both outcomes
+    uint32_t micros;    // time spent, both outcomes
 };
 
 class Telemetry {
@@ -78,6 +95,84 @@ public:
     String createAlertTelemetry(const char* deviceId, const char* alertType, 
                                 const char* message);
 
+    /**
+     * @brief Stream telemetry packets into a JsonWriter (buffer or Print sink)
+     *
+     * Same layouts as the matching create*Telemetry() call.
+     * @return false if the writer's buffer overflowed
+     */
+    static bool writeFullTelemetry(JsonWriter& w, const GPSData& gpsData,
+                                   const IMUData& imuData, const char* deviceId,
+                                   uint8_t battery);
+    static bool writeGPSTelemetry(JsonWriter& w, const GPSData& gpsData, const char* deviceId);
+    static bool writeIMUTelemetry(JsonWriter& w, const IMUData& imuData, const char* deviceId);
+    static bool writeStatusTelemetry(JsonWriter& w, const char* deviceId, uint8_t battery,
+                                     uint32_t uptime, int rssi);
+    static bool writeAlertTelemetry(JsonWriter& w, const char* deviceId,
+                                    const char* alertType, const char* message);
+
+    /**
+     * @brief Encode telemetry packets in the binary form (see TelemetryCodec.h)
+     *
+     * `cap` of TELEMETRY_BINARY_MAX always suffices.
+     * @return bytes written, 0 if `buf` is too small
+     */
+    static size_t packFullTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData,
+                                    const IMUData& imuData, uint8_t battery);
+    static size_t packGPSTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData);
+    static size_t packIMUTelemetry(uint8_t* buf, size_t cap, const IMUData& imuData);
+    static size_t packStatusTelemetry(uint8_t* buf, size_t cap, uint8_t battery,
+                                      uint32_t uptime, int rssi);
+    static size_t packAlertTelemetry(uint8_t* buf, size_t cap, const char* alertType,
+                                     const char* message);
+
+    /**
+     * @brief Encode the next periodic update as a keyframe or delta
+     *
+     * A keyframe goes out every TELEMETRY_KEYFRAME_INTERVAL packets of each
+     * type and after requestKeyframe(); otherwise only changed fields.
+     * `cap` of TELEMETRY_STREAM_MAX always suffices.
+     * @return bytes written, 0 if `buf` is too small
+     */
+    size_t streamFullTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData,
+                               const IMUData& imuData, uint8_t battery);
+    size_t streamGPSTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData);
+    size_t streamIMUTelemetry(uint8_t* buf, size_t cap, const IMUData& imuData);
+    size_t streamStatusTelemetry(uint8_t* buf, size_t cap, uint8_t battery,
+                                 uint32_t uptime, int rssi);
+
+    /**
+     * @brief A receiver lost sync (FRAME_TELEMETRY_RESYNC): key the next packet
+     */
+    void requestKeyframe(TelemetryType type) { stream.requestKeyframe(type); }
+
+    const TelemetryStreamEncoder& getStreamEncoder() const { return stream; }
+
+    /**
+     * @brief Convert sensor readings to codec records (timestamp = millis())
+     */
+    static void toRecord(const GPSData& gpsData, GpsRecord& rec);
+    static void toRecord(const IMUData& imuData, ImuRecord& rec);
+
+    /**
+     * @brief Parse incoming binary telemetry
+     * @param buf Packet produced by one of the pack*Telemetry() calls
+     * @param len Packet length
+     * @return true if the packet decoded; see getLastType()/getLastRecord()
+     */
+    bool parseBinary(const uint8_t* buf, size_t len);
+
+    /**
+     * @brief Parse incoming JSON telemetry in place
+     * @param json Packet text; modified, and must outlive msg.deviceId
+     * @param len Packet length
+     * @param msg Decoded type, device id and record
+     * @param fieldMask Schema fields to decode (TelemetryCodec::fieldMask())
+     * @return TELEMETRY_PARSE_OK or the reason the packet was rejected
+     */
+    TelemetryParseResult parseTelemetry(char* json, size_t len, TelemetryMessage& msg,
+                                        uint32_t fieldMask = TELEMETRY_ALL_FIELDS);
+
     /**
      * @brief Parse incoming JSON telemetry
      * @param json JSON string to parse
@@ -85,26 +180,42 @@ public:
      */
     bool parseTelemetry(const String& json);
 
+    /**
+     * @brief Record decoded by the last successful parse
+     */
+    const TelemetryRecord& getLastRecord() const { return lastRecord; }
+
     /**
      * @brief Get last parsed telemetry type
      * @return TelemetryType of last parsed packet
      */
     TelemetryType getLastType();
 
-private:
-    StaticJsonDocument<512> doc;
-    TelemetryType lastType;
-
     /**
-     * @brief Add timestamp to JSON document
+     * @brief Parse statistics for one packet type
+     * @param type A TelemetryType, or TELEMETRY_TYPE_COUNT for packets whose
+     *             type could not be determined
      */
-    void addTimestamp();
+    const TelemetryParseStats& getParseStats(uint8_t type) const;
 
     /**
-     * @brief Add device info to JSON document
-     * @param deviceId Device identifier
+     * @brief Convert decoded records back to sensor structs
      */
-    void addDeviceInfo(const char* deviceId);
+    static void toGPSData(const GpsRecord& rec, GPSData& gpsData);
+    static void toIMUData(const ImuRecord& rec, IMUData& imuData);
+
+private:
+    TelemetryType lastType;
+    TelemetryRecord lastRecord;
+    TelemetryParseStats stats[TELEMETRY_TYPE_COUNT + 1];
+    TelemetryStreamEncoder stream;
+
+    void countParse(uint8_t type, bool ok, size_t bytes, uint32_t startUs);
+
+    static void toFullRecord(FullRecord& rec, const GPSData& gpsData,
+                             const IMUData& imuData, uint8_t battery);
+    static void toStatusRecord(StatusRecord& rec, uint8_t battery, uint32_t uptime, int rssi);
+    static void toAlertRecord(AlertRecord& rec, const char* alertType, const char* message);
 };
 
 #endif // TELEMETRY_H
@@ -0,0 +1,224 @@
+/**
+ * @file TelemetryCodec.h
+ * @brief One schema per telemetry record, shared by the JSON and binary codecs
+ *
+ * Each TelemetryType has a plain fixed-point record struct and a constexpr
+ * field table (offset, width, kind, JSON key, decimals, nesting).  Both
+ * encoders walk the same table, so adding a field means adding one line to
+ * the schema — the JSON layout and the binary layout cannot drift apart.
+ *
+ * Binary layout (for LoRa; a full packet is ~35 bytes against ~285 of JSON):
+ *   [type tag] [timestamp varint] [field]...
+ * where BOOL/UINT fields are LEB128 varints, INT fields are zigzag varints
+ * and STRING fields are a varint length followed by the bytes.  Fields are
+ * positional, in schema order, so there are no per-field tags on the air.
+ *
+ * Delta records carry only what changed since a reference record both ends
+ * hold:
+ *   [type tag] [timestamp delta varint] [changed-field mask varint] [change]...
+ * A numeric change is the zigzag varint count of `quantum` steps; a string
+ * change is the new string.  The encoder advances its reference by exactly
+ * what the decoder will reconstruct, so quantisation error stays within
+ * half a step and never accumulates.
+ *
+ * Decoding dispatches on the tag through a table of schemas (binary) or on
+ * the first letter of the "type" string (JSON) — no strcmp chain.
+ *
+ * JSON is decoded in place: values are read straight from the caller's
+ * buffer into the record (numbers land as fixed-point without a float
+ * round trip), device_id is returned as a pointer into that buffer, and
+ * keys that are not in the schema — or not in the caller's field mask —
+ * are skipped without conversion.  Keys are matched verbatim, so a key
+ * spelled with escape sequences is treated as unknown.
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "JsonWriter.h"
+
+// Telemetry packet types; the value is the binary tag
+enum TelemetryType : uint8_t {
+    TELEMETRY_FULL,      // Complete telemetry with all sensors
+    TELEMETRY_GPS,       // GPS data only
+    TELEMETRY_IMU,       // IMU data only
+    TELEMETRY_STATUS,    // Status/health data
+    TELEMETRY_ALERT,     // Alert/event data
+    TELEMETRY_MOTION,    // ActivityMonitor window features
+    TELEMETRY_TYPE_COUNT
+};
+
+#define TELEMETRY_ALERT_TYPE_LEN 16    // incl. NUL
+#define TELEMETRY_MESSAGE_LEN    64
+#define TELEMETRY_BINARY_MAX     96    // largest encoded record (an alert: 86)
+
+// ── Records ──────────────────────────────────────────────────────────────────
+// Every record starts with the same millis() timestamp.
+
+struct GpsRecord {
+    uint32_t timestamp;
+    bool     valid;
+    int32_t  latE6;
+    int32_t  lonE6;
+    int32_t  altCm;
+    uint16_t speedX100;    // km/h
+    uint16_t courseX100;   // degrees
+    uint8_t  satellites;
+};
+
+struct ImuRecord {
+    uint32_t timestamp;
+    int32_t  accelMilli[3];   // m/s² × 1000
+    int32_t  gyroMilli[3];    // rad/s × 1000
+    int16_t  tempX100;        // °C
+};
+
+struct FullRecord {
+    uint32_t  timestamp;
+    uint8_t   battery;
+    GpsRecord gps;
+    ImuRecord imu;
+};
+
+struct StatusRecord {
+    uint32_t timestamp;
+    uint8_t  battery;
+    uint32_t uptime;      // seconds
+    int16_t  rssi;
+};
+
+struct AlertRecord {
+    uint32_t timestamp;
+    char     alertType[TELEMETRY_ALERT_TYPE_LEN];
+    char     message[TELEMETRY_MESSAGE_LEN];
+};
+
+struct MotionRecord {
+    uint32_t timestamp;
+    uint8_t  level;           // 0–100
+    bool     moving;
+    uint16_t steps;           // in the window
+    int16_t  meanMg;          // mean |a| − 1 g
+    uint16_t stdMg;
+    uint16_t accelRmsMg;      // gravity removed
+    uint16_t gyroRmsDpsX10;
+};
+
+/** Storage large enough for any record. */
+union TelemetryRecord {
+    uint32_t     timestamp;
+    FullRecord   full;
+    GpsRecord    gps;
+    ImuRecord    imu;
+    StatusRecord status;
+    AlertRecord  alert;
+    MotionRecord motion;
+};
+
+// ── Schema ───────────────────────────────────────────────────────────────────
+
+enum FieldKind : uint8_t {
+    FIELD_BOOL,
+    FIELD_UINT,
+    FIELD_INT,
+    FIELD_STRING     // char[size], NUL-terminated
+};
+
+struct FieldDesc {
+    JsonKey        key;
+    const JsonKey* group;      // enclosing JSON object, or nullptr
+    const JsonKey* subgroup;   // object inside `group`, or nullptr
+    uint16_t       offset;     // into the record
+    uint8_t        size;       // member width in bytes (string: capacity)
+    FieldKind      kind;
+    uint8_t        decimals;   // JSON fixed-point scale
+    uint8_t        quantum;    // delta step in record units (1 = lossless)
+};
+
+#define TELEMETRY_ALL_FIELDS 0xFFFFFFFFUL   // field mask: bit i = schema field i
+
+struct RecordSchema {
+    TelemetryType    type;
+    const char*      name;     // JSON "type" value
+    const FieldDesc* fields;
+    uint8_t          fieldCount;
+    uint16_t         recordSize;
+};
+
+enum TelemetryParseResult : uint8_t {
+    TELEMETRY_PARSE_OK = 0,
+    TELEMETRY_PARSE_SYNTAX,         // not a well-formed JSON object
+    TELEMETRY_PARSE_NO_TYPE,        // "type" missing or not a string
+    TELEMETRY_PARSE_UNKNOWN_TYPE,
+    TELEMETRY_PARSE_BAD_VALUE       // wrong JSON kind or out of the member's range
+};
+
+/** A packet decoded from JSON. */
+struct TelemetryMessage {
+    TelemetryType   type;       // TELEMETRY_TYPE_COUNT if it could not be determined
+    const char*     deviceId;   // into the parsed buffer; nullptr if absent
+    uint32_t        present;    // bit i: schema field i was decoded
+    TelemetryRecord record;     // fields not present are zero
+};
+
+namespace TelemetryCodec {
+    /** Schema of `type`, or nullptr if out of range. */
+    const RecordSchema* schemaFor(uint8_t type);
+
+    /** Type named `name` ("gps", ...), or -1; `name` may be nullptr. */
+    int8_t typeFromName(const char* name);
+
+    /**
+     * Encode `record` (the struct matching `type`) into `buf`.
+     * @return bytes written, 0 if `cap` is too small
+     */
+    size_t encodeBinary(TelemetryType type, const void* record, uint8_t* buf, size_t cap);
+
+    /**
+     * Decode one binary record into `out`.
+     * @return bytes consumed, 0 if truncated, malformed or of unknown type
+     */
+    size_t decodeBinary(const uint8_t* buf, size_t len, TelemetryType& type,
+                        TelemetryRecord& out);
+
+    /**
+     * Encode `record` as a delta against `ref` (a record of the same type
+     * that the receiver holds), and advance `ref` to the receiver's result.
+     * @return bytes written, 0 if `cap` is too small (`ref` unchanged)
+     */
+    size_t encodeDelta(TelemetryType type, void* ref, const void* record,
+                       uint8_t* buf, size_t cap);
+
+    /**
+     * Apply a delta record of `type` to `rec` (left unchanged on failure).
+     * @return bytes consumed, 0 if truncated, malformed or of another type
+     */
+    size_t applyDelta(TelemetryType type, const uint8_t* buf, size_t len,
+                      TelemetryRecord& rec);
+
+    /**
+     * Write `record` as a JSON object: device_id, timestamp, type, then the
+     * schema fields.
+     * @return false if the writer's buffer overflowed
+     */
+    bool encodeJson(JsonWriter& w, TelemetryType type, const void* record,
+                    const char* deviceId);
+
+    /**
+     * Decode a JSON packet in place.  `json` is modified (strings that are
+     * kept get unescaped and NUL-terminated) and must outlive msg.deviceId.
+     * @param fieldMask  schema fields to decode; the rest are skipped
+     */
+    TelemetryParseResult decodeJson(char* json, size_t len, uint32_t fieldMask,
+                                    TelemetryMessage& msg);
+
+    /** Mask of the fields of `type` whose JSON key is one of `names`. */
+    uint32_t fieldMask(TelemetryType type, const char* const* names, uint8_t count);
+
+    /** Short description of a parse result, for logs. */
+    const char* resultName(TelemetryParseResult result);
+}
+
+#endif // TELEMETRY_CODEC_H
@@ -0,0 +1,115 @@
+/**
+ * @file TelemetryStream.h
+ * @brief Keyframe + delta telemetry over a lossy link
+ *
+ * The sender keeps, per telemetry type, the record the receiver is known
+ * to hold.  Every TELEMETRY_KEYFRAME_INTERVAL packets (or on request) it
+ * sends a keyframe — the full binary record; in between, a TelemetryCodec
+ * delta that carries only the fields that moved by at least one quantum.
+ *
+ *   [kind] [seq] [keyframe: binary record | delta: delta record]
+ *
+ * `seq` counts packets per type (mod 256).  A receiver that sees a delta
+ * out of sequence, or one with no keyframe before it, drops it and asks
+ * the sender for a keyframe; further deltas are dropped until one arrives,
+ * with the request repeated every TELEMETRY_RESYNC_RETRY_MS.
+ *
+ * The decoder keeps state for TELEMETRY_STREAM_SOURCES senders; the one
+ * heard least recently is replaced.
+ */
+
+#ifndef TELEMETRY_STREAM_H
+#define TELEMETRY_STREAM_H
+
+#include <Arduino.h>
+#include "TelemetryCodec.h"
+
+#define TELEMETRY_KEYFRAME_INTERVAL 16
+#define TELEMETRY_STREAM_SOURCES    4
+#define TELEMETRY_RESYNC_RETRY_MS   5000
+#define TELEMETRY_STREAM_MAX        (2 + TELEMETRY_BINARY_MAX)
+
+enum TelemetryStreamKind : uint8_t {
+    STREAM_KEYFRAME = 1,
+    STREAM_DELTA    = 2
+};
+
+enum TelemetryStreamResult : uint8_t {
+    STREAM_OK = 0,
+    STREAM_RESYNC,      // gap or no keyframe yet: send a keyframe request now
+    STREAM_WAITING,     // dropped; a keyframe request is already outstanding
+    STREAM_MALFORMED
+};
+
+class TelemetryStreamEncoder {
+public:
+    explicit TelemetryStreamEncoder(uint8_t keyframeInterval = TELEMETRY_KEYFRAME_INTERVAL);
+
+    /**
+     * Encode the next packet of `type`.
+     * @return bytes written (at most TELEMETRY_STREAM_MAX), 0 if `cap` is too small
+     */
+    size_t encode(TelemetryType type, const void* record, uint8_t* buf, size_t cap);
+
+    /** Make the next packet of `type` a keyframe (receiver lost sync). */
+    void requestKeyframe(TelemetryType type);
+
+    uint32_t getKeyframes() const { return keyframes; }
+    uint32_t getDeltas()    const { return deltas; }
+    uint32_t getBytes()     const { return bytes; }
+
+private:
+    struct TypeState {
+        TelemetryRecord ref;        // what the receiver holds
+        uint8_t         seq;
+        uint8_t         sinceKey;   // packets since the last keyframe
+        bool            valid;      // a keyframe has been sent
+    };
+
+    TypeState state[TELEMETRY_TYPE_COUNT];
+    uint8_t   interval;
+    uint32_t  keyframes;
+    uint32_t  deltas;
+    uint32_t  bytes;
+};
+
+class TelemetryStreamDecoder {
+public:
+    TelemetryStreamDecoder();
+
+    /**
+     * Decode a packet from `src`.  On STREAM_OK `type`/`out` hold the
+     * reconstructed record; on STREAM_RESYNC `type` names the stream that
+     * needs a keyframe.
+     */
+    TelemetryStreamResult decode(uint16_t src, const uint8_t* buf, size_t len, uint32_t now,
+                                 TelemetryType& type, TelemetryRecord& out);
+
+    uint32_t getGaps()           const { return gaps; }
+    uint32_t getResyncRequests() const { return resyncs; }
+
+private:
+    struct TypeState {
+        TelemetryRecord rec;
+        uint8_t         seq;          // of the last packet applied
+        bool            valid;
+        bool            requested;    // keyframe request outstanding
+        uint32_t        requestedAt;
+    };
+
+    struct Source {
+        uint16_t  addr;
+        bool      used;
+        uint32_t  lastHeard;
+        TypeState types[TELEMETRY_TYPE_COUNT];
+    };
+
+    Source   sources[TELEMETRY_STREAM_SOURCES];
+    uint32_t gaps;
+    uint32_t resyncs;
+
+    Source&               sourceFor(uint16_t addr, uint32_t now);
+    TelemetryStreamResult lostSync(TypeState& ts, uint32_t now);
+};
+
+#endif // TELEMETRY_STREAM_H
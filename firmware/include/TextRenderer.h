@@ -0,0 +1,62 @@
+/**
+ * @file TextRenderer.h
+ * @brief Page-aligned 5x7 text straight into the SSD1306 framebuffer
+ *
+ * The SSD1306 buffer is page-major: one byte is a column of 8 vertical
+ * pixels.  A 5x7 glyph drawn at a page boundary is therefore just five byte
+ * stores plus a blank spacing column — no per-pixel drawPixel() calls as in
+ * Adafruit_GFX::print().  Text is placed on a 6 px × 8 px character grid
+ * (21 columns × 8 rows on a 128×64 panel), the same grid the default GFX
+ * font uses at size 1, so screens look the same as before.
+ *
+ * The formatting helpers write integers and fixed-point values into caller
+ * stack buffers, so a screen can be composed without String or the heap.
+ */
+
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <Arduino.h>
+#include "PinConfig.h"
+
+#define TEXT_CHAR_WIDTH   6      // 5 px glyph + 1 px spacing
+#define TEXT_COLUMNS      (SCREEN_WIDTH / TEXT_CHAR_WIDTH)
+
+/** Static text drawn once when a screen layout is entered. */
+struct TextLabel {
+    uint8_t     page;        // 0-7 (8 px rows)
+    uint8_t     col;         // pixel column
+    const char* text;
+};
+
+/** A fixed field: updated in place, blank-padded to `chars`. */
+struct TextSlot {
+    uint8_t page;
+    uint8_t col;
+    uint8_t chars;
+};
+
+namespace TextRenderer {
+
+/**
+ * Rasterise `text` at (page, col), clipped to `maxChars` and padded with
+ * blanks up to `maxChars`, so a shorter value erases the tail of a longer
+ * one.  Characters outside printable ASCII are drawn as '?'.
+ * @return characters of `text` drawn
+ */
+uint8_t drawText(uint8_t* fb, uint8_t page, uint8_t col,
+                 const char* text, uint8_t maxChars);
+
+/** Unsigned decimal.  @return length (without terminator) */
+uint8_t fmtUInt(char* out, uint32_t value);
+
+/**
+ * Signed fixed-point decimal: `value` scaled by 10^decimals
+ * (fmtFixed(buf, -57, 1) → "-5.7", fmtFixed(buf, 5, 2) → "0.05").
+ * @return length (without terminator)
+ */
+uint8_t fmtFixed(char* out, int32_t value, uint8_t decimals);
+
+} // namespace TextRenderer
+
+#endif // TEXT_RENDERER_H
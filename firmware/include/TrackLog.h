@@ -0,0 +1,124 @@
+/**
+ * @file TrackLog.h
+ * @brief Fixed-capacity on-device GPS track with online line simplification
+ *
+ * Fixes are fed one at a time.  An opening-window simplifier (the streaming
+ * relative of Douglas-Peucker) keeps a point only when the straight line
+ * from the previous kept point can no longer represent the fixes in between
+ * to within TRACK_TOLERANCE_MM.  Straight legs collapse to their end
+ * points, so a route keeps its shape in a small fraction of the raw fixes.
+ *
+ * At most TRACK_WINDOW fixes wait on one segment.  When the window fills,
+ * fixes within the tolerance of the segment's start are dropped (any line
+ * from there covers them), so a parked period stays one segment however
+ * long it lasts; a moving leg that still fits is cut into a vertex.
+ *
+ * Kept points live in a ring buffer; when it is full the oldest point is
+ * overwritten.  Every kept point has a monotonically increasing sequence
+ * number so an uploader can resume from where it left off.
+ *
+ * Compact form (little-endian):
+ *   u8  count
+ *   u32 firstTimestamp (s)   i32 firstLatE6   i32 firstLonE6
+ *   count-1 × { zigzag-varint ΔlatE6, zigzag-varint ΔlonE6, varint Δt (s) }
+ */
+
+#ifndef TRACK_LOG_H
+#define TRACK_LOG_H
+
+#include <Arduino.h>
+
+#define TRACK_CAPACITY      512     // kept points (12 B each)
+#define TRACK_WINDOW        32      // max fixes pending on one segment (see above)
+#define TRACK_TOLERANCE_MM  5000    // max cross-track error of the simplified line
+
+// Most points a compact form of `len` bytes can hold: 13-byte first point,
+// then at least 3 bytes (three one-byte varints) per point, ≤ 255 in all
+#define TRACK_COMPACT_MAX_POINTS(len) \
+    ((len) < 13 ? 0 : ((len) - 13) / 3 + 1 > 255 ? 255 : ((len) - 13) / 3 + 1)
+
+struct TrackPoint {
+    int32_t  latE6;
+    int32_t  lonE6;
+    uint32_t timestamp;   // seconds (millis()/1000, or UTC if the caller has it)
+};
+
+class TrackLog {
+public:
+    explicit TrackLog(uint32_t toleranceMm = TRACK_TOLERANCE_MM);
+
+    /** Drop everything, including the pending window. */
+    void clear();
+
+    /** Feed one fix. */
+    void add(int32_t latE6, int32_t lonE6, uint32_t timestamp);
+
+    /**
+     * Commit the most recent fix as a kept point (e.g. before an upload or
+     * when the fix is lost), so the stored track ends where the asset is.
+     */
+    void flush();
+
+    /** Number of kept points currently stored. */
+    uint16_t size() const { return count; }
+
+    /** Sequence number the next kept point will get. */
+    uint32_t nextSeq() const { return totalKept; }
+
+    /** Sequence number of the oldest point still stored. */
+    uint32_t oldestSeq() const { return totalKept - count; }
+
+    /** Fetch a kept point by sequence number. */
+    bool getBySeq(uint32_t seq, TrackPoint& out) const;
+
+    /**
+     * Encode kept points starting at `fromSeq` (clamped to oldestSeq()) in the
+     * compact form, as many as fit in `cap` bytes (and ≤ 255).
+     * @param encoded  Set to the number of points written
+     * @return bytes written (0 if nothing to send or cap too small)
+     */
+    size_t encodeCompact(uint32_t fromSeq, uint8_t* buf, size_t cap,
+                         uint16_t& encoded) const;
+
+    /**
+     * Decode the compact form.
+     * @return number of points written to `out`, or -1 if malformed
+     */
+    static int decodeCompact(const uint8_t* buf, size_t len,
+                             TrackPoint* out, uint16_t maxPoints);
+
+    /** Fixes fed in vs points kept — the compression ratio is kept/input. */
+    uint32_t getInputCount()   const { return totalInput; }
+    uint32_t getKeptCount()    const { return totalKept; }
+    /** Kept points lost to ring-buffer overwrite. */
+    uint32_t getOverwrittenCount() const { return overwritten; }
+
+private:
+    struct WindowPoint {
+        TrackPoint p;
+        int32_t    eastMm;     // relative to the anchor
+        int32_t    northMm;
+    };
+
+    TrackPoint  ring[TRACK_CAPACITY];
+    uint16_t    head;          // next write slot
+    uint16_t    count;
+    uint32_t    totalKept;
+    uint32_t    totalInput;
+    uint32_t    overwritten;
+
+    // Opening window
+    uint32_t    toleranceMm;
+    bool        haveAnchor;
+    TrackPoint  anchor;
+    int16_t     anchorCosQ15;
+    WindowPoint window[TRACK_WINDOW];
+    uint8_t     windowLen;
+
+    void keep(const TrackPoint& p);
+    bool windowFits(int32_t eastMm, int32_t northMm) const;
+    bool collapseWindow();
+    void restartWindow(const TrackPoint& newAnchor);
+};
+
+#endif // TRACK_LOG_H
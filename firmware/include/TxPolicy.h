@@ -0,0 +1,110 @@
+/**
+ * @file TxPolicy.h
+ * @brief Motion-adaptive (dead-band) LoRa transmit suppression
+ *
+ * The receiver of a heartbeat dead-reckons the sender from the last
+ * position, speed and course it was sent.  TxPolicy runs the very same
+ * extrapolation on the sender and only lets a heartbeat through when the
+ * real position has drifted beyond a threshold from what the receiver
+ * already believes, or when a keepalive deadline expires.
+ *
+ * Threshold and keepalive are chosen from a small speed-band table keyed on
+ * GPSData::speed, so a parked asset talks every few minutes while a moving
+ * one keeps its track to within a few metres.
+ */
+
+#ifndef TX_POLICY_H
+#define TX_POLICY_H
+
+#include <Arduino.h>
+#include "GPS.h"
+
+#define TX_POLICY_MAX_BANDS     6
+
+// Hard floor between transmissions regardless of deviation
+#define TX_MIN_INTERVAL_MS      2000
+// Keepalive used while there is no fix (nothing to extrapolate)
+#define TX_NOFIX_KEEPALIVE_MS   60000
+
+/** One row of the speed-band table; rows are ordered by maxSpeedKmhX10. */
+struct SpeedBand {
+    uint16_t maxSpeedKmhX10;   // band applies while speed*10 < this
+    uint32_t thresholdMm;      // max tolerated receiver-side error
+    uint32_t keepaliveMs;      // transmit at least this often
+};
+
+enum TxReason : uint8_t {
+    TX_SUPPRESSED = 0,
+    TX_FIRST,          // nothing sent yet
+    TX_DEVIATION,      // receiver's extrapolation drifted past threshold
+    TX_KEEPALIVE,      // deadline reached
+    TX_FIX_CHANGE,     // fix acquired or lost since last transmission
+    TX_REASON_COUNT
+};
+
+/** What was last put on air, in exactly the resolution the receiver sees. */
+struct TxSnapshot {
+    int32_t  latE6;
+    int32_t  lonE6;
+    uint16_t speedKmhX10;
+    uint16_t courseDeg;
+    bool     valid;
+    uint32_t sentAt;
+};
+
+class TxPolicy {
+public:
+    TxPolicy();
+
+    /** Replace the speed-band table (copied; at most TX_POLICY_MAX_BANDS rows). */
+    void setBands(const SpeedBand* bands, uint8_t count);
+
+    /** Transmit at least every `ms`, with or without a fix; 0 = no cap. */
+    void setKeepaliveCap(uint32_t ms) { keepaliveCapMs = ms; }
+
+    /**
+     * Decide whether a heartbeat is needed now.
+     * @param latE6/lonE6  Best current position (e.g. PositionFilter output)
+     * @param fix          Latest GPSData (validity and speed select the band)
+     * @param now          millis()
+     */
+    TxReason evaluate(int32_t latE6, int32_t lonE6, const GPSData& fix, uint32_t now);
+
+    /** Record a transmission; pass the values exactly as encoded on air. */
+    void markSent(const TxSnapshot& sent);
+
+    /** Receiver-side view: where the last sent snapshot extrapolates to at `now`. */
+    bool predictReceiver(uint32_t now, int32_t& latE6, int32_t& lonE6) const;
+
+    /**
+     * Dead-reckon a position forward.  Shared by sender and receiver so both
+     * sides extrapolate identically.
+     */
+    static void extrapolate(int32_t latE6, int32_t lonE6,
+                            uint16_t speedKmhX10, uint16_t courseDeg,
+                            uint32_t dtMs,
+                            int32_t& outLatE6, int32_t& outLonE6);
+
+    /** Deviation (mm) computed by the last evaluate() call with a fix. */
+    uint32_t getLastDeviationMm() const { return lastDeviationMm; }
+
+    uint32_t getCount(TxReason r) const { return r < TX_REASON_COUNT ? counts[r] : 0; }
+    uint32_t getSentCount() const;
+    uint32_t getSuppressedCount() const { return counts[TX_SUPPRESSED]; }
+
+    static const char* reasonName(TxReason r);
+
+private:
+    SpeedBand  bands[TX_POLICY_MAX_BANDS];
+    uint8_t    bandCount;
+    uint32_t   keepaliveCapMs;
+    TxSnapshot last;
+    bool       haveSent;
+    uint32_t   lastDeviationMm;
+    uint32_t   counts[TX_REASON_COUNT];
+
+    const SpeedBand& bandFor(float speedKmh) const;
+    TxReason         tally(TxReason r) { counts[r]++; return r; }
+};
+
+#endif // TX_POLICY_H
@@ -0,0 +1,91 @@
+/**
+ * @file UIScheduler.h
+ * @brief Decides when the visible screen is re-rendered
+ *
+ * Each screen declares a refresh policy instead of everything redrawing on
+ * one global interval:
+ *   REFRESH_PERIODIC   every intervalMs (animated content, e.g. the radar)
+ *   REFRESH_ON_CHANGE  after notify(), at most once per intervalMs, so a
+ *                      burst of updates costs one frame
+ *   REFRESH_ON_EVENT   on the first loop after notify()
+ *
+ * Switching screens forces a render on the same loop iteration.  Otherwise
+ * a render is held back while the loop iteration has already used up the
+ * render budget (time spent on GPS/LoRa work plus the screen's typical
+ * render cost), for at most UI_MAX_DEFER_MS.
+ *
+ * Screens are identified by index; the scheduler knows nothing about what
+ * they draw.
+ */
+
+#ifndef UI_SCHEDULER_H
+#define UI_SCHEDULER_H
+
+#include <Arduino.h>
+
+#define UI_MAX_SCREENS       8
+#define UI_RENDER_BUDGET_US  10000   // per loop iteration, incl. work before rendering
+#define UI_MAX_DEFER_MS      500     // a due render is never held back longer
+
+enum RefreshPolicy : uint8_t {
+    REFRESH_PERIODIC = 0,
+    REFRESH_ON_CHANGE,
+    REFRESH_ON_EVENT
+};
+
+struct ScreenPolicy {
+    RefreshPolicy policy;
+    uint16_t      intervalMs;   // period (PERIODIC) or minimum spacing (ON_CHANGE)
+};
+
+class UIScheduler {
+public:
+    UIScheduler();
+
+    /** Set the per-screen policies (copied; at most UI_MAX_SCREENS). */
+    void setPolicies(const ScreenPolicy* policies, uint8_t count);
+
+    void setBudget(uint32_t budgetUs) { this->budgetUs = budgetUs; }
+
+    /** Switch to `screen` and render it on the next due() call. */
+    void show(uint8_t screen);
+
+    /** Switch to the next screen (wrapping). */
+    void next() { if (count) show((uint8_t)((current + 1) % count)); }
+
+    uint8_t getCurrent() const { return current; }
+
+    /** The data shown by `screen` changed (any screen, visible or not). */
+    void notify(uint8_t screen);
+
+    /**
+     * Should the current screen be rendered now?
+     * @param loopElapsedUs  time already spent in this loop iteration
+     */
+    bool due(uint32_t nowMs, uint32_t loopElapsedUs);
+
+    /** Report a finished render and how long it took. */
+    void rendered(uint32_t nowMs, uint32_t costUs);
+
+    uint32_t getRenderCount()   const { return renders; }
+    /** Loop iterations in which a due render was held back by the budget. */
+    uint32_t getDeferCount()    const { return deferrals; }
+    /** Typical render cost of `screen` in µs (running average). */
+    uint32_t getCostEstimate(uint8_t screen) const { return costUs[screen]; }
+
+private:
+    ScreenPolicy policies[UI_MAX_SCREENS];
+    uint8_t      count;
+    uint8_t      current;
+    bool         dirty[UI_MAX_SCREENS];
+    uint32_t     costUs[UI_MAX_SCREENS];
+    bool         forced;
+    uint32_t     lastRender;
+    bool         deferring;
+    uint32_t     deferStart;
+    uint32_t     budgetUs;
+    uint32_t     renders;
+    uint32_t     deferrals;
+};
+
+#endif // UI_SCHEDULER_H
@@ -0,0 +1,128 @@
+/**
+ * @file ActivityMonitor.cpp
+ * @brief Gravity high-pass, block sums, step detector, window features
+ */
+
+#include "ActivityMonitor.h"
+#include "FixedMath.h"
+
+#define ONE_G_MG 1000
+
+ActivityMonitor::ActivityMonitor(uint16_t blockSamples)
+    : blockSamples(blockSamples ? blockSamples : 1), totalSteps(0), sampleCount(0),
+      blockCycles(0), sampleCycles(0) {
+    reset();
+}
+
+void ActivityMonitor::reset() {
+    memset(blocks, 0, sizeof(blocks));
+    memset(gravityQ8, 0, sizeof(gravityQ8));
+    memset(&last, 0, sizeof(last));
+    current      = 0;
+    filled       = 0;
+    gravityValid = false;
+    smoothM      = 0;
+    stepArmed    = false;
+    lastStepUs   = 0;
+    movingNow    = false;
+}
+
+bool ActivityMonitor::add(const ImuSample& s, ActivityFeatures& out) {
+    uint32_t c0 = rp2040.getCycleCount();
+
+    // Raw → mg: 1000 / IMU_ACCEL_LSB_PER_G = 125 / 512
+    int32_t a[3];
+    for (uint8_t i = 0; i < 3; i++) a[i] = ((int32_t)s.accel[i] * 125) >> 9;
+
+    if (!gravityValid) {
+        for (uint8_t i = 0; i < 3; i++) gravityQ8[i] = a[i] * 256;
+        gravityValid = true;
+    }
+
+    // High-pass: subtract the slowly tracked gravity vector
+    uint32_t d2 = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        gravityQ8[i] += (a[i] * 256 - gravityQ8[i]) >> ACTIVITY_GRAVITY_SHIFT;
+        int32_t d = a[i] - (gravityQ8[i] >> 8);
+        d2 += (uint32_t)(d * d);
+    }
+    movingNow = d2 > (uint32_t)ACTIVITY_MOTION_MG * ACTIVITY_MOTION_MG;
+
+    // |a| − 1 g without a square root
+    int32_t a2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+    int32_t m  = (a2 - ONE_G_MG * ONE_G_MG) / (2 * ONE_G_MG);
+
+    uint32_t w2 = 0;
+    for (uint8_t i = 0; i < 3; i++) w2 += (uint32_t)((int32_t)s.gyro[i] * s.gyro[i]);
+
+    // Steps: a dip below LOW, then a rise above HIGH, no faster than MIN_MS
+    smoothM += (m - smoothM) >> ACTIVITY_SMOOTH_SHIFT;
+    Block& b = blocks[current];
+    if (smoothM < ACTIVITY_STEP_LOW_MG) {
+        stepArmed = true;
+    } else if (stepArmed && smoothM > ACTIVITY_STEP_HIGH_MG &&
+               s.timestampUs - lastStepUs >= ACTIVITY_STEP_MIN_MS * 1000UL) {
+        stepArmed  = false;
+        lastStepUs = s.timestampUs;
+        b.steps++;
+        totalSteps++;
+    }
+
+    if (b.n == 0) b.startUs = s.timestampUs;
+    b.sumM  += m;
+    b.sumM2 += (int64_t)m * m;
+    b.sumD2 += d2;
+    b.sumW2 += w2;
+    b.moving += movingNow ? 1 : 0;
+    b.n++;
+    sampleCount++;
+
+    if (b.n < blockSamples) {
+        sampleCycles = rp2040.getCycleCount() - c0;
+        return false;
+    }
+
+    if (filled < ACTIVITY_BLOCKS) filled++;
+    finishWindow(s.timestampUs, out);
+    current = (uint8_t)((current + 1) % ACTIVITY_BLOCKS);
+    memset(&blocks[current], 0, sizeof(Block));
+    blockCycles = rp2040.getCycleCount() - c0;
+    return true;
+}
+
+void ActivityMonitor::finishWindow(uint32_t endUs, ActivityFeatures& out) {
+    int64_t  sumM = 0, sumM2 = 0;
+    uint64_t sumD2 = 0, sumW2 = 0;
+    uint32_t n = 0, moving = 0, steps = 0;
+    uint32_t startUs = endUs;
+    for (uint8_t k = 0; k < filled; k++) {
+        const Block& b = blocks[(current + ACTIVITY_BLOCKS - k) % ACTIVITY_BLOCKS];
+        sumM   += b.sumM;
+        sumM2  += b.sumM2;
+        sumD2  += b.sumD2;
+        sumW2  += b.sumW2;
+        n      += b.n;
+        moving += b.moving;
+        steps  += b.steps;
+        startUs = b.startUs;
+    }
+
+    int64_t mean = sumM / (int64_t)n;
+    int64_t var  = (sumM2 - sumM * mean) / (int64_t)n;
+    if (var < 0) var = 0;
+
+    uint32_t accelRms = FixedMath::isqrt64(sumD2 / n);
+    uint32_t gyroRaw  = FixedMath::isqrt64(sumW2 / n);
+
+    out.timestampMs   = endUs / 1000;
+    out.windowMs      = (uint16_t)min((endUs - startUs) / 1000, (uint32_t)UINT16_MAX);
+    out.samples       = (uint16_t)min(n, (uint32_t)UINT16_MAX);
+    out.meanMg        = (int16_t)constrain(mean, INT16_MIN, INT16_MAX);
+    out.stdMg         = (uint16_t)min(FixedMath::isqrt64((uint64_t)var), (uint32_t)UINT16_MAX);
+    out.accelRmsMg    = (uint16_t)min(accelRms, (uint32_t)UINT16_MAX);
+    out.gyroRmsDpsX10 = (uint16_t)min(gyroRaw * 100 / IMU_GYRO_LSB_PER_DPS_X10, (uint32_t)UINT16_MAX);
+    out.steps         = (uint16_t)steps;
+    out.level         = (uint8_t)min(accelRms * 100 / ACTIVITY_LEVEL_FULL_MG, (uint32_t)100);
+    out.moving        = moving * 100 >= (uint32_t)ACTIVITY_MOVING_PERCENT * n;
+    last = out;
+}
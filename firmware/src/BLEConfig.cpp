@@ -5,6 +5,12 @@
 
 #include "BLEConfig.h"
 
+#if defined(CONFIG_NIMBLE_CPP_IDF)
+#include "os/os_mbuf.h"
+#else
+#include "nimble/porting/nimble/include/os/os_mbuf.h"
+#endif
+
 // Server callbacks class implementation
 class BLEConfig::ServerCallbacks : public NimBLEServerCallbacks {
 private:
@@ -13,35 +19,94 @@ private:
 public:
     ServerCallbacks(BLEConfig* p) : parent(p) {}
 
-    void onConnect(NimBLEServer* pServer) {
+    void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
         Serial.println("BLE client connected");
         parent->clientConnected = true;
+        parent->connectionChanged = true;
+        // Short interval: several notifications per event during a dump
+        pServer->updateConnParams(desc->conn_handle, BLE_CONN_INTERVAL_MIN,
+                                  BLE_CONN_INTERVAL_MAX, 0, BLE_CONN_TIMEOUT);
     }
 
     void onDisconnect(NimBLEServer* pServer) {
         Serial.println("BLE client disconnected");
         parent->clientConnected = false;
+        parent->connectionChanged = true;
         // Restart advertising
         pServer->startAdvertising();
     }
+
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+        parent->negotiatedMtu = MTU;
+    }
+};
+
+// Stream characteristic callbacks: subscription and refused notifications
+class BLEConfig::StreamCallbacks : public NimBLECharacteristicCallbacks {
+private:
+    BLEConfig* parent;
+
+public:
+    StreamCallbacks(BLEConfig* p) : parent(p) {}
+
+    void onSubscribe(NimBLECharacteristic* pCharacteristic,
+                     ble_gap_conn_desc* desc, uint16_t subValue) {
+        if (subValue & 0x0001) parent->dumpRequested = true;
+    }
+
+    // Reported from inside notify().  SUCCESS_NOTIFY only means the packet
+    // was queued, so it is not a credit; see BLEConfig::reclaimCredits().
+    void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) {
+        if (s != Status::SUCCESS_NOTIFY) {
+            parent->notifyRefused = true;     // the stack had no buffer for it
+        }
+    }
+};
+
+// CONFIG / COMMAND writes: copied here, applied by update()
+class BLEConfig::WriteCallbacks : public NimBLECharacteristicCallbacks {
+private:
+    BLEConfig* parent;
+
+public:
+    WriteCallbacks(BLEConfig* p) : parent(p) {}
+
+    void onWrite(NimBLECharacteristic* pCharacteristic) {
+        auto value = pCharacteristic->getValue();
+        // One spare byte so an oversized record still fails as too long
+        if (pCharacteristic == parent->pConfigCharacteristic) {
+            size_t len = min(value.length(), sizeof(parent->pendingConfig));
+            memcpy(parent->pendingConfig, value.data(), len);
+            parent->pendingConfigLen = (uint8_t)len;
+            parent->configWritten = true;
+        } else {
+            size_t len = min(value.length(), sizeof(parent->pendingCommand));
+            memcpy(parent->pendingCommand, value.data(), len);
+            parent->pendingCommandLen = (uint8_t)len;
+            parent->commandWritten = true;
+        }
+    }
 };
 
 BLEConfig::BLEConfig() : pServer(nullptr), pService(nullptr), 
                          pConfigCharacteristic(nullptr), 
                          pStatusCharacteristic(nullptr),
                          pCommandCharacteristic(nullptr),
-                         initialized(false), clientConnected(false) {
-    // Initialize default config
-    config.loraFrequency = 915;
-    config.loraPower = 20;
-    config.gpsInterval = 5000;
-    config.telemetryInterval = 10000;
-    strcpy(config.deviceName, "BRAVO_BEACON");
+                         pStreamCharacteristic(nullptr),
+                         deviceConfig(nullptr),
+                         initialized(false), clientConnected(false),
+                         peerSource(nullptr), trackSource(nullptr),
+                         connectionChanged(false), dumpRequested(false),
+                         notifyRefused(false), negotiatedMtu(0),
+                         notifiesPending(0), mbufBaseline(0), dumpReported(true),
+                         pendingConfigLen(0), configWritten(false),
+                         pendingCommandLen(0), commandWritten(false) {
 }
 
 bool BLEConfig::begin(const char* deviceName) {
     // Initialize BLE
     NimBLEDevice::init(deviceName);
+    NimBLEDevice::setMTU(BLE_STREAM_MAX_MTU);
 
     // Create BLE Server
     pServer = NimBLEDevice::createServer();
@@ -66,6 +131,17 @@ bool BLEConfig::begin(const char* deviceName) {
         NIMBLE_PROPERTY::WRITE
     );
 
+    WriteCallbacks* writeCallbacks = new WriteCallbacks(this);
+    pConfigCharacteristic->setCallbacks(writeCallbacks);
+    pCommandCharacteristic->setCallbacks(writeCallbacks);
+    publishConfig();
+
+    pStreamCharacteristic = pService->createCharacteristic(
+        STREAM_UUID,
+        NIMBLE_PROPERTY::NOTIFY
+    );
+    pStreamCharacteristic->setCallbacks(new StreamCallbacks(this));
+
     // Start service
     pService->start();
 
@@ -81,20 +157,165 @@ bool BLEConfig::begin(const char* deviceName) {
 }
 
 void BLEConfig::update() {
-    // BLE stack handles updates automatically
-    // This function is for future extensions
+    if (!initialized) {
+        return;
+    }
+
+    if (connectionChanged) {
+        connectionChanged = false;
+        stream.reset();
+        notifiesPending = 0;
+        dumpReported = true;
+    }
+    if (negotiatedMtu) {
+        stream.setMtu(negotiatedMtu);
+        Serial.println("[BLE] MTU " + String(negotiatedMtu));
+        negotiatedMtu = 0;
+    }
+
+    reclaimCredits();
+
+    if (configWritten) {
+        uint8_t record[sizeof(pendingConfig)];
+        uint8_t len = pendingConfigLen;
+        memcpy(record, pendingConfig, len);
+        configWritten = false;
+        if (deviceConfig) {
+            reportConfig(deviceConfig->applyWire(record, len));
+        }
+    }
+    if (commandWritten) {
+        uint8_t command[sizeof(pendingCommand)];
+        uint8_t len = pendingCommandLen;
+        memcpy(command, pendingCommand, len);
+        commandWritten = false;
+        handleCommand(command, len);
+    }
+
+    if (dumpRequested && clientConnected) {
+        dumpRequested = false;
+        startDump();
+    }
+    pumpStream();
+}
+
+void BLEConfig::pumpStream() {
+    if (!clientConnected || !pStreamCharacteristic) {
+        return;
+    }
+
+    uint8_t buf[BLE_STREAM_MAX_NOTIFY];
+    size_t len;
+    stream.refill();
+    while (os_msys_num_free() >= BLE_STREAM_MBUF_RESERVE &&
+           (len = stream.next(buf, sizeof(buf), millis())) > 0) {
+        if (notifiesPending == 0) mbufBaseline = os_msys_num_free();
+        notifyRefused = false;
+        pStreamCharacteristic->notify(buf, len, true);
+        if (notifyRefused) {
+            stream.unsend();          // retried on the next update()
+            break;
+        }
+        notifiesPending++;
+        stream.refill();
+    }
+
+    if (!dumpReported && stream.idle()) {
+        dumpReported = true;
+        const BLEStreamStats& st = stream.getStats();
+        Serial.println("[BLE] Dump sent: " + String(st.bytes) + " B in " +
+                       String(st.notifications) + " notifications, " +
+                       String(stream.bytesPerSecond()) + " B/s");
+    }
+}
+
+void BLEConfig::reclaimCredits() {
+    // A queued notification holds msys mbufs until the host has handed it
+    // to the controller.  Once the pool is back to where it was before the
+    // first one went out, everything sent since has left the host.
+    if (notifiesPending == 0 || os_msys_num_free() < mbufBaseline) {
+        return;
+    }
+    uint32_t now = millis();
+    for (; notifiesPending > 0; notifiesPending--) {
+        stream.onSent(now);
+    }
+}
+
+void BLEConfig::setStreamSources(const PeerTable* peers, const TrackLog* track) {
+    peerSource = peers;
+    trackSource = track;
+}
+
+void BLEConfig::startDump() {
+    if (!peerSource || !trackSource) {
+        return;
+    }
+    stream.startDump(*peerSource, *trackSource, millis());
+    dumpReported = false;
 }
 
 bool BLEConfig::isConnected() {
     return clientConnected;
 }
 
-BLEConfigData BLEConfig::getConfig() {
-    return config;
+void BLEConfig::setDeviceConfig(DeviceConfig* cfg) {
+    deviceConfig = cfg;
+    publishConfig();
+}
+
+DeviceSettings BLEConfig::getConfig() {
+    return deviceConfig ? deviceConfig->get() : DeviceConfig::defaults();
 }
 
-void BLEConfig::setConfig(const BLEConfigData& newConfig) {
-    config = newConfig;
+void BLEConfig::setConfig(const DeviceSettings& newConfig) {
+    if (deviceConfig) {
+        reportConfig(deviceConfig->apply(newConfig));
+    }
+}
+
+void BLEConfig::handleCommand(const uint8_t* data, size_t len) {
+    if (len != 2 || data[0] != BLE_COMMAND_VERSION) {
+        sendStatus("cmd: unsupported");
+        return;
+    }
+    switch (data[1]) {
+        case BLE_CMD_DEFAULTS: {
+            // Radio and timing only: the unit keeps its addresses
+            DeviceSettings d = DeviceConfig::defaults();
+            d.address = getConfig().address;
+            d.target  = getConfig().target;
+            setConfig(d);
+            break;
+        }
+        case BLE_CMD_DUMP:
+            startDump();
+            break;
+        case BLE_CMD_REPORT:
+            if (deviceConfig) {
+                sendStatus("cfg " + DeviceConfig::describe(deviceConfig->getLastReport()));
+            }
+            break;
+        default:
+            sendStatus("cmd: unknown " + String(data[1]));
+            break;
+    }
+}
+
+void BLEConfig::reportConfig(const ConfigReport& report) {
+    String line = DeviceConfig::describe(report);
+    Serial.println("[Config] " + line);
+    sendStatus("cfg " + line);
+    publishConfig();    // CONFIG always reads back what is in force
+}
+
+void BLEConfig::publishConfig() {
+    if (!pConfigCharacteristic) {
+        return;
+    }
+    uint8_t record[CONFIG_WIRE_LEN];
+    size_t len = DeviceConfig::encode(getConfig(), record, sizeof(record));
+    pConfigCharacteristic->setValue(record, len);
 }
 
 void BLEConfig::sendStatus(const String& status) {
@@ -0,0 +1,173 @@
+/**
+ * @file BLEStream.cpp
+ * @brief Record ring, MTU-sized notification packing, credit flow control
+ */
+
+#include "BLEStream.h"
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+BLEStream::BLEStream() {
+    reset();
+}
+
+void BLEStream::reset() {
+    head        = 0;
+    tail        = 0;
+    notifySize  = BLE_STREAM_DEFAULT_MTU - 3;
+    seq         = 0;
+    inFlight    = 0;
+    lastLen     = 0;
+    lastSentMs  = 0;
+    dumpBytes   = 0;
+    track       = nullptr;
+    trackSeq    = 0;
+    trackPoints = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void BLEStream::setMtu(uint16_t attMtu) {
+    if (attMtu < BLE_STREAM_DEFAULT_MTU) attMtu = BLE_STREAM_DEFAULT_MTU;
+    if (attMtu > BLE_STREAM_MAX_MTU)     attMtu = BLE_STREAM_MAX_MTU;
+    notifySize = attMtu - 3;
+}
+
+void BLEStream::copyIn(const uint8_t* data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) ring[(uint16_t)(head + i) & (BLE_STREAM_RING - 1)] = data[i];
+    head += len;
+}
+
+bool BLEStream::push(uint8_t type, const uint8_t* data, uint8_t len) {
+    if (space() < 2 + len) {
+        stats.dropped++;
+        return false;
+    }
+    uint8_t hdr[2] = { type, len };
+    copyIn(hdr, 2);
+    copyIn(data, len);
+    stats.records++;
+    return true;
+}
+
+void BLEStream::pushMark(uint8_t mark, uint16_t count) {
+    uint8_t m[3] = { mark };
+    put16(m + 1, count);
+    push(BLE_REC_MARK, m, sizeof(m));
+}
+
+// ── Dump ─────────────────────────────────────────────────────────────────────
+
+void BLEStream::startDump(const PeerTable& peers, const TrackLog& log, uint32_t now) {
+    if (dumping()) return;
+    dumpBytes         = 0;
+    stats.firstSentMs = 0;
+
+    pushMark(BLE_MARK_DUMP_START, peers.count());
+    uint16_t sent = 0;
+    for (uint8_t i = 0; i < peers.capacity(); i++) {
+        const PeerInfo& p = peers.get(i);
+        if (!p.used) continue;
+        uint8_t r[BLE_STREAM_PEER_LEN];
+        put16(r, p.addr);
+        put32(r + 2, (uint32_t)p.pos.latE6);
+        put32(r + 6, (uint32_t)p.pos.lonE6);
+        put16(r + 10, p.pos.speedKmhX10);
+        put16(r + 12, p.pos.courseDeg);
+        r[14] = p.satellites;
+        put16(r + 15, (uint16_t)p.rssi);
+        put16(r + 17, (uint16_t)p.snrX10);
+        put32(r + 19, now - p.lastHeard);
+        r[23] = p.hasPosition ? 1 : 0;
+        if (push(BLE_REC_PEER, r, sizeof(r))) sent++;
+    }
+    pushMark(BLE_MARK_PEERS_END, sent);
+
+    track       = &log;
+    trackSeq    = log.oldestSeq();
+    trackPoints = 0;
+    refill();
+}
+
+void BLEStream::refill() {
+    while (track) {
+        // Whole chunks only: encode once there is room for the largest one
+        if (space() < 2 + 4 + BLE_STREAM_TRACK_CHUNK) return;
+
+        uint8_t  r[4 + BLE_STREAM_TRACK_CHUNK];
+        uint16_t encoded;
+        if (trackSeq < track->oldestSeq()) trackSeq = track->oldestSeq();   // overwritten meanwhile
+        size_t n = track->encodeCompact(trackSeq, r + 4, BLE_STREAM_TRACK_CHUNK, encoded);
+        if (n == 0) {
+            track = nullptr;
+            pushMark(BLE_MARK_DUMP_END, trackPoints);
+            return;
+        }
+        put32(r, trackSeq);
+        push(BLE_REC_TRACK, r, (uint8_t)(4 + n));
+        trackSeq    += encoded;
+        trackPoints += encoded;
+    }
+}
+
+// ── Notifications ────────────────────────────────────────────────────────────
+
+size_t BLEStream::next(uint8_t* buf, size_t cap, uint32_t now) {
+    if (inFlight && now - lastSentMs > BLE_STREAM_CREDIT_TIMEOUT_MS) {
+        inFlight = 0;
+        stats.timeouts++;
+    }
+    if (queued() == 0 || cap <= BLE_STREAM_HEADER) return 0;
+    if (inFlight >= BLE_STREAM_IN_FLIGHT) {
+        stats.creditWaits++;
+        return 0;
+    }
+
+    size_t   room = min(cap, (size_t)notifySize) - BLE_STREAM_HEADER;
+    uint16_t n    = (uint16_t)min(room, (size_t)queued());
+    put16(buf, seq);
+    for (uint16_t i = 0; i < n; i++) {
+        buf[BLE_STREAM_HEADER + i] = ring[(uint16_t)(tail + i) & (BLE_STREAM_RING - 1)];
+    }
+    tail    += n;
+    lastLen  = n;
+    seq++;
+    inFlight++;
+    lastSentMs = now;
+    if (dumpBytes == 0) stats.firstSentMs = now;
+    dumpBytes += n + BLE_STREAM_HEADER;
+    stats.notifications++;
+    stats.bytes += n + BLE_STREAM_HEADER;
+    return n + BLE_STREAM_HEADER;
+}
+
+void BLEStream::unsend() {
+    if (lastLen == 0) return;
+    tail -= lastLen;
+    seq--;
+    if (inFlight) inFlight--;
+    dumpBytes -= lastLen + BLE_STREAM_HEADER;
+    stats.notifications--;
+    stats.bytes -= lastLen + BLE_STREAM_HEADER;
+    stats.refused++;
+    lastLen = 0;
+}
+
+void BLEStream::onSent(uint32_t now) {
+    if (inFlight) inFlight--;
+    stats.lastDoneMs = now;
+}
+
+uint32_t BLEStream::bytesPerSecond() const {
+    if (dumpBytes == 0) return 0;
+    uint32_t ms = stats.lastDoneMs - stats.firstSentMs;
+    if (ms == 0) ms = 1;
+    return (uint32_t)((uint64_t)dumpBytes * 1000 / ms);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file Checksum.cpp
+ * @brief CRC-16/CCITT and CRC-32 implementations
+ */
+
+#include "Checksum.h"
+
+uint16_t crc16(const void* data, size_t len, uint16_t crc) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint32_t crc32(const void* data, size_t len, uint32_t crc) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file DeltaPatch.cpp
+ * @brief Patch record state machine, buffered output, base and result hashes
+ */
+
+#include "DeltaPatch.h"
+
+static inline uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+DeltaPatcher::DeltaPatcher()
+    : oldImage(nullptr), oldImageSize(0), out(nullptr), headerLen(0), phase(PH_ERROR),
+      error(DELTA_BAD_PATCH), varint(0), varintShift(0), diffLeft(0), extraLeft(0), runLeft(0),
+      seek(0), oldPos(0), newPos(0), bufLen(0) {
+    memset(&header, 0, sizeof(header));
+}
+
+bool DeltaPatcher::parseHeader(const uint8_t* p, size_t len, DeltaHeader& h) {
+    if (len < DELTA_HEADER_LEN || get32(p) != DELTA_MAGIC) return false;
+    h.oldSize = get32(p + 4);
+    h.newSize = get32(p + 8);
+    memcpy(h.oldSha256, p + 12, SHA256_DIGEST_SIZE);
+    memcpy(h.newSha256, p + 12 + SHA256_DIGEST_SIZE, SHA256_DIGEST_SIZE);
+    return true;
+}
+
+bool DeltaPatcher::matchesBase(const DeltaHeader& h, const uint8_t* image, uint32_t imageSize) {
+    if (!image || h.oldSize > imageSize) return false;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    Sha256::hash(image, h.oldSize, digest);
+    return memcmp(digest, h.oldSha256, SHA256_DIGEST_SIZE) == 0;
+}
+
+void DeltaPatcher::begin(const uint8_t* image, uint32_t imageSize, Print& sink) {
+    oldImage     = image;
+    oldImageSize = imageSize;
+    out          = &sink;
+    headerLen    = 0;
+    phase        = PH_HEADER;
+    varint       = 0;
+    varintShift  = 0;
+    oldPos       = 0;
+    newPos       = 0;
+    bufLen       = 0;
+    hasher.reset();
+}
+
+DeltaResult DeltaPatcher::fail(DeltaResult r) {
+    phase = PH_ERROR;
+    error = r;
+    return r;
+}
+
+bool DeltaPatcher::takeVarint(uint8_t b) {
+    varint |= (uint32_t)(b & 0x7F) << varintShift;
+    varintShift += 7;
+    if (b & 0x80) return false;
+    varintShift = 0;
+    return true;
+}
+
+bool DeltaPatcher::flush() {
+    if (bufLen == 0) return true;
+    if (out->write(buf, bufLen) != bufLen) return false;
+    hasher.update(buf, bufLen);
+    bufLen = 0;
+    return true;
+}
+
+bool DeltaPatcher::emit(const uint8_t* data, size_t len) {
+    newPos += len;
+    while (len) {
+        size_t n = min(len, (size_t)(sizeof(buf) - bufLen));
+        memcpy(buf + bufLen, data, n);
+        bufLen += n;
+        data   += n;
+        len    -= n;
+        if (bufLen == sizeof(buf) && !flush()) return false;
+    }
+    return true;
+}
+
+void DeltaPatcher::endRecord() {
+    // Bounds of the new position were checked with the seek varint
+    oldPos = (uint32_t)((int64_t)oldPos + seek);
+    phase  = newPos == header.newSize ? PH_DONE : PH_DIFF_LEN;
+}
+
+DeltaResult DeltaPatcher::write(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        switch (phase) {
+            case PH_HEADER: {
+                size_t n = min(len - i, (size_t)(DELTA_HEADER_LEN - headerLen));
+                memcpy(headerBuf + headerLen, data + i, n);
+                headerLen += n;
+                i         += n;
+                if (headerLen < DELTA_HEADER_LEN) break;
+                if (!parseHeader(headerBuf, headerLen, header)) return fail(DELTA_BAD_PATCH);
+                if (!matchesBase(header, oldImage, oldImageSize)) return fail(DELTA_WRONG_BASE);
+                phase = header.newSize ? PH_DIFF_LEN : PH_DONE;
+                break;
+            }
+
+            case PH_DIFF_LEN:
+            case PH_EXTRA_LEN:
+            case PH_SEEK:
+            case PH_ZERO_RUN:
+            case PH_DELTA_LEN: {
+                if (varintShift > 28) return fail(DELTA_BAD_PATCH);
+                if (!takeVarint(data[i++])) break;
+                uint32_t v = varint;
+                varint = 0;
+
+                if (phase == PH_DIFF_LEN) {
+                    diffLeft = v;
+                    phase    = PH_EXTRA_LEN;
+                } else if (phase == PH_EXTRA_LEN) {
+                    extraLeft = v;
+                    phase     = PH_SEEK;
+                } else if (phase == PH_SEEK) {
+                    seek = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+                    int64_t next = (int64_t)oldPos + diffLeft + seek;
+                    if ((uint64_t)diffLeft + extraLeft > header.newSize - newPos ||
+                        (uint64_t)oldPos + diffLeft > header.oldSize ||
+                        next < 0 || next > (int64_t)header.oldSize) {
+                        return fail(DELTA_BAD_PATCH);
+                    }
+                    if (diffLeft)       phase = PH_ZERO_RUN;
+                    else if (extraLeft) phase = PH_EXTRA;
+                    else                endRecord();
+                } else if (phase == PH_ZERO_RUN) {
+                    if (v > diffLeft) return fail(DELTA_BAD_PATCH);
+                    if (!emit(oldImage + oldPos, v)) return fail(DELTA_WRITE_FAILED);
+                    oldPos   += v;
+                    diffLeft -= v;
+                    phase     = PH_DELTA_LEN;
+                } else {
+                    if (v > diffLeft) return fail(DELTA_BAD_PATCH);
+                    runLeft = v;
+                    if (runLeft)        phase = PH_DELTA;
+                    else if (diffLeft)  phase = PH_ZERO_RUN;
+                    else if (extraLeft) phase = PH_EXTRA;
+                    else                endRecord();
+                }
+                break;
+            }
+
+            case PH_DELTA: {
+                size_t n = min(len - i, (size_t)runLeft);
+                for (size_t k = 0; k < n; k++) {
+                    buf[bufLen++] = (uint8_t)(oldImage[oldPos++] + data[i++]);
+                    if (bufLen == sizeof(buf) && !flush()) return fail(DELTA_WRITE_FAILED);
+                }
+                newPos   += n;
+                runLeft  -= n;
+                diffLeft -= n;
+                if (runLeft)        break;
+                if (diffLeft)       phase = PH_ZERO_RUN;
+                else if (extraLeft) phase = PH_EXTRA;
+                else                endRecord();
+                break;
+            }
+
+            case PH_EXTRA: {
+                size_t n = min(len - i, (size_t)extraLeft);
+                if (!emit(data + i, n)) return fail(DELTA_WRITE_FAILED);
+                i         += n;
+                extraLeft -= n;
+                if (extraLeft == 0) endRecord();
+                break;
+            }
+
+            case PH_DONE:
+                return fail(DELTA_BAD_PATCH);   // bytes past the end of the image
+
+            case PH_ERROR:
+            default:
+                return error;
+        }
+    }
+    return phase == PH_ERROR ? error : DELTA_OK;
+}
+
+DeltaResult DeltaPatcher::finish() {
+    if (phase == PH_ERROR) return error;
+    if (phase != PH_DONE) return fail(DELTA_BAD_PATCH);
+    if (!flush()) return fail(DELTA_WRITE_FAILED);
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    hasher.finish(digest);
+    if (memcmp(digest, header.newSha256, SHA256_DIGEST_SIZE) != 0) return fail(DELTA_BAD_HASH);
+    return DELTA_DONE;
+}
+
+const char* DeltaPatcher::resultName(DeltaResult r) {
+    switch (r) {
+        case DELTA_OK:           return "ok";
+        case DELTA_DONE:         return "done";
+        case DELTA_BAD_PATCH:    return "bad patch";
+        case DELTA_WRONG_BASE:   return "wrong base";
+        case DELTA_WRITE_FAILED: return "write failed";
+        case DELTA_BAD_HASH:     return "bad hash";
+        default:                 return "?";
+    }
+}
@@ -0,0 +1,362 @@
+/**
+ * @file DeviceConfig.cpp
+ * @brief Settings record codec, range checks, timed per-group apply, LittleFS store
+ */
+
+#include "DeviceConfig.h"
+#include <LittleFS.h>
+#include "Checksum.h"
+
+// RYLR896 datasheet limits
+#define LORA_FREQ_MIN_HZ    862000000UL
+#define LORA_FREQ_MAX_HZ    1020000000UL
+#define LORA_POWER_MAX_DBM  15
+
+// NEO-7m: 10 Hz at most; slower than 0.1 Hz is better done with power save
+#define GPS_RATE_MIN_MS     100
+#define GPS_RATE_MAX_MS     10000
+
+#define HEARTBEAT_MIN_MS    200
+#define HEARTBEAT_MAX_MS    60000
+#define KEEPALIVE_MIN_MS    TX_MIN_INTERVAL_MS
+#define KEEPALIVE_MAX_MS    3600000UL
+
+// RYLR896 AT+ADDRESS range; 0 is the module's broadcast address
+#define LORA_ADDRESS_MIN    1
+
+#define RADIO_GROUPS (CONFIG_GROUP_BAND | CONFIG_GROUP_PARAMETER | CONFIG_GROUP_POWER | \
+                      CONFIG_GROUP_ADDRESS)
+
+static inline void put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+    return (uint32_t)get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+DeviceConfig::DeviceConfig(LoRaComm& l, GPS& g, TxPolicy& p, uint32_t& hb)
+    : lora(l), gps(g), policy(p), heartbeatMs(hb), current(defaults()) {
+    memset(&report, 0, sizeof(report));
+}
+
+DeviceSettings DeviceConfig::defaults() {
+    DeviceSettings s;
+    s.loraFreqHz     = LORA_FREQ_HZ;
+    s.loraSf         = LORA_PARAM_SF;
+    s.loraBw         = LORA_PARAM_BW;
+    s.loraCr         = LORA_PARAM_CR;
+    s.loraPreamble   = LORA_PARAM_PP;
+    s.loraPowerDbm   = CONFIG_DEFAULT_POWER_DBM;
+    s.gpsRateMs      = CONFIG_DEFAULT_GPS_RATE_MS;
+    s.heartbeatMs    = CONFIG_DEFAULT_HEARTBEAT_MS;
+    s.keepaliveCapMs = 0;
+    s.address        = DEVICE_ADDRESS;
+    s.target         = TARGET_ADDRESS;
+    return s;
+}
+
+// ── Wire format ──────────────────────────────────────────────────────────────
+
+size_t DeviceConfig::encode(const DeviceSettings& s, uint8_t* buf, size_t cap) {
+    if (cap < CONFIG_WIRE_LEN) return 0;
+    buf[0] = CONFIG_WIRE_VERSION;
+    buf[1] = 0;
+    put32(buf + 2, s.loraFreqHz);
+    buf[6]  = s.loraSf;
+    buf[7]  = s.loraBw;
+    buf[8]  = s.loraCr;
+    buf[9]  = s.loraPreamble;
+    buf[10] = s.loraPowerDbm;
+    put16(buf + 11, s.gpsRateMs);
+    put16(buf + 13, s.heartbeatMs);
+    put32(buf + 15, s.keepaliveCapMs);
+    put16(buf + 19, s.address);
+    put16(buf + 21, s.target);
+    put16(buf + 23, crc16(buf, 23));
+    return CONFIG_WIRE_LEN;
+}
+
+ConfigResult DeviceConfig::decode(const uint8_t* buf, size_t len, DeviceSettings& s,
+                                  ConfigField& field) {
+    field = CONFIG_FIELD_NONE;
+    // Version first: a newer record is longer, and that is the real reason
+    if (len >= 1 && buf[0] != CONFIG_WIRE_VERSION && buf[0] != 1) return CONFIG_BAD_VERSION;
+    size_t want = len >= 1 && buf[0] == 1 ? CONFIG_WIRE_LEN_V1 : CONFIG_WIRE_LEN;
+    if (len != want)                                   return CONFIG_BAD_LENGTH;
+    if (get16(buf + want - 2) != crc16(buf, want - 2)) return CONFIG_BAD_CRC;
+
+    s.loraFreqHz     = get32(buf + 2);
+    s.loraSf         = buf[6];
+    s.loraBw         = buf[7];
+    s.loraCr         = buf[8];
+    s.loraPreamble   = buf[9];
+    s.loraPowerDbm   = buf[10];
+    s.gpsRateMs      = get16(buf + 11);
+    s.heartbeatMs    = get16(buf + 13);
+    s.keepaliveCapMs = get32(buf + 15);
+    if (want == CONFIG_WIRE_LEN) {              // version 1 leaves the caller's pair
+        s.address = get16(buf + 19);
+        s.target  = get16(buf + 21);
+    }
+
+    field = validate(s);
+    return field == CONFIG_FIELD_NONE ? CONFIG_OK : CONFIG_OUT_OF_RANGE;
+}
+
+ConfigField DeviceConfig::validate(const DeviceSettings& s) {
+    if (s.loraFreqHz < LORA_FREQ_MIN_HZ || s.loraFreqHz > LORA_FREQ_MAX_HZ) return CONFIG_FIELD_FREQ;
+    if (s.loraSf < 7 || s.loraSf > 12)                 return CONFIG_FIELD_SF;
+    if (s.loraBw > 9)                                  return CONFIG_FIELD_BW;
+    if (s.loraCr < 1 || s.loraCr > 4)                  return CONFIG_FIELD_CR;
+    if (s.loraPreamble < 4 || s.loraPreamble > 24)     return CONFIG_FIELD_PREAMBLE;
+    if (s.loraPowerDbm > LORA_POWER_MAX_DBM)           return CONFIG_FIELD_POWER;
+    if (s.gpsRateMs < GPS_RATE_MIN_MS || s.gpsRateMs > GPS_RATE_MAX_MS) return CONFIG_FIELD_GPS_RATE;
+    if (s.heartbeatMs < HEARTBEAT_MIN_MS || s.heartbeatMs > HEARTBEAT_MAX_MS) {
+        return CONFIG_FIELD_HEARTBEAT;
+    }
+    if (s.keepaliveCapMs &&
+        (s.keepaliveCapMs < KEEPALIVE_MIN_MS || s.keepaliveCapMs > KEEPALIVE_MAX_MS)) {
+        return CONFIG_FIELD_KEEPALIVE;
+    }
+    if (s.address < LORA_ADDRESS_MIN)                  return CONFIG_FIELD_ADDRESS;
+    if (s.target == s.address)                         return CONFIG_FIELD_TARGET;
+    return CONFIG_FIELD_NONE;
+}
+
+// ── Apply ────────────────────────────────────────────────────────────────────
+
+bool DeviceConfig::begin() {
+    if (!LittleFS.begin()) return false;
+    uint8_t buf[CONFIG_WIRE_LEN + 1];   // one spare byte to notice a longer file
+    size_t  n = 0;
+    File    f = LittleFS.open(CONFIG_FILE, "r");
+    bool    found = (bool)f;
+    if (found) {
+        n = f.read(buf, sizeof(buf));
+        f.close();
+    }
+
+    DeviceSettings s = defaults();      // a version 1 file migrates to the build's pair
+    ConfigField    field;
+    ConfigResult   r = found ? decode(buf, n, s, field) : CONFIG_BAD_LENGTH;
+    if (r != CONFIG_OK) {
+        // First boot (or a lost record): pin the build's identity so a later
+        // image built with other defaults does not change this unit's address
+        if (found) Serial.println("[Config] " CONFIG_FILE " ignored: " + String(resultName(r)));
+        Serial.println("[Config] Saving defaults, address " + String(current.address) +
+                       " → " + String(current.target));
+        save();
+        return false;
+    }
+    applyChanges(s, false);
+    Serial.println("[Config] Loaded, address " + String(current.address) + " → " +
+                   String(current.target) + ": " + describe(report));
+    return true;
+}
+
+const ConfigReport& DeviceConfig::apply(const DeviceSettings& next) {
+    return applyChanges(next, true);
+}
+
+const ConfigReport& DeviceConfig::applyWire(const uint8_t* data, size_t len) {
+    uint32_t       t0 = micros();
+    DeviceSettings next = current;      // a version 1 write keeps the addresses in force
+    ConfigField    field;
+    ConfigResult   r = decode(data, len, next, field);
+    if (r != CONFIG_OK) {
+        memset(&report, 0, sizeof(report));
+        report.result  = r;
+        report.field   = field;
+        report.totalUs = micros() - t0;
+        return report;
+    }
+    return applyChanges(next, true);
+}
+
+uint8_t DeviceConfig::applyRadio(const DeviceSettings& next, uint8_t groups) {
+    // The RYLR896 only listens to AT commands when awake
+    bool    wasAsleep = lora.isSleeping();
+    uint8_t failed    = 0;
+    if (wasAsleep) lora.wake();
+
+    if (groups & CONFIG_GROUP_ADDRESS) {
+        if (lora.setAddress(next.address)) current.address = next.address;
+        else                               failed |= CONFIG_GROUP_ADDRESS;
+    }
+    if (groups & CONFIG_GROUP_BAND) {
+        if (lora.setFrequency(next.loraFreqHz)) current.loraFreqHz = next.loraFreqHz;
+        else                                    failed |= CONFIG_GROUP_BAND;
+    }
+    if (groups & CONFIG_GROUP_PARAMETER) {
+        if (lora.setRfParameters(next.loraSf, next.loraBw, next.loraCr, next.loraPreamble)) {
+            current.loraSf       = next.loraSf;
+            current.loraBw       = next.loraBw;
+            current.loraCr       = next.loraCr;
+            current.loraPreamble = next.loraPreamble;
+        } else {
+            failed |= CONFIG_GROUP_PARAMETER;
+        }
+    }
+    if (groups & CONFIG_GROUP_POWER) {
+        if (lora.setOutputPower(next.loraPowerDbm)) current.loraPowerDbm = next.loraPowerDbm;
+        else                                        failed |= CONFIG_GROUP_POWER;
+    }
+
+    if (wasAsleep) lora.sleep();
+    return failed;
+}
+
+const ConfigReport& DeviceConfig::applyChanges(const DeviceSettings& next, bool persist) {
+    uint32_t t0 = micros();
+    memset(&report, 0, sizeof(report));
+
+    report.field = validate(next);
+    if (report.field != CONFIG_FIELD_NONE) {
+        report.result  = CONFIG_OUT_OF_RANGE;
+        report.totalUs = micros() - t0;
+        return report;
+    }
+
+    uint8_t groups = 0;
+    if (next.address != current.address)       groups |= CONFIG_GROUP_ADDRESS;
+    if (next.target != current.target)         groups |= CONFIG_GROUP_TARGET;
+    if (next.loraFreqHz != current.loraFreqHz) groups |= CONFIG_GROUP_BAND;
+    if (next.loraSf != current.loraSf || next.loraBw != current.loraBw ||
+        next.loraCr != current.loraCr || next.loraPreamble != current.loraPreamble) {
+        groups |= CONFIG_GROUP_PARAMETER;
+    }
+    if (next.loraPowerDbm != current.loraPowerDbm) groups |= CONFIG_GROUP_POWER;
+    if (next.gpsRateMs != current.gpsRateMs)       groups |= CONFIG_GROUP_GPS;
+    if (next.heartbeatMs != current.heartbeatMs ||
+        next.keepaliveCapMs != current.keepaliveCapMs) {
+        groups |= CONFIG_GROUP_HEARTBEAT;
+    }
+    report.changed = groups;
+
+    uint32_t t;
+    if (groups & RADIO_GROUPS) {
+        t = micros();
+        report.failed |= applyRadio(next, groups);
+        report.radioUs = micros() - t;
+    }
+    if (groups & CONFIG_GROUP_GPS) {
+        t = micros();
+        if (gps.setRate(next.gpsRateMs)) current.gpsRateMs = next.gpsRateMs;
+        else                             report.failed |= CONFIG_GROUP_GPS;
+        report.gpsUs = micros() - t;
+    }
+    if (groups & CONFIG_GROUP_HEARTBEAT) {
+        t = micros();
+        heartbeatMs = next.heartbeatMs;
+        policy.setKeepaliveCap(next.keepaliveCapMs);
+        current.heartbeatMs    = next.heartbeatMs;
+        current.keepaliveCapMs = next.keepaliveCapMs;
+        report.heartbeatUs = micros() - t;
+    }
+    if (groups & CONFIG_GROUP_TARGET) current.target = next.target;   // software only
+
+    if (persist && (groups & ~report.failed)) {
+        t = micros();
+        report.saved  = save();
+        report.saveUs = micros() - t;
+        if (!report.saved) report.result = CONFIG_SAVE_FAILED;
+    }
+    if (report.failed) report.result = CONFIG_APPLY_FAILED;
+    report.totalUs = micros() - t0;
+    return report;
+}
+
+bool DeviceConfig::save() {
+    uint8_t buf[CONFIG_WIRE_LEN];
+    encode(current, buf, sizeof(buf));
+
+    // Temp file + rename: a power cut leaves the old settings, never a torn file
+    File f = LittleFS.open(CONFIG_FILE ".tmp", "w");
+    if (!f) return false;
+    bool ok = f.write(buf, sizeof(buf)) == sizeof(buf);
+    f.close();
+    if (!ok) {
+        LittleFS.remove(CONFIG_FILE ".tmp");
+        return false;
+    }
+    // rename replaces the old record atomically; removing it first would
+    // open a window with neither file on a power cut
+    if (!LittleFS.rename(CONFIG_FILE ".tmp", CONFIG_FILE)) {
+        LittleFS.remove(CONFIG_FILE ".tmp");
+        return false;
+    }
+    return true;
+}
+
+// ── Reporting ────────────────────────────────────────────────────────────────
+
+static String msText(uint32_t us) {
+    return String(us / 1000) + "." + String(us / 100 % 10) + " ms";
+}
+
+String DeviceConfig::describe(const ConfigReport& r) {
+    String s = resultName(r.result);
+    if (r.result == CONFIG_OUT_OF_RANGE) return s + ": " + fieldName(r.field);
+    if (r.result != CONFIG_OK && r.result != CONFIG_APPLY_FAILED &&
+        r.result != CONFIG_SAVE_FAILED) {
+        return s;
+    }
+    if (!r.changed) return s + ": no change";
+
+    s += ":";
+    if (r.changed & RADIO_GROUPS)           s += " radio " + msText(r.radioUs) + ",";
+    if (r.changed & CONFIG_GROUP_GPS)       s += " gps " + msText(r.gpsUs) + ",";
+    if (r.changed & CONFIG_GROUP_HEARTBEAT) s += " heartbeat " + msText(r.heartbeatUs) + ",";
+    if (r.saved)                            s += " save " + msText(r.saveUs) + ",";
+    s += " total " + msText(r.totalUs);
+    if (r.failed) {
+        s += "; refused:";
+        if (r.failed & CONFIG_GROUP_ADDRESS)   s += " address";
+        if (r.failed & CONFIG_GROUP_BAND)      s += " band";
+        if (r.failed & CONFIG_GROUP_PARAMETER) s += " parameter";
+        if (r.failed & CONFIG_GROUP_POWER)     s += " power";
+        if (r.failed & CONFIG_GROUP_GPS)       s += " gps";
+    }
+    return s;
+}
+
+const char* DeviceConfig::resultName(ConfigResult r) {
+    switch (r) {
+        case CONFIG_OK:           return "ok";
+        case CONFIG_BAD_LENGTH:   return "bad length";
+        case CONFIG_BAD_VERSION:  return "unsupported version";
+        case CONFIG_BAD_CRC:      return "bad CRC";
+        case CONFIG_OUT_OF_RANGE: return "out of range";
+        case CONFIG_APPLY_FAILED: return "partly applied";
+        case CONFIG_SAVE_FAILED:  return "applied, not saved";
+        default:                  return "?";
+    }
+}
+
+const char* DeviceConfig::fieldName(ConfigField f) {
+    switch (f) {
+        case CONFIG_FIELD_FREQ:      return "frequency";
+        case CONFIG_FIELD_SF:        return "spreading factor";
+        case CONFIG_FIELD_BW:        return "bandwidth";
+        case CONFIG_FIELD_CR:        return "coding rate";
+        case CONFIG_FIELD_PREAMBLE:  return "preamble";
+        case CONFIG_FIELD_POWER:     return "output power";
+        case CONFIG_FIELD_GPS_RATE:  return "GPS rate";
+        case CONFIG_FIELD_HEARTBEAT: return "heartbeat interval";
+        case CONFIG_FIELD_KEEPALIVE: return "keepalive cap";
+        case CONFIG_FIELD_ADDRESS:   return "address";
+        case CONFIG_FIELD_TARGET:    return "target address";
+        default:                     return "none";
+    }
+}
@@ -4,13 +4,115 @@
  *
  * Wire.setSDA / Wire.setSCL must be called before Wire.begin() in arduino-pico.
  * The display object is stack-allocated so no heap allocation is needed.
+ *
+ * Only begin() uses Adafruit's full-frame display(); every later frame goes
+ * through flush(), which sends just the dirty span of each page — by DMA
+ * straight into the I2C0 TX FIFO when a channel is available.
+ *
+ * Wire and the DMA path share I2C0.  Nothing else is on this bus, and Wire
+ * re-programs the target address on every transaction, so the DMA path just
+ * sets TAR itself before each transfer.
  */
 
 #include "Display.h"
+#include "FixedMath.h"
+#include <hardware/dma.h>
+#include <hardware/i2c.h>
+#include <hardware/irq.h>
+
+// I2C control bytes (Co = 0): following bytes are commands / GDDRAM data
+static const uint8_t SSD1306_CTRL_CMD  = 0x00;
+static const uint8_t SSD1306_CTRL_DATA = 0x40;
+
+// The DMA IRQ is shared and has no context pointer
+static Display* dmaOwner = nullptr;
+
+// ── Screen layouts ──────────────────────────────────────────────────────────
+// One text row per 8 px page; a value starts right after its label.
+
+#define COL(chars) ((chars) * TEXT_CHAR_WIDTH)
+
+struct ScreenLayout {
+    const TextLabel* labels;
+    uint8_t          labelCount;
+    const TextSlot*  slots;
+    uint8_t          slotCount;
+};
+
+enum GpsField   : uint8_t { GPS_FIX, GPS_SATS, GPS_LAT, GPS_LON, GPS_ALT };
+enum RadioField : uint8_t { RADIO_TX, RADIO_RX, RADIO_RSSI, RADIO_SNR, RADIO_MSG };
+enum LinkField  : uint8_t { LINK_PEER, LINK_RSSI_AVG, LINK_RSSI_RANGE,
+                            LINK_SNR_AVG, LINK_SNR_RANGE };
+enum RadarField : uint8_t { RADAR_SCALE, RADAR_PEERS, RADAR_NEAR_ID, RADAR_NEAR_RANGE,
+                            RADAR_NEAR_BEARING };
+
+static constexpr TextLabel GPS_LABELS[] = {
+    {0, 0, "-- GPS --"}, {1, 0, "Fix:"}, {2, 0, "Sat:"},
+    {3, 0, "Lat:"},      {4, 0, "Lon:"}, {5, 0, "Alt:"},
+};
+static constexpr TextSlot GPS_SLOTS[] = {
+    {1, COL(5), 3}, {2, COL(5), 3}, {3, COL(5), 12}, {4, COL(5), 12}, {5, COL(5), 10},
+};
+
+static constexpr TextLabel RADIO_LABELS[] = {
+    {0, 0, "-- RADIO --"}, {1, 0, "TX:"},  {2, 0, "RX:"},
+    {3, 0, "RSSI:"},       {4, 0, "SNR:"}, {5, 0, "Msg:"},
+};
+static constexpr TextSlot RADIO_SLOTS[] = {
+    {1, COL(4), 10}, {2, COL(4), 10}, {3, COL(6), 6}, {4, COL(6), 6},
+    {5, COL(5), DISPLAY_FIELD_CHARS},
+};
+
+// Text panel to the right of the 64 px scope: 10 characters wide
+#define RADAR_TEXT_COL (RADAR_SIZE + 2)
+#define RADAR_TEXT_CHARS ((SCREEN_WIDTH - RADAR_TEXT_COL) / TEXT_CHAR_WIDTH)
+
+static constexpr TextLabel RADAR_LABELS[] = {
+    {0, RADAR_TEXT_COL, "RADAR"}, {3, RADAR_TEXT_COL, "Nearest"},
+};
+static constexpr TextSlot RADAR_SLOTS[] = {
+    {1, RADAR_TEXT_COL, RADAR_TEXT_CHARS}, {2, RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+    {4, RADAR_TEXT_COL, RADAR_TEXT_CHARS}, {5, RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+    {6, RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+};
+
+// Link screen: sparklines in the left 64 columns, stats beside them
+static constexpr TextLabel LINK_LABELS[] = {
+    {0, 0, "LINK"}, {SPARK_RSSI_PAGE, RADAR_TEXT_COL, "RSSI"},
+    {SPARK_SNR_PAGE, RADAR_TEXT_COL, "SNR"},
+};
+static constexpr TextSlot LINK_SLOTS[] = {
+    {0, COL(5), 16},
+    {SPARK_RSSI_PAGE + 1, RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+    {SPARK_RSSI_PAGE + 2, RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+    {SPARK_SNR_PAGE + 1,  RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+    {SPARK_SNR_PAGE + 2,  RADAR_TEXT_COL, RADAR_TEXT_CHARS},
+};
+
+#define LAYOUT_OF(l, f) { l, sizeof(l) / sizeof(l[0]), f, sizeof(f) / sizeof(f[0]) }
+static constexpr ScreenLayout LAYOUTS[] = {
+    { nullptr, 0, nullptr, 0 },               // LAYOUT_NONE
+    LAYOUT_OF(GPS_LABELS,   GPS_SLOTS),
+    LAYOUT_OF(RADIO_LABELS, RADIO_SLOTS),
+    LAYOUT_OF(RADAR_LABELS, RADAR_SLOTS),
+    LAYOUT_OF(LINK_LABELS,  LINK_SLOTS),
+};
+static_assert(sizeof(GPS_SLOTS)   / sizeof(TextSlot) <= DISPLAY_MAX_FIELDS, "GPS layout");
+static_assert(sizeof(RADIO_SLOTS) / sizeof(TextSlot) <= DISPLAY_MAX_FIELDS, "radio layout");
+static_assert(sizeof(RADAR_SLOTS) / sizeof(TextSlot) <= DISPLAY_MAX_FIELDS, "radar layout");
+static_assert(sizeof(LINK_SLOTS)  / sizeof(TextSlot) <= DISPLAY_MAX_FIELDS, "link layout");
 
 Display::Display()
-    : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1),
-      initialized(false), lastUpdate(0) {}
+    : display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, OLED_I2C_CLOCK, OLED_I2C_CLOCK),
+      initialized(false), lastUpdate(0), shadowValid(false),
+      lastFlushBytes(0), totalFlushBytes(0), lastFlushUs(0),
+      lastSubmitUs(0), streamLen(0), dmaChannel(-1), dmaDone(false),
+      dmaActive(false), flushPending(false), transferStartUs(0),
+      coalescedFrames(0), flushErrors(0), layout(LAYOUT_NONE),
+      lastRenderCycles(0), sparkAddr(0), sparkSeq(0), sparkValid(false) {
+    memset(shadow, 0, sizeof(shadow));
+    memset(fieldText, 0, sizeof(fieldText));
+}
 
 bool Display::begin() {
     Serial.println("[Display] Initializing SSD1306...");
@@ -32,34 +134,278 @@ bool Display::begin() {
     display.println("B.R.A.V.O.");
     display.println("Starting...");
     display.display();
+    memcpy(shadow, display.getBuffer(), DISPLAY_BUFFER_SIZE);
+    shadowValid = true;
     Serial.println("[Display] SSD1306 OK");
+
+    if (!beginDma()) {
+        Serial.println("[Display] No free DMA channel — using blocking flush");
+    }
     return true;
 }
 
 void Display::clear() {
     if (!initialized) return;
+    beginFreeform();
+    flush();
+}
+
+// ── Layout composition ──────────────────────────────────────────────────────
+
+bool Display::useLayout(uint8_t id) {
+    if (layout == id) return false;
+    layout = id;
     display.clearDisplay();
-    display.display();
+    memset(fieldText, 0, sizeof(fieldText));
+
+    const ScreenLayout& l = LAYOUTS[id];
+    uint8_t* fb = display.getBuffer();
+    for (uint8_t i = 0; i < l.labelCount; i++) {
+        TextRenderer::drawText(fb, l.labels[i].page, l.labels[i].col,
+                               l.labels[i].text, TEXT_COLUMNS);
+    }
+    return true;
 }
 
-// ── Screen A: GPS ───────────────────────────────────────────────────────────
+void Display::setField(uint8_t slot, const char* text) {
+    char* cached = fieldText[slot];
+    if (strncmp(cached, text, DISPLAY_FIELD_CHARS) == 0) return;
 
-void Display::showGPSScreen(const GPSData& gpsData) {
-    if (!initialized) return;
+    const TextSlot& s = LAYOUTS[layout].slots[slot];
+    TextRenderer::drawText(display.getBuffer(), s.page, s.col, text, s.chars);
+    strncpy(cached, text, DISPLAY_FIELD_CHARS);
+    cached[DISPLAY_FIELD_CHARS] = '\0';
+}
+
+void Display::beginFreeform() {
+    layout = LAYOUT_NONE;
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
+}
 
-    display.setCursor(0, 0);  display.println("-- GPS --");
-    display.print("Fix: ");   display.println(gpsData.valid ? "YES" : "NO ");
-    display.print("Sat: ");   display.println(gpsData.satellites);
-    display.print("Lat: ");   display.println(gpsData.valid ? String(gpsData.latitude,  5) : "--");
-    display.print("Lon: ");   display.println(gpsData.valid ? String(gpsData.longitude, 5) : "--");
-    display.print("Alt: ");
-    if (gpsData.valid) { display.print(gpsData.altitude, 1); display.println("m"); }
-    else               { display.println("--"); }
+// ── DMA transport ────────────────────────────────────────────────────────────
 
-    display.display();
+bool Display::beginDma() {
+    dmaChannel = dma_claim_unused_channel(false);
+    if (dmaChannel < 0) return false;
+
+    // 16-bit words into DATA_CMD: low byte is data, bit 9 issues STOP after it
+    dma_channel_config c = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c0, true));
+    dma_channel_configure(dmaChannel, &c, &i2c0_hw->data_cmd, stream, 0, false);
+
+    dmaOwner = this;
+    dma_channel_set_irq0_enabled(dmaChannel, true);
+    irq_add_shared_handler(DMA_IRQ_0, dmaIrqHandler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    Serial.println("[Display] DMA flush on channel " + String(dmaChannel) +
+                   " @ " + String(OLED_I2C_CLOCK / 1000) + " kHz");
+    return true;
+}
+
+void Display::dmaIrqHandler() {
+    if (!dmaOwner || dmaOwner->dmaChannel < 0) return;
+    if (dma_channel_get_irq0_status(dmaOwner->dmaChannel)) {
+        dma_channel_acknowledge_irq0(dmaOwner->dmaChannel);
+        dmaOwner->dmaDone = true;
+    }
+}
+
+void Display::startDma() {
+    i2c0_hw->enable = 0;
+    i2c0_hw->tar    = OLED_I2C_ADDR;
+    i2c0_hw->enable = 1;
+
+    dmaDone         = false;
+    dmaActive       = true;
+    transferStartUs = micros();
+    dma_channel_transfer_from_buffer_now(dmaChannel, stream, streamLen);
+}
+
+/**
+ * Retire the transfer in flight if it is over.  The DMA IRQ fires when the
+ * last word enters the TX FIFO; the frame is on the panel once the FIFO has
+ * drained and the controller has issued the final STOP.
+ * @return true if the bus is free for another frame
+ */
+bool Display::reapDma() {
+    if (!dmaActive) return true;
+
+    if (i2c0_hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        // NACK / arbitration loss: the controller flushed its FIFO.  Stop the
+        // channel and resend everything next time — the panel state is unknown.
+        dma_channel_set_irq0_enabled(dmaChannel, false);
+        dma_channel_abort(dmaChannel);
+        dma_channel_acknowledge_irq0(dmaChannel);
+        dma_channel_set_irq0_enabled(dmaChannel, true);
+        (void)i2c0_hw->clr_tx_abrt;
+        shadowValid = false;
+        flushErrors++;
+        dmaActive = false;
+        Serial.println("[Display] I2C transfer aborted");
+        return true;
+    }
+
+    uint32_t status = i2c0_hw->status;
+    if (!dmaDone || !(status & I2C_IC_STATUS_TFE_BITS) ||
+        (status & I2C_IC_STATUS_MST_ACTIVITY_BITS)) {
+        return false;
+    }
+    dmaActive   = false;
+    lastFlushUs = micros() - transferStartUs;
+    return true;
+}
+
+void Display::poll() {
+    if (dmaChannel < 0) return;
+    if (reapDma() && flushPending) flush();
+}
+
+// ── Differential flush ───────────────────────────────────────────────────────
+
+void Display::streamBytes(const uint8_t* bytes, uint16_t len, bool stop) {
+    for (uint16_t i = 0; i < len; i++) {
+        uint16_t w = bytes[i];
+        if (stop && i == len - 1) w |= I2C_IC_DATA_CMD_STOP_BITS;
+        stream[streamLen++] = w;
+    }
+    lastFlushBytes += len;
+}
+
+void Display::sendCommands(const uint8_t* cmds, uint8_t len) {
+    Wire.beginTransmission(OLED_I2C_ADDR);
+    Wire.write(SSD1306_CTRL_CMD);
+    Wire.write(cmds, len);
+    Wire.endTransmission();
+    lastFlushBytes += 2 + len;   // address + control + commands
+}
+
+void Display::sendData(const uint8_t* data, uint16_t len) {
+    while (len > 0) {
+        uint16_t n = len > DISPLAY_I2C_CHUNK ? DISPLAY_I2C_CHUNK : len;
+        Wire.beginTransmission(OLED_I2C_ADDR);
+        Wire.write(SSD1306_CTRL_DATA);
+        Wire.write(data, n);
+        Wire.endTransmission();
+        lastFlushBytes += 2 + n;
+        data += n;
+        len  -= n;
+    }
+}
+
+/**
+ * Address one page's dirty columns and write them.  On the DMA path both
+ * transactions go into the stream (the address byte is generated by the
+ * controller, but counted so both paths report bus bytes alike) and the data
+ * needs no chunking.
+ */
+void Display::emitWindow(uint8_t page, uint8_t first, uint8_t last,
+                         const uint8_t* data) {
+    uint8_t window[] = {
+        SSD1306_CTRL_CMD,
+        SSD1306_COLUMNADDR, first, last,
+        SSD1306_PAGEADDR,   page,  page
+    };
+    uint16_t span = (uint16_t)(last - first + 1);
+
+    if (dmaChannel < 0) {
+        sendCommands(window + 1, sizeof(window) - 1);
+        sendData(data, span);
+        return;
+    }
+    const uint8_t ctrlData = SSD1306_CTRL_DATA;
+    streamBytes(window, sizeof(window), true);
+    streamBytes(&ctrlData, 1, false);
+    streamBytes(data, span, true);
+    lastFlushBytes += 2;   // address byte of each transaction
+}
+
+/**
+ * For each 8-row page, find the first and last column that differ from the
+ * shadow and send just that span.  An unchanged frame costs no I2C traffic;
+ * a changed counter costs one small window instead of the whole 1 KB.
+ *
+ * With DMA the diff is taken against what has already been queued, so the
+ * shadow is updated at encode time.  If the previous frame is still on the
+ * bus the request is only recorded and poll() sends the latest framebuffer
+ * once it is free — intermediate frames are dropped, never queued.
+ */
+void Display::flush() {
+    if (dmaChannel >= 0 && !reapDma()) {
+        if (flushPending) coalescedFrames++;
+        flushPending = true;
+        return;
+    }
+    flushPending = false;
+
+    uint32_t t0    = micros();
+    uint8_t* buf   = display.getBuffer();
+    lastFlushBytes = 0;
+    streamLen      = 0;
+
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        uint8_t* row = buf    + page * SCREEN_WIDTH;
+        uint8_t* old = shadow + page * SCREEN_WIDTH;
+
+        int16_t first = 0;
+        int16_t last  = SCREEN_WIDTH - 1;
+        if (shadowValid) {
+            while (first < SCREEN_WIDTH && row[first] == old[first]) first++;
+            if (first == SCREEN_WIDTH) continue;
+            while (last > first && row[last] == old[last]) last--;
+        }
+
+        emitWindow(page, (uint8_t)first, (uint8_t)last, row + first);
+        memcpy(old + first, row + first, (size_t)(last - first + 1));
+    }
+    shadowValid      = true;
+    totalFlushBytes += lastFlushBytes;
+
+    if (dmaChannel < 0) {
+        lastFlushUs = lastSubmitUs = micros() - t0;
+        return;
+    }
+    if (streamLen > 0) startDma();
+    lastSubmitUs = micros() - t0;
+}
+
+// ── Screen A: GPS ───────────────────────────────────────────────────────────
+
+void Display::showGPSScreen(const GPSData& gpsData) {
+    if (!initialized) return;
+    uint32_t c0 = rp2040.getCycleCount();
+    char buf[DISPLAY_FIELD_CHARS + 1];
+
+    useLayout(LAYOUT_GPS);
+    setField(GPS_FIX, gpsData.valid ? "YES" : "NO");
+    TextRenderer::fmtUInt(buf, gpsData.satellites);
+    setField(GPS_SATS, buf);
+
+    if (gpsData.valid) {
+        // 5 decimals ≈ 1 m, rounded from microdegrees
+        int32_t lat = FixedMath::toMicroDeg(gpsData.latitude);
+        int32_t lon = FixedMath::toMicroDeg(gpsData.longitude);
+        TextRenderer::fmtFixed(buf, (lat + (lat < 0 ? -5 : 5)) / 10, 5);
+        setField(GPS_LAT, buf);
+        TextRenderer::fmtFixed(buf, (lon + (lon < 0 ? -5 : 5)) / 10, 5);
+        setField(GPS_LON, buf);
+        uint8_t n = TextRenderer::fmtFixed(buf, (int32_t)lround(gpsData.altitude * 10.0), 1);
+        buf[n] = 'm'; buf[n + 1] = '\0';
+        setField(GPS_ALT, buf);
+    } else {
+        setField(GPS_LAT, "--");
+        setField(GPS_LON, "--");
+        setField(GPS_ALT, "--");
+    }
+
+    lastRenderCycles = rp2040.getCycleCount() - c0;
+    flush();
     lastUpdate = millis();
 }
 
@@ -69,20 +415,308 @@ void Display::showRadioScreen(uint32_t txCount, uint32_t rxCount,
                                int rssi, float snr,
                                const String& lastMsg) {
     if (!initialized) return;
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    uint32_t c0 = rp2040.getCycleCount();
+    char buf[DISPLAY_FIELD_CHARS + 1];
 
-    display.setCursor(0, 0);
-    display.println("-- RADIO --");
-    display.print("TX: ");   display.println(txCount);
-    display.print("RX: ");   display.println(rxCount);
-    display.print("RSSI: "); display.println(rxCount > 0 ? String(rssi)    : "--");
-    display.print("SNR:  "); display.println(rxCount > 0 ? String(snr, 1)  : "--");
-    display.print("Msg: ");
-    display.println(lastMsg.length() > 14 ? lastMsg.substring(0, 14) : lastMsg);
+    useLayout(LAYOUT_RADIO);
+    TextRenderer::fmtUInt(buf, txCount);
+    setField(RADIO_TX, buf);
+    TextRenderer::fmtUInt(buf, rxCount);
+    setField(RADIO_RX, buf);
 
-    display.display();
+    if (rxCount > 0) {
+        TextRenderer::fmtFixed(buf, rssi, 0);
+        setField(RADIO_RSSI, buf);
+        TextRenderer::fmtFixed(buf, (int32_t)lroundf(snr * 10.0f), 1);
+        setField(RADIO_SNR, buf);
+    } else {
+        setField(RADIO_RSSI, "--");
+        setField(RADIO_SNR, "--");
+    }
+    // Borrow the String's storage; the slot clips to its width
+    setField(RADIO_MSG, lastMsg.c_str());
+
+    lastRenderCycles = rp2040.getCycleCount() - c0;
+    flush();
+    lastUpdate = millis();
+}
+
+// ── Screen C: Peer radar ─────────────────────────────────────────────────────
+
+// Full-scale radius choices (m); the smallest that holds the farthest peer wins
+static constexpr uint32_t RADAR_SCALES_M[] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000
+};
+static constexpr uint8_t RADAR_SCALE_COUNT = sizeof(RADAR_SCALES_M) / sizeof(RADAR_SCALES_M[0]);
+
+static const char* const COMPASS_POINTS[8] = { "N", "NE", "E", "SE", "S", "SW", "W", "NW" };
+
+static inline void plot(uint8_t* fb, int16_t x, int16_t y) {
+    if (x < 0 || x >= RADAR_SIZE || y < 0 || y >= RADAR_SIZE) return;
+    fb[(y >> 3) * SCREEN_WIDTH + x] |= (uint8_t)(1 << (y & 7));
+}
+
+/** "850m", "1.25km", "12km" */
+static void fmtDistance(char* out, uint32_t metres) {
+    uint8_t n;
+    if (metres < 1000) {
+        n = TextRenderer::fmtUInt(out, metres);
+        out[n++] = 'm';
+    } else {
+        n = metres < 10000 ? TextRenderer::fmtFixed(out, (int32_t)(metres / 10), 2)
+                           : TextRenderer::fmtUInt(out, metres / 1000);
+        out[n++] = 'k';
+        out[n++] = 'm';
+    }
+    out[n] = '\0';
+}
+
+/** Appends "12s" / "5m" / "3h" at `out`; returns new length. */
+static uint8_t fmtAge(char* out, uint32_t ms) {
+    uint32_t s = ms / 1000;
+    char     unit = 's';
+    if (s >= 3600)    { s /= 3600; unit = 'h'; }
+    else if (s >= 60) { s /= 60;   unit = 'm'; }
+    uint8_t n = TextRenderer::fmtUInt(out, s);
+    out[n++] = unit;
+    out[n]   = '\0';
+    return n;
+}
+
+/** Outer ring, dotted half-range ring, north tick and own-position cross. */
+void Display::drawRadarBackdrop() {
+    uint8_t* fb = display.getBuffer();
+    display.drawCircle(RADAR_CENTER, RADAR_CENTER, RADAR_RADIUS, SSD1306_WHITE);
+    for (uint16_t a = 0; a < 32; a++) {
+        uint16_t bam = (uint16_t)(a * 2048);
+        plot(fb, RADAR_CENTER + ((RADAR_RADIUS / 2) * FixedMath::sinQ15(bam) >> 15),
+                 RADAR_CENTER - ((RADAR_RADIUS / 2) * FixedMath::cosQ15(bam) >> 15));
+    }
+    display.drawFastVLine(RADAR_CENTER, 0, 3, SSD1306_WHITE);
+    display.drawFastHLine(RADAR_CENTER - 2, RADAR_CENTER, 5, SSD1306_WHITE);
+    display.drawFastVLine(RADAR_CENTER, RADAR_CENTER - 2, 5, SSD1306_WHITE);
+
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        memcpy(radarBackdrop + page * RADAR_SIZE, fb + page * SCREEN_WIDTH, RADAR_SIZE);
+    }
+}
+
+void Display::showRadarScreen(const PeerTable& peers, bool haveFix,
+                              int32_t latE6, int32_t lonE6, uint32_t now) {
+    if (!initialized) return;
+    uint32_t c0 = rp2040.getCycleCount();
+    uint8_t* fb = display.getBuffer();
+    char     buf[DISPLAY_FIELD_CHARS + 1];
+
+    if (useLayout(LAYOUT_RADAR)) drawRadarBackdrop();
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        memcpy(fb + page * SCREEN_WIDTH, radarBackdrop + page * RADAR_SIZE, RADAR_SIZE);
+    }
+
+    // Pass 1: range/bearing of every located peer
+    struct Blip { uint32_t rangeMm; uint16_t bearing; uint32_t age; uint8_t index; };
+    Blip    blips[PEER_MAX];
+    uint8_t blipCount = 0;
+    uint32_t maxRangeMm = 0;
+    if (haveFix) {
+        for (uint8_t i = 0; i < peers.capacity(); i++) {
+            int32_t pLat, pLon;
+            if (!peers.estimate(i, now, pLat, pLon)) continue;
+            Blip& b   = blips[blipCount++];
+            b.rangeMm = FixedMath::distanceMm(latE6, lonE6, pLat, pLon);
+            b.bearing = FixedMath::bearingBam(latE6, lonE6, pLat, pLon);
+            b.age     = now - peers.get(i).lastHeard;
+            b.index   = i;
+            if (b.rangeMm > maxRangeMm) maxRangeMm = b.rangeMm;
+        }
+    }
+
+    uint8_t scale = 0;
+    while (scale < RADAR_SCALE_COUNT - 1 && RADAR_SCALES_M[scale] * 1000 < maxRangeMm) scale++;
+    uint32_t scaleMm = RADAR_SCALES_M[scale] * 1000;
+
+    // Pass 2: markers — solid when fresh, hollow when aging, a dot when stale
+    const Blip* nearest = nullptr;
+    for (uint8_t k = 0; k < blipCount; k++) {
+        const Blip& b = blips[k];
+        if (!nearest || b.rangeMm < nearest->rangeMm) nearest = &b;
+
+        uint32_t rPx = (uint32_t)((uint64_t)b.rangeMm * RADAR_RADIUS / scaleMm);
+        if (rPx > RADAR_RADIUS) rPx = RADAR_RADIUS;
+        int16_t x = RADAR_CENTER + (int16_t)(((int32_t)rPx * FixedMath::sinQ15(b.bearing)) >> 15);
+        int16_t y = RADAR_CENTER - (int16_t)(((int32_t)rPx * FixedMath::cosQ15(b.bearing)) >> 15);
+
+        if (b.age < RADAR_AGED_MS) {
+            for (int8_t dy = -1; dy <= 1; dy++) {
+                for (int8_t dx = -1; dx <= 1; dx++) {
+                    if (dx == 0 && dy == 0 && b.age >= RADAR_FRESH_MS) continue;
+                    plot(fb, x + dx, y + dy);
+                }
+            }
+        } else {
+            plot(fb, x, y);
+        }
+    }
+
+    // Text panel
+    memcpy(buf, "R ", 2);
+    fmtDistance(buf + 2, RADAR_SCALES_M[scale]);
+    setField(RADAR_SCALE, buf);
+
+    if (!haveFix) {
+        setField(RADAR_PEERS, "no fix");
+    } else {
+        uint8_t n = TextRenderer::fmtUInt(buf, blipCount);
+        memcpy(buf + n, blipCount == 1 ? " peer" : " peers", 7);
+        setField(RADAR_PEERS, buf);
+    }
+
+    if (nearest) {
+        buf[0] = '#';
+        uint8_t n = (uint8_t)(1 + TextRenderer::fmtUInt(buf + 1, peers.get(nearest->index).addr));
+        buf[n++] = ' ';
+        fmtAge(buf + n, nearest->age);
+        setField(RADAR_NEAR_ID, buf);
+
+        fmtDistance(buf, nearest->rangeMm / 1000);
+        setField(RADAR_NEAR_RANGE, buf);
+
+        uint16_t deg = FixedMath::bamToDeg(nearest->bearing);
+        buf[0] = (char)('0' + deg / 100);
+        buf[1] = (char)('0' + deg / 10 % 10);
+        buf[2] = (char)('0' + deg % 10);
+        buf[3] = ' ';
+        strcpy(buf + 4, COMPASS_POINTS[(uint16_t)(nearest->bearing + 4096) >> 13]);
+        setField(RADAR_NEAR_BEARING, buf);
+    } else {
+        setField(RADAR_NEAR_ID, "--");
+        setField(RADAR_NEAR_RANGE, "");
+        setField(RADAR_NEAR_BEARING, "");
+    }
+
+    lastRenderCycles = rp2040.getCycleCount() - c0;
+    flush();
+    lastUpdate = millis();
+}
+
+// ── Screen D: Link quality ───────────────────────────────────────────────────
+
+/**
+ * One sparkline column: a bar from the bottom of the SPARK_PAGES band up to
+ * `value` on the [lo, hi] scale, as one byte per page (bit 0 = top row).
+ */
+static void drawBar(uint8_t* fb, uint8_t page, uint8_t x, int16_t value, int16_t lo, int16_t hi) {
+    const int16_t rows = SPARK_PAGES * 8;
+    int32_t h = ((int32_t)(value - lo) * rows + (hi - lo) / 2) / (hi - lo);
+    if (h < 1)    h = 1;     // a weak sample still shows a pixel
+    if (h > rows) h = rows;
+
+    uint32_t mask = ((1UL << h) - 1) << (rows - h);
+    for (uint8_t i = 0; i < SPARK_PAGES; i++) {
+        fb[(page + i) * SCREEN_WIDTH + x] = (uint8_t)(mask >> (8 * i));
+    }
+}
+
+void Display::drawSparkSample(uint8_t x, int8_t rssi, int8_t snrX4) {
+    uint8_t* fb = display.getBuffer();
+    drawBar(fb, SPARK_RSSI_PAGE, x, rssi,  SPARK_RSSI_MIN,   SPARK_RSSI_MAX);
+    drawBar(fb, SPARK_SNR_PAGE,  x, snrX4, SPARK_SNR_MIN_X4, SPARK_SNR_MAX_X4);
+}
+
+void Display::clearSparklines() {
+    uint8_t* fb = display.getBuffer();
+    for (uint8_t i = 0; i < SPARK_PAGES; i++) {
+        memset(fb + (SPARK_RSSI_PAGE + i) * SCREEN_WIDTH, 0, SPARK_WIDTH);
+        memset(fb + (SPARK_SNR_PAGE  + i) * SCREEN_WIDTH, 0, SPARK_WIDTH);
+    }
+}
+
+/** "-95/-80" from two integers, or from two 0.25 dB values as tenths. */
+static void fmtRange(char* out, int32_t lo, int32_t hi, uint8_t decimals) {
+    uint8_t n = TextRenderer::fmtFixed(out, lo, decimals);
+    out[n++] = '/';
+    TextRenderer::fmtFixed(out + n, hi, decimals);
+}
+
+static inline int32_t x4ToTenths(int32_t v) {
+    return (v * 10 + (v < 0 ? -2 : 2)) / 4;
+}
+
+void Display::showLinkScreen(const PeerTable& peers) {
+    if (!initialized) return;
+    uint32_t c0 = rp2040.getCycleCount();
+    uint8_t* fb = display.getBuffer();
+    char     buf[DISPLAY_FIELD_CHARS + 1];
+
+    if (useLayout(LAYOUT_LINK)) sparkValid = false;
+
+    int8_t idx = peers.mostRecent();
+    if (idx < 0) {
+        if (sparkValid) clearSparklines();
+        sparkValid = false;
+        setField(LINK_PEER, "no peers");
+        setField(LINK_RSSI_AVG, "");
+        setField(LINK_RSSI_RANGE, "");
+        setField(LINK_SNR_AVG, "");
+        setField(LINK_SNR_RANGE, "");
+        lastRenderCycles = rp2040.getCycleCount() - c0;
+        flush();
+        lastUpdate = millis();
+        return;
+    }
+
+    const PeerInfo&    peer = peers.get((uint8_t)idx);
+    const LinkHistory& h    = peer.link;
+    int8_t rssi, snrX4;
+
+    if (!sparkValid || peer.addr != sparkAddr || h.seq - sparkSeq > SPARK_WIDTH) {
+        // New peer or too far behind: rebuild, newest sample in the rightmost column
+        clearSparklines();
+        for (uint8_t k = 0; k < h.count; k++) {
+            uint32_t seq = h.seq - h.count + k;
+            if (peers.getLinkSample((uint8_t)idx, seq, rssi, snrX4)) {
+                drawSparkSample((uint8_t)(SPARK_WIDTH - h.count + k), rssi, snrX4);
+            }
+        }
+    } else {
+        // Scroll by one column per new sample
+        for (uint32_t seq = sparkSeq; seq < h.seq; seq++) {
+            for (uint8_t i = 0; i < SPARK_PAGES; i++) {
+                uint8_t* r = fb + (SPARK_RSSI_PAGE + i) * SCREEN_WIDTH;
+                uint8_t* s = fb + (SPARK_SNR_PAGE  + i) * SCREEN_WIDTH;
+                memmove(r, r + 1, SPARK_WIDTH - 1);
+                memmove(s, s + 1, SPARK_WIDTH - 1);
+            }
+            if (peers.getLinkSample((uint8_t)idx, seq, rssi, snrX4)) {
+                drawSparkSample(SPARK_WIDTH - 1, rssi, snrX4);
+            }
+        }
+    }
+    sparkAddr  = peer.addr;
+    sparkSeq   = h.seq;
+    sparkValid = true;
+
+    LinkStats st = peers.getLinkStats((uint8_t)idx);
+    buf[0] = '#';
+    uint8_t n = (uint8_t)(1 + TextRenderer::fmtUInt(buf + 1, peer.addr));
+    memcpy(buf + n, " n=", 3);
+    TextRenderer::fmtUInt(buf + n + 3, st.samples);
+    setField(LINK_PEER, buf);
+
+    n = TextRenderer::fmtFixed(buf, st.avgRssi, 0);
+    memcpy(buf + n, "dBm", 4);
+    setField(LINK_RSSI_AVG, buf);
+    fmtRange(buf, st.minRssi, st.maxRssi, 0);
+    setField(LINK_RSSI_RANGE, buf);
+
+    n = TextRenderer::fmtFixed(buf, x4ToTenths(st.avgSnrX4), 1);
+    memcpy(buf + n, "dB", 3);
+    setField(LINK_SNR_AVG, buf);
+    fmtRange(buf, x4ToTenths(st.minSnrX4), x4ToTenths(st.maxSnrX4), 1);
+    setField(LINK_SNR_RANGE, buf);
+
+    lastRenderCycles = rp2040.getCycleCount() - c0;
+    flush();
     lastUpdate = millis();
 }
 
@@ -91,39 +725,33 @@ void Display::showRadioScreen(uint32_t txCount, uint32_t rxCount,
 void Display::updateStatus(const GPSData& gpsData, const char* deviceId,
                             const char* deviceType) {
     if (!initialized || !shouldUpdate()) return;
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    beginFreeform();
     display.setCursor(0, 0);
     display.println(deviceId);
     display.println(deviceType);
     display.print("Fix: ");  display.println(gpsData.valid ? "YES" : "NO");
     display.print("Sats: "); display.println(gpsData.satellites);
-    display.display();
+    flush();
     lastUpdate = millis();
 }
 
 void Display::showInitStatus(const char* module, bool success) {
     if (!initialized) return;
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    beginFreeform();
     display.setCursor(0, 20);
     display.print(module);
     display.print(": ");
     display.println(success ? "OK" : "FAIL");
-    display.display();
+    flush();
     delay(600);
 }
 
 void Display::showMessage(const char* message) {
     if (!initialized) return;
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
+    beginFreeform();
     display.setCursor(0, 20);
     display.println(message);
-    display.display();
+    flush();
 }
 
 bool Display::shouldUpdate() {
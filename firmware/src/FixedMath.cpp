@@ -0,0 +1,188 @@
+/**
+ * @file FixedMath.cpp
+ * @brief Table-driven integer trig and geometry for the RP2040 (no FPU)
+ *
+ * Both tables are 257 entries (quarter-wave sine, atan over [0, 1]) and are
+ * linearly interpolated, giving < 0.01° bearing error and < 2e-5 sine error.
+ * The inverse square root seeds one Newton step from a 96-entry table.
+ */
+
+#include "FixedMath.h"
+
+// sin(i/256 · 90°) in Q15, i = 0..256
+static const int16_t SIN_QUARTER_Q15[257] = {
+        0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,
+     2410,  2611,  2811,  3012,  3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+     4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,  6393,  6590,  6786,  6983,
+     7179,  7375,  7571,  7767,  7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+     9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12353, 12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+    14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269, 15446, 15623, 15800, 15976,
+    16151, 16325, 16499, 16673, 16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+    18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000,
+    20159, 20317, 20475, 20631, 20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+    22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027, 23170, 23311, 23452, 23592,
+    23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+    25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198, 26319, 26438, 26556, 26674,
+    26790, 26905, 27019, 27133, 27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+    28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803, 28898, 28992, 29085, 29177,
+    29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+    30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783, 30852, 30919, 30985, 31050,
+    31113, 31176, 31237, 31297, 31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+    31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098, 32137, 32176, 32213, 32250,
+    32285, 32318, 32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+    32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737, 32745, 32752,
+    32757, 32761, 32765, 32766, 32767,
+};
+
+// atan(i/256) in BAM, i = 0..256 (8192 = 45°)
+static const uint16_t ATAN_BAM[257] = {
+        0,    41,    81,   122,   163,   204,   244,   285,   326,   367,   407,   448,
+      489,   529,   570,   610,   651,   692,   732,   773,   813,   854,   894,   935,
+      975,  1015,  1056,  1096,  1136,  1177,  1217,  1257,  1297,  1337,  1377,  1417,
+     1457,  1497,  1537,  1577,  1617,  1656,  1696,  1736,  1775,  1815,  1854,  1894,
+     1933,  1973,  2012,  2051,  2090,  2129,  2168,  2207,  2246,  2285,  2324,  2363,
+     2401,  2440,  2478,  2517,  2555,  2594,  2632,  2670,  2708,  2746,  2784,  2822,
+     2860,  2897,  2935,  2973,  3010,  3047,  3085,  3122,  3159,  3196,  3233,  3270,
+     3307,  3344,  3380,  3417,  3453,  3490,  3526,  3562,  3599,  3635,  3670,  3706,
+     3742,  3778,  3813,  3849,  3884,  3920,  3955,  3990,  4025,  4060,  4095,  4129,
+     4164,  4199,  4233,  4267,  4302,  4336,  4370,  4404,  4438,  4471,  4505,  4539,
+     4572,  4605,  4639,  4672,  4705,  4738,  4771,  4803,  4836,  4869,  4901,  4933,
+     4966,  4998,  5030,  5062,  5094,  5125,  5157,  5188,  5220,  5251,  5282,  5313,
+     5344,  5375,  5406,  5437,  5467,  5498,  5528,  5559,  5589,  5619,  5649,  5679,
+     5708,  5738,  5768,  5797,  5826,  5856,  5885,  5914,  5943,  5972,  6000,  6029,
+     6058,  6086,  6114,  6142,  6171,  6199,  6227,  6254,  6282,  6310,  6337,  6365,
+     6392,  6419,  6446,  6473,  6500,  6527,  6554,  6580,  6607,  6633,  6660,  6686,
+     6712,  6738,  6764,  6790,  6815,  6841,  6867,  6892,  6917,  6943,  6968,  6993,
+     7018,  7043,  7068,  7092,  7117,  7141,  7166,  7190,  7214,  7238,  7262,  7286,
+     7310,  7334,  7358,  7381,  7405,  7428,  7451,  7475,  7498,  7521,  7544,  7566,
+     7589,  7612,  7635,  7657,  7679,  7702,  7724,  7746,  7768,  7790,  7812,  7834,
+     7856,  7877,  7899,  7920,  7942,  7963,  7984,  8005,  8026,  8047,  8068,  8089,
+     8110,  8131,  8151,  8172,  8192,
+};
+
+// 1/sqrt(f) in Q30 at the midpoint of each f = i/128 .. (i+1)/128, i = 32..127
+static const uint32_t RSQRT_Q30[96] = {
+    2130900515, 2098855072, 2068213208, 2038875364, 2010751598, 1983760420,
+    1957827796, 1932886296, 1908874354, 1885735628, 1863418444, 1841875310,
+    1821062491, 1800939636, 1781469447, 1762617387, 1744351429, 1726641819,
+    1709460876, 1692782810, 1676583559, 1660840642, 1645533028, 1630641020,
+    1616146146, 1602031062, 1588279468, 1574876026, 1561806289, 1549056637,
+    1536614214, 1524466875, 1512603139, 1501012140, 1489683584, 1478607716,
+    1467775280, 1457177486, 1446805984, 1436652834, 1426710480, 1416971728,
+    1407429723, 1398077927, 1388910104, 1379920300, 1371102827, 1362452250,
+    1353963368, 1345631207, 1337451002, 1329418191, 1321528399, 1313777432,
+    1306161267, 1298676040, 1291318043, 1284083712, 1276969620, 1269972473,
+    1263089103, 1256316458, 1249651603, 1243091706, 1236634043, 1230275986,
+    1224014999, 1217848637, 1211774541, 1205790433, 1199894112, 1194083452,
+    1188356400, 1182710970, 1177145240, 1171657354, 1166245512, 1160907976,
+    1155643060, 1150449133, 1145324612, 1140267967, 1135277711, 1130352405,
+    1125490652, 1120691096, 1115952423, 1111273357, 1106652658, 1102089122,
+    1097581581, 1093128899, 1088729972, 1084383727, 1080089122, 1075845140,
+};
+
+namespace FixedMath {
+
+int16_t sinQ15(uint16_t bam) {
+    // Top two bits select the quadrant; the next 14 index/interpolate.
+    uint16_t quadrant = bam >> 14;
+    uint16_t idx      = bam & 0x3FFF;
+    if (quadrant & 1) idx = 0x4000 - idx;
+
+    uint16_t i    = idx >> 6;          // 0..256
+    uint16_t frac = idx & 0x3F;        // 6-bit interpolation weight
+    int32_t  a    = SIN_QUARTER_Q15[i];
+    int32_t  v    = (i < 256) ? a + (((SIN_QUARTER_Q15[i + 1] - a) * frac) >> 6) : a;
+    return (int16_t)((quadrant & 2) ? -v : v);
+}
+
+uint16_t atan2Bam(int32_t east, int32_t north) {
+    if (east == 0 && north == 0) return 0;
+
+    uint32_t ax = (uint32_t)(east  < 0 ? -(int64_t)east  : east);
+    uint32_t ay = (uint32_t)(north < 0 ? -(int64_t)north : north);
+
+    // Ratio of the smaller to the larger component in Q16 → angle in [0, 45°].
+    bool     swap  = ax > ay;
+    uint32_t num   = swap ? ay : ax;
+    uint32_t den   = swap ? ax : ay;
+    uint32_t ratio = (uint32_t)(((uint64_t)num << 16) / den);   // 0..65536
+    uint32_t i     = ratio >> 8;
+    uint32_t frac  = ratio & 0xFF;
+    uint32_t a     = ATAN_BAM[i];
+    uint32_t ang   = (i < 256) ? a + (((ATAN_BAM[i + 1] - a) * frac) >> 8) : a;
+
+    // ang is measured from north toward east unless the components swapped.
+    if (swap) ang = 16384 - ang;                 // from east toward north
+    if (north >= 0) return (uint16_t)(east >= 0 ? ang : 65536 - ang);
+    return (uint16_t)(east >= 0 ? 32768 - ang : 32768 + ang);
+}
+
+uint32_t isqrt32(uint32_t v) {
+    uint32_t res = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= res + bit) {
+            v  -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+uint32_t isqrt64(uint64_t v) {
+    if (v <= 0xFFFFFFFFULL) return isqrt32((uint32_t)v);
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= res + bit) {
+            v  -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+uint32_t rsqrtQ31(uint32_t v) {
+    if (v == 0) return UINT32_MAX;
+
+    // v = m · 2^-k with m in [2^30, 2^32) and k even, so 1/sqrt(v) =
+    // 2^(k/2 − 16) / sqrt(f) where f = m / 2^32 is in [0.25, 1).
+    uint8_t k = (uint8_t)(__builtin_clz(v) & ~1u);
+    uint32_t m = v << k;
+
+    // Table seed (< 0.8 % off), then y ← y · (3 − f·y²) / 2 (< 1e-4)
+    uint32_t y  = RSQRT_Q30[(m >> 25) - 32];
+    uint64_t y2 = ((uint64_t)y * y) >> 30;               // Q30, < 4
+    uint32_t fy = (uint32_t)((y2 * m) >> 32);            // Q30, ≈ 1
+    y = (uint32_t)(((uint64_t)y * ((3UL << 30) - fy)) >> 31);
+
+    uint8_t shift = 15 - k / 2;
+    return shift ? (y + (1UL << (shift - 1))) >> shift : y;
+}
+
+int64_t distanceSqMm(int32_t lat1E6, int32_t lon1E6,
+                     int32_t lat2E6, int32_t lon2E6) {
+    int32_t east, north;
+    toLocalMm(lat2E6, lon2E6, lat1E6, lon1E6,
+              cosLatQ15((int32_t)(((int64_t)lat1E6 + lat2E6) / 2)), east, north);
+    return (int64_t)east * east + (int64_t)north * north;
+}
+
+uint16_t bearingBam(int32_t lat1E6, int32_t lon1E6,
+                    int32_t lat2E6, int32_t lon2E6) {
+    int32_t east, north;
+    toLocalMm(lat2E6, lon2E6, lat1E6, lon1E6,
+              cosLatQ15((int32_t)(((int64_t)lat1E6 + lat2E6) / 2)), east, north);
+    return atan2Bam(east, north);
+}
+
+} // namespace FixedMath
@@ -0,0 +1,399 @@
+/**
+ * @file FlashLog.cpp
+ * @brief Segment ring, page batching, recovery scan and paced drain
+ */
+
+#include "FlashLog.h"
+#include "Checksum.h"
+
+#define ACK_DATA_LEN 6   // u32 segment, u16 offset
+
+static void packCursor(uint8_t* out, const LogCursor& c) {
+    memcpy(out, &c.segment, 4);
+    memcpy(out + 4, &c.offset, 2);
+}
+
+static LogCursor unpackCursor(const uint8_t* in) {
+    LogCursor c;
+    memcpy(&c.segment, in, 4);
+    memcpy(&c.offset, in + 4, 2);
+    return c;
+}
+
+static bool before(const LogCursor& a, const LogCursor& b) {
+    return a.segment < b.segment || (a.segment == b.segment && a.offset < b.offset);
+}
+
+/** Validate a segment header; returns its sequence number and drain cursor. */
+static bool parseHeader(const uint8_t* h, uint32_t& seq, LogCursor& ack) {
+    uint32_t magic;
+    uint16_t crc;
+    memcpy(&magic, h, 4);
+    memcpy(&crc, h + 14, 2);
+    if (magic != FLASH_LOG_MAGIC || crc16(h, 14) != crc) return false;
+    memcpy(&seq, h + 4, 4);
+    ack = unpackCursor(h + 8);
+    return true;
+}
+
+FlashLog::FlashLog()
+    : flash(nullptr), segCount(0), started(false), open(false), headSeq(0), writeOff(0),
+      pageStart(0), pageLen(0), erasedAhead(false), drained{ 0, FLASH_LOG_HEADER_SIZE },
+      ackDirty(false), lastFlush(0), nextDrainAt(0), airtimeShare(FLASH_LOG_AIRTIME_SHARE),
+      batchRecords(0), batchBytes(0) {
+    memset(page, 0xFF, sizeof(page));
+    memset(&stats, 0, sizeof(stats));
+}
+
+// ── Recovery ─────────────────────────────────────────────────────────────────
+
+bool FlashLog::readHeader(uint32_t seq, LogCursor& ack) {
+    uint8_t  h[FLASH_LOG_HEADER_SIZE];
+    uint32_t found;
+    flash->read(sectorOf(seq), h, sizeof(h));
+    return parseHeader(h, found, ack) && found == seq;
+}
+
+bool FlashLog::begin(LogFlash& f) {
+    flash    = &f;
+    segCount = (uint16_t)(f.size() / LOG_FLASH_SECTOR_SIZE);
+    if (segCount < 2) {
+        Serial.println("[Log] Flash region too small");
+        flash = nullptr;
+        return false;
+    }
+
+    // Newest valid header = head segment
+    LogCursor headAck = { 0, FLASH_LOG_HEADER_SIZE };
+    started = false;
+    for (uint16_t i = 0; i < segCount; i++) {
+        uint8_t   h[FLASH_LOG_HEADER_SIZE];
+        uint32_t  seq;
+        LogCursor ack;
+        f.read((uint32_t)i * LOG_FLASH_SECTOR_SIZE, h, sizeof(h));
+        if (!parseHeader(h, seq, ack) || seq % segCount != i) continue;
+        if (!started || seq > headSeq) {
+            headSeq = seq;
+            headAck = ack;
+            started = true;
+        }
+    }
+
+    if (!started) {
+        open    = false;
+        drained = LogCursor{ 0, FLASH_LOG_HEADER_SIZE };
+        Serial.println("[Log] Empty log, " + String(segCount) + " segments");
+        return true;
+    }
+
+    drained = headAck;
+    recoverHead();
+
+    // An earlier erase-ahead may have left the next sector blank already
+    erasedAhead = true;
+    uint32_t next = sectorOf(headSeq + 1);
+    for (uint32_t off = 0; off < LOG_FLASH_SECTOR_SIZE && erasedAhead; off += sizeof(page)) {
+        flash->read(next + off, page, sizeof(page));
+        for (size_t i = 0; i < sizeof(page); i++) {
+            if (page[i] != 0xFF) {
+                erasedAhead = false;
+                break;
+            }
+        }
+    }
+    memset(page, 0xFF, sizeof(page));
+
+    if (before(drained, LogCursor{ oldestSeq(), FLASH_LOG_HEADER_SIZE })) {
+        drained = LogCursor{ oldestSeq(), FLASH_LOG_HEADER_SIZE };
+    }
+    Serial.println("[Log] Recovered segment " + String(headSeq) + " @" + String(writeOff) +
+                   ", backlog " + String(backlogBytes()) + " B");
+    return true;
+}
+
+void FlashLog::recoverHead() {
+    uint32_t base = sectorOf(headSeq);
+    uint16_t off  = FLASH_LOG_HEADER_SIZE;
+    bool     torn = false;
+
+    while (off + FLASH_LOG_RECORD_HEADER <= LOG_FLASH_SECTOR_SIZE) {
+        uint8_t hdr[FLASH_LOG_RECORD_HEADER];
+        flash->read(base + off, hdr, sizeof(hdr));
+        if (hdr[0] == 0xFF) {
+            if (off % LOG_FLASH_PAGE_SIZE == 0) break;   // end of data
+            off = (uint16_t)((off / LOG_FLASH_PAGE_SIZE + 1) * LOG_FLASH_PAGE_SIZE);
+            continue;
+        }
+
+        uint8_t  data[FLASH_LOG_MAX_RECORD];
+        uint8_t  len = hdr[0];
+        uint16_t crc;
+        memcpy(&crc, hdr + 2, 2);
+        if (len > FLASH_LOG_MAX_RECORD || off + FLASH_LOG_RECORD_HEADER + len > LOG_FLASH_SECTOR_SIZE) {
+            torn = true;
+            break;
+        }
+        flash->read(base + off + FLASH_LOG_RECORD_HEADER, data, len);
+        if (crc16(data, len, crc16(&hdr[1], 1)) != crc) {
+            torn = true;
+            break;
+        }
+        if (hdr[1] == LOG_ACK && len == ACK_DATA_LEN) drained = unpackCursor(data);
+        off = (uint16_t)(off + FLASH_LOG_RECORD_HEADER + len);
+    }
+
+    if (torn) stats.corruptRecords++;
+
+    // Continue on the next untouched page; a torn segment is closed instead
+    uint16_t next = (uint16_t)((off + LOG_FLASH_PAGE_SIZE - 1) / LOG_FLASH_PAGE_SIZE * LOG_FLASH_PAGE_SIZE);
+    pageStart = torn ? (uint16_t)LOG_FLASH_SECTOR_SIZE : next;
+    pageLen   = 0;
+    writeOff  = pageStart;
+    open      = !torn && writeOff + FLASH_LOG_RECORD_HEADER < LOG_FLASH_SECTOR_SIZE;
+    if (!open) pageStart = writeOff = LOG_FLASH_SECTOR_SIZE;
+}
+
+// ── Writing ──────────────────────────────────────────────────────────────────
+
+void FlashLog::setDrained(const LogCursor& c) {
+    if (before(drained, c)) {
+        drained  = c;
+        ackDirty = true;
+    }
+}
+
+void FlashLog::eraseFor(uint32_t seq) {
+    // The sector still holds segment seq - segCount
+    if (started && seq >= segCount) {
+        LogCursor oldest = { seq - segCount + 1, FLASH_LOG_HEADER_SIZE };
+        if (before(drained, oldest)) {
+            stats.segmentsLost++;
+            drained  = oldest;
+            ackDirty = true;
+        }
+    }
+    flash->eraseSector(sectorOf(seq));
+    stats.segmentsErased++;
+}
+
+bool FlashLog::openSegment() {
+    uint32_t seq = started ? headSeq + 1 : 0;
+    if (!erasedAhead) eraseFor(seq);
+    erasedAhead = false;
+
+    headSeq   = seq;
+    started   = true;
+    pageStart = 0;
+    pageLen   = 0;
+    open      = true;
+    if (before(drained, LogCursor{ oldestSeq(), FLASH_LOG_HEADER_SIZE })) {
+        drained = LogCursor{ oldestSeq(), FLASH_LOG_HEADER_SIZE };
+    }
+
+    // The header carries the drain cursor, so no separate ACK is needed
+    uint8_t  h[FLASH_LOG_HEADER_SIZE];
+    uint32_t magic = FLASH_LOG_MAGIC;
+    memcpy(h, &magic, 4);
+    memcpy(h + 4, &seq, 4);
+    packCursor(h + 8, drained);
+    uint16_t crc = crc16(h, 14);
+    memcpy(h + 14, &crc, 2);
+    put(h, sizeof(h));
+    ackDirty = false;
+    return true;
+}
+
+void FlashLog::programPage() {
+    memset(page + pageLen, 0xFF, sizeof(page) - pageLen);
+    flash->programPage(sectorOf(headSeq) + pageStart, page);
+    stats.pagesWritten++;
+    pageStart = (uint16_t)(pageStart + LOG_FLASH_PAGE_SIZE);
+    pageLen   = 0;
+    writeOff  = pageStart;
+    if (pageStart >= LOG_FLASH_SECTOR_SIZE) open = false;
+}
+
+void FlashLog::put(const uint8_t* data, size_t len) {
+    while (len) {
+        size_t n = min(len, sizeof(page) - pageLen);
+        memcpy(page + pageLen, data, n);
+        pageLen = (uint16_t)(pageLen + n);
+        data   += n;
+        len    -= n;
+        if (pageLen == sizeof(page)) programPage();
+    }
+    writeOff = (uint16_t)(pageStart + pageLen);
+}
+
+bool FlashLog::appendRaw(uint8_t type, const uint8_t* data, uint8_t len) {
+    if (!flash || len > FLASH_LOG_MAX_RECORD) return false;
+    if (!open || writeOff + FLASH_LOG_RECORD_HEADER + len > LOG_FLASH_SECTOR_SIZE) {
+        if (open && pageLen) programPage();
+        openSegment();
+    }
+
+    uint8_t  hdr[FLASH_LOG_RECORD_HEADER] = { len, type, 0, 0 };
+    uint16_t crc = crc16(data, len, crc16(&type, 1));
+    memcpy(hdr + 2, &crc, 2);
+    put(hdr, sizeof(hdr));
+    put(data, len);
+    return true;
+}
+
+void FlashLog::writeAck() {
+    uint8_t ack[ACK_DATA_LEN];
+    packCursor(ack, drained);
+    ackDirty = false;
+    appendRaw(LOG_ACK, ack, sizeof(ack));
+}
+
+bool FlashLog::append(uint8_t type, const uint8_t* data, uint8_t len) {
+    if (type == LOG_ACK || len > FLASH_LOG_MAX_RECORD) return false;
+    // The cursor rides along with the next page that reaches flash
+    if (ackDirty && started) writeAck();
+    if (!appendRaw(type, data, len)) return false;
+    stats.appended++;
+    stats.appendedBytes += len;
+    return true;
+}
+
+bool FlashLog::flush() {
+    if (!flash || !started) return false;
+    if (ackDirty) writeAck();
+    // A fresh segment's header alone is not worth a page
+    if (open && pageLen > (pageStart == 0 ? FLASH_LOG_HEADER_SIZE : 0)) programPage();
+    return true;
+}
+
+void FlashLog::service(uint32_t now) {
+    if (!flash) return;
+    if (now - lastFlush >= FLASH_LOG_FLUSH_MS) {
+        lastFlush = now;
+        flush();
+    }
+    if (open && !erasedAhead && writeOff >= LOG_FLASH_SECTOR_SIZE / 2) {
+        eraseFor(headSeq + 1);
+        erasedAhead = true;
+    }
+}
+
+// ── Draining ─────────────────────────────────────────────────────────────────
+
+bool FlashLog::hasBacklog() const {
+    if (!started) return false;
+    return before(drained, LogCursor{ headSeq, flushedEnd(headSeq) });
+}
+
+uint32_t FlashLog::backlogBytes() const {
+    if (!hasBacklog()) return 0;
+    return (headSeq - drained.segment) * (uint32_t)LOG_FLASH_SECTOR_SIZE +
+           flushedEnd(headSeq) - drained.offset;
+}
+
+bool FlashLog::nextRecord(LogCursor& c, uint8_t& type, uint8_t* data, uint8_t& len) {
+    while (started && c.segment <= headSeq) {
+        uint16_t end = flushedEnd(c.segment);
+        LogCursor ack;
+        bool skipSegment =
+            (c.offset == FLASH_LOG_HEADER_SIZE && end > 0 && !readHeader(c.segment, ack)) ||
+            c.offset + FLASH_LOG_RECORD_HEADER > end;
+
+        uint8_t hdr[FLASH_LOG_RECORD_HEADER];
+        if (!skipSegment) {
+            flash->read(sectorOf(c.segment) + c.offset, hdr, sizeof(hdr));
+            if (hdr[0] == 0xFF) {
+                if (c.offset % LOG_FLASH_PAGE_SIZE == 0) {
+                    skipSegment = true;                  // end of this segment's data
+                } else {
+                    c.offset = (uint16_t)((c.offset / LOG_FLASH_PAGE_SIZE + 1) * LOG_FLASH_PAGE_SIZE);
+                    continue;
+                }
+            }
+        }
+        if (!skipSegment) {
+            len = hdr[0];
+            if (c.offset + FLASH_LOG_RECORD_HEADER + len > end) {
+                if (c.segment == headSeq) return false;  // rest is still in RAM
+                stats.corruptRecords++;
+                skipSegment = true;
+            }
+        }
+        if (!skipSegment) {
+            uint16_t crc;
+            memcpy(&crc, hdr + 2, 2);
+            flash->read(sectorOf(c.segment) + c.offset + FLASH_LOG_RECORD_HEADER, data, len);
+            if (crc16(data, len, crc16(&hdr[1], 1)) != crc) {
+                stats.corruptRecords++;
+                skipSegment = true;
+            }
+        }
+
+        if (skipSegment) {
+            if (c.segment == headSeq) {
+                if (c.offset < end) c.offset = end;      // caught up
+                return false;
+            }
+            c.segment++;
+            c.offset = FLASH_LOG_HEADER_SIZE;
+            continue;
+        }
+
+        c.offset = (uint16_t)(c.offset + FLASH_LOG_RECORD_HEADER + len);
+        type     = hdr[1];
+        if (type != LOG_ACK) return true;
+    }
+    return false;
+}
+
+size_t FlashLog::readBatch(uint8_t* buf, size_t cap, LogCursor& next) {
+    batchRecords = 0;
+    batchBytes   = 0;
+    next         = drained;
+    if (!hasBacklog()) return 0;
+
+    LogCursor c   = drained;
+    size_t    pos = 0;
+    uint8_t   data[FLASH_LOG_MAX_RECORD];
+    uint8_t   type, len;
+    for (;;) {
+        LogCursor at = c;
+        if (!nextRecord(c, type, data, len)) {
+            next = c;                    // skip trailing ACKs/padding too
+            break;
+        }
+        if (pos + 2 + len > cap) {
+            next = at;
+            break;
+        }
+        buf[pos++] = type;
+        buf[pos++] = len;
+        memcpy(buf + pos, data, len);
+        pos  += len;
+        next  = c;
+        batchRecords++;
+        batchBytes = (uint16_t)(batchBytes + len);
+    }
+
+    // Nothing sendable was left: consume the skipped bytes now
+    if (pos == 0) setDrained(next);
+    return pos;
+}
+
+void FlashLog::onBatchSent(const LogCursor& next, uint32_t airtimeMs, uint32_t now) {
+    setDrained(next);
+    stats.batchesSent++;
+    stats.drainedRecords += batchRecords;
+    stats.drainedBytes   += batchBytes;
+    nextDrainAt = now + airtimeMs * (100u - airtimeShare) / airtimeShare;
+}
+
+bool FlashLog::appendSent(uint8_t type, const uint8_t* data, uint8_t len) {
+    // Caught up only if nothing appended before, flushed or still in the
+    // RAM page, is undelivered; otherwise this record joins the backlog
+    bool caughtUp = !before(drained, LogCursor{ headSeq, writeOff });
+    if (!append(type, data, len)) return false;
+    // Anything between the old head and this record is ACKs, padding or a
+    // segment header, none of which the drain sends
+    if (caughtUp) setDrained(LogCursor{ headSeq, writeOff });
+    return true;
+}
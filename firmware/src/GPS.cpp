@@ -4,6 +4,9 @@
  *
  * Serial2.setTX/setRX must be called before Serial2.begin() in arduino-pico.
  * The PPS interrupt free-function lives in main.cpp and calls GPS::onPPS().
+ *
+ * UBX frames (aiding poll responses) share the UART with NMEA; every byte is
+ * offered to both TinyGPS and a small UBX frame parser.
  */
 
 #include "GPS.h"
@@ -11,26 +14,252 @@
 // arduino-pico maps Serial2 to UART1
 #define GPS_SERIAL Serial2
 
-GPS::GPS() : initialized(false), ppsFlag(false) {}
+// UBX parser states
+enum UbxState : uint8_t {
+    UBX_SYNC1, UBX_SYNC2, UBX_CLASS, UBX_ID, UBX_LEN1, UBX_LEN2,
+    UBX_PAYLOAD, UBX_CK_A, UBX_CK_B
+};
+
+// Power management messages
+#define UBX_CLASS_CFG      0x06
+#define UBX_ID_CFG_RXM     0x11
+#define UBX_ID_CFG_RATE    0x08
+#define UBX_CLASS_RXM      0x02
+#define UBX_ID_RXM_PMREQ   0x41
+#define PMREQ_FLAG_BACKUP  0x02
+#define GPS_WAKE_MS        100    // backup → running after UART activity
+
+// UBX-AID-INI flags
+static const uint32_t AID_INI_FLAG_POS = 0x01;
+static const uint32_t AID_INI_FLAG_LLA = 0x20;
+
+static void putLE32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+GPS::GPS()
+    : initialized(false), ppsFlag(false), powerMode(GPS_POWER_CONTINUOUS),
+      rateMs(GPS_DEFAULT_RATE_MS), ratePendingMs(0),
+      bootMillis(0), ttffMs(0), warmStart(false),
+      nextAidSave(0), capturing(false), captureStart(0),
+      ubxState(UBX_SYNC1), ubxClass(0), ubxId(0), ubxLen(0), ubxPos(0),
+      ubxCkA(0), ubxCkB(0) {}
 
 bool GPS::begin() {
     GPS_SERIAL.setTX(PIN_GPS_TX);
     GPS_SERIAL.setRX(PIN_GPS_RX);
+    GPS_SERIAL.setFIFOSize(GPS_RX_FIFO_SIZE);
     GPS_SERIAL.begin(GPS_BAUD);
 
     // Configure PPS pin as input (interrupt attached in main.cpp)
     pinMode(PIN_GPS_PPS, INPUT);
 
+    bootMillis  = millis();
     initialized = true;
     Serial.println("[GPS] NEO-7m on UART1 ready");
+
+    injectAiding();
     return true;
 }
 
 void GPS::update() {
     if (!initialized) return;
     while (GPS_SERIAL.available() > 0) {
-        gps.encode((char)GPS_SERIAL.read());
+        uint8_t c = (uint8_t)GPS_SERIAL.read();
+        feedUBX(c);
+        gps.encode((char)c);
+    }
+
+    if (ttffMs == 0 && gps.location.isValid()) {
+        ttffMs = millis() - bootMillis;
+        if (ttffMs == 0) ttffMs = 1;
+        Serial.printf("[GPS] TTFF %lu ms (%s start)\n",
+                      (unsigned long)ttffMs, warmStart ? "warm" : "cold");
+        aidCache.setTTFF(ttffMs, warmStart);
+        nextAidSave = millis() + GPS_AID_FIRST_SAVE_DELAY;
+    }
+
+    maintainAidCache();
+}
+
+// ── Power modes ──────────────────────────────────────────────────────────────
+
+void GPS::setPowerMode(GpsPowerMode mode) {
+    if (!initialized || mode == powerMode) return;
+
+    if (powerMode == GPS_POWER_BACKUP) {
+        // Any RX edge wakes the receiver; the first bytes are lost
+        for (uint8_t i = 0; i < 8; i++) GPS_SERIAL.write((uint8_t)0xFF);
+        delay(GPS_WAKE_MS);
     }
+
+    if (mode == GPS_POWER_BACKUP) {
+        // duration 0 = until woken
+        const uint8_t pmreq[8] = { 0, 0, 0, 0, PMREQ_FLAG_BACKUP, 0, 0, 0 };
+        sendUBX(UBX_CLASS_RXM, UBX_ID_RXM_PMREQ, pmreq, sizeof(pmreq));
+    } else {
+        // reserved1 = 8, lpMode: 0 continuous, 1 power save
+        const uint8_t rxm[2] = { 8, (uint8_t)(mode == GPS_POWER_SAVE ? 1 : 0) };
+        sendUBX(UBX_CLASS_CFG, UBX_ID_CFG_RXM, rxm, sizeof(rxm));
+    }
+
+    powerMode = mode;
+    static const char* const NAMES[] = { "continuous", "power save", "backup" };
+    Serial.println("[GPS] Power mode: " + String(NAMES[mode]));
+
+    if (mode != GPS_POWER_BACKUP && ratePendingMs) setRate(ratePendingMs);
+}
+
+bool GPS::setRate(uint16_t periodMs) {
+    if (!initialized || periodMs < 100 || periodMs > 10000) return false;
+    rateMs = periodMs;
+    if (powerMode == GPS_POWER_BACKUP) {
+        ratePendingMs = periodMs;
+        return true;
+    }
+    // measRate, navRate = 1 solution per measurement, timeRef = GPS time
+    uint8_t rate[6] = { 0, 0, 1, 0, 1, 0 };
+    rate[0] = (uint8_t)periodMs;
+    rate[1] = (uint8_t)(periodMs >> 8);
+    sendUBX(UBX_CLASS_CFG, UBX_ID_CFG_RATE, rate, sizeof(rate));
+    ratePendingMs = 0;
+    return true;
+}
+
+// ── UBX / aiding ─────────────────────────────────────────────────────────────
+
+void GPS::sendUBX(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+    uint8_t hdr[6] = { 0xB5, 0x62, cls, id, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8) };
+    uint8_t ckA = 0, ckB = 0;
+    for (uint8_t i = 2; i < 6; i++) { ckA += hdr[i]; ckB += ckA; }
+    for (uint16_t i = 0; i < len; i++) { ckA += payload[i]; ckB += ckA; }
+
+    GPS_SERIAL.write(hdr, sizeof(hdr));
+    if (len) GPS_SERIAL.write(payload, len);
+    GPS_SERIAL.write(ckA);
+    GPS_SERIAL.write(ckB);
+}
+
+void GPS::feedUBX(uint8_t c) {
+    switch (ubxState) {
+        case UBX_SYNC1:
+            if (c == 0xB5) ubxState = UBX_SYNC2;
+            return;
+        case UBX_SYNC2:
+            ubxState = (c == 0x62) ? UBX_CLASS : UBX_SYNC1;
+            return;
+        case UBX_CLASS:
+            ubxClass = c; ubxCkA = c; ubxCkB = c;
+            ubxState = UBX_ID;
+            return;
+        case UBX_ID:
+            ubxId = c; ubxCkA += c; ubxCkB += ubxCkA;
+            ubxState = UBX_LEN1;
+            return;
+        case UBX_LEN1:
+            ubxLen = c; ubxCkA += c; ubxCkB += ubxCkA;
+            ubxState = UBX_LEN2;
+            return;
+        case UBX_LEN2:
+            ubxLen |= (uint16_t)c << 8; ubxCkA += c; ubxCkB += ubxCkA;
+            ubxPos   = 0;
+            // Frames we could never store are still walked to stay in sync
+            ubxState = ubxLen ? UBX_PAYLOAD : UBX_CK_A;
+            return;
+        case UBX_PAYLOAD:
+            if (ubxPos < GPS_UBX_MAX_PAYLOAD) ubxBuf[ubxPos] = c;
+            ubxPos++;
+            ubxCkA += c; ubxCkB += ubxCkA;
+            if (ubxPos >= ubxLen) ubxState = UBX_CK_A;
+            return;
+        case UBX_CK_A:
+            ubxState = (c == ubxCkA) ? UBX_CK_B : UBX_SYNC1;
+            return;
+        case UBX_CK_B:
+            ubxState = UBX_SYNC1;
+            if (c == ubxCkB && ubxLen <= GPS_UBX_MAX_PAYLOAD) {
+                aidCache.onUbx(ubxClass, ubxId, ubxBuf, ubxLen);
+            }
+            return;
+    }
+}
+
+/**
+ * Replay the flash cache: AID-INI with the last position (time is left
+ * invalid — the Pico has no battery-backed RTC, so the age of the saved
+ * UTC is unknown), then every stored almanac and ephemeris record.
+ */
+void GPS::injectAiding() {
+    uint32_t t0 = millis();
+    if (!aidCache.load() || !aidCache.hasPosition()) {
+        Serial.println("[GPS] No aiding cache — cold start");
+        return;
+    }
+
+    const GPSAidHeader& h = aidCache.getHeader();
+    if (h.lastTtffMs) {
+        Serial.printf("[GPS] Previous boot TTFF %lu ms (%s start)\n",
+                      (unsigned long)h.lastTtffMs, h.lastStartWarm ? "warm" : "cold");
+    }
+    Serial.printf("[GPS] Cached fix saved %04u-%02u-%02u %02u:%02u:%02u UTC\n",
+                  h.utcYear, h.utcMonth, h.utcDay, h.utcHour, h.utcMinute, h.utcSecond);
+
+    uint8_t ini[48];
+    memset(ini, 0, sizeof(ini));
+    putLE32(ini + 0,  (uint32_t)h.latE7);
+    putLE32(ini + 4,  (uint32_t)h.lonE7);
+    putLE32(ini + 8,  (uint32_t)h.altCm);
+    putLE32(ini + 12, h.posAccCm);
+    putLE32(ini + 44, AID_INI_FLAG_POS | AID_INI_FLAG_LLA);
+    sendUBX(UBX_CLASS_AID, UBX_ID_AID_INI, ini, sizeof(ini));
+
+    for (uint8_t i = 0; i < aidCache.getAlmanacCount(); i++) {
+        sendUBX(UBX_CLASS_AID, UBX_ID_AID_ALM, aidCache.getAlmanac(i), GPS_AID_ALM_LEN);
+    }
+    for (uint8_t i = 0; i < aidCache.getEphemerisCount(); i++) {
+        sendUBX(UBX_CLASS_AID, UBX_ID_AID_EPH, aidCache.getEphemeris(i), GPS_AID_EPH_LEN);
+    }
+    GPS_SERIAL.flush();
+
+    warmStart = true;
+    Serial.printf("[GPS] Injected position + %u alm + %u eph in %lu ms\n",
+                  aidCache.getAlmanacCount(), aidCache.getEphemerisCount(),
+                  (unsigned long)(millis() - t0));
+}
+
+/**
+ * Once a fix is held: snapshot it, poll AID-ALM and AID-EPH (32 responses
+ * each), and write the cache when the responses are in or time out.
+ */
+void GPS::maintainAidCache() {
+    uint32_t now = millis();
+
+    if (capturing) {
+        if (aidCache.getResponsesSeen() >= 2 * GPS_AID_MAX_SV ||
+            now - captureStart >= GPS_AID_CAPTURE_TIMEOUT) {
+            capturing   = false;
+            nextAidSave = now + GPS_AID_SAVE_INTERVAL;
+            bool ok = aidCache.save();
+            Serial.printf("[GPS] Aiding %s: %u alm, %u eph\n", ok ? "saved" : "save FAILED",
+                          aidCache.getAlmanacCount(), aidCache.getEphemerisCount());
+        }
+        return;
+    }
+
+    if (nextAidSave == 0 || (int32_t)(now - nextAidSave) < 0 || !hasFix()) return;
+
+    aidCache.setFix(gps.location.lat(), gps.location.lng(),
+                    gps.altitude.isValid() ? gps.altitude.meters() : 0.0,
+                    gps.hdop.isValid() ? gps.hdop.value() : 0,
+                    gps.date.isValid() ? gps.date.year()  : 0,
+                    gps.date.isValid() ? gps.date.month() : 0,
+                    gps.date.isValid() ? gps.date.day()   : 0,
+                    gps.time.hour(), gps.time.minute(), gps.time.second());
+    aidCache.beginCapture();
+    sendUBX(UBX_CLASS_AID, UBX_ID_AID_ALM, nullptr, 0);
+    sendUBX(UBX_CLASS_AID, UBX_ID_AID_EPH, nullptr, 0);
+    capturing    = true;
+    captureStart = now;
 }
 
 bool GPS::getLocation(double& lat, double& lon) {
@@ -61,13 +290,16 @@ uint8_t GPS::getSatellites() {
 }
 
 bool GPS::hasFix() {
-    return initialized && gps.location.isValid();
+    return initialized && gps.location.isValid() && gps.location.age() < fixMaxAgeMs();
 }
 
 GPSData GPS::getData() {
     GPSData data;
     data.timestamp = millis();
     if (hasFix()) {
+        // Date the fix by when it was parsed, so the same fix read twice
+        // carries the same timestamp
+        data.timestamp -= gps.location.age();
         data.latitude   = gps.location.lat();
         data.longitude  = gps.location.lng();
         data.altitude   = gps.altitude.isValid()   ? gps.altitude.meters()         : 0.0;
@@ -0,0 +1,143 @@
+/**
+ * @file GPSAidCache.cpp
+ * @brief LittleFS-backed store for NEO-7m aiding data
+ */
+
+#include "GPSAidCache.h"
+#include <LittleFS.h>
+#include "Checksum.h"
+
+// u-blox: UERE used to turn HDOP into the AID-INI position accuracy
+static const uint32_t AID_UERE_CM = 500;
+
+GPSAidCache::GPSAidCache() : responsesSeen(0) {
+    memset(&header, 0, sizeof(header));
+    header.magic   = GPS_AID_MAGIC;
+    header.version = GPS_AID_VERSION;
+    freshAlm = freshEph = false;
+}
+
+uint32_t GPSAidCache::fileCrc(const GPSAidHeader& h) const {
+    uint32_t crc = crc32(&h, offsetof(GPSAidHeader, crc));
+    crc = crc32(alm, (size_t)h.almCount * GPS_AID_ALM_LEN, crc);
+    return crc32(eph, (size_t)h.ephCount * GPS_AID_EPH_LEN, crc);
+}
+
+bool GPSAidCache::load() {
+    if (!LittleFS.begin()) {
+        Serial.println("[GPS] LittleFS mount failed — no aiding cache");
+        return false;
+    }
+
+    File f = LittleFS.open(GPS_AID_FILE, "r");
+    if (!f) return false;
+
+    GPSAidHeader h;
+    bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+              h.magic == GPS_AID_MAGIC && h.version == GPS_AID_VERSION &&
+              h.almCount <= GPS_AID_MAX_SV && h.ephCount <= GPS_AID_MAX_SV;
+    if (ok) {
+        size_t almBytes = (size_t)h.almCount * GPS_AID_ALM_LEN;
+        size_t ephBytes = (size_t)h.ephCount * GPS_AID_EPH_LEN;
+        ok = f.read((uint8_t*)alm, almBytes) == almBytes &&
+             f.read((uint8_t*)eph, ephBytes) == ephBytes;
+    }
+    f.close();
+
+    if (ok) {
+        header = h;
+        ok     = fileCrc(h) == h.crc;
+    }
+    if (!ok) {
+        Serial.println("[GPS] Aiding cache corrupt — ignoring");
+        memset(&header, 0, sizeof(header));
+        header.magic   = GPS_AID_MAGIC;
+        header.version = GPS_AID_VERSION;
+        return false;
+    }
+    return true;
+}
+
+bool GPSAidCache::save() {
+    header.crc = fileCrc(header);
+
+    // Write to a temp file and rename so a power cut never leaves a torn cache
+    File f = LittleFS.open(GPS_AID_FILE ".tmp", "w");
+    if (!f) return false;
+    size_t almBytes = (size_t)header.almCount * GPS_AID_ALM_LEN;
+    size_t ephBytes = (size_t)header.ephCount * GPS_AID_EPH_LEN;
+    bool ok = f.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              f.write((const uint8_t*)alm, almBytes) == almBytes &&
+              f.write((const uint8_t*)eph, ephBytes) == ephBytes;
+    f.close();
+
+    if (!ok) {
+        LittleFS.remove(GPS_AID_FILE ".tmp");
+        return false;
+    }
+    // rename replaces the old cache atomically; removing it first would
+    // open a window with neither file on a power cut
+    if (!LittleFS.rename(GPS_AID_FILE ".tmp", GPS_AID_FILE)) {
+        LittleFS.remove(GPS_AID_FILE ".tmp");
+        return false;
+    }
+    return true;
+}
+
+void GPSAidCache::setFix(double lat, double lon, double altM, uint32_t hdopX100,
+                         uint16_t year, uint8_t month, uint8_t day,
+                         uint8_t hour, uint8_t minute, uint8_t second) {
+    header.latE7    = (int32_t)(lat * 1e7);
+    header.lonE7    = (int32_t)(lon * 1e7);
+    header.altCm    = (int32_t)(altM * 100.0);
+    uint32_t acc    = (hdopX100 ? hdopX100 : 200) * AID_UERE_CM / 100;
+    header.posAccCm = acc ? acc : 1;
+    header.utcYear   = year;
+    header.utcMonth  = month;
+    header.utcDay    = day;
+    header.utcHour   = hour;
+    header.utcMinute = minute;
+    header.utcSecond = second;
+}
+
+void GPSAidCache::beginCapture() {
+    responsesSeen = 0;
+    freshAlm = freshEph = true;
+}
+
+void GPSAidCache::storeRecord(uint8_t* table, size_t stride, uint8_t& count,
+                              const uint8_t* payload) {
+    // First U4 of both AID-ALM and AID-EPH is the SV id
+    for (uint8_t i = 0; i < count; i++) {
+        if (memcmp(table + i * stride, payload, 4) == 0) {
+            memcpy(table + i * stride, payload, stride);
+            return;
+        }
+    }
+    if (count < GPS_AID_MAX_SV) {
+        memcpy(table + count * stride, payload, stride);
+        count++;
+    }
+}
+
+bool GPSAidCache::onUbx(uint8_t cls, uint8_t id, const uint8_t* payload, uint16_t len) {
+    if (cls != UBX_CLASS_AID) return false;
+
+    if (id == UBX_ID_AID_ALM) {
+        responsesSeen++;
+        if (len == GPS_AID_ALM_LEN) {
+            if (freshAlm) { header.almCount = 0; freshAlm = false; }
+            storeRecord(&alm[0][0], GPS_AID_ALM_LEN, header.almCount, payload);
+        }
+        return true;
+    }
+    if (id == UBX_ID_AID_EPH) {
+        responsesSeen++;
+        if (len == GPS_AID_EPH_LEN) {
+            if (freshEph) { header.ephCount = 0; freshEph = false; }
+            storeRecord(&eph[0][0], GPS_AID_EPH_LEN, header.ephCount, payload);
+        }
+        return true;
+    }
+    return false;
+}
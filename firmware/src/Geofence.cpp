@@ -0,0 +1,232 @@
+/**
+ * @file Geofence.cpp
+ * @brief Bounding-box prefiltered circle / polygon fences with hysteresis
+ */
+
+#include "Geofence.h"
+#include "FixedMath.h"
+
+Geofence::Geofence()
+    : marginMm(GEOFENCE_MARGIN_MM), confirmFixes(GEOFENCE_CONFIRM_FIXES) {
+    clear();
+}
+
+void Geofence::clear() {
+    fenceCount     = 0;
+    vertexCount    = 0;
+    evHead         = evCount = 0;
+    droppedEvents  = 0;
+    lastUpdateUs   = 0;
+    lastExactTests = 0;
+}
+
+void Geofence::setHysteresis(uint32_t newMarginMm, uint8_t newConfirmFixes) {
+    marginMm     = newMarginMm;
+    confirmFixes = newConfirmFixes ? newConfirmFixes : 1;
+    if (confirmFixes > GEOFENCE_CONFIRM_MAX) confirmFixes = GEOFENCE_CONFIRM_MAX;
+    for (uint8_t i = 0; i < fenceCount; i++) computeBox(fences[i]);
+}
+
+/** Bounding box of the fence grown by the exit margin on every side. */
+void Geofence::computeBox(Fence& f) const {
+    int32_t minLat, maxLat, minLon, maxLon;
+    int64_t padMm = marginMm;
+
+    if (f.shape == FENCE_CIRCLE) {
+        minLat = maxLat = f.circle.latE6;
+        minLon = maxLon = f.circle.lonE6;
+        padMm += f.circle.radiusMm;
+    } else {
+        minLat = maxLat = vertLat[f.poly.first];
+        minLon = maxLon = vertLon[f.poly.first];
+        for (uint16_t i = 1; i < f.poly.count; i++) {
+            int32_t la = vertLat[f.poly.first + i];
+            int32_t lo = vertLon[f.poly.first + i];
+            if (la < minLat) minLat = la;
+            if (la > maxLat) maxLat = la;
+            if (lo < minLon) minLon = lo;
+            if (lo > maxLon) maxLon = lo;
+        }
+    }
+
+    int32_t padLat = (int32_t)((padMm << 16) / FM_MM_PER_UDEG_Q16) + 1;
+    int32_t padLon = (int32_t)(((int64_t)padLat << 15) / (f.cosQ15 > 0 ? f.cosQ15 : 1)) + 1;
+    f.minLat = minLat - padLat;
+    f.maxLat = maxLat + padLat;
+    f.minLon = minLon - padLon;
+    f.maxLon = maxLon + padLon;
+}
+
+int Geofence::addCircle(uint16_t id, int32_t latE6, int32_t lonE6, uint32_t radiusMm) {
+    if (fenceCount >= GEOFENCE_MAX_FENCES) return -1;
+
+    Fence& f          = fences[fenceCount];
+    f.id              = id;
+    f.shape           = FENCE_CIRCLE;
+    f.inside          = 0;
+    f.pending         = 0;
+    f.circle.latE6    = latE6;
+    f.circle.lonE6    = lonE6;
+    f.circle.radiusMm = radiusMm;
+    f.cosQ15          = FixedMath::cosLatQ15(latE6);
+    computeBox(f);
+    return fenceCount++;
+}
+
+int Geofence::addPolygon(uint16_t id, const int32_t* latE6, const int32_t* lonE6,
+                         uint16_t count) {
+    if (fenceCount >= GEOFENCE_MAX_FENCES || count < 3 ||
+        vertexCount + count > GEOFENCE_MAX_VERTICES) {
+        return -1;
+    }
+
+    Fence& f      = fences[fenceCount];
+    f.id          = id;
+    f.shape       = FENCE_POLYGON;
+    f.inside      = 0;
+    f.pending     = 0;
+    f.poly.first  = vertexCount;
+    f.poly.count  = count;
+    memcpy(&vertLat[vertexCount], latE6, count * sizeof(int32_t));
+    memcpy(&vertLon[vertexCount], lonE6, count * sizeof(int32_t));
+    vertexCount  += count;
+
+    int64_t latSum = 0;
+    for (uint16_t i = 0; i < count; i++) latSum += latE6[i];
+    f.cosQ15 = FixedMath::cosLatQ15((int32_t)(latSum / count));
+    computeBox(f);
+    return fenceCount++;
+}
+
+/**
+ * Crossing-number test with lon as x and lat as y.  The edge/ray
+ * intersection comparison is cross-multiplied so no division is needed;
+ * µdeg differences stay below 2^29, so the products fit in int64.
+ */
+bool Geofence::pointInPolygon(const Fence& f, int32_t latE6, int32_t lonE6) const {
+    const int32_t* la = &vertLat[f.poly.first];
+    const int32_t* lo = &vertLon[f.poly.first];
+    bool     in = false;
+    uint16_t j  = f.poly.count - 1;
+
+    for (uint16_t i = 0; i < f.poly.count; j = i++) {
+        if ((la[i] > latE6) != (la[j] > latE6)) {
+            int64_t dy  = (int64_t)la[j] - la[i];
+            int64_t lhs = ((int64_t)lonE6 - lo[i]) * dy;
+            int64_t rhs = ((int64_t)latE6 - la[i]) * ((int64_t)lo[j] - lo[i]);
+            if (dy > 0 ? lhs < rhs : lhs > rhs) in = !in;
+        }
+    }
+    return in;
+}
+
+/** True if the point is within `mm` of any polygon edge (local mm plane). */
+bool Geofence::withinMmOfEdge(const Fence& f, int32_t latE6, int32_t lonE6, uint32_t mm) const {
+    int64_t  limSq = (int64_t)mm * mm;
+    uint16_t j     = f.poly.count - 1;
+    int32_t  ae, an;
+    FixedMath::toLocalMm(vertLat[f.poly.first + j], vertLon[f.poly.first + j],
+                         latE6, lonE6, f.cosQ15, ae, an);
+
+    for (uint16_t i = 0; i < f.poly.count; i++) {
+        int32_t be, bn;
+        FixedMath::toLocalMm(vertLat[f.poly.first + i], vertLon[f.poly.first + i],
+                             latE6, lonE6, f.cosQ15, be, bn);
+
+        // Point is the origin; closest point on segment A→B
+        int64_t dx = (int64_t)be - ae, dy = (int64_t)bn - an;
+        int64_t lenSq = dx * dx + dy * dy;
+        int64_t t     = -((int64_t)ae * dx + (int64_t)an * dy);   // dot(−A, B−A)
+        int64_t distSq;
+        if (lenSq == 0 || t <= 0) {
+            distSq = (int64_t)ae * ae + (int64_t)an * an;
+        } else if (t >= lenSq) {
+            distSq = (int64_t)be * be + (int64_t)bn * bn;
+        } else {
+            // |A × (B−A)|² / |B−A|²
+            int64_t cross = (int64_t)ae * dy - (int64_t)an * dx;
+            int64_t q     = cross / (int64_t)FixedMath::isqrt64((uint64_t)lenSq);
+            distSq = q * q;
+        }
+        if (distSq <= limSq) return true;
+
+        ae = be;
+        an = bn;
+    }
+    return false;
+}
+
+bool Geofence::containsWithHysteresis(const Fence& f, int32_t latE6, int32_t lonE6) const {
+    if (f.shape == FENCE_CIRCLE) {
+        int32_t e, n;
+        FixedMath::toLocalMm(latE6, lonE6, f.circle.latE6, f.circle.lonE6, f.cosQ15, e, n);
+        int64_t dSq = (int64_t)e * e + (int64_t)n * n;
+        int64_t r   = (int64_t)f.circle.radiusMm + (f.inside ? marginMm : 0);
+        return dSq <= r * r;
+    }
+
+    if (pointInPolygon(f, latE6, lonE6)) return true;
+    // Already inside: only count as out once clear of the margin band
+    return f.inside && withinMmOfEdge(f, latE6, lonE6, marginMm);
+}
+
+void Geofence::seed(int index, int32_t latE6, int32_t lonE6) {
+    if (index < 0 || index >= fenceCount) return;
+    Fence& f  = fences[index];
+    f.inside  = 0;   // judge by the boundary itself, as for an entry
+    f.pending = 0;
+    f.inside  = latE6 >= f.minLat && latE6 <= f.maxLat &&
+                lonE6 >= f.minLon && lonE6 <= f.maxLon &&
+                containsWithHysteresis(f, latE6, lonE6);
+}
+
+void Geofence::pushEvent(const GeofenceEvent& ev) {
+    if (evCount == GEOFENCE_EVENT_QUEUE) {
+        evHead = (uint8_t)((evHead + 1) % GEOFENCE_EVENT_QUEUE);   // drop oldest
+        evCount--;
+        droppedEvents++;
+    }
+    events[(evHead + evCount) % GEOFENCE_EVENT_QUEUE] = ev;
+    evCount++;
+}
+
+uint8_t Geofence::update(int32_t latE6, int32_t lonE6, uint32_t timestamp) {
+    uint32_t t0     = micros();
+    uint8_t  queued = 0;
+    uint8_t  exact  = 0;
+
+    for (uint8_t i = 0; i < fenceCount; i++) {
+        Fence& f = fences[i];
+
+        bool in = false;
+        if (latE6 >= f.minLat && latE6 <= f.maxLat &&
+            lonE6 >= f.minLon && lonE6 <= f.maxLon) {
+            exact++;
+            in = containsWithHysteresis(f, latE6, lonE6);
+        }
+
+        if (in == (bool)f.inside) {
+            f.pending = 0;
+            continue;
+        }
+        if (++f.pending < confirmFixes) continue;
+
+        f.inside  = in;
+        f.pending = 0;
+        GeofenceEvent ev = { f.id, in ? GEOFENCE_ENTER : GEOFENCE_EXIT, timestamp, latE6, lonE6 };
+        pushEvent(ev);
+        queued++;
+    }
+
+    lastExactTests = exact;
+    lastUpdateUs   = micros() - t0;
+    return queued;
+}
+
+bool Geofence::pollEvent(GeofenceEvent& out) {
+    if (evCount == 0) return false;
+    out    = events[evHead];
+    evHead = (uint8_t)((evHead + 1) % GEOFENCE_EVENT_QUEUE);
+    evCount--;
+    return true;
+}
@@ -1,34 +1,71 @@
 /**
  * @file IMU.cpp
  * @brief IMU module implementation
+ *
+ * Hardware connections (Pico W):
+ *   GP6 (I2C1 SDA) ↔ MPU6050 SDA
+ *   GP7 (I2C1 SCL) → MPU6050 SCL
+ *   Pin 36 (3V3)   → MPU6050 VCC, AD0 to GND (address 0x68)
  */
 
 #include "IMU.h"
-#include <Wire.h>
 
-IMU::IMU() : initialized(false) {
+// I2C1 is Wire1 in arduino-pico; the OLED keeps Wire (I2C0) to itself
+#define IMU_WIRE Wire1
+
+// MPU6050 registers used by FIFO mode
+#define REG_SMPLRT_DIV    0x19
+#define REG_CONFIG        0x1A
+#define REG_ACCEL_CONFIG  0x1C
+#define REG_MOT_THR       0x1F
+#define REG_MOT_DUR       0x20
+#define REG_FIFO_EN       0x23
+#define REG_INT_ENABLE    0x38
+#define REG_INT_STATUS    0x3A
+#define REG_USER_CTRL     0x6A
+#define REG_FIFO_COUNT_H  0x72
+#define REG_FIFO_R_W      0x74
+
+#define FIFO_EN_ACCEL     0x08
+#define FIFO_EN_GYRO_XYZ  0x70
+#define USER_FIFO_EN      0x40
+#define USER_FIFO_RESET   0x04
+#define INT_FIFO_OFLOW    0x10
+#define INT_MOTION        0x40
+#define ACCEL_FS_8G       0x10
+#define ACCEL_HPF_5HZ     0x01   // motion detector sees accel high-passed at 5 Hz
+#define DLPF_CFG_42HZ     0x03   // gyro output rate stays 1 kHz with DLPF on
+
+static const float G_MS2 = 9.80665f;
+
+IMU::IMU()
+    : initialized(false), fifoMode(false), sampleRateHz(0), samplePeriodUs(0),
+      nextSampleUs(0), timeLocked(false), ringHead(0), ringTail(0), fifoOverflows(0),
+      ringOverflows(0), sampleCount(0), burstCount(0), lastPollMicros(0), intEnable(0),
+      motionFlag(false), motionEvents(0) {
     memset(&currentData, 0, sizeof(IMUData));
 }
 
 bool IMU::begin() {
-    // Initialize I2C
-    Wire.begin(IMU_SDA_PIN, IMU_SCL_PIN);
+    // Initialize I2C1
+    IMU_WIRE.setSDA(PIN_IMU_SDA);
+    IMU_WIRE.setSCL(PIN_IMU_SCL);
+    IMU_WIRE.begin();
+    IMU_WIRE.setClock(IMU_I2C_CLOCK);
 
     // Initialize MPU6050
-    if (!mpu.begin()) {
-        Serial.println("Failed to find MPU6050 chip");
+    if (!mpu.begin(IMU_I2C_ADDR, &IMU_WIRE)) {
+        Serial.println("[IMU] MPU6050 not found");
         return false;
     }
 
-    Serial.println("MPU6050 Found!");
-
     // Configure MPU6050
     mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
     mpu.setGyroRange(MPU6050_RANGE_500_DEG);
     mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
 
     initialized = true;
-    Serial.println("IMU initialized successfully");
+    Serial.println("[IMU] MPU6050 ready");
     return true;
 }
 
@@ -52,6 +89,183 @@ bool IMU::readSensor() {
     return true;
 }
 
+// ── FIFO mode ────────────────────────────────────────────────────────────────
+
+bool IMU::writeReg(uint8_t reg, uint8_t value) {
+    IMU_WIRE.beginTransmission(IMU_I2C_ADDR);
+    IMU_WIRE.write(reg);
+    IMU_WIRE.write(value);
+    return IMU_WIRE.endTransmission() == 0;
+}
+
+bool IMU::readRegs(uint8_t reg, uint8_t* out, size_t len) {
+    IMU_WIRE.beginTransmission(IMU_I2C_ADDR);
+    IMU_WIRE.write(reg);
+    if (IMU_WIRE.endTransmission(false) != 0) return false;
+    if (IMU_WIRE.requestFrom((uint8_t)IMU_I2C_ADDR, len) != len) return false;
+    for (size_t i = 0; i < len; i++) out[i] = (uint8_t)IMU_WIRE.read();
+    return true;
+}
+
+void IMU::resetFifo() {
+    writeReg(REG_USER_CTRL, USER_FIFO_RESET);
+    writeReg(REG_USER_CTRL, USER_FIFO_EN);
+    timeLocked = false;
+}
+
+bool IMU::beginFifo(uint16_t rateHz) {
+    if (!initialized) return false;
+
+    rateHz              = constrain(rateHz, 4, 1000);
+    uint8_t div         = (uint8_t)(1000 / rateHz - 1);
+    sampleRateHz        = (uint16_t)(1000 / (div + 1));
+    samplePeriodUs      = 1000UL * (div + 1);
+
+    // Overflow stays off INT_ENABLE: the pin is the wake-on-motion line, and
+    // pollFifo() spots an overflow from the FIFO count anyway
+    bool ok = writeReg(REG_CONFIG, DLPF_CFG_42HZ) &&
+              writeReg(REG_SMPLRT_DIV, div) &&
+              writeReg(REG_FIFO_EN, FIFO_EN_ACCEL | FIFO_EN_GYRO_XYZ);
+    if (!ok) {
+        Serial.println("[IMU] FIFO setup failed");
+        return false;
+    }
+    resetFifo();
+
+    ringHead = ringTail = 0;
+    fifoMode = true;
+    Serial.println("[IMU] FIFO mode at " + String(sampleRateHz) + " Hz");
+    return true;
+}
+
+void IMU::setFifoEnabled(bool enabled) {
+    if (!fifoMode) return;
+    if (enabled) {
+        writeReg(REG_FIFO_EN, FIFO_EN_ACCEL | FIFO_EN_GYRO_XYZ);
+        resetFifo();
+    } else {
+        writeReg(REG_FIFO_EN, 0);
+        writeReg(REG_USER_CTRL, 0);
+    }
+}
+
+bool IMU::enableMotionInterrupt(uint16_t thresholdMg, uint8_t durationMs) {
+    if (!initialized) return false;
+    uint16_t thr = min((uint16_t)(thresholdMg / 2), (uint16_t)255);
+    bool ok = writeReg(REG_ACCEL_CONFIG, ACCEL_FS_8G | ACCEL_HPF_5HZ) &&
+              writeReg(REG_MOT_THR, (uint8_t)max(thr, (uint16_t)1)) &&
+              writeReg(REG_MOT_DUR, max(durationMs, (uint8_t)1)) &&
+              writeReg(REG_INT_ENABLE, intEnable | INT_MOTION);
+    if (!ok) {
+        Serial.println("[IMU] Motion interrupt setup failed");
+        return false;
+    }
+    intEnable |= INT_MOTION;
+    Serial.println("[IMU] Wake-on-motion armed at " + String(thresholdMg) + " mg");
+    return true;
+}
+
+bool IMU::takeMotion() {
+    noInterrupts();
+    bool seen  = motionFlag;
+    motionFlag = false;
+    interrupts();
+    if (seen) motionEvents++;
+    return seen;
+}
+
+void IMU::pushSample(const uint8_t* frame, uint32_t timestampUs) {
+    if (ringHead - ringTail >= IMU_RING_SIZE) {
+        ringTail++;                       // drop the oldest
+        ringOverflows++;
+    }
+    ImuSample& s  = ring[ringHead & (IMU_RING_SIZE - 1)];
+    s.timestampUs = timestampUs;
+    for (uint8_t i = 0; i < 3; i++) {
+        s.accel[i] = (int16_t)((frame[2 * i] << 8) | frame[2 * i + 1]);
+        s.gyro[i]  = (int16_t)((frame[6 + 2 * i] << 8) | frame[6 + 2 * i + 1]);
+    }
+    ringHead++;
+    sampleCount++;
+}
+
+size_t IMU::pollFifo() {
+    if (!fifoMode) return 0;
+    uint32_t t0 = micros();
+
+    uint8_t status, countBuf[2];
+    if (!readRegs(REG_INT_STATUS, &status, 1) || !readRegs(REG_FIFO_COUNT_H, countBuf, 2)) {
+        return 0;
+    }
+    uint16_t count = (uint16_t)((countBuf[0] << 8) | countBuf[1]);
+    if (status & INT_MOTION) motionFlag = true;   // reading INT_STATUS cleared it
+
+    if ((status & INT_FIFO_OFLOW) || count >= IMU_FIFO_SIZE || count % IMU_FIFO_FRAME) {
+        // Full (so overflowing) or torn: frame boundaries are lost
+        fifoOverflows++;
+        resetFifo();
+        lastPollMicros = micros() - t0;
+        return 0;
+    }
+
+    size_t frames = count / IMU_FIFO_FRAME;
+    if (frames == 0) {
+        lastPollMicros = micros() - t0;
+        return 0;
+    }
+
+    // The newest frame was sampled within one period of the count read.
+    // Follow that slowly so the sensor's own clock sets the spacing.
+    uint32_t firstUs = t0 - (uint32_t)(frames - 1) * samplePeriodUs;
+    int32_t  err     = (int32_t)(firstUs - nextSampleUs);
+    if (!timeLocked || err > 4 * (int32_t)samplePeriodUs || err < -4 * (int32_t)samplePeriodUs) {
+        nextSampleUs = firstUs;
+        timeLocked   = true;
+    } else {
+        nextSampleUs += err / 8;
+    }
+
+    uint8_t buf[IMU_FIFO_BURST];
+    size_t  left = frames * IMU_FIFO_FRAME;
+    while (left) {
+        size_t n = min(left, (size_t)IMU_FIFO_BURST);
+        if (!readRegs(REG_FIFO_R_W, buf, n)) {
+            resetFifo();
+            break;
+        }
+        burstCount++;
+        for (size_t off = 0; off < n; off += IMU_FIFO_FRAME) {
+            pushSample(buf + off, nextSampleUs);
+            nextSampleUs += samplePeriodUs;
+        }
+        left -= n;
+    }
+
+    // Keep the float accessors current with the newest sample
+    const ImuSample& last = ring[(ringHead - 1) & (IMU_RING_SIZE - 1)];
+    const float aScale = G_MS2 / IMU_ACCEL_LSB_PER_G;
+    const float gScale = (float)(DEG_TO_RAD * 10.0 / IMU_GYRO_LSB_PER_DPS_X10);
+    currentData.accelX    = last.accel[0] * aScale;
+    currentData.accelY    = last.accel[1] * aScale;
+    currentData.accelZ    = last.accel[2] * aScale;
+    currentData.gyroX     = last.gyro[0] * gScale;
+    currentData.gyroY     = last.gyro[1] * gScale;
+    currentData.gyroZ     = last.gyro[2] * gScale;
+    currentData.timestamp = last.timestampUs / 1000;
+
+    lastPollMicros = micros() - t0;
+    return frames - left / IMU_FIFO_FRAME;
+}
+
+bool IMU::popSample(ImuSample& out) {
+    if (ringHead == ringTail) return false;
+    out = ring[ringTail & (IMU_RING_SIZE - 1)];
+    ringTail++;
+    return true;
+}
+
+// ── Accessors ────────────────────────────────────────────────────────────────
+
 void IMU::getAcceleration(float& x, float& y, float& z) {
     x = currentData.accelX;
     y = currentData.accelY;
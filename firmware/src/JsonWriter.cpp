@@ -0,0 +1,155 @@
+/**
+ * @file JsonWriter.cpp
+ * @brief Streaming JSON serializer implementation
+ */
+
+#include "JsonWriter.h"
+
+static const int32_t POW10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+JsonWriter::JsonWriter(char* buf, size_t cap)
+    : buf(buf), cap(cap), out(nullptr), len(0), overflow(false), depth(0), needComma(0) {
+    if (cap > 0) buf[0] = '\0';
+}
+
+JsonWriter::JsonWriter(Print& out)
+    : buf(nullptr), cap(0), out(&out), len(0), overflow(false), depth(0), needComma(0) {}
+
+void JsonWriter::put(const char* s, size_t n) {
+    if (out) {
+        out->write((const uint8_t*)s, n);
+    } else if (!overflow) {
+        if (len + n < cap) {
+            memcpy(buf + len, s, n);
+            buf[len + n] = '\0';
+        } else {
+            overflow = true;
+        }
+    }
+    len += n;
+}
+
+void JsonWriter::putKey(const JsonKey& key) {
+    uint16_t bit = (uint16_t)(1u << depth);
+    if (needComma & bit) put(',');
+    needComma |= bit;
+    put(key.text, key.len);
+}
+
+void JsonWriter::putUInt(uint32_t v) {
+    char    tmp[10];
+    uint8_t n = sizeof(tmp);
+    do {
+        tmp[--n] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    put(tmp + n, sizeof(tmp) - n);
+}
+
+void JsonWriter::beginObject() {
+    put('{');
+    if (depth < JSON_WRITER_MAX_DEPTH) depth++;
+    needComma &= (uint16_t)~(1u << depth);
+}
+
+void JsonWriter::beginObject(const JsonKey& key) {
+    putKey(key);
+    beginObject();
+}
+
+void JsonWriter::endObject() {
+    put('}');
+    if (depth > 0) depth--;
+}
+
+void JsonWriter::addInt(const JsonKey& key, int32_t value) {
+    putKey(key);
+    if (value < 0) {
+        put('-');
+        putUInt(0u - (uint32_t)value);
+    } else {
+        putUInt((uint32_t)value);
+    }
+}
+
+void JsonWriter::addUInt(const JsonKey& key, uint32_t value) {
+    putKey(key);
+    putUInt(value);
+}
+
+void JsonWriter::addBool(const JsonKey& key, bool value) {
+    putKey(key);
+    if (value) put("true", 4);
+    else       put("false", 5);
+}
+
+void JsonWriter::addString(const JsonKey& key, const char* value) {
+    putKey(key);
+    put('"');
+    if (value) {
+        // Copy runs of safe characters in one go; escape the rest
+        const char* run = value;
+        for (const char* p = value; *p; p++) {
+            uint8_t c = (uint8_t)*p;
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            put(run, (size_t)(p - run));
+            run = p + 1;
+            char esc[6] = { '\\', (char)c, 0, 0, 0, 0 };
+            if (c == '\n')      { esc[1] = 'n'; put(esc, 2); }
+            else if (c == '\r') { esc[1] = 'r'; put(esc, 2); }
+            else if (c == '\t') { esc[1] = 't'; put(esc, 2); }
+            else if (c == '\b') { esc[1] = 'b'; put(esc, 2); }
+            else if (c == '\f') { esc[1] = 'f'; put(esc, 2); }
+            else if (c < 0x20) {
+                static const char hex[] = "0123456789abcdef";
+                esc[1] = 'u'; esc[2] = '0'; esc[3] = '0';
+                esc[4] = hex[c >> 4]; esc[5] = hex[c & 0xF];
+                put(esc, 6);
+            } else {
+                put(esc, 2);
+            }
+        }
+        put(run, strlen(run));
+    }
+    put('"');
+}
+
+void JsonWriter::addFixed(const JsonKey& key, int32_t value, uint8_t decimals) {
+    putKey(key);
+    uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    if (value < 0) put('-');
+    if (decimals == 0 || decimals > 9) {
+        putUInt(mag);
+        return;
+    }
+
+    uint32_t div = 1;
+    for (uint8_t i = 0; i < decimals; i++) div *= 10;
+    putUInt(mag / div);
+
+    // Trailing zeros dropped, as ArduinoJson writes numbers: 12.50 → 12.5
+    uint32_t f = mag % div;
+    if (f == 0) return;
+    while (f % 10 == 0) {
+        f /= 10;
+        decimals--;
+    }
+    put('.');
+
+    char frac[9];
+    for (int8_t i = (int8_t)decimals - 1; i >= 0; i--) {
+        frac[i] = (char)('0' + f % 10);
+        f /= 10;
+    }
+    put(frac, decimals);
+}
+
+void JsonWriter::addFloat(const JsonKey& key, float value, uint8_t decimals) {
+    if (decimals > 6) decimals = 6;
+    float scaled = value * (float)POW10[decimals];
+    // Clamp to the int32 range; NaN becomes 0
+    int32_t fixed = scaled >= 2147483520.0f  ? INT32_MAX
+                  : scaled <= -2147483520.0f ? -INT32_MAX
+                  : scaled == scaled         ? (int32_t)lroundf(scaled) : 0;
+    addFixed(key, fixed, decimals);
+}
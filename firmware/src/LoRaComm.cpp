@@ -15,8 +15,14 @@
 // UART0 is Serial1 in arduino-pico
 #define LORA_SERIAL Serial1
 
+// RF parameters in force, for airtimeMs(); begin() sets the build defaults
+static uint8_t rfSf = LORA_PARAM_SF;
+static uint8_t rfBw = LORA_PARAM_BW;
+static uint8_t rfCr = LORA_PARAM_CR;
+static uint8_t rfPp = LORA_PARAM_PP;
+
 LoRaComm::LoRaComm()
-    : initialized(false), lastRSSI(0), lastSNR(0.0f), rxBuffer("") {}
+    : initialized(false), sleeping(false), lastRSSI(0), lastSNR(0.0f), rxBuffer("") {}
 
 // ── Private helpers ──────────────────────────────────────────────────────────
 
@@ -102,6 +108,10 @@ bool LoRaComm::begin(uint16_t deviceAddress) {
                       String(LORA_PARAM_PP);
     resp = sendAT(paramCmd, "+PARAMETER=", 2000);
     Serial.println("[LoRa] PARAMETER → " + resp);
+    rfSf = LORA_PARAM_SF;
+    rfBw = LORA_PARAM_BW;
+    rfCr = LORA_PARAM_CR;
+    rfPp = LORA_PARAM_PP;
 
     initialized = true;
     Serial.println("[LoRa] RYLR896 ready");
@@ -128,6 +138,150 @@ bool LoRaComm::sendMessage(uint16_t targetAddress, const String& message) {
     return true;
 }
 
+// ── Runtime RF settings ──────────────────────────────────────────────────────
+
+bool LoRaComm::setFrequency(uint32_t hz) {
+    if (!initialized) return false;
+    if (sendAT("AT+BAND=" + String(hz), "+OK", 2000) == "") {
+        Serial.println("[LoRa] BAND not acknowledged");
+        return false;
+    }
+    return true;
+}
+
+bool LoRaComm::setRfParameters(uint8_t sf, uint8_t bw, uint8_t cr, uint8_t preamble) {
+    if (!initialized) return false;
+    String cmd = "AT+PARAMETER=" + String(sf) + "," + String(bw) + "," +
+                 String(cr) + "," + String(preamble);
+    if (sendAT(cmd, "+OK", 2000) == "") {
+        Serial.println("[LoRa] PARAMETER not acknowledged");
+        return false;
+    }
+    rfSf = sf;
+    rfBw = bw;
+    rfCr = cr;
+    rfPp = preamble;
+    return true;
+}
+
+bool LoRaComm::setAddress(uint16_t address) {
+    if (!initialized) return false;
+    if (sendAT("AT+ADDRESS=" + String(address), "+OK", 2000) == "") {
+        Serial.println("[LoRa] ADDRESS not acknowledged");
+        return false;
+    }
+    return true;
+}
+
+bool LoRaComm::setOutputPower(uint8_t dbm) {
+    if (!initialized) return false;
+    if (sendAT("AT+CRFOP=" + String(dbm), "+OK", 2000) == "") {
+        Serial.println("[LoRa] CRFOP not acknowledged");
+        return false;
+    }
+    return true;
+}
+
+// ── Sleep ────────────────────────────────────────────────────────────────────
+
+bool LoRaComm::sleep() {
+    if (!initialized || sleeping) return sleeping;
+    if (sendAT("AT+MODE=1", "+OK", 1000) == "") {
+        Serial.println("[LoRa] Sleep not acknowledged");
+        return false;
+    }
+    sleeping = true;
+    return true;
+}
+
+bool LoRaComm::wake() {
+    if (!sleeping) return true;
+    // The first command after sleep only wakes the module
+    sendAT("AT", "+OK", 200);
+    if (sendAT("AT+MODE=0", "+OK", 1000) == "") {
+        Serial.println("[LoRa] Wake not acknowledged");
+        return false;
+    }
+    sleeping = false;
+    rxBuffer = "";
+    return true;
+}
+
+// ── Binary framing ───────────────────────────────────────────────────────────
+
+static const char B64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int8_t b64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+bool LoRaComm::sendBinary(uint16_t targetAddress, const uint8_t* data, size_t len) {
+    if (len == 0 || len > RYLR_MAX_BINARY) {
+        Serial.println("[LoRa] Binary frame too large");
+        return false;
+    }
+
+    char   text[RYLR_MAX_PAYLOAD + 1];
+    size_t n = 0;
+    text[n++] = LORA_BINARY_MARKER;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        text[n++] = B64_ALPHABET[(v >> 18) & 0x3F];
+        text[n++] = B64_ALPHABET[(v >> 12) & 0x3F];
+        text[n++] = (i + 1 < len) ? B64_ALPHABET[(v >> 6) & 0x3F] : '=';
+        text[n++] = (i + 2 < len) ? B64_ALPHABET[v & 0x3F]        : '=';
+    }
+    text[n] = '\0';
+    return sendMessage(targetAddress, String(text));
+}
+
+int LoRaComm::decodeBinary(const String& payload, uint8_t* out, size_t cap) {
+    if (!isBinary(payload)) return -1;
+
+    size_t   written = 0;
+    uint32_t acc     = 0;
+    uint8_t  bits    = 0;
+    for (unsigned i = 1; i < payload.length(); i++) {
+        char c = payload[i];
+        if (c == '=') break;
+        int8_t v = b64Value(c);
+        if (v < 0) return -1;
+        acc   = (acc << 6) | (uint8_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (written >= cap) return -1;
+            out[written++] = (uint8_t)(acc >> bits);
+        }
+    }
+    return (int)written;
+}
+
+uint32_t LoRaComm::airtimeMs(size_t payloadLen) {
+    // RYLR896 AT+PARAMETER bandwidth codes 0–9
+    static const uint32_t BW_HZ[] = { 7800, 10400, 15600, 20800, 31250,
+                                      41700, 62500, 125000, 250000, 500000 };
+    const int32_t sf     = rfSf;
+    uint32_t      tsymUs = (uint32_t)((1000000ULL << sf) / BW_HZ[rfBw]);
+    int32_t       de     = tsymUs > 16000 ? 1 : 0;   // low data rate optimise
+
+    int32_t num     = 8 * (int32_t)payloadLen - 4 * sf + 28 + 16;
+    int32_t den     = 4 * (sf - 2 * de);
+    int32_t symbols = 8;
+    if (num > 0) symbols += ((num + den - 1) / den) * (rfCr + 4);
+
+    uint32_t preambleUs = (uint32_t)(4 * rfPp + 17) * tsymUs / 4;
+    return (preambleUs + (uint32_t)symbols * tsymUs + 999) / 1000;
+}
+
 /**
  * Non-blocking receive.  Accumulates characters into rxBuffer and checks for
  * a complete "+RCV=..." line each call.
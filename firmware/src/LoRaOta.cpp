@@ -0,0 +1,676 @@
+/**
+ * @file LoRaOta.cpp
+ * @brief Offer MAC (both sides); slot bitmaps, block writes and hash check
+ *        (receiver); rounds, pacing and NACK merging (sender)
+ */
+
+#include "LoRaOta.h"
+#include "LoRaComm.h"
+#include "Checksum.h"
+#include "DeltaPatch.h"
+#include <LittleFS.h>
+
+#ifdef ARDUINO_ARCH_RP2040
+#include <hardware/regs/addressmap.h>
+
+// Provided by the arduino-pico linker script
+extern uint8_t __flash_binary_end;
+
+/** The image this unit is running, read in place through XIP. */
+static const uint8_t* runningImage(uint32_t& size) {
+    size = (uint32_t)((uintptr_t)&__flash_binary_end - XIP_BASE);
+    return (const uint8_t*)XIP_BASE;
+}
+#else
+static const uint8_t* runningImage(uint32_t& size) {
+    size = 0;
+    return nullptr;
+}
+#endif
+
+#define OTA_SLOT_MAGIC       0x41544F42UL   // "BOTA"
+#define OTA_HEADER_LEN       48             // fields, then CRC-32
+#define OTA_STATUS_OFFSET    64             // status byte in page 0
+#define OTA_ERASED_OFFSET    LOG_FLASH_PAGE_SIZE
+#define OTA_BITMAP_OFFSET    LOG_FLASH_SECTOR_SIZE
+
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static inline void put32(uint8_t* p, uint32_t v) { for (uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i)); }
+static inline uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t blockLen(const OtaImageInfo& img, uint16_t i) {
+    uint32_t off = (uint32_t)i * OTA_BLOCK_SIZE;
+    return (uint16_t)min((uint32_t)OTA_BLOCK_SIZE, img.size - off);
+}
+
+#define OTA_OFFER_SIGNED_LEN (OTA_OFFER_LEN - OTA_MAC_SIZE)
+
+// ── Network key ──────────────────────────────────────────────────────────────
+
+bool OtaKey::load(const char* path) {
+    len = 0;
+    if (!LittleFS.begin() || !LittleFS.exists(path)) return false;
+    File f = LittleFS.open(path, "r");
+    if (!f) return false;
+    size_t n = f.size();
+    if (n >= OTA_KEY_MIN && n <= OTA_KEY_MAX && f.read(bytes, n) == n) len = (uint8_t)n;
+    f.close();
+    return len != 0;
+}
+
+void OtaKey::mac(const uint8_t* data, size_t dataLen, uint8_t out[OTA_MAC_SIZE]) const {
+    uint8_t full[SHA256_DIGEST_SIZE];
+    Sha256::hmac(bytes, len, data, dataLen, full);
+    memcpy(out, full, OTA_MAC_SIZE);
+}
+
+bool OtaKey::verify(const uint8_t* data, size_t dataLen, const uint8_t* expected) const {
+    if (!len) return false;
+    uint8_t m[OTA_MAC_SIZE];
+    mac(data, dataLen, m);
+    uint8_t diff = 0;
+    for (uint8_t i = 0; i < OTA_MAC_SIZE; i++) diff |= m[i] ^ expected[i];
+    return diff == 0;
+}
+
+// ── Receiver ─────────────────────────────────────────────────────────────────
+
+OtaReceiver::OtaReceiver()
+    : flash(nullptr), key(nullptr), address(0), state(OTA_IDLE), relay(0), have(0), flags(0),
+      nackAt(0), hashPos(0), hashStart(0) {
+    memset(&image, 0, sizeof(image));
+    memset(received, 0, sizeof(received));
+    memset(erased, 0, sizeof(erased));
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool OtaReceiver::begin(LogFlash& slot, uint16_t ownAddress, const OtaKey& k) {
+    if (!k.isSet() || slot.size() < OTA_SLOT_SIZE) return false;
+    key     = &k;
+    flash   = &slot;
+    address = ownAddress;
+    if (loadSession()) {
+        stats.resumedBlocks = have;
+        Serial.println("[OTA] Slot holds session " + String(image.session, HEX) + ": " +
+                       String(have) + "/" + String(image.blocks) + " blocks, " +
+                       stateName(state));
+    }
+    return true;
+}
+
+bool OtaReceiver::loadSession() {
+    uint8_t h[LOG_FLASH_PAGE_SIZE];
+    flash->read(0, h, sizeof(h));
+    if (get32(h) != OTA_SLOT_MAGIC || get32(h + OTA_HEADER_LEN) != crc32(h, OTA_HEADER_LEN)) {
+        state = OTA_IDLE;
+        return false;
+    }
+    image.session = get16(h + 4);
+    image.blocks  = get16(h + 6);
+    image.size    = get32(h + 8);
+    image.version = get32(h + 12);
+    memcpy(image.sha256, h + 16, SHA256_DIGEST_SIZE);
+    if (image.blocks == 0 || image.blocks > OTA_MAX_BLOCKS) {
+        state = OTA_IDLE;
+        return false;
+    }
+
+    flags = (uint8_t)~h[OTA_STATUS_OFFSET];
+    flash->read(OTA_ERASED_OFFSET, erased, sizeof(erased));
+    flash->read(OTA_BITMAP_OFFSET, received, sizeof(received));
+    have = 0;
+    for (uint16_t i = 0; i < sizeof(erased); i++) erased[i] = (uint8_t)~erased[i];
+    for (uint16_t i = 0; i < sizeof(received); i++) received[i] = (uint8_t)~received[i];
+    for (uint16_t i = 0; i < image.blocks; i++) have += isReceived(i) ? 1 : 0;
+
+    if (flags & OTA_FLAG_INSTALLED)      state = OTA_INSTALLED;
+    else if (flags & OTA_FLAG_WRONG_BASE) state = OTA_REJECTED;
+    else if (flags & OTA_FLAG_BAD_HASH)  state = OTA_FAILED;
+    else if (flags & OTA_FLAG_VERIFIED)  state = OTA_READY;
+    else if (have == image.blocks)       state = OTA_VERIFYING;
+    else                                 state = OTA_RECEIVING;
+    if (state == OTA_VERIFYING) {
+        hasher.reset();
+        hashPos   = 0;
+        hashStart = millis();
+    }
+    return true;
+}
+
+bool OtaReceiver::startSession(const OtaImageInfo& info) {
+    // Metadata sectors only; image sectors are erased as blocks reach them
+    if (!flash->eraseSector(0) || !flash->eraseSector(OTA_BITMAP_OFFSET)) return false;
+
+    uint8_t h[LOG_FLASH_PAGE_SIZE];
+    memset(h, 0xFF, sizeof(h));
+    put32(h, OTA_SLOT_MAGIC);
+    put16(h + 4, info.session);
+    put16(h + 6, info.blocks);
+    put32(h + 8, info.size);
+    put32(h + 12, info.version);
+    memcpy(h + 16, info.sha256, SHA256_DIGEST_SIZE);
+    put32(h + OTA_HEADER_LEN, crc32(h, OTA_HEADER_LEN));
+    if (!flash->programPage(0, h)) return false;
+
+    image = info;
+    state = OTA_RECEIVING;
+    have  = 0;
+    flags = 0;
+    memset(received, 0, sizeof(received));
+    memset(erased, 0, sizeof(erased));
+    nackAt = 0;
+    Serial.println("[OTA] Session " + String(info.session, HEX) + ": " + String(info.size) +
+                   " B in " + String(info.blocks) + " blocks, version " + String(info.version));
+    return true;
+}
+
+void OtaReceiver::clearBit(uint32_t offset, uint8_t bit) {
+    // Reprogram the page with what it already holds minus one bit: NOR only
+    // clears, so nothing else in it changes
+    uint32_t base = offset - offset % LOG_FLASH_PAGE_SIZE;
+    uint8_t  page[LOG_FLASH_PAGE_SIZE];
+    flash->read(base, page, sizeof(page));
+    page[offset % LOG_FLASH_PAGE_SIZE] &= (uint8_t)~(1u << bit);
+    flash->programPage(base, page);
+}
+
+void OtaReceiver::setFlag(uint8_t flag) {
+    for (uint8_t b = 0; b < 8; b++) {
+        if ((flag & (1u << b)) && !(flags & (1u << b))) clearBit(OTA_STATUS_OFFSET, b);
+    }
+    flags |= flag;
+}
+
+bool OtaReceiver::writeBlock(uint16_t index, const uint8_t* data, size_t len) {
+    uint32_t off    = OTA_IMAGE_OFFSET + (uint32_t)index * OTA_BLOCK_SIZE;
+    uint16_t sector = (uint16_t)(off / LOG_FLASH_SECTOR_SIZE);
+    if (!(erased[sector >> 3] & (1u << (sector & 7)))) {
+        if (!flash->eraseSector((uint32_t)sector * LOG_FLASH_SECTOR_SIZE)) return false;
+        clearBit(OTA_ERASED_OFFSET + (sector >> 3), sector & 7);
+        erased[sector >> 3] |= (uint8_t)(1u << (sector & 7));
+        stats.sectorsErased++;
+    }
+
+    // The other half of the page may already hold its block: keep it as is
+    uint32_t base = off - off % LOG_FLASH_PAGE_SIZE;
+    uint8_t  page[LOG_FLASH_PAGE_SIZE];
+    flash->read(base, page, sizeof(page));
+    memcpy(page + off % LOG_FLASH_PAGE_SIZE, data, len);
+    if (!flash->programPage(base, page)) return false;
+
+    uint8_t check[OTA_BLOCK_SIZE];
+    flash->read(off, check, len);
+    if (memcmp(check, data, len) != 0) {
+        // Only a block torn by a power cut lands here; its sector cannot be
+        // rewritten without losing its neighbours, so start over
+        stats.crcErrors++;
+        Serial.println("[OTA] Block " + String(index) + " did not program, restarting session");
+        OtaImageInfo info = image;
+        startSession(info);
+        return false;
+    }
+
+    clearBit(OTA_BITMAP_OFFSET + (index >> 3), index & 7);
+    received[index >> 3] |= (uint8_t)(1u << (index & 7));
+    have++;
+    stats.blocksWritten++;
+    return true;
+}
+
+bool OtaReceiver::onFrame(uint16_t src, const uint8_t* f, size_t len, uint32_t now) {
+    if (!flash || len < 3) return false;
+    uint16_t session = get16(f + 1);
+
+    switch (f[0]) {
+        case FRAME_OTA_OFFER: {
+            if (len < OTA_OFFER_LEN) return true;
+            // Before anything else, so a forged offer cannot even redirect NACKs
+            if (!key->verify(f, OTA_OFFER_SIGNED_LEN, f + OTA_OFFER_SIGNED_LEN)) {
+                stats.badOffers++;
+                return true;
+            }
+            if (state != OTA_IDLE && session == image.session) {
+                relay = src;
+                if (state != OTA_FAILED) return true;   // failed: fetch it again
+            }
+            OtaImageInfo info;
+            info.session = session;
+            info.size    = get32(f + 3);
+            info.blocks  = get16(f + 7);
+            info.version = get32(f + 9);
+            memcpy(info.sha256, f + 13, SHA256_DIGEST_SIZE);
+            if (info.version == 0 || info.version <= FIRMWARE_VERSION) return true;
+            if (info.blocks == 0 || info.blocks > OTA_MAX_BLOCKS ||
+                info.blocks != (info.size + OTA_BLOCK_SIZE - 1) / OTA_BLOCK_SIZE) {
+                return true;
+            }
+            if (startSession(info)) relay = src;
+            return true;
+        }
+
+        case FRAME_OTA_BLOCK: {
+            if (len < OTA_BLOCK_HEADER || state != OTA_RECEIVING || session != image.session) {
+                return true;
+            }
+            uint16_t index = get16(f + 3);
+            size_t   n     = len - OTA_BLOCK_HEADER;
+            if (index >= image.blocks || n != blockLen(image, index) ||
+                crc16(f + OTA_BLOCK_HEADER, n) != get16(f + 5)) {
+                stats.crcErrors++;
+                return true;
+            }
+            if (isReceived(index)) {
+                stats.duplicates++;
+                return true;
+            }
+            if (!writeBlock(index, f + OTA_BLOCK_HEADER, n)) return true;
+            if (index == 0) checkBase(f + OTA_BLOCK_HEADER, n, now);
+            if (state == OTA_RECEIVING && have == image.blocks) {
+                setFlag(OTA_FLAG_COMPLETE);
+                state = OTA_VERIFYING;
+                hasher.reset();
+                hashPos   = 0;
+                hashStart = now;
+            }
+            return true;
+        }
+
+        case FRAME_OTA_POLL: {
+            if (len < OTA_POLL_LEN || state == OTA_IDLE || session != image.session) return true;
+            uint8_t  slots  = f[4] ? f[4] : 1;
+            uint16_t slotMs = get16(f + 5);
+            relay  = src;
+            nackAt = now + (uint32_t)(address % slots) * slotMs + 1;
+            return true;
+        }
+
+        case FRAME_OTA_NACK:
+            return true;   // another receiver's report — the relay's business
+
+        default:
+            return false;
+    }
+}
+
+void OtaReceiver::checkBase(const uint8_t* block, size_t len, uint32_t now) {
+    // A patch only rebuilds the image it was made from: stop downloading
+    // one made for another build as soon as its header is in
+    DeltaHeader h;
+    if (!DeltaPatcher::parseHeader(block, len, h)) return;
+    uint32_t       size;
+    const uint8_t* running = runningImage(size);
+    if (DeltaPatcher::matchesBase(h, running, size)) return;
+    setFlag(OTA_FLAG_WRONG_BASE);
+    state  = OTA_REJECTED;
+    nackAt = now ? now : 1;
+    Serial.println("[OTA] Patch is for another build, ignoring session " +
+                   String(image.session, HEX));
+}
+
+void OtaReceiver::service(uint32_t now) {
+    if (state != OTA_VERIFYING) return;
+
+    uint8_t  buf[LOG_FLASH_PAGE_SIZE];
+    uint32_t end = min(image.size, hashPos + OTA_HASH_CHUNK);
+    while (hashPos < end) {
+        size_t n = min((uint32_t)sizeof(buf), end - hashPos);
+        flash->read(OTA_IMAGE_OFFSET + hashPos, buf, n);
+        hasher.update(buf, n);
+        hashPos += n;
+    }
+    if (hashPos < image.size) return;
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    hasher.finish(digest);
+    stats.hashMs = now - hashStart;
+    if (memcmp(digest, image.sha256, SHA256_DIGEST_SIZE) == 0) {
+        setFlag(OTA_FLAG_VERIFIED);
+        state = OTA_READY;
+        Serial.println("[OTA] Image verified in " + String(stats.hashMs) + " ms");
+    } else {
+        setFlag(OTA_FLAG_BAD_HASH);
+        state = OTA_FAILED;
+        Serial.println("[OTA] Image hash mismatch — discarded");
+    }
+    nackAt = now ? now : 1;   // tell the relay straight away
+}
+
+size_t OtaReceiver::buildNack(uint8_t* out, size_t cap) {
+    if (cap < OTA_NACK_HEADER || state == OTA_IDLE) return 0;
+
+    uint16_t first = 0;
+    while (first < image.blocks && isReceived(first)) first++;
+
+    out[0] = FRAME_OTA_NACK;
+    put16(out + 1, image.session);
+    out[3] = flags;
+    put16(out + 4, have);
+    put16(out + 6, first);
+
+    size_t bytes = min((size_t)OTA_NACK_WINDOW_BYTES, cap - OTA_NACK_HEADER);
+    bytes = min(bytes, (size_t)((image.blocks - first + 7) / 8));
+    memset(out + OTA_NACK_HEADER, 0, bytes);
+    for (uint32_t j = 0; j < bytes * 8 && first + j < image.blocks; j++) {
+        if (!isReceived((uint16_t)(first + j))) out[OTA_NACK_HEADER + j / 8] |= (uint8_t)(1u << (j & 7));
+    }
+    return OTA_NACK_HEADER + bytes;
+}
+
+bool OtaReceiver::install(OtaImageWriter& writer) {
+    if (state != OTA_READY) return false;
+
+    // A patch is applied on the way, against the image running now
+    uint8_t     buf[LOG_FLASH_PAGE_SIZE];
+    DeltaHeader dh;
+    flash->read(OTA_IMAGE_OFFSET, buf, DELTA_HEADER_LEN);
+    bool patch = image.size >= DELTA_HEADER_LEN &&
+                 DeltaPatcher::parseHeader(buf, DELTA_HEADER_LEN, dh);
+
+    // The slot was hashed by verify() and is copied as it stands (the
+    // patcher checks its own output), so the writer does not hash again
+    if (!writer.begin(patch ? dh.newSize : image.size)) {
+        Serial.println("[OTA] Staging failed: " +
+                       String(OtaImageWriter::resultName(writer.getError())));
+        return false;
+    }
+
+    DeltaPatcher patcher;
+    DeltaResult  r = DELTA_OK;
+    if (patch) {
+        uint32_t       size;
+        const uint8_t* running = runningImage(size);
+        patcher.begin(running, size, writer);
+    }
+    bool copied = true;
+    for (uint32_t pos = 0; pos < image.size && r == DELTA_OK && copied; pos += sizeof(buf)) {
+        size_t n = min((uint32_t)sizeof(buf), image.size - pos);
+        flash->read(OTA_IMAGE_OFFSET + pos, buf, n);
+        if (patch) r = patcher.write(buf, n);
+        else       copied = writer.write(buf, n) == n;
+    }
+    if (!copied) {
+        Serial.println("[OTA] Staging failed: " +
+                       String(OtaImageWriter::resultName(writer.getError())));
+        writer.abort();
+        return false;
+    }
+    if (patch && r == DELTA_OK) r = patcher.finish();
+    if (patch && r != DELTA_DONE) {
+        Serial.println("[OTA] Patch failed: " + String(DeltaPatcher::resultName(r)));
+        writer.abort();
+        return false;
+    }
+
+    OtaWriterResult w = writer.commit();
+    if (w != OTA_WRITE_OK) {
+        Serial.println("[OTA] Staging failed: " + String(OtaImageWriter::resultName(w)));
+        return false;
+    }
+    const OtaWriterTiming& t = writer.getTiming();
+    Serial.println("[OTA] Staged " + String(writer.getSize()) + " B" +
+                   (patch ? " from a " + String(image.size) + " B patch" : String("")) +
+                   " in " + String(t.totalMs) + " ms (hash " + String(t.hashUs / 1000) +
+                   " ms, flash " + String(t.flashUs / 1000) + " ms, commit " +
+                   String(t.commitUs / 1000) + " ms)");
+
+    setFlag(OTA_FLAG_INSTALLED);
+    state = OTA_INSTALLED;
+    Serial.println("[OTA] Installing version " + String(image.version) + ", rebooting");
+    Serial.flush();
+    rp2040.reboot();
+    return true;
+}
+
+const char* OtaReceiver::stateName(OtaState s) {
+    switch (s) {
+        case OTA_IDLE:      return "idle";
+        case OTA_RECEIVING: return "receiving";
+        case OTA_VERIFYING: return "verifying";
+        case OTA_READY:     return "ready";
+        case OTA_FAILED:    return "failed";
+        case OTA_INSTALLED: return "installed";
+        case OTA_REJECTED:  return "rejected";
+        default:            return "?";
+    }
+}
+
+// ── Sender ───────────────────────────────────────────────────────────────────
+
+bool FileOtaSource::open(const char* p) {
+    if (!LittleFS.begin() || !LittleFS.exists(p)) return false;
+    File f = LittleFS.open(p, "r");
+    if (!f) return false;
+    path     = p;
+    fileSize = f.size();
+    f.close();
+
+    File v = LittleFS.open(OTA_VERSION_FILE, "r");
+    if (v) {
+        version = (uint32_t)v.readStringUntil('\n').toInt();
+        v.close();
+    }
+    return fileSize > 0;
+}
+
+bool FileOtaSource::read(uint32_t offset, uint8_t* out, size_t len) {
+    // Reopened per block: blocks go out seconds apart, and no handle is
+    // held open across a LittleFS write elsewhere
+    File f = LittleFS.open(path, "r");
+    if (!f) return false;
+    bool ok = f.seek(offset) && f.read(out, len) == len;
+    f.close();
+    return ok;
+}
+
+OtaSender::OtaSender()
+    : src(nullptr), phase(PHASE_DONE), round(0), cursor(0), sinceOffer(0), resendAll(false), nextTxAt(0),
+      collectUntil(0), slotMs(0), doneAt(0), receiverCount(0) {
+    memset(&image, 0, sizeof(image));
+    memset(offerMac, 0, sizeof(offerMac));
+    memset(pending, 0, sizeof(pending));
+    memset(missing, 0, sizeof(missing));
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool OtaSender::begin(OtaSource& source, uint32_t version, const OtaKey& key) {
+    if (!key.isSet()) return false;
+    if (version == 0) {
+        Serial.println("[OTA] No image version (" OTA_VERSION_FILE "), not offering it");
+        return false;
+    }
+    uint32_t size = source.size();
+    if (size == 0 || size > (uint32_t)OTA_MAX_BLOCKS * OTA_BLOCK_SIZE) {
+        Serial.println("[OTA] Image of " + String(size) + " B does not fit the slot");
+        return false;
+    }
+
+    Sha256  h;
+    uint8_t buf[LOG_FLASH_PAGE_SIZE];
+    for (uint32_t pos = 0; pos < size; pos += sizeof(buf)) {
+        size_t n = min((uint32_t)sizeof(buf), size - pos);
+        if (!source.read(pos, buf, n)) return false;
+        h.update(buf, n);
+    }
+    h.finish(image.sha256);
+    image.session = get16(image.sha256);
+    image.size    = size;
+    image.blocks  = (uint16_t)((size + OTA_BLOCK_SIZE - 1) / OTA_BLOCK_SIZE);
+    image.version = version;
+
+    // The MAC depends only on the offer fields: sign them once
+    uint8_t offer[OTA_OFFER_LEN];
+    buildOffer(offer);
+    key.mac(offer, OTA_OFFER_SIGNED_LEN, offerMac);
+
+    src           = &source;
+    round         = 0;
+    receiverCount = 0;
+    memset(missing, 0, sizeof(missing));
+    startRound(true);
+    Serial.println("[OTA] Serving " + String(size) + " B (" + String(image.blocks) +
+                   " blocks), version " + String(version) + ", session " +
+                   String(image.session, HEX));
+    return true;
+}
+
+void OtaSender::buildOffer(uint8_t* out) const {
+    out[0] = FRAME_OTA_OFFER;
+    put16(out + 1, image.session);
+    put32(out + 3, image.size);
+    put16(out + 7, image.blocks);
+    put32(out + 9, image.version);
+    memcpy(out + 13, image.sha256, SHA256_DIGEST_SIZE);
+}
+
+void OtaSender::startRound(bool all) {
+    round++;
+    stats.rounds++;
+    if (all || resendAll) {
+        memset(pending, 0, sizeof(pending));
+        for (uint16_t i = 0; i < image.blocks; i++) pending[i >> 3] |= (uint8_t)(1u << (i & 7));
+    } else {
+        memcpy(pending, missing, sizeof(pending));
+    }
+    memset(missing, 0, sizeof(missing));
+    resendAll = false;
+    cursor    = 0;
+    phase     = PHASE_OFFER;
+}
+
+size_t OtaSender::nextFrame(uint8_t* out, size_t cap, uint32_t now) {
+    if (!src || cap < OTA_OFFER_LEN || (int32_t)(now - nextTxAt) < 0) return 0;
+
+    switch (phase) {
+        case PHASE_OFFER:
+            buildOffer(out);
+            memcpy(out + OTA_OFFER_SIGNED_LEN, offerMac, OTA_MAC_SIZE);
+            phase      = PHASE_BLOCKS;
+            sinceOffer = 0;
+            return OTA_OFFER_LEN;
+
+        case PHASE_BLOCKS:
+            while (cursor < image.blocks && !(pending[cursor >> 3] & (1u << (cursor & 7)))) cursor++;
+            if (cursor < image.blocks && cap >= OTA_BLOCK_HEADER + OTA_BLOCK_SIZE) {
+                if (sinceOffer >= OTA_OFFER_EVERY) {
+                    phase = PHASE_OFFER;
+                    return nextFrame(out, cap, now);
+                }
+                sinceOffer++;
+                uint16_t i = cursor++;
+                uint16_t n = blockLen(image, i);
+                pending[i >> 3] &= (uint8_t)~(1u << (i & 7));
+                if (!src->read((uint32_t)i * OTA_BLOCK_SIZE, out + OTA_BLOCK_HEADER, n)) return 0;
+                out[0] = FRAME_OTA_BLOCK;
+                put16(out + 1, image.session);
+                put16(out + 3, i);
+                put16(out + 5, crc16(out + OTA_BLOCK_HEADER, n));
+                stats.blocksSent++;
+                return OTA_BLOCK_HEADER + n;
+            }
+            phase = PHASE_POLL;
+            // fall through
+
+        case PHASE_POLL:
+            out[0] = FRAME_OTA_POLL;
+            put16(out + 1, image.session);
+            out[3] = round;
+            out[4] = OTA_NACK_SLOTS;
+            slotMs = nackSlotMs();
+            put16(out + 5, slotMs);
+            phase = PHASE_COLLECT;
+            return OTA_POLL_LEN;
+
+        case PHASE_COLLECT: {
+            if ((int32_t)(now - collectUntil) < 0) return 0;
+            bool any = resendAll;
+            for (uint16_t i = 0; i < sizeof(missing) && !any; i++) any = missing[i] != 0;
+            // A silent poll is not proof: a receiver still short of blocks
+            // may just have lost its NACK, so poll again while it is around
+            for (uint8_t i = 0; i < receiverCount && !any; i++) {
+                any = !(receivers[i].flags & (OTA_FLAG_VERIFIED | OTA_FLAG_INSTALLED |
+                                              OTA_FLAG_WRONG_BASE)) &&
+                      now - receivers[i].lastHeard < OTA_REOFFER_MS;
+            }
+            if (any) {
+                startRound(false);
+                return nextFrame(out, cap, now);
+            }
+            phase  = PHASE_DONE;
+            doneAt = now;
+            Serial.println("[OTA] Round " + String(round) + " left no gaps; " +
+                           String(getVerifiedCount()) + "/" + String(receiverCount) +
+                           " receivers verified");
+            return 0;
+        }
+
+        case PHASE_DONE:
+        default:
+            if (now - doneAt < OTA_REOFFER_MS) return 0;
+            startRound(false);   // offer + poll only, for units that joined late
+            return nextFrame(out, cap, now);
+    }
+}
+
+void OtaSender::onSent(uint32_t airtimeMs, uint32_t now) {
+    stats.framesSent++;
+    stats.airtimeMs += airtimeMs;
+    nextTxAt = now + airtimeMs * (100u - OTA_AIRTIME_SHARE) / OTA_AIRTIME_SHARE;
+    if (phase == PHASE_COLLECT) {
+        collectUntil = now + (uint32_t)(OTA_NACK_SLOTS + 1) * slotMs;
+    }
+}
+
+uint16_t OtaSender::nackSlotMs() {
+    uint32_t ms = LoRaComm::airtimeMs(LORA_BINARY_TEXT_LEN(OTA_NACK_HEADER + OTA_NACK_WINDOW_BYTES)) +
+                  OTA_NACK_GUARD_MS;
+    return (uint16_t)min(ms, (uint32_t)UINT16_MAX);
+}
+
+void OtaSender::onNack(uint16_t from, const uint8_t* f, size_t len, uint32_t now) {
+    if (!src || len < OTA_NACK_HEADER || get16(f + 1) != image.session) return;
+    stats.nacksHeard++;
+
+    uint8_t  flags = f[3];
+    uint16_t have  = get16(f + 4);
+    uint16_t first = get16(f + 6);
+
+    OtaReceiverStatus* r = nullptr;
+    for (uint8_t i = 0; i < receiverCount; i++) {
+        if (receivers[i].address == from) r = &receivers[i];
+    }
+    if (!r && receiverCount < OTA_MAX_RECEIVERS) r = &receivers[receiverCount++];
+    if (r) {
+        r->address   = from;
+        r->flags     = flags;
+        r->have      = have;
+        r->lastHeard = now;
+    }
+
+    if (flags & OTA_FLAG_WRONG_BASE) return;   // patch it cannot use: nothing to resend
+    if (flags & OTA_FLAG_BAD_HASH) {
+        resendAll = true;
+        return;
+    }
+    for (uint32_t j = 0; j < (len - OTA_NACK_HEADER) * 8; j++) {
+        uint32_t i = first + j;
+        if (i >= image.blocks) break;
+        if (f[OTA_NACK_HEADER + j / 8] & (1u << (j & 7))) missing[i >> 3] |= (uint8_t)(1u << (i & 7));
+    }
+    // A NACK that arrives after the round closed still counts for the next one
+    if (phase == PHASE_DONE) {
+        bool any = false;
+        for (uint16_t i = 0; i < sizeof(missing) && !any; i++) any = missing[i] != 0;
+        if (any) startRound(false);
+    }
+}
+
+uint8_t OtaSender::getVerifiedCount() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < receiverCount; i++) {
+        if (receivers[i].flags & (OTA_FLAG_VERIFIED | OTA_FLAG_INSTALLED)) n++;
+    }
+    return n;
+}
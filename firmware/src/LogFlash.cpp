@@ -0,0 +1,134 @@
+/**
+ * @file LogFlash.cpp
+ * @brief Pico W flash region and RAM-simulated flash for FlashLog
+ */
+
+#include "LogFlash.h"
+
+// ── Pico W ───────────────────────────────────────────────────────────────────
+
+#ifdef ARDUINO_ARCH_RP2040
+#include <hardware/flash.h>
+
+// Provided by the arduino-pico linker script
+extern uint8_t _FS_start;
+extern uint8_t __flash_binary_end;
+
+PicoLogFlash::PicoLogFlash(uint32_t size, uint32_t gap)
+    : base(0), regionSize(0), wantSize(size), gapBelowFs(gap) {}
+
+bool PicoLogFlash::begin() {
+    uint32_t fsStart   = (uint32_t)((uintptr_t)&_FS_start - XIP_BASE);
+    uint32_t binaryEnd = (uint32_t)((uintptr_t)&__flash_binary_end - XIP_BASE);
+    uint32_t below     = wantSize + gapBelowFs;
+    if (fsStart < below || fsStart - below < binaryEnd) {
+        Serial.println("[Flash] Region of " + String(wantSize / 1024) +
+                       " KB would overlap the firmware");
+        return false;
+    }
+    base       = fsStart - below;
+    regionSize = wantSize;
+    return true;
+}
+
+bool PicoLogFlash::eraseSector(uint32_t offset) {
+    if (offset % LOG_FLASH_SECTOR_SIZE || offset >= regionSize) return false;
+    noInterrupts();
+    rp2040.idleOtherCore();
+    flash_range_erase(base + offset, LOG_FLASH_SECTOR_SIZE);
+    rp2040.resumeOtherCore();
+    interrupts();
+    return true;
+}
+
+bool PicoLogFlash::programPage(uint32_t offset, const uint8_t* data) {
+    if (offset % LOG_FLASH_PAGE_SIZE || offset >= regionSize) return false;
+    noInterrupts();
+    rp2040.idleOtherCore();
+    flash_range_program(base + offset, data, LOG_FLASH_PAGE_SIZE);
+    rp2040.resumeOtherCore();
+    interrupts();
+    return true;
+}
+
+void PicoLogFlash::read(uint32_t offset, uint8_t* out, size_t len) {
+    // Flash is memory-mapped through XIP
+    memcpy(out, (const uint8_t*)(uintptr_t)(XIP_BASE + base + offset), len);
+}
+
+#else
+
+PicoLogFlash::PicoLogFlash(uint32_t size, uint32_t gap)
+    : base(0), regionSize(0), wantSize(size), gapBelowFs(gap) {}
+bool PicoLogFlash::begin() { return false; }
+bool PicoLogFlash::eraseSector(uint32_t) { return false; }
+bool PicoLogFlash::programPage(uint32_t, const uint8_t*) { return false; }
+void PicoLogFlash::read(uint32_t, uint8_t* out, size_t len) { memset(out, 0xFF, len); }
+
+#endif
+
+// ── Simulation ───────────────────────────────────────────────────────────────
+
+SimLogFlash::SimLogFlash(uint8_t* mem, uint32_t size)
+    : mem(mem), erases(0), programs(0), busyUs(0), violations(0),
+      tearBudget(0), tearArmed(false) {
+    if (size > (uint32_t)SIM_LOG_FLASH_MAX_SECTORS * LOG_FLASH_SECTOR_SIZE) {
+        size = (uint32_t)SIM_LOG_FLASH_MAX_SECTORS * LOG_FLASH_SECTOR_SIZE;
+    }
+    memSize = size - size % LOG_FLASH_SECTOR_SIZE;
+    memset(mem, 0xFF, memSize);
+    memset(sectorErases, 0, sizeof(sectorErases));
+}
+
+bool SimLogFlash::eraseSector(uint32_t offset) {
+    if (offset % LOG_FLASH_SECTOR_SIZE || offset >= memSize) return false;
+    if (tearArmed && tearBudget == UINT32_MAX) return false;
+    memset(mem + offset, 0xFF, LOG_FLASH_SECTOR_SIZE);
+    sectorErases[offset / LOG_FLASH_SECTOR_SIZE]++;
+    erases++;
+    busyUs += LOG_FLASH_ERASE_US;
+    return true;
+}
+
+bool SimLogFlash::programPage(uint32_t offset, const uint8_t* data) {
+    if (offset % LOG_FLASH_PAGE_SIZE || offset >= memSize) return false;
+
+    size_t len = LOG_FLASH_PAGE_SIZE;
+    if (tearArmed) {
+        if (tearBudget == UINT32_MAX) return false;   // power is gone
+        if (tearBudget == 0) {
+            len        = LOG_FLASH_PAGE_SIZE / 2;
+            tearBudget = UINT32_MAX;
+        } else {
+            tearBudget--;
+        }
+    }
+    for (size_t i = 0; i < len; i++) {
+        // NOR program can only clear bits
+        if (data[i] & ~mem[offset + i]) violations++;
+        mem[offset + i] &= data[i];
+    }
+    programs++;
+    busyUs += LOG_FLASH_PROGRAM_US;
+    return true;
+}
+
+void SimLogFlash::read(uint32_t offset, uint8_t* out, size_t len) {
+    memcpy(out, mem + offset, len);
+}
+
+uint32_t SimLogFlash::getMaxSectorErases() const {
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < memSize / LOG_FLASH_SECTOR_SIZE; i++) {
+        if (sectorErases[i] > m) m = sectorErases[i];
+    }
+    return m;
+}
+
+uint32_t SimLogFlash::getMinSectorErases() const {
+    uint32_t m = UINT32_MAX;
+    for (uint32_t i = 0; i < memSize / LOG_FLASH_SECTOR_SIZE; i++) {
+        if (sectorErases[i] < m) m = sectorErases[i];
+    }
+    return memSize ? m : 0;
+}
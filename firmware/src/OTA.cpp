@@ -103,7 +103,8 @@ void OTA::onEnd() {
 
 void OTA::onProgress(unsigned int progress, unsigned int total) {
     static unsigned int lastPercent = 0;
-    unsigned int percent = (progress / (total / 100));
+    // total / 100 is 0 for images under 100 bytes
+    unsigned int percent = total ? (unsigned int)((uint64_t)progress * 100 / total) : 100;
     
     if (percent != lastPercent && percent % 10 == 0) {
         Serial.printf("OTA Progress: %u%%\n", percent);
@@ -0,0 +1,171 @@
+/**
+ * @file OrientationFilter.cpp
+ * @brief Q30 Mahony update, accel gating, Euler extraction, cycle benchmark
+ */
+
+#include "OrientationFilter.h"
+#include "FixedMath.h"
+
+// π · 2^30, for the gyro scale
+#define PI_Q30  3373259426LL
+
+// Accel gate in raw LSB², compared against |a|² directly
+static const uint32_t GATE_LO2 = (uint32_t)(ORIENT_ACCEL_GATE_LO_MG * IMU_ACCEL_LSB_PER_G / 1000) *
+                                 (ORIENT_ACCEL_GATE_LO_MG * IMU_ACCEL_LSB_PER_G / 1000);
+static const uint32_t GATE_HI2 = (uint32_t)(ORIENT_ACCEL_GATE_HI_MG * IMU_ACCEL_LSB_PER_G / 1000) *
+                                 (ORIENT_ACCEL_GATE_HI_MG * IMU_ACCEL_LSB_PER_G / 1000);
+
+static inline int32_t mulQ30(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+OrientationFilter::OrientationFilter()
+    : gyroHalfQ30(0), kpHalfQ30(0), kiHalfQ46(0), headingOffset(0), seeded(false),
+      updates(0), accelRejected(0), lastCycles(0), maxCycles(0) {
+    begin(IMU_FIFO_RATE_HZ);
+}
+
+void OrientationFilter::begin(uint16_t rateHz) {
+    if (rateHz == 0) rateHz = IMU_FIFO_RATE_HZ;
+    // raw · (π/180) / (LSB per °/s) · dt / 2, in Q30
+    gyroHalfQ30 = (int32_t)((PI_Q30 * 10 + 180LL * IMU_GYRO_LSB_PER_DPS_X10 * rateHz) /
+                            (360LL * IMU_GYRO_LSB_PER_DPS_X10 * rateHz));
+    kpHalfQ30   = (int32_t)(((int64_t)ORIENT_KP_X1000 << 30) / (2000LL * rateHz));
+    kiHalfQ46   = (((int64_t)ORIENT_KI_X1000 << 46) / (2000LL * rateHz * rateHz));
+    reset();
+}
+
+void OrientationFilter::reset() {
+    q.w = ORIENT_Q30_ONE;
+    q.x = q.y = q.z = 0;
+    memset(biasQ46, 0, sizeof(biasQ46));
+    headingOffset = 0;
+    seeded        = false;
+}
+
+void OrientationFilter::seed(const int32_t a[3]) {
+    // Roll and pitch straight from gravity so the filter starts converged
+    int32_t  horiz = (int32_t)FixedMath::isqrt32((uint32_t)(a[1] * a[1] + a[2] * a[2]));
+    uint16_t roll  = FixedMath::atan2Bam(a[1], a[2]);
+    uint16_t pitch = FixedMath::atan2Bam(-a[0], horiz);
+
+    uint16_t halfRoll  = (uint16_t)((int16_t)roll / 2);
+    uint16_t halfPitch = (uint16_t)((int16_t)pitch / 2);
+    int32_t cr = FixedMath::cosQ15(halfRoll);
+    int32_t sr = FixedMath::sinQ15(halfRoll);
+    int32_t cp = FixedMath::cosQ15(halfPitch);
+    int32_t sp = FixedMath::sinQ15(halfPitch);
+    q.w =  cp * cr;             // Q15 · Q15 = Q30
+    q.x =  cp * sr;
+    q.y =  sp * cr;
+    q.z = -sp * sr;
+    normalise();
+    seeded = true;
+}
+
+void OrientationFilter::normalise() {
+    // |q| stays within ~1e-6 of 1, so one Newton step of 1/sqrt about 1 is
+    // exact to Q30: s = (3 − |q|²) / 2
+    int64_t n2 = (int64_t)q.w * q.w + (int64_t)q.x * q.x +
+                 (int64_t)q.y * q.y + (int64_t)q.z * q.z;        // Q60
+    int32_t s  = (int32_t)(((3LL << 30) - (n2 >> 30)) >> 1);
+    q.w = mulQ30(q.w, s);
+    q.x = mulQ30(q.x, s);
+    q.y = mulQ30(q.y, s);
+    q.z = mulQ30(q.z, s);
+}
+
+void OrientationFilter::update(const ImuSample& s) {
+    uint32_t c0 = rp2040.getCycleCount();
+
+    int32_t a[3] = { s.accel[0], s.accel[1], s.accel[2] };
+    uint32_t a2  = (uint32_t)(a[0] * a[0]) + (uint32_t)(a[1] * a[1]) + (uint32_t)(a[2] * a[2]);
+    if (!seeded && a2 != 0) seed(a);
+
+    // Rotation this sample, as half-angles in Q30
+    int32_t h[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        h[i] = (int32_t)s.gyro[i] * gyroHalfQ30 + (int32_t)(biasQ46[i] >> 16);
+    }
+
+    if (a2 >= GATE_LO2 && a2 <= GATE_HI2) {
+        // Unit accel, Q30
+        uint32_t r = FixedMath::rsqrtQ31(a2);
+        int32_t  u[3];
+        for (uint8_t i = 0; i < 3; i++) u[i] = (int32_t)(((int64_t)a[i] * r) >> 1);
+
+        // Gravity direction predicted by q
+        int32_t vx = 2 * (mulQ30(q.x, q.z) - mulQ30(q.w, q.y));
+        int32_t vy = 2 * (mulQ30(q.w, q.x) + mulQ30(q.y, q.z));
+        int32_t vz = mulQ30(q.w, q.w) - mulQ30(q.x, q.x) - mulQ30(q.y, q.y) + mulQ30(q.z, q.z);
+
+        // e = u × v
+        int32_t e[3] = {
+            mulQ30(u[1], vz) - mulQ30(u[2], vy),
+            mulQ30(u[2], vx) - mulQ30(u[0], vz),
+            mulQ30(u[0], vy) - mulQ30(u[1], vx),
+        };
+        for (uint8_t i = 0; i < 3; i++) {
+            biasQ46[i] += (kiHalfQ46 * e[i]) >> 30;
+            h[i] += mulQ30(kpHalfQ30, e[i]);
+        }
+    } else {
+        accelRejected++;
+    }
+
+    // q += q ⊗ (0, h)
+    int32_t w = q.w, x = q.x, y = q.y, z = q.z;
+    q.w += (int32_t)((-(int64_t)x * h[0] - (int64_t)y * h[1] - (int64_t)z * h[2]) >> 30);
+    q.x += (int32_t)(( (int64_t)w * h[0] + (int64_t)y * h[2] - (int64_t)z * h[1]) >> 30);
+    q.y += (int32_t)(( (int64_t)w * h[1] - (int64_t)x * h[2] + (int64_t)z * h[0]) >> 30);
+    q.z += (int32_t)(( (int64_t)w * h[2] + (int64_t)x * h[1] - (int64_t)y * h[0]) >> 30);
+    normalise();
+
+    updates++;
+    lastCycles = rp2040.getCycleCount() - c0;
+    if (lastCycles > maxCycles) maxCycles = lastCycles;
+}
+
+EulerBam OrientationFilter::getEuler() const {
+    int64_t ww = (int64_t)q.w * q.w, xx = (int64_t)q.x * q.x;
+    int64_t yy = (int64_t)q.y * q.y, zz = (int64_t)q.z * q.z;
+
+    // Q60 products → Q30 for atan2Bam
+    int32_t rollY  = (int32_t)((2 * ((int64_t)q.w * q.x + (int64_t)q.y * q.z)) >> 30);
+    int32_t rollX  = (int32_t)((ww - xx - yy + zz) >> 30);
+    int32_t sinP   = (int32_t)((2 * ((int64_t)q.w * q.y - (int64_t)q.x * q.z)) >> 30);
+    int32_t yawY   = (int32_t)((2 * ((int64_t)q.w * q.z + (int64_t)q.x * q.y)) >> 30);
+    int32_t yawX   = (int32_t)((ww + xx - yy - zz) >> 30);
+
+    sinP = constrain(sinP, -ORIENT_Q30_ONE, ORIENT_Q30_ONE);
+    int32_t cosP = (int32_t)FixedMath::isqrt64((1ULL << 60) - (uint64_t)((int64_t)sinP * sinP));
+
+    EulerBam out;
+    out.roll    = (int16_t)FixedMath::atan2Bam(rollY, rollX);
+    out.pitch   = (int16_t)FixedMath::atan2Bam(sinP, cosP);
+    out.heading = (uint16_t)(headingOffset - FixedMath::atan2Bam(yawY, yawX));
+    return out;
+}
+
+void OrientationFilter::setHeading(uint16_t headingBam) {
+    EulerBam e    = getEuler();
+    headingOffset = (uint16_t)(headingOffset + headingBam - e.heading);
+}
+
+uint32_t OrientationFilter::benchmark(uint16_t n) {
+    OrientationFilter f;
+    ImuSample s = {};
+    uint32_t  total = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        // Tilted, slowly turning, with some vibration: exercises every branch
+        s.accel[0] = (int16_t)(800 + (i & 63));
+        s.accel[1] = (int16_t)(-300 - (i & 31));
+        s.accel[2] = (int16_t)(3950 - (i & 15));
+        s.gyro[0]  = (int16_t)(40 - (i & 127));
+        s.gyro[1]  = 25;
+        s.gyro[2]  = 650;
+        f.update(s);
+        total += f.getLastUpdateCycles();
+    }
+    return n ? total / n : 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file OtaImageWriter.cpp
+ * @brief Block-sized LittleFS writes, verify-and-rename commit
+ */
+
+#include "OtaImageWriter.h"
+
+#ifdef ARDUINO_ARCH_RP2040
+#include <PicoOTA.h>
+#endif
+
+OtaImageWriter::OtaImageWriter()
+    : open(false), checkHash(false), size(0), received(0), fillLen(0),
+      error(OTA_WRITE_NOT_OPEN), startMs(0) {
+    memset(&timing, 0, sizeof(timing));
+}
+
+bool OtaImageWriter::begin(uint32_t imageSize, const uint8_t* sha256) {
+    if (open) abort();
+    memset(&timing, 0, sizeof(timing));
+    startMs = millis();
+
+    FSInfo fs;
+    if (!LittleFS.begin() || !LittleFS.info(fs)) {
+        error = OTA_WRITE_IO_ERROR;
+        return false;
+    }
+    LittleFS.remove(OTA_WRITER_TEMP);   // left over from an interrupted update
+    if (fs.totalBytes - fs.usedBytes < imageSize + 2 * fs.blockSize) {
+        error = OTA_WRITE_NO_SPACE;
+        return false;
+    }
+    file = LittleFS.open(OTA_WRITER_TEMP, "w");
+    if (!file) {
+        error = OTA_WRITE_IO_ERROR;
+        return false;
+    }
+
+    checkHash = sha256 != nullptr;
+    if (checkHash) memcpy(expected, sha256, SHA256_DIGEST_SIZE);
+    hasher.reset();
+    size     = imageSize;
+    received = 0;
+    fillLen  = 0;
+    error    = OTA_WRITE_OK;
+    open     = true;
+    return true;
+}
+
+OtaWriterResult OtaImageWriter::fail(OtaWriterResult r) {
+    if (error == OTA_WRITE_OK) error = r;
+    return error;
+}
+
+bool OtaImageWriter::writeBuffer() {
+    if (fillLen == 0) return true;
+    uint32_t t0 = micros();
+    size_t   n  = file.write(buf, fillLen);
+    timing.flashUs += micros() - t0;
+    if (n != fillLen) {
+        fail(OTA_WRITE_IO_ERROR);
+        return false;
+    }
+    fillLen = 0;
+    return true;
+}
+
+void OtaImageWriter::take(size_t n) {
+    if (checkHash) {
+        uint32_t t0 = micros();
+        hasher.update(buf + fillLen, n);
+        timing.hashUs += micros() - t0;
+    }
+    fillLen  += n;
+    received += n;
+    if (fillLen == OTA_WRITER_BUFFER) writeBuffer();
+}
+
+size_t OtaImageWriter::write(const uint8_t* data, size_t len) {
+    if (!open || error != OTA_WRITE_OK) return 0;
+    if (len > size - received) {
+        fail(OTA_WRITE_SIZE_MISMATCH);
+        return 0;
+    }
+    size_t done = 0;
+    while (done < len && error == OTA_WRITE_OK) {
+        size_t n = min(len - done, (size_t)(OTA_WRITER_BUFFER - fillLen));
+        memcpy(buf + fillLen, data + done, n);
+        take(n);
+        done += n;
+    }
+    return error == OTA_WRITE_OK ? done : 0;
+}
+
+size_t OtaImageWriter::feed(Stream& in) {
+    if (!open || error != OTA_WRITE_OK) return 0;
+    size_t total = 0;
+    int    avail;
+    while ((avail = in.available()) > 0 && received < size && error == OTA_WRITE_OK) {
+        size_t n = min((size_t)avail, (size_t)(OTA_WRITER_BUFFER - fillLen));
+        n        = min(n, (size_t)(size - received));
+        n        = in.readBytes(buf + fillLen, n);
+        if (n == 0) break;
+        take(n);
+        total += n;
+    }
+    return total;
+}
+
+OtaWriterResult OtaImageWriter::commit() {
+    if (!open) return OTA_WRITE_NOT_OPEN;
+    uint32_t t0 = micros();
+
+    if (error == OTA_WRITE_OK) writeBuffer();
+    if (error == OTA_WRITE_OK && received != size) fail(OTA_WRITE_SIZE_MISMATCH);
+    if (error == OTA_WRITE_OK && checkHash) {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        hasher.finish(digest);
+        if (memcmp(digest, expected, SHA256_DIGEST_SIZE) != 0) fail(OTA_WRITE_BAD_HASH);
+    }
+    if (error != OTA_WRITE_OK) {
+        OtaWriterResult r = error;
+        abort();
+        error = r;
+        return r;
+    }
+
+    file.close();
+    open = false;
+    // rename replaces an older staged image atomically; removing it first
+    // would open a window with neither file on a power cut
+    if (!LittleFS.rename(OTA_WRITER_TEMP, OTA_WRITER_FILE)) {
+        LittleFS.remove(OTA_WRITER_TEMP);
+        return error = OTA_WRITE_IO_ERROR;
+    }
+#ifdef ARDUINO_ARCH_RP2040
+    picoOTA.begin();
+    if (!picoOTA.addFile(OTA_WRITER_FILE)) return error = OTA_WRITE_BOOTLOADER;
+    picoOTA.commit();
+#endif
+    timing.commitUs = micros() - t0;
+    timing.totalMs  = millis() - startMs;
+    return OTA_WRITE_OK;
+}
+
+void OtaImageWriter::abort() {
+    if (open) {
+        file.close();
+        LittleFS.remove(OTA_WRITER_TEMP);
+    }
+    open    = false;
+    fillLen = 0;
+    error   = OTA_WRITE_NOT_OPEN;
+}
+
+uint8_t OtaImageWriter::getProgress() const {
+    if (size == 0) return 100;
+    return (uint8_t)((uint64_t)received * 100 / size);
+}
+
+const char* OtaImageWriter::resultName(OtaWriterResult r) {
+    switch (r) {
+        case OTA_WRITE_OK:            return "ok";
+        case OTA_WRITE_NOT_OPEN:      return "not open";
+        case OTA_WRITE_NO_SPACE:      return "no space";
+        case OTA_WRITE_IO_ERROR:      return "I/O error";
+        case OTA_WRITE_SIZE_MISMATCH: return "size mismatch";
+        case OTA_WRITE_BAD_HASH:      return "bad hash";
+        case OTA_WRITE_BOOTLOADER:    return "bootloader refused";
+        default:                      return "?";
+    }
+}
@@ -0,0 +1,184 @@
+/**
+ * @file PeerTable.cpp
+ * @brief Peer position/link table fed from received LoRa packets
+ */
+
+#include "PeerTable.h"
+
+/**
+ * Parse one '|'-terminated decimal field into a fixed-point integer with
+ * `decimals` fractional digits (extra digits are truncated).
+ */
+static bool parseFixed(const char*& p, uint8_t decimals, int32_t& out) {
+    bool neg = false;
+    if (*p == '-') { neg = true; p++; }
+    if (*p < '0' || *p > '9') return false;
+
+    int64_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > 0x7FFFFFFFLL) return false;
+    }
+    uint8_t frac = 0;
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            if (frac < decimals) { v = v * 10 + (*p - '0'); frac++; }
+            p++;
+        }
+    }
+    for (; frac < decimals; frac++) v *= 10;
+    if (v > 0x7FFFFFFFLL) return false;
+
+    if (*p == '|') p++;
+    else if (*p != '\0') return false;
+    out = (int32_t)(neg ? -v : v);
+    return true;
+}
+
+PeerTable::PeerTable() {
+    clear();
+}
+
+void PeerTable::clear() {
+    memset(peers, 0, sizeof(peers));
+}
+
+bool PeerTable::parseHeartbeat(const char* payload, TxSnapshot& out, uint8_t& sats) {
+    const char* p = payload;
+    int32_t addr, lat, lon, s, spd, crs;
+    if (!parseFixed(p, 0, addr) || !parseFixed(p, 6, lat) || !parseFixed(p, 6, lon) ||
+        !parseFixed(p, 0, s)    || !parseFixed(p, 1, spd) || !parseFixed(p, 0, crs) ||
+        *p != '\0') {
+        return false;
+    }
+    if (lat < -90000000 || lat > 90000000 || lon < -180000000 || lon > 180000000) {
+        return false;
+    }
+    out.latE6       = lat;
+    out.lonE6       = lon;
+    out.speedKmhX10 = (uint16_t)constrain(spd, 0, 65535);
+    out.courseDeg   = (uint16_t)(((crs % 360) + 360) % 360);
+    // The sender puts 0,0 on air while it has never had a fix
+    out.valid       = lat != 0 || lon != 0;
+    sats            = (uint8_t)constrain(s, 0, 255);
+    return true;
+}
+
+uint8_t PeerTable::slotFor(uint16_t addr) {
+    uint8_t free = PEER_MAX, oldest = PEER_MAX;
+    for (uint8_t i = 0; i < PEER_MAX; i++) {
+        if (!peers[i].used) {
+            if (free == PEER_MAX) free = i;
+        } else if (peers[i].addr == addr) {
+            return i;
+        } else if (oldest == PEER_MAX ||
+                   (int32_t)(peers[i].lastHeard - peers[oldest].lastHeard) < 0) {
+            oldest = i;
+        }
+    }
+    uint8_t i = free < PEER_MAX ? free : oldest;
+    memset(&peers[i], 0, sizeof(PeerInfo));
+    peers[i].used = true;
+    peers[i].addr = addr;
+    return i;
+}
+
+uint8_t PeerTable::onPacket(uint16_t addr, const char* payload,
+                            int rssi, float snr, uint32_t now) {
+    uint8_t   i = slotFor(addr);
+    PeerInfo& peer = peers[i];
+    peer.lastHeard = now;
+    peer.packets++;
+    peer.rssi      = (int16_t)rssi;
+    peer.snrX10    = (int16_t)lroundf(snr * 10.0f);
+
+    LinkHistory& h = peer.link;
+    if (h.count == PEER_LINK_HISTORY) {
+        h.rssiSum  -= h.rssi[h.head];
+        h.snrX4Sum -= h.snrX4[h.head];
+    } else {
+        h.count++;
+    }
+    h.rssi[h.head]  = (int8_t)constrain(rssi, -128, 127);
+    h.snrX4[h.head] = (int8_t)constrain(lroundf(snr * 4.0f), -128L, 127L);
+    h.rssiSum      += h.rssi[h.head];
+    h.snrX4Sum     += h.snrX4[h.head];
+    h.head          = (uint8_t)((h.head + 1) % PEER_LINK_HISTORY);
+    h.seq++;
+
+    TxSnapshot snap;
+    uint8_t    sats;
+    if (payload && parseHeartbeat(payload, snap, sats) && snap.valid) {
+        snap.sentAt      = now;
+        peer.pos         = snap;
+        peer.satellites  = sats;
+        peer.hasPosition = true;
+    }
+    return i;
+}
+
+void PeerTable::expire(uint32_t now) {
+    for (uint8_t i = 0; i < PEER_MAX; i++) {
+        if (peers[i].used && now - peers[i].lastHeard > PEER_EXPIRE_MS) {
+            peers[i].used = false;
+        }
+    }
+}
+
+bool PeerTable::estimate(uint8_t index, uint32_t now, int32_t& latE6, int32_t& lonE6) const {
+    const PeerInfo& peer = peers[index];
+    if (!peer.used || !peer.hasPosition) return false;
+
+    uint32_t dt = now - peer.pos.sentAt;
+    if (dt > PEER_EXTRAPOLATE_MS) dt = PEER_EXTRAPOLATE_MS;
+    TxPolicy::extrapolate(peer.pos.latE6, peer.pos.lonE6,
+                          peer.pos.speedKmhX10, peer.pos.courseDeg, dt, latE6, lonE6);
+    return true;
+}
+
+bool PeerTable::getLinkSample(uint8_t index, uint32_t seq,
+                              int8_t& rssi, int8_t& snrX4) const {
+    const LinkHistory& h = peers[index].link;
+    uint32_t back = h.seq - seq;              // 1 = newest
+    if (seq >= h.seq || back > h.count) return false;
+    uint8_t slot = (uint8_t)((h.head + PEER_LINK_HISTORY - back) % PEER_LINK_HISTORY);
+    rssi  = h.rssi[slot];
+    snrX4 = h.snrX4[slot];
+    return true;
+}
+
+LinkStats PeerTable::getLinkStats(uint8_t index) const {
+    const LinkHistory& h = peers[index].link;
+    LinkStats st;
+    memset(&st, 0, sizeof(st));
+    st.samples = h.count;
+    if (h.count == 0) return st;
+
+    st.minRssi  = st.maxRssi  = h.rssi[0];
+    st.minSnrX4 = st.maxSnrX4 = h.snrX4[0];
+    for (uint8_t i = 1; i < h.count; i++) {
+        if (h.rssi[i]  < st.minRssi)  st.minRssi  = h.rssi[i];
+        if (h.rssi[i]  > st.maxRssi)  st.maxRssi  = h.rssi[i];
+        if (h.snrX4[i] < st.minSnrX4) st.minSnrX4 = h.snrX4[i];
+        if (h.snrX4[i] > st.maxSnrX4) st.maxSnrX4 = h.snrX4[i];
+    }
+    st.avgRssi  = (int16_t)(h.rssiSum  / h.count);
+    st.avgSnrX4 = (int16_t)(h.snrX4Sum / h.count);
+    return st;
+}
+
+int8_t PeerTable::mostRecent() const {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < PEER_MAX; i++) {
+        if (!peers[i].used) continue;
+        if (best < 0 || (int32_t)(peers[i].lastHeard - peers[best].lastHeard) > 0) best = (int8_t)i;
+    }
+    return best;
+}
+
+uint8_t PeerTable::count() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < PEER_MAX; i++) n += peers[i].used;
+    return n;
+}
@@ -0,0 +1,474 @@
+/**
+ * @file PicoBLE.cpp
+ * @brief BTstack GATT server, advertising, config writes and completion-based stream credits
+ */
+
+#include "PicoBLE.h"
+
+#if defined(ARDUINO_ARCH_RP2040) && defined(PIO_FRAMEWORK_ARDUINO_ENABLE_BLUETOOTH)
+#include <btstack.h>
+#include <ble/att_db_util.h>
+#include <pico/cyw43_arch.h>
+#define PICO_BLE_HAVE_BTSTACK
+#endif
+
+PicoBLE* PicoBLE::instance = nullptr;
+
+PicoBLE::PicoBLE() : initialized(false), conn(PICO_BLE_NO_CONN),
+                     attMtu(BLE_STREAM_DEFAULT_MTU), configHandle(0), statusHandle(0),
+                     commandHandle(0), streamHandle(0), deviceConfig(nullptr),
+                     peerSource(nullptr), trackSource(nullptr), dumpReported(true),
+                     sentHead(0), sentCount(0), fragsDone(0),
+                     configLen(0), statusLen(0), statusPending(false), configDirty(true),
+                     postedConn(PICO_BLE_NO_CONN), connectionChanged(false),
+                     negotiatedMtu(0), streamSubscribed(false), statusSubscribed(false),
+                     dumpRequested(false), completedFrags(0),
+                     pendingConfigLen(0), configWritten(false),
+                     pendingCommandLen(0), commandWritten(false) {
+}
+
+void PicoBLE::setStreamSources(const PeerTable* peers, const TrackLog* track) {
+    peerSource = peers;
+    trackSource = track;
+}
+
+void PicoBLE::startDump() {
+    if (!peerSource || !trackSource) {
+        return;
+    }
+    stream.startDump(*peerSource, *trackSource, millis());
+    dumpReported = false;
+}
+
+void PicoBLE::sendStatus(const String& status) {
+    statusLen = (uint8_t)min((size_t)status.length(), sizeof(statusValue));
+    memcpy(statusValue, status.c_str(), statusLen);
+    statusPending = true;
+}
+
+void PicoBLE::handleCommand(const uint8_t* data, size_t len) {
+    if (len != 2 || data[0] != BLE_COMMAND_VERSION) {
+        sendStatus("cmd: unsupported");
+        return;
+    }
+    switch (data[1]) {
+        case BLE_CMD_DEFAULTS:
+            if (deviceConfig) {
+                // Radio and timing only: the unit keeps its addresses
+                DeviceSettings d = DeviceConfig::defaults();
+                d.address = deviceConfig->address();
+                d.target  = deviceConfig->target();
+                reportConfig(deviceConfig->apply(d));
+            }
+            break;
+        case BLE_CMD_DUMP:
+            startDump();
+            break;
+        case BLE_CMD_REPORT:
+            if (deviceConfig) {
+                sendStatus("cfg " + DeviceConfig::describe(deviceConfig->getLastReport()));
+            }
+            break;
+        default:
+            sendStatus("cmd: unknown " + String(data[1]));
+            break;
+    }
+}
+
+void PicoBLE::reportConfig(const ConfigReport& report) {
+    String line = DeviceConfig::describe(report);
+    Serial.println("[Config] " + line);
+    sendStatus("cfg " + line);
+    configDirty = true;     // CONFIG always reads back what is in force
+}
+
+#ifdef PICO_BLE_HAVE_BTSTACK
+
+static btstack_packet_callback_registration_t hciRegistration;
+
+/** Write callback transaction modes (att_db.h). */
+#ifndef ATT_TRANSACTION_MODE_NONE
+#define ATT_TRANSACTION_MODE_NONE    0x0
+#define ATT_TRANSACTION_MODE_ACTIVE  0x1
+#define ATT_TRANSACTION_MODE_EXECUTE 0x2
+#define ATT_TRANSACTION_MODE_CANCEL  0x3
+#endif
+
+static uint8_t advData[3 + 2 + 16];
+static uint8_t scanData[2 + 29];
+
+/** "xxxxxxxx-xxxx-..." → 16 bytes, most significant first (att_db_util order). */
+static void parseUuid(const char* s, uint8_t* out) {
+    uint8_t n = 0;
+    for (; *s && n < 32; s++) {
+        char c = *s;
+        uint8_t v;
+        if (c >= '0' && c <= '9')      v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else continue;
+        if (n & 1) out[n / 2] |= v;
+        else       out[n / 2] = v << 4;
+        n++;
+    }
+}
+
+bool PicoBLE::begin(const char* deviceName) {
+    instance = this;
+
+    uint8_t uuid[16];
+    att_db_util_init();
+    parseUuid(SERVICE_UUID, uuid);
+    att_db_util_add_service_uuid128(uuid);
+    // All values live here, not in the database: reads and writes go
+    // through onRead() / onWrite()
+    parseUuid(CONFIG_UUID, uuid);
+    configHandle = att_db_util_add_characteristic_uuid128(
+        uuid, ATT_PROPERTY_READ | ATT_PROPERTY_WRITE | ATT_PROPERTY_DYNAMIC,
+        ATT_SECURITY_NONE, ATT_SECURITY_NONE, nullptr, 0);
+    parseUuid(STATUS_UUID, uuid);
+    statusHandle = att_db_util_add_characteristic_uuid128(
+        uuid, ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY | ATT_PROPERTY_DYNAMIC,
+        ATT_SECURITY_NONE, ATT_SECURITY_NONE, nullptr, 0);
+    parseUuid(COMMAND_UUID, uuid);
+    commandHandle = att_db_util_add_characteristic_uuid128(
+        uuid, ATT_PROPERTY_WRITE | ATT_PROPERTY_DYNAMIC,
+        ATT_SECURITY_NONE, ATT_SECURITY_NONE, nullptr, 0);
+    parseUuid(STREAM_UUID, uuid);
+    streamHandle = att_db_util_add_characteristic_uuid128(
+        uuid, ATT_PROPERTY_NOTIFY | ATT_PROPERTY_DYNAMIC,
+        ATT_SECURITY_NONE, ATT_SECURITY_NONE, nullptr, 0);
+    configLen = (uint8_t)DeviceConfig::encode(
+        deviceConfig ? deviceConfig->get() : DeviceConfig::defaults(),
+        configValue, sizeof(configValue));
+    configDirty = false;
+
+    l2cap_init();
+    sm_init();
+    att_server_init(att_db_util_get_address(), onRead, onWrite);
+
+    hciRegistration.callback = &onPacket;
+    hci_add_event_handler(&hciRegistration);
+    att_server_register_packet_handler(&onPacket);
+
+    // Flags, then the service UUID (little-endian) so the app can filter on it
+    parseUuid(SERVICE_UUID, uuid);
+    uint8_t n = 0;
+    advData[n++] = 2;
+    advData[n++] = BLUETOOTH_DATA_TYPE_FLAGS;
+    advData[n++] = 0x06;                          // general discoverable, no BR/EDR
+    advData[n++] = 17;
+    advData[n++] = BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_128_BIT_SERVICE_CLASS_UUIDS;
+    for (uint8_t i = 0; i < 16; i++) advData[n++] = uuid[15 - i];
+
+    uint8_t nameLen = (uint8_t)min(strlen(deviceName), sizeof(scanData) - 2);
+    scanData[0] = nameLen + 1;
+    scanData[1] = BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME;
+    memcpy(scanData + 2, deviceName, nameLen);
+
+    bd_addr_t none = { 0 };
+    gap_advertisements_set_params(PICO_BLE_ADV_INTERVAL, PICO_BLE_ADV_INTERVAL,
+                                  0 /* ADV_IND */, 0, none, 0x07, 0);
+    gap_advertisements_set_data(n, advData);
+    gap_scan_response_set_data(nameLen + 2, scanData);
+    gap_advertisements_enable(1);
+
+    if (hci_power_control(HCI_POWER_ON) != 0) {
+        Serial.println("[BLE] Controller did not power on");
+        return false;
+    }
+    initialized = true;
+    Serial.println("[BLE] Advertising as " + String(deviceName));
+    return true;
+}
+
+// ── BTstack callbacks (async context): post only ─────────────────────────────
+
+void PicoBLE::onPacket(uint8_t type, uint16_t channel, uint8_t* packet, uint16_t size) {
+    PicoBLE* self = instance;
+    if (type != HCI_EVENT_PACKET || !self) {
+        return;
+    }
+    switch (hci_event_packet_get_type(packet)) {
+        case ATT_EVENT_CONNECTED:
+            self->postedConn = att_event_connected_get_handle(packet);
+            self->streamSubscribed = false;
+            self->statusSubscribed = false;
+            self->connectionChanged = true;
+            break;
+        case ATT_EVENT_DISCONNECTED:
+            self->postedConn = PICO_BLE_NO_CONN;
+            self->streamSubscribed = false;
+            self->statusSubscribed = false;
+            self->connectionChanged = true;
+            break;
+        case ATT_EVENT_MTU_EXCHANGE_COMPLETE:
+            self->negotiatedMtu = att_event_mtu_exchange_complete_get_MTU(packet);
+            break;
+        case HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS: {
+            // [u8 handles]{[u16 handle][u16 packets]}...
+            uint8_t  handles = packet[2];
+            uint16_t offset  = 3;
+            for (uint8_t i = 0; i < handles && offset + 4 <= size; i++, offset += 4) {
+                uint16_t handle = little_endian_read_16(packet, offset) & 0x0FFF;
+                if (handle == self->postedConn) {
+                    self->completedFrags = self->completedFrags +
+                                           little_endian_read_16(packet, offset + 2);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+uint16_t PicoBLE::onRead(uint16_t conn, uint16_t handle, uint16_t offset,
+                         uint8_t* buf, uint16_t size) {
+    PicoBLE* self = instance;
+    if (!self) {
+        return 0;
+    }
+    if (handle == self->configHandle) {
+        return att_read_callback_handle_blob(self->configValue, self->configLen,
+                                             offset, buf, size);
+    }
+    if (handle == self->statusHandle) {
+        return att_read_callback_handle_blob((const uint8_t*)self->statusValue,
+                                             self->statusLen, offset, buf, size);
+    }
+    if (handle == self->statusHandle + 1 || handle == self->streamHandle + 1) {
+        bool on = handle == self->streamHandle + 1 ? self->streamSubscribed
+                                                   : self->statusSubscribed;
+        uint8_t cccd[2] = { (uint8_t)(on ? 0x01 : 0x00), 0 };
+        return att_read_callback_handle_blob(cccd, sizeof(cccd), offset, buf, size);
+    }
+    return 0;
+}
+
+int PicoBLE::onWrite(uint16_t conn, uint16_t handle, uint16_t mode, uint16_t offset,
+                     uint8_t* buf, uint16_t size) {
+    PicoBLE* self = instance;
+    if (!self) {
+        return 0;
+    }
+    if (handle == self->configHandle) {
+        // A record longer than MTU − 3 arrives as prepared writes, then execute
+        switch (mode) {
+            case ATT_TRANSACTION_MODE_NONE:
+            case ATT_TRANSACTION_MODE_ACTIVE: {
+                if (mode == ATT_TRANSACTION_MODE_NONE || offset == 0) self->pendingConfigLen = 0;
+                if (offset >= sizeof(self->pendingConfig)) break;
+                uint16_t n = min((size_t)size, sizeof(self->pendingConfig) - offset);
+                memcpy(self->pendingConfig + offset, buf, n);
+                self->pendingConfigLen = max(self->pendingConfigLen, (uint8_t)(offset + n));
+                if (mode == ATT_TRANSACTION_MODE_NONE) self->configWritten = true;
+                break;
+            }
+            case ATT_TRANSACTION_MODE_EXECUTE:
+                self->configWritten = true;
+                break;
+            case ATT_TRANSACTION_MODE_CANCEL:
+                self->pendingConfigLen = 0;
+                break;
+            default:
+                break;
+        }
+        return 0;
+    }
+    if (handle == self->commandHandle) {
+        if (mode != ATT_TRANSACTION_MODE_NONE) return 0;
+        self->pendingCommandLen = (uint8_t)min((size_t)size, sizeof(self->pendingCommand) + 1);
+        memcpy(self->pendingCommand, buf, min((size_t)size, sizeof(self->pendingCommand)));
+        self->commandWritten = true;
+        return 0;
+    }
+    if (size < 2) {
+        return 0;
+    }
+    bool notify = little_endian_read_16(buf, 0) & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
+    if (handle == self->streamHandle + 1) {
+        if (notify && !self->streamSubscribed) self->dumpRequested = true;
+        self->streamSubscribed = notify;
+    } else if (handle == self->statusHandle + 1) {
+        self->statusSubscribed = notify;
+    }
+    return 0;
+}
+
+// ── Loop side ────────────────────────────────────────────────────────────────
+
+void PicoBLE::update() {
+    if (!initialized) {
+        return;
+    }
+    async_context_t* ctx = cyw43_arch_async_context();
+    uint8_t record[sizeof(pendingConfig)];
+    uint8_t recordLen = 0;
+    uint8_t command[sizeof(pendingCommand)];
+    uint8_t commandLen = 0;
+    bool    haveRecord = false;
+    bool    haveCommand = false;
+
+    async_context_acquire_lock_blocking(ctx);
+    takeEvents();
+    if (configWritten) {
+        recordLen = pendingConfigLen;
+        memcpy(record, pendingConfig, recordLen);
+        configWritten = false;
+        haveRecord = true;
+    }
+    if (commandWritten) {
+        commandLen = pendingCommandLen;
+        memcpy(command, pendingCommand, min((size_t)commandLen, sizeof(command)));
+        commandWritten = false;
+        haveCommand = true;
+    }
+    async_context_release_lock(ctx);
+
+    // Outside the lock: an apply waits on AT round trips and a flash write
+    if (haveRecord && deviceConfig) {
+        reportConfig(deviceConfig->applyWire(record, recordLen));
+    }
+    if (haveCommand) {
+        handleCommand(command, commandLen);
+    }
+
+    async_context_acquire_lock_blocking(ctx);
+    if (configDirty) {
+        configDirty = false;
+        configLen = (uint8_t)DeviceConfig::encode(
+            deviceConfig ? deviceConfig->get() : DeviceConfig::defaults(),
+            configValue, sizeof(configValue));
+    }
+    notifyStatus();
+    if (dumpRequested && conn != PICO_BLE_NO_CONN) {
+        dumpRequested = false;
+        startDump();
+    }
+    pumpStream();
+    async_context_release_lock(ctx);
+}
+
+void PicoBLE::takeEvents() {
+    if (connectionChanged) {
+        connectionChanged = false;
+        conn = postedConn;
+        attMtu = BLE_STREAM_DEFAULT_MTU;
+        stream.reset();
+        sentHead = sentCount = 0;
+        fragsDone = 0;
+        completedFrags = 0;
+        dumpReported = true;
+        if (conn != PICO_BLE_NO_CONN) {
+            Serial.println("[BLE] Client connected");
+            // Short interval: several notifications per event during a dump
+            gap_request_connection_parameter_update(conn, BLE_CONN_INTERVAL_MIN,
+                                                    BLE_CONN_INTERVAL_MAX, 0,
+                                                    BLE_CONN_TIMEOUT);
+        } else {
+            Serial.println("[BLE] Client disconnected");
+            gap_advertisements_enable(1);
+        }
+    }
+    if (negotiatedMtu) {
+        attMtu = negotiatedMtu;
+        stream.setMtu(negotiatedMtu);
+        Serial.println("[BLE] MTU " + String(negotiatedMtu));
+        negotiatedMtu = 0;
+    }
+
+    fragsDone += completedFrags;
+    completedFrags = 0;
+    onCompleted();
+}
+
+void PicoBLE::notifyStatus() {
+    if (!statusPending || conn == PICO_BLE_NO_CONN || !statusSubscribed) {
+        statusPending = false;    // still readable
+        return;
+    }
+    if (!att_server_can_send_packet_now(conn)) {
+        return;                   // ahead of the stream on the next update()
+    }
+    statusPending = false;
+    // Longer text is cut to one notification; a read returns all of it
+    uint16_t len = min((uint16_t)statusLen, (uint16_t)(attMtu - 3));
+    att_server_notify(conn, statusHandle, (const uint8_t*)statusValue, len);
+}
+
+void PicoBLE::onCompleted() {
+    uint32_t now = millis();
+    while (sentCount && fragsDone >= sentFrags[sentHead]) {
+        fragsDone -= sentFrags[sentHead];
+        sentHead = (sentHead + 1) % BLE_STREAM_IN_FLIGHT;
+        sentCount--;
+        stream.onSent(now);
+    }
+    if (sentCount == 0) fragsDone = 0;    // ATT responses, nothing of ours pending
+}
+
+void PicoBLE::pumpStream() {
+    if (conn == PICO_BLE_NO_CONN || !streamSubscribed) {
+        return;
+    }
+
+    uint8_t  buf[BLE_STREAM_MAX_NOTIFY];
+    uint16_t acl = hci_max_acl_le_data_packet_length();
+    size_t   len;
+    stream.refill();
+    // Only what the controller has buffers for right now; the rest waits
+    // for completions, so BLEStream's credits track packets on the air
+    while (att_server_can_send_packet_now(conn) &&
+           (len = stream.next(buf, sizeof(buf), millis())) > 0) {
+        if (att_server_notify(conn, streamHandle, buf, (uint16_t)len) != ERROR_CODE_SUCCESS) {
+            stream.unsend();          // retried on the next update()
+            break;
+        }
+        if (sentCount == BLE_STREAM_IN_FLIGHT) {
+            // BLEStream reclaimed credits after its timeout; forget the oldest
+            sentHead = (sentHead + 1) % BLE_STREAM_IN_FLIGHT;
+            sentCount--;
+        }
+        // L2CAP header 4 + ATT opcode and handle 3, in controller-sized fragments
+        sentFrags[(sentHead + sentCount) % BLE_STREAM_IN_FLIGHT] =
+            (uint8_t)((len + 7 + acl - 1) / acl);
+        sentCount++;
+        stream.refill();
+    }
+
+    if (!dumpReported && stream.idle()) {
+        dumpReported = true;
+        const BLEStreamStats& st = stream.getStats();
+        Serial.println("[BLE] Dump sent: " + String(st.bytes) + " B in " +
+                       String(st.notifications) + " notifications, " +
+                       String(stream.bytesPerSecond()) + " B/s");
+    }
+}
+
+#else   // no Bluetooth in this build
+
+bool PicoBLE::begin(const char* deviceName) {
+    Serial.println("[BLE] Not enabled in this build");
+    return false;
+}
+
+void PicoBLE::update() {}
+void PicoBLE::takeEvents() {}
+void PicoBLE::onCompleted() {}
+void PicoBLE::notifyStatus() {}
+void PicoBLE::pumpStream() {}
+
+void PicoBLE::onPacket(uint8_t type, uint16_t channel, uint8_t* packet, uint16_t size) {}
+
+uint16_t PicoBLE::onRead(uint16_t conn, uint16_t handle, uint16_t offset,
+                         uint8_t* buf, uint16_t size) {
+    return 0;
+}
+
+int PicoBLE::onWrite(uint16_t conn, uint16_t handle, uint16_t mode, uint16_t offset,
+                     uint8_t* buf, uint16_t size) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,218 @@
+/**
+ * @file PositionFilter.cpp
+ * @brief Fixed-point constant-velocity Kalman filter implementation
+ *
+ * All products are formed in int64 and gains are Q16, so a full predict +
+ * position + velocity update is a handful of 64-bit multiplies and four
+ * 64-bit divides — tens of microseconds on the RP2040, once per fix.
+ */
+
+#include "PositionFilter.h"
+#include "FixedMath.h"
+
+// Default HDOP (hundredths) when the receiver does not report one
+static const uint32_t DEFAULT_HDOP_X100 = 200;
+// Velocity σ assumed on the first fix when no speed is reported (2 m/s)
+static const int64_t  INITIAL_VV = 2000LL * 2000LL;
+
+static const int64_t  Q_ACCEL = (int64_t)KF_ACCEL_SIGMA_MMS2 * KF_ACCEL_SIGMA_MMS2;
+
+PositionFilter::PositionFilter() {
+    reset();
+}
+
+void PositionFilter::reset() {
+    initialized      = false;
+    originLatE6      = originLonE6 = 0;
+    cosOriginQ15     = FM_Q15_ONE - 1;
+    posE = posN      = 0;
+    velE = velN      = 0;
+    pp = pv = vv     = 0;
+    lastTimestamp    = 0;
+    lastInnovationMm = 0;
+}
+
+// ── Private helpers ──────────────────────────────────────────────────────────
+
+void PositionFilter::setOrigin(int32_t latE6, int32_t lonE6) {
+    originLatE6  = latE6;
+    originLonE6  = lonE6;
+    cosOriginQ15 = FixedMath::cosLatQ15(latE6);
+}
+
+/**
+ * Constant-velocity prediction over dtMs with white-acceleration noise:
+ *   pp += 2·dt·pv + dt²·vv + q·dt³/3
+ *   pv += dt·vv + q·dt²/2
+ *   vv += q·dt
+ * Each term is built up one /1000 at a time to stay inside int64.
+ */
+void PositionFilter::propagate(uint32_t dtMs) {
+    if (dtMs == 0) return;
+    int64_t dt = dtMs;
+
+    posE += (int32_t)(((int64_t)velE * dt) / 1000);
+    posN += (int32_t)(((int64_t)velN * dt) / 1000);
+
+    int64_t qdt   = Q_ACCEL * dt / 1000;        // q·dt
+    int64_t qdt2  = qdt * dt / 1000;            // q·dt²
+    int64_t qdt3  = qdt2 * dt / 1000;           // q·dt³
+    int64_t vvdt  = vv * dt / 1000;             // vv·dt
+
+    pp += 2 * pv * dt / 1000 + vvdt * dt / 1000 + qdt3 / 3;
+    pv += vvdt + qdt2 / 2;
+    vv += qdt;
+}
+
+void PositionFilter::fusePosition(int32_t zE, int32_t zN, int64_t r) {
+    int64_t s  = pp + r;
+    int64_t k0 = (pp << 16) / s;                // Q16
+    int64_t k1 = (pv << 16) / s;
+
+    int32_t yE = zE - posE;
+    int32_t yN = zN - posN;
+    lastInnovationMm = FixedMath::isqrt64((uint64_t)((int64_t)yE * yE + (int64_t)yN * yN));
+
+    posE += (int32_t)((k0 * yE) >> 16);
+    posN += (int32_t)((k0 * yN) >> 16);
+    velE += (int32_t)((k1 * yE) >> 16);
+    velN += (int32_t)((k1 * yN) >> 16);
+
+    int64_t npp = pp - ((k0 * pp) >> 16);
+    int64_t npv = pv - ((k0 * pv) >> 16);
+    int64_t nvv = vv - ((k1 * pv) >> 16);
+    pp = npp > 1 ? npp : 1;
+    pv = npv;
+    vv = nvv > 1 ? nvv : 1;
+}
+
+void PositionFilter::fuseVelocity(int32_t zE, int32_t zN, int64_t r) {
+    int64_t s  = vv + r;
+    int64_t k0 = (pv << 16) / s;
+    int64_t k1 = (vv << 16) / s;
+
+    int32_t yE = zE - velE;
+    int32_t yN = zN - velN;
+
+    posE += (int32_t)((k0 * yE) >> 16);
+    posN += (int32_t)((k0 * yN) >> 16);
+    velE += (int32_t)((k1 * yE) >> 16);
+    velN += (int32_t)((k1 * yN) >> 16);
+
+    int64_t npp = pp - ((k0 * pv) >> 16);
+    int64_t npv = pv - ((k0 * vv) >> 16);
+    int64_t nvv = vv - ((k1 * vv) >> 16);
+    pp = npp > 1 ? npp : 1;
+    pv = npv;
+    vv = nvv > 1 ? nvv : 1;
+}
+
+// ── Public API ────────────────────────────────────────────────────────────────
+
+bool PositionFilter::update(const GPSData& fix) {
+    if (!fix.valid) return false;
+    // A snapshot taken before the receiver produced the next fix repeats the
+    // last one; fusing it again would shrink the covariance for nothing.
+    if (initialized && (int32_t)(fix.timestamp - lastTimestamp) <= 0) return false;
+
+    int32_t latE6 = FixedMath::toMicroDeg(fix.latitude);
+    int32_t lonE6 = FixedMath::toMicroDeg(fix.longitude);
+
+    uint32_t hdop  = fix.hdop ? fix.hdop : DEFAULT_HDOP_X100;
+    int64_t  sigma = (int64_t)hdop * KF_UERE_MM / 100;
+    int64_t  rPos  = sigma * sigma;
+
+    // Doppler velocity is only meaningful once the asset is actually moving
+    bool    haveVel = fix.speed >= KF_MIN_COURSE_SPEED_KMH;
+    int32_t zVelE = 0, zVelN = 0;
+    if (haveVel) {
+        int32_t  speedMms = (int32_t)(fix.speed * (1000000.0f / 3600.0f));
+        uint16_t course   = FixedMath::degToBam(fix.course);
+        zVelE = (int32_t)(((int64_t)speedMms * FixedMath::sinQ15(course)) >> 15);
+        zVelN = (int32_t)(((int64_t)speedMms * FixedMath::cosQ15(course)) >> 15);
+    }
+
+    uint32_t dtMs = fix.timestamp - lastTimestamp;
+    if (!initialized || dtMs > KF_MAX_PREDICT_MS) {
+        // First fix, or coasted too long for the old state to mean anything
+        setOrigin(latE6, lonE6);
+        posE = posN = 0;
+        velE = zVelE;
+        velN = zVelN;
+        pp   = rPos;
+        pv   = 0;
+        vv   = haveVel ? (int64_t)KF_VEL_SIGMA_MMS * KF_VEL_SIGMA_MMS : INITIAL_VV;
+        lastTimestamp    = fix.timestamp;
+        lastInnovationMm = 0;
+        initialized      = true;
+        return true;
+    }
+
+    propagate(dtMs);
+    lastTimestamp = fix.timestamp;
+
+    // Keep the tangent plane close to the asset so mm values stay small and
+    // the cos(lat) longitude scale stays accurate.
+    if (posE > KF_REORIGIN_MM || posE < -KF_REORIGIN_MM ||
+        posN > KF_REORIGIN_MM || posN < -KF_REORIGIN_MM) {
+        int32_t curLat, curLon;
+        FixedMath::fromLocalMm(posE, posN, originLatE6, originLonE6, cosOriginQ15,
+                               curLat, curLon);
+        setOrigin(curLat, curLon);
+        posE = posN = 0;
+    }
+
+    int32_t zE, zN;
+    FixedMath::toLocalMm(latE6, lonE6, originLatE6, originLonE6, cosOriginQ15, zE, zN);
+    fusePosition(zE, zN, rPos);
+
+    if (haveVel) {
+        fuseVelocity(zVelE, zVelN, (int64_t)KF_VEL_SIGMA_MMS * KF_VEL_SIGMA_MMS);
+    }
+    return true;
+}
+
+bool PositionFilter::predict(uint32_t timestamp, int32_t& latE6, int32_t& lonE6) const {
+    if (!initialized) return false;
+
+    int32_t dt = (int32_t)(timestamp - lastTimestamp);
+    if (dt < 0) dt = 0;
+    if ((uint32_t)dt > KF_MAX_PREDICT_MS) dt = KF_MAX_PREDICT_MS;
+
+    int32_t e = posE + (int32_t)(((int64_t)velE * dt) / 1000);
+    int32_t n = posN + (int32_t)(((int64_t)velN * dt) / 1000);
+    FixedMath::fromLocalMm(e, n, originLatE6, originLonE6, cosOriginQ15, latE6, lonE6);
+    return true;
+}
+
+uint32_t PositionFilter::predictSigmaMm(uint32_t timestamp) const {
+    if (!initialized) return UINT32_MAX;
+
+    int32_t dt = (int32_t)(timestamp - lastTimestamp);
+    if (dt < 0) dt = 0;
+    if ((uint32_t)dt > KF_MAX_PREDICT_MS) dt = KF_MAX_PREDICT_MS;
+
+    int64_t qdt3 = Q_ACCEL * dt / 1000 * dt / 1000 * dt / 1000;
+    int64_t var  = pp + 2 * pv * dt / 1000 + vv * dt / 1000 * dt / 1000 + qdt3 / 3;
+    return FixedMath::isqrt64((uint64_t)(var > 0 ? var : 0));
+}
+
+FilterState PositionFilter::getState() const {
+    FilterState s;
+    s.valid = initialized;
+    if (!initialized) {
+        s.latE6 = s.lonE6 = 0;
+        s.velEastMms = s.velNorthMms = 0;
+        s.posSigmaMm = s.velSigmaMms = UINT32_MAX;
+        s.timestamp  = 0;
+        return s;
+    }
+    FixedMath::fromLocalMm(posE, posN, originLatE6, originLonE6, cosOriginQ15,
+                           s.latE6, s.lonE6);
+    s.velEastMms  = velE;
+    s.velNorthMms = velN;
+    s.posSigmaMm  = FixedMath::isqrt64((uint64_t)pp);
+    s.velSigmaMms = FixedMath::isqrt64((uint64_t)vv);
+    s.timestamp   = lastTimestamp;
+    return s;
+}
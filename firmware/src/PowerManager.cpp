@@ -0,0 +1,110 @@
+/**
+ * @file PowerManager.cpp
+ * @brief Stillness timers, keepalive wake-ups and per-state time accounting
+ */
+
+#include "PowerManager.h"
+#include <string.h>
+
+static const uint16_t CURRENT_MA_X10[POWER_STATE_COUNT] = {
+    POWER_CURRENT_ACTIVE_MA_X10, POWER_CURRENT_IDLE_MA_X10,
+    POWER_CURRENT_SLEEP_MA_X10,  POWER_CURRENT_KEEPALIVE_MA_X10
+};
+
+PowerManager::PowerManager()
+    : timings{ POWER_IDLE_AFTER_MS, POWER_SLEEP_AFTER_MS, POWER_KEEPALIVE_MS,
+               POWER_KEEPALIVE_FIX_MS, POWER_KEEPALIVE_MAX_MS, POWER_KEEPALIVE_LISTEN_MS },
+      state(POWER_ACTIVE), enteredAt(0), lastMotion(0), keepaliveSentAt(0), transitions(0) {
+    memset(timeIn, 0, sizeof(timeIn));
+}
+
+void PowerManager::begin(uint32_t now) {
+    memset(timeIn, 0, sizeof(timeIn));
+    state           = POWER_ACTIVE;
+    enteredAt       = now;
+    lastMotion      = now;
+    keepaliveSentAt = 0;
+    transitions     = 0;
+}
+
+void PowerManager::enter(PowerState s, uint32_t now) {
+    timeIn[state] += now - enteredAt;
+    state           = s;
+    enteredAt       = now;
+    keepaliveSentAt = 0;
+    transitions++;
+}
+
+void PowerManager::onMotion(uint32_t now) {
+    lastMotion = now;
+    if (state != POWER_ACTIVE) enter(POWER_ACTIVE, now);
+}
+
+bool PowerManager::update(uint32_t now) {
+    PowerState before = state;
+    uint32_t   still  = now - lastMotion;
+    uint32_t   inState = now - enteredAt;
+
+    switch (state) {
+        case POWER_ACTIVE:
+            if (still >= timings.idleAfterMs) enter(POWER_IDLE, now);
+            break;
+        case POWER_IDLE:
+            if (still >= timings.sleepAfterMs) enter(POWER_SLEEP, now);
+            break;
+        case POWER_SLEEP:
+            if (inState >= timings.keepaliveMs) enter(POWER_KEEPALIVE, now);
+            break;
+        case POWER_KEEPALIVE:
+            if ((keepaliveSentAt && now - keepaliveSentAt >= timings.keepaliveListenMs) ||
+                inState >= timings.keepaliveMaxMs) {
+                enter(POWER_SLEEP, now);
+            }
+            break;
+        default:
+            break;
+    }
+    return state != before;
+}
+
+bool PowerManager::keepaliveDue(uint32_t now, bool haveFix) const {
+    return state == POWER_KEEPALIVE && keepaliveSentAt == 0 &&
+           (haveFix || now - enteredAt >= timings.keepaliveFixMs);
+}
+
+void PowerManager::onKeepaliveSent(uint32_t now) {
+    if (state == POWER_KEEPALIVE) keepaliveSentAt = now ? now : 1;
+}
+
+GpsPowerMode PowerManager::gpsMode() const {
+    switch (state) {
+        case POWER_IDLE:  return GPS_POWER_SAVE;
+        case POWER_SLEEP: return GPS_POWER_BACKUP;
+        default:          return GPS_POWER_CONTINUOUS;
+    }
+}
+
+uint32_t PowerManager::getTimeInState(PowerState s, uint32_t now) const {
+    if (s >= POWER_STATE_COUNT) return 0;
+    return timeIn[s] + (s == state ? now - enteredAt : 0);
+}
+
+uint32_t PowerManager::getAverageCurrentMaX10(uint32_t now) const {
+    uint64_t charge = 0, total = 0;
+    for (uint8_t s = 0; s < POWER_STATE_COUNT; s++) {
+        uint32_t t = getTimeInState((PowerState)s, now);
+        charge += (uint64_t)t * CURRENT_MA_X10[s];
+        total  += t;
+    }
+    return total ? (uint32_t)(charge / total) : CURRENT_MA_X10[state];
+}
+
+const char* PowerManager::stateName(PowerState s) {
+    switch (s) {
+        case POWER_ACTIVE:    return "active";
+        case POWER_IDLE:      return "idle";
+        case POWER_SLEEP:     return "sleep";
+        case POWER_KEEPALIVE: return "keepalive";
+        default:              return "?";
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ * @file Sha256.cpp
+ * @brief SHA-256 compression and padding, HMAC
+ */
+
+#include "Sha256.h"
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t ror(uint32_t x, uint8_t n) { return (x >> n) | (x << (32 - n)); }
+
+void Sha256::reset() {
+    static const uint32_t H0[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(state, H0, sizeof(state));
+    totalLen = 0;
+    blockLen = 0;
+}
+
+void Sha256::compress(const uint8_t* p) {
+    // 16-word rolling schedule instead of 64: 192 B less stack
+    uint32_t w[16];
+    for (uint8_t i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 |
+               (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (uint8_t i = 0; i < 64; i++) {
+        if (i >= 16) {
+            uint32_t w15 = w[(i + 1) & 15], w2 = w[(i + 14) & 15];
+            uint32_t s0  = ror(w15, 7) ^ ror(w15, 18) ^ (w15 >> 3);
+            uint32_t s1  = ror(w2, 17) ^ ror(w2, 19) ^ (w2 >> 10);
+            w[i & 15] += s0 + w[(i + 9) & 15] + s1;
+        }
+        uint32_t t1 = h + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) +
+                      K[i] + w[i & 15];
+        uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    totalLen += len;
+    if (blockLen) {
+        size_t take = min(len, (size_t)(SHA256_BLOCK_SIZE - blockLen));
+        memcpy(block + blockLen, p, take);
+        blockLen += (uint8_t)take;
+        p   += take;
+        len -= take;
+        if (blockLen < SHA256_BLOCK_SIZE) return;
+        compress(block);
+        blockLen = 0;
+    }
+    for (; len >= SHA256_BLOCK_SIZE; p += SHA256_BLOCK_SIZE, len -= SHA256_BLOCK_SIZE) {
+        compress(p);
+    }
+    memcpy(block, p, len);
+    blockLen = (uint8_t)len;
+}
+
+void Sha256::finish(uint8_t out[SHA256_DIGEST_SIZE]) {
+    uint64_t bits = totalLen * 8;
+    block[blockLen++] = 0x80;
+    if (blockLen > SHA256_BLOCK_SIZE - 8) {
+        memset(block + blockLen, 0, SHA256_BLOCK_SIZE - blockLen);
+        compress(block);
+        blockLen = 0;
+    }
+    memset(block + blockLen, 0, SHA256_BLOCK_SIZE - 8 - blockLen);
+    for (uint8_t i = 0; i < 8; i++) block[SHA256_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8 * i));
+    compress(block);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)state[i];
+    }
+}
+
+void Sha256::hash(const void* data, size_t len, uint8_t out[SHA256_DIGEST_SIZE]) {
+    Sha256 h;
+    h.update(data, len);
+    h.finish(out);
+}
+
+void Sha256::hmac(const uint8_t* key, size_t keyLen, const void* data, size_t len,
+                  uint8_t out[SHA256_DIGEST_SIZE]) {
+    uint8_t k[SHA256_BLOCK_SIZE] = {};
+    if (keyLen > SHA256_BLOCK_SIZE) hash(key, keyLen, k);
+    else                            memcpy(k, key, keyLen);
+
+    uint8_t pad[SHA256_BLOCK_SIZE];
+    Sha256  h;
+    for (uint8_t i = 0; i < SHA256_BLOCK_SIZE; i++) pad[i] = k[i] ^ 0x36;
+    h.update(pad, sizeof(pad));
+    h.update(data, len);
+    h.finish(out);
+
+    h.reset();
+    for (uint8_t i = 0; i < SHA256_BLOCK_SIZE; i++) pad[i] = k[i] ^ 0x5c;
+    h.update(pad, sizeof(pad));
+    h.update(out, SHA256_DIGEST_SIZE);
+    h.finish(out);
+}
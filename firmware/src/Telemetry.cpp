@@ -6,156 +6,279 @@
 #include "Telemetry.h"
 
 Telemetry::Telemetry() : lastType(TELEMETRY_FULL) {
+    memset(&lastRecord, 0, sizeof(lastRecord));
+    memset(stats, 0, sizeof(stats));
 }
 
-void Telemetry::addTimestamp() {
-    doc["timestamp"] = millis();
+// ── Records ──────────────────────────────────────────────────────────────────
+
+static int32_t toFixed(double v, double scale) {
+    return (int32_t)lround(v * scale);
+}
+
+static void copyText(char* dst, size_t cap, const char* src) {
+    if (!src) src = "";
+    strncpy(dst, src, cap - 1);
+    dst[cap - 1] = '\0';
+}
+
+void Telemetry::toRecord(const GPSData& gpsData, GpsRecord& rec) {
+    rec.timestamp  = millis();
+    rec.valid      = gpsData.valid;
+    rec.latE6      = toFixed(gpsData.latitude,  1e6);
+    rec.lonE6      = toFixed(gpsData.longitude, 1e6);
+    rec.altCm      = toFixed(gpsData.altitude,  100.0);
+    rec.speedX100  = (uint16_t)constrain(toFixed(gpsData.speed,  100.0), 0, UINT16_MAX);
+    rec.courseX100 = (uint16_t)constrain(toFixed(gpsData.course, 100.0), 0, 35999);
+    rec.satellites = gpsData.satellites;
+}
+
+void Telemetry::toRecord(const IMUData& imuData, ImuRecord& rec) {
+    rec.timestamp     = millis();
+    rec.accelMilli[0] = toFixed(imuData.accelX, 1000.0);
+    rec.accelMilli[1] = toFixed(imuData.accelY, 1000.0);
+    rec.accelMilli[2] = toFixed(imuData.accelZ, 1000.0);
+    rec.gyroMilli[0]  = toFixed(imuData.gyroX,  1000.0);
+    rec.gyroMilli[1]  = toFixed(imuData.gyroY,  1000.0);
+    rec.gyroMilli[2]  = toFixed(imuData.gyroZ,  1000.0);
+    rec.tempX100      = (int16_t)constrain(toFixed(imuData.temperature, 100.0),
+                                           INT16_MIN, INT16_MAX);
+}
+
+void Telemetry::toGPSData(const GpsRecord& rec, GPSData& gpsData) {
+    gpsData.valid      = rec.valid;
+    gpsData.latitude   = rec.latE6 / 1e6;
+    gpsData.longitude  = rec.lonE6 / 1e6;
+    gpsData.altitude   = rec.altCm / 100.0;
+    gpsData.speed      = rec.speedX100  / 100.0f;
+    gpsData.course     = rec.courseX100 / 100.0f;
+    gpsData.satellites = rec.satellites;
+    gpsData.timestamp  = rec.timestamp;
+}
+
+void Telemetry::toIMUData(const ImuRecord& rec, IMUData& imuData) {
+    imuData.accelX      = rec.accelMilli[0] / 1000.0f;
+    imuData.accelY      = rec.accelMilli[1] / 1000.0f;
+    imuData.accelZ      = rec.accelMilli[2] / 1000.0f;
+    imuData.gyroX       = rec.gyroMilli[0]  / 1000.0f;
+    imuData.gyroY       = rec.gyroMilli[1]  / 1000.0f;
+    imuData.gyroZ       = rec.gyroMilli[2]  / 1000.0f;
+    imuData.temperature = rec.tempX100 / 100.0f;
+    imuData.timestamp   = rec.timestamp;
+}
+
+void Telemetry::toFullRecord(FullRecord& rec, const GPSData& gpsData,
+                             const IMUData& imuData, uint8_t battery) {
+    toRecord(gpsData, rec.gps);
+    toRecord(imuData, rec.imu);
+    rec.timestamp = rec.gps.timestamp;
+    rec.battery   = battery;
+}
+
+void Telemetry::toStatusRecord(StatusRecord& rec, uint8_t battery, uint32_t uptime, int rssi) {
+    rec.timestamp = millis();
+    rec.battery   = battery;
+    rec.uptime    = uptime;
+    rec.rssi      = (int16_t)constrain(rssi, INT16_MIN, INT16_MAX);
+}
+
+void Telemetry::toAlertRecord(AlertRecord& rec, const char* alertType, const char* message) {
+    rec.timestamp = millis();
+    copyText(rec.alertType, sizeof(rec.alertType), alertType);
+    copyText(rec.message,   sizeof(rec.message),   message);
+}
+
+// ── Streaming writers ────────────────────────────────────────────────────────
+
+bool Telemetry::writeFullTelemetry(JsonWriter& w, const GPSData& gpsData,
+                                   const IMUData& imuData, const char* deviceId,
+                                   uint8_t battery) {
+    FullRecord rec;
+    toFullRecord(rec, gpsData, imuData, battery);
+    return TelemetryCodec::encodeJson(w, TELEMETRY_FULL, &rec, deviceId);
+}
+
+bool Telemetry::writeGPSTelemetry(JsonWriter& w, const GPSData& gpsData, const char* deviceId) {
+    GpsRecord rec;
+    toRecord(gpsData, rec);
+    return TelemetryCodec::encodeJson(w, TELEMETRY_GPS, &rec, deviceId);
+}
+
+bool Telemetry::writeIMUTelemetry(JsonWriter& w, const IMUData& imuData, const char* deviceId) {
+    ImuRecord rec;
+    toRecord(imuData, rec);
+    return TelemetryCodec::encodeJson(w, TELEMETRY_IMU, &rec, deviceId);
+}
+
+bool Telemetry::writeStatusTelemetry(JsonWriter& w, const char* deviceId, uint8_t battery,
+                                     uint32_t uptime, int rssi) {
+    StatusRecord rec;
+    toStatusRecord(rec, battery, uptime, rssi);
+    return TelemetryCodec::encodeJson(w, TELEMETRY_STATUS, &rec, deviceId);
+}
+
+bool Telemetry::writeAlertTelemetry(JsonWriter& w, const char* deviceId,
+                                    const char* alertType, const char* message) {
+    AlertRecord rec;
+    toAlertRecord(rec, alertType, message);
+    return TelemetryCodec::encodeJson(w, TELEMETRY_ALERT, &rec, deviceId);
+}
+
+// ── Binary packets ───────────────────────────────────────────────────────────
+
+size_t Telemetry::packFullTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData,
+                                    const IMUData& imuData, uint8_t battery) {
+    FullRecord rec;
+    toFullRecord(rec, gpsData, imuData, battery);
+    return TelemetryCodec::encodeBinary(TELEMETRY_FULL, &rec, buf, cap);
+}
+
+size_t Telemetry::packGPSTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData) {
+    GpsRecord rec;
+    toRecord(gpsData, rec);
+    return TelemetryCodec::encodeBinary(TELEMETRY_GPS, &rec, buf, cap);
 }
 
-void Telemetry::addDeviceInfo(const char* deviceId) {
-    doc["device_id"] = deviceId;
+size_t Telemetry::packIMUTelemetry(uint8_t* buf, size_t cap, const IMUData& imuData) {
+    ImuRecord rec;
+    toRecord(imuData, rec);
+    return TelemetryCodec::encodeBinary(TELEMETRY_IMU, &rec, buf, cap);
 }
 
-String Telemetry::createFullTelemetry(const GPSData& gpsData, const IMUData& imuData, 
+size_t Telemetry::packStatusTelemetry(uint8_t* buf, size_t cap, uint8_t battery,
+                                      uint32_t uptime, int rssi) {
+    StatusRecord rec;
+    toStatusRecord(rec, battery, uptime, rssi);
+    return TelemetryCodec::encodeBinary(TELEMETRY_STATUS, &rec, buf, cap);
+}
+
+size_t Telemetry::packAlertTelemetry(uint8_t* buf, size_t cap, const char* alertType,
+                                     const char* message) {
+    AlertRecord rec;
+    toAlertRecord(rec, alertType, message);
+    return TelemetryCodec::encodeBinary(TELEMETRY_ALERT, &rec, buf, cap);
+}
+
+// ── String wrappers ──────────────────────────────────────────────────────────
+
+String Telemetry::createFullTelemetry(const GPSData& gpsData, const IMUData& imuData,
                                       const char* deviceId, uint8_t battery) {
-    doc.clear();
-    
-    addDeviceInfo(deviceId);
-    addTimestamp();
-    doc["type"] = "full";
-    doc["battery"] = battery;
-
-    // GPS data
-    JsonObject gps = doc.createNestedObject("gps");
-    gps["valid"] = gpsData.valid;
-    gps["lat"] = gpsData.latitude;
-    gps["lon"] = gpsData.longitude;
-    gps["alt"] = gpsData.altitude;
-    gps["speed"] = gpsData.speed;
-    gps["course"] = gpsData.course;
-    gps["satellites"] = gpsData.satellites;
-
-    // IMU data
-    JsonObject imu = doc.createNestedObject("imu");
-    JsonObject accel = imu.createNestedObject("accel");
-    accel["x"] = imuData.accelX;
-    accel["y"] = imuData.accelY;
-    accel["z"] = imuData.accelZ;
-    
-    JsonObject gyro = imu.createNestedObject("gyro");
-    gyro["x"] = imuData.gyroX;
-    gyro["y"] = imuData.gyroY;
-    gyro["z"] = imuData.gyroZ;
-    
-    imu["temp"] = imuData.temperature;
-
-    String output;
-    serializeJson(doc, output);
-    return output;
+    char buf[TELEMETRY_JSON_MAX];
+    JsonWriter w(buf, sizeof(buf));
+    return writeFullTelemetry(w, gpsData, imuData, deviceId, battery) ? String(buf) : String();
 }
 
 String Telemetry::createGPSTelemetry(const GPSData& gpsData, const char* deviceId) {
-    doc.clear();
-    
-    addDeviceInfo(deviceId);
-    addTimestamp();
-    doc["type"] = "gps";
+    char buf[TELEMETRY_JSON_MAX];
+    JsonWriter w(buf, sizeof(buf));
+    return writeGPSTelemetry(w, gpsData, deviceId) ? String(buf) : String();
+}
 
-    doc["valid"] = gpsData.valid;
-    doc["lat"] = gpsData.latitude;
-    doc["lon"] = gpsData.longitude;
-    doc["alt"] = gpsData.altitude;
-    doc["speed"] = gpsData.speed;
-    doc["course"] = gpsData.course;
-    doc["satellites"] = gpsData.satellites;
+String Telemetry::createIMUTelemetry(const IMUData& imuData, const char* deviceId) {
+    char buf[TELEMETRY_JSON_MAX];
+    JsonWriter w(buf, sizeof(buf));
+    return writeIMUTelemetry(w, imuData, deviceId) ? String(buf) : String();
+}
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+String Telemetry::createStatusTelemetry(const char* deviceId, uint8_t battery,
+                                        uint32_t uptime, int rssi) {
+    char buf[TELEMETRY_JSON_MAX];
+    JsonWriter w(buf, sizeof(buf));
+    return writeStatusTelemetry(w, deviceId, battery, uptime, rssi) ? String(buf) : String();
 }
 
-String Telemetry::createIMUTelemetry(const IMUData& imuData, const char* deviceId) {
-    doc.clear();
-    
-    addDeviceInfo(deviceId);
-    addTimestamp();
-    doc["type"] = "imu";
-
-    JsonObject accel = doc.createNestedObject("accel");
-    accel["x"] = imuData.accelX;
-    accel["y"] = imuData.accelY;
-    accel["z"] = imuData.accelZ;
-    
-    JsonObject gyro = doc.createNestedObject("gyro");
-    gyro["x"] = imuData.gyroX;
-    gyro["y"] = imuData.gyroY;
-    gyro["z"] = imuData.gyroZ;
-    
-    doc["temp"] = imuData.temperature;
-
-    String output;
-    serializeJson(doc, output);
-    return output;
-}
-
-String Telemetry::createStatusTelemetry(const char* deviceId, uint8_t battery, 
+String Telemetry::createAlertTelemetry(const char* deviceId, const char* alertType,
+                                       const char* message) {
+    char buf[TELEMETRY_JSON_MAX];
+    JsonWriter w(buf, sizeof(buf));
+    return writeAlertTelemetry(w, deviceId, alertType, message) ? String(buf) : String();
+}
+
+// ── Keyframe/delta stream ────────────────────────────────────────────────────
+
+size_t Telemetry::streamFullTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData,
+                                      const IMUData& imuData, uint8_t battery) {
+    FullRecord rec;
+    toFullRecord(rec, gpsData, imuData, battery);
+    return stream.encode(TELEMETRY_FULL, &rec, buf, cap);
+}
+
+size_t Telemetry::streamGPSTelemetry(uint8_t* buf, size_t cap, const GPSData& gpsData) {
+    GpsRecord rec;
+    toRecord(gpsData, rec);
+    return stream.encode(TELEMETRY_GPS, &rec, buf, cap);
+}
+
+size_t Telemetry::streamIMUTelemetry(uint8_t* buf, size_t cap, const IMUData& imuData) {
+    ImuRecord rec;
+    toRecord(imuData, rec);
+    return stream.encode(TELEMETRY_IMU, &rec, buf, cap);
+}
+
+size_t Telemetry::streamStatusTelemetry(uint8_t* buf, size_t cap, uint8_t battery,
                                         uint32_t uptime, int rssi) {
-    doc.clear();
-    
-    addDeviceInfo(deviceId);
-    addTimestamp();
-    doc["type"] = "status";
-    doc["battery"] = battery;
-    doc["uptime"] = uptime;
-    doc["rssi"] = rssi;
+    StatusRecord rec;
+    toStatusRecord(rec, battery, uptime, rssi);
+    return stream.encode(TELEMETRY_STATUS, &rec, buf, cap);
+}
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+// ── Parsing ──────────────────────────────────────────────────────────────────
+
+void Telemetry::countParse(uint8_t type, bool ok, size_t bytes, uint32_t startUs) {
+    TelemetryParseStats& st = stats[type < TELEMETRY_TYPE_COUNT ? type : (uint8_t)TELEMETRY_TYPE_COUNT];
+    if (ok) st.packets++;
+    else    st.errors++;
+    st.bytes  += bytes;
+    st.micros += micros() - startUs;
 }
 
-String Telemetry::createAlertTelemetry(const char* deviceId, const char* alertType, 
-                                       const char* message) {
-    doc.clear();
-    
-    addDeviceInfo(deviceId);
-    addTimestamp();
-    doc["type"] = "alert";
-    doc["alert_type"] = alertType;
-    doc["message"] = message;
+TelemetryParseResult Telemetry::parseTelemetry(char* json, size_t len, TelemetryMessage& msg,
+                                               uint32_t fieldMask) {
+    uint32_t t0 = micros();
+    TelemetryParseResult r = TelemetryCodec::decodeJson(json, len, fieldMask, msg);
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+    // Errors after the type was resolved count against that type
+    countParse(msg.type, r == TELEMETRY_PARSE_OK, len, t0);
+
+    if (r == TELEMETRY_PARSE_OK) {
+        lastType   = msg.type;
+        lastRecord = msg.record;
+    }
+    return r;
 }
 
 bool Telemetry::parseTelemetry(const String& json) {
-    doc.clear();
-    
-    DeserializationError error = deserializeJson(doc, json);
-    if (error) {
-        Serial.print("JSON parse error: ");
-        Serial.println(error.c_str());
+    char buf[TELEMETRY_JSON_MAX];
+    if (json.length() >= sizeof(buf)) {
+        Serial.println("JSON parse error: packet too long");
+        countParse(TELEMETRY_TYPE_COUNT, false, json.length(), micros());
         return false;
     }
+    memcpy(buf, json.c_str(), json.length() + 1);
 
-    // Determine type
-    const char* type = doc["type"];
-    if (strcmp(type, "full") == 0) {
-        lastType = TELEMETRY_FULL;
-    } else if (strcmp(type, "gps") == 0) {
-        lastType = TELEMETRY_GPS;
-    } else if (strcmp(type, "imu") == 0) {
-        lastType = TELEMETRY_IMU;
-    } else if (strcmp(type, "status") == 0) {
-        lastType = TELEMETRY_STATUS;
-    } else if (strcmp(type, "alert") == 0) {
-        lastType = TELEMETRY_ALERT;
+    TelemetryMessage msg;
+    TelemetryParseResult r = parseTelemetry(buf, json.length(), msg);
+    if (r != TELEMETRY_PARSE_OK) {
+        Serial.print("JSON parse error: ");
+        Serial.println(TelemetryCodec::resultName(r));
+        return false;
     }
-
     return true;
 }
 
+bool Telemetry::parseBinary(const uint8_t* buf, size_t len) {
+    uint32_t t0 = micros();
+    TelemetryType type;
+    bool ok = TelemetryCodec::decodeBinary(buf, len, type, lastRecord) != 0;
+    countParse(ok ? (uint8_t)type : len ? buf[0] : (uint8_t)TELEMETRY_TYPE_COUNT, ok, len, t0);
+    if (ok) lastType = type;
+    return ok;
+}
+
+const TelemetryParseStats& Telemetry::getParseStats(uint8_t type) const {
+    return stats[type < TELEMETRY_TYPE_COUNT ? type : (uint8_t)TELEMETRY_TYPE_COUNT];
+}
+
 TelemetryType Telemetry::getLastType() {
     return lastType;
 }
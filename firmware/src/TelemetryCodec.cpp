@@ -0,0 +1,901 @@
+/**
+ * @file TelemetryCodec.cpp
+ * @brief Telemetry record schemas and the binary/JSON codecs driven by them
+ */
+
+#include "TelemetryCodec.h"
+
+// Key literals, quotes and colon included
+static constexpr JsonKey K_DEVICE_ID  = JSON_KEY("device_id");
+static constexpr JsonKey K_TIMESTAMP  = JSON_KEY("timestamp");
+static constexpr JsonKey K_TYPE       = JSON_KEY("type");
+static constexpr JsonKey K_BATTERY    = JSON_KEY("battery");
+static constexpr JsonKey K_GPS        = JSON_KEY("gps");
+static constexpr JsonKey K_IMU        = JSON_KEY("imu");
+static constexpr JsonKey K_VALID      = JSON_KEY("valid");
+static constexpr JsonKey K_LAT        = JSON_KEY("lat");
+static constexpr JsonKey K_LON        = JSON_KEY("lon");
+static constexpr JsonKey K_ALT        = JSON_KEY("alt");
+static constexpr JsonKey K_SPEED      = JSON_KEY("speed");
+static constexpr JsonKey K_COURSE     = JSON_KEY("course");
+static constexpr JsonKey K_SATELLITES = JSON_KEY("satellites");
+static constexpr JsonKey K_ACCEL      = JSON_KEY("accel");
+static constexpr JsonKey K_GYRO       = JSON_KEY("gyro");
+static constexpr JsonKey K_X          = JSON_KEY("x");
+static constexpr JsonKey K_Y          = JSON_KEY("y");
+static constexpr JsonKey K_Z          = JSON_KEY("z");
+static constexpr JsonKey K_TEMP       = JSON_KEY("temp");
+static constexpr JsonKey K_UPTIME     = JSON_KEY("uptime");
+static constexpr JsonKey K_RSSI       = JSON_KEY("rssi");
+static constexpr JsonKey K_ALERT_TYPE = JSON_KEY("alert_type");
+static constexpr JsonKey K_MESSAGE    = JSON_KEY("message");
+static constexpr JsonKey K_LEVEL      = JSON_KEY("level");
+static constexpr JsonKey K_MOVING     = JSON_KEY("moving");
+static constexpr JsonKey K_STEPS      = JSON_KEY("steps");
+static constexpr JsonKey K_MEAN       = JSON_KEY("mean");
+static constexpr JsonKey K_STD        = JSON_KEY("std");
+static constexpr JsonKey K_ACCEL_RMS  = JSON_KEY("accel_rms");
+static constexpr JsonKey K_GYRO_RMS   = JSON_KEY("gyro_rms");
+
+// ── Schema tables ────────────────────────────────────────────────────────────
+
+#define FIELD(Rec, member, key, kind, dec, q, grp, sub)                               \
+    FieldDesc{ key, grp, sub, (uint16_t)offsetof(Rec, member),                        \
+               (uint8_t)sizeof(((Rec*)nullptr)->member), kind, dec, q }
+
+// GPS and IMU fields appear both on their own and inside a full record;
+// `path` is the member prefix ("gps." / "imu." or empty).
+#define GPS_FIELDS(Rec, path, grp)                                                    \
+    FIELD(Rec, path valid,      K_VALID,      FIELD_BOOL, 0,   1, grp, nullptr),      \
+    FIELD(Rec, path latE6,      K_LAT,        FIELD_INT,  6,  10, grp, nullptr),      \
+    FIELD(Rec, path lonE6,      K_LON,        FIELD_INT,  6,  10, grp, nullptr),      \
+    FIELD(Rec, path altCm,      K_ALT,        FIELD_INT,  2,  50, grp, nullptr),      \
+    FIELD(Rec, path speedX100,  K_SPEED,      FIELD_UINT, 2,  10, grp, nullptr),      \
+    FIELD(Rec, path courseX100, K_COURSE,     FIELD_UINT, 2, 100, grp, nullptr),      \
+    FIELD(Rec, path satellites, K_SATELLITES, FIELD_UINT, 0,   1, grp, nullptr)
+
+#define IMU_FIELDS(Rec, path, grp)                                                    \
+    FIELD(Rec, path accelMilli[0], K_X,    FIELD_INT, 3, 50, grp, &K_ACCEL),          \
+    FIELD(Rec, path accelMilli[1], K_Y,    FIELD_INT, 3, 50, grp, &K_ACCEL),          \
+    FIELD(Rec, path accelMilli[2], K_Z,    FIELD_INT, 3, 50, grp, &K_ACCEL),          \
+    FIELD(Rec, path gyroMilli[0],  K_X,    FIELD_INT, 3, 10, grp, &K_GYRO),           \
+    FIELD(Rec, path gyroMilli[1],  K_Y,    FIELD_INT, 3, 10, grp, &K_GYRO),           \
+    FIELD(Rec, path gyroMilli[2],  K_Z,    FIELD_INT, 3, 10, grp, &K_GYRO),           \
+    FIELD(Rec, path tempX100,      K_TEMP, FIELD_INT, 2, 10, grp, nullptr)
+
+static constexpr FieldDesc FULL_FIELDS[] = {
+    FIELD(FullRecord, battery, K_BATTERY, FIELD_UINT, 0, 1, nullptr, nullptr),
+    GPS_FIELDS(FullRecord, gps., &K_GPS),
+    IMU_FIELDS(FullRecord, imu., &K_IMU),
+};
+
+static constexpr FieldDesc GPS_ONLY_FIELDS[] = {
+    GPS_FIELDS(GpsRecord, , nullptr),
+};
+
+static constexpr FieldDesc IMU_ONLY_FIELDS[] = {
+    IMU_FIELDS(ImuRecord, , nullptr),
+};
+
+static constexpr FieldDesc STATUS_FIELDS[] = {
+    FIELD(StatusRecord, battery, K_BATTERY, FIELD_UINT, 0, 1, nullptr, nullptr),
+    FIELD(StatusRecord, uptime,  K_UPTIME,  FIELD_UINT, 0, 1, nullptr, nullptr),
+    FIELD(StatusRecord, rssi,    K_RSSI,    FIELD_INT,  0, 1, nullptr, nullptr),
+};
+
+static constexpr FieldDesc ALERT_FIELDS[] = {
+    FIELD(AlertRecord, alertType, K_ALERT_TYPE, FIELD_STRING, 0, 1, nullptr, nullptr),
+    FIELD(AlertRecord, message,   K_MESSAGE,    FIELD_STRING, 0, 1, nullptr, nullptr),
+};
+
+// Accelerations in g (mg with 3 decimals), rates in °/s
+static constexpr FieldDesc MOTION_FIELDS[] = {
+    FIELD(MotionRecord, level,         K_LEVEL,     FIELD_UINT, 0,  1, nullptr, nullptr),
+    FIELD(MotionRecord, moving,        K_MOVING,    FIELD_BOOL, 0,  1, nullptr, nullptr),
+    FIELD(MotionRecord, steps,         K_STEPS,     FIELD_UINT, 0,  1, nullptr, nullptr),
+    FIELD(MotionRecord, meanMg,        K_MEAN,      FIELD_INT,  3,  5, nullptr, nullptr),
+    FIELD(MotionRecord, stdMg,         K_STD,       FIELD_UINT, 3,  5, nullptr, nullptr),
+    FIELD(MotionRecord, accelRmsMg,    K_ACCEL_RMS, FIELD_UINT, 3,  5, nullptr, nullptr),
+    FIELD(MotionRecord, gyroRmsDpsX10, K_GYRO_RMS,  FIELD_UINT, 1, 10, nullptr, nullptr),
+};
+
+/** Numeric members must be 1/2/4 bytes wide and lie inside the record. */
+template <size_t N>
+static constexpr bool fieldsValid(const FieldDesc (&fields)[N], size_t recordSize) {
+    if (N > 32) return false;   // TelemetryMessage::present is a 32-bit mask
+    for (size_t i = 0; i < N; i++) {
+        const FieldDesc& f = fields[i];
+        if (f.offset < sizeof(uint32_t) || f.offset + f.size > recordSize) return false;
+        if (f.kind == FIELD_BOOL && f.size != 1) return false;
+        if ((f.kind == FIELD_UINT || f.kind == FIELD_INT) &&
+            f.size != 1 && f.size != 2 && f.size != 4) return false;
+        if (f.kind == FIELD_STRING && f.size < 2) return false;
+        if (f.quantum == 0) return false;
+    }
+    return true;
+}
+
+template <typename Rec, size_t N>
+static constexpr RecordSchema makeSchema(TelemetryType type, const char* name,
+                                         const FieldDesc (&fields)[N]) {
+    return RecordSchema{ type, name, fields, (uint8_t)N, (uint16_t)sizeof(Rec) };
+}
+
+static_assert(offsetof(FullRecord, timestamp)   == 0 && offsetof(GpsRecord,   timestamp) == 0 &&
+              offsetof(ImuRecord, timestamp)    == 0 && offsetof(StatusRecord, timestamp) == 0 &&
+              offsetof(AlertRecord, timestamp)  == 0 && offsetof(MotionRecord, timestamp) == 0,
+              "records must start with the timestamp");
+static_assert(fieldsValid(FULL_FIELDS,     sizeof(FullRecord)),   "bad full schema");
+static_assert(fieldsValid(GPS_ONLY_FIELDS, sizeof(GpsRecord)),    "bad gps schema");
+static_assert(fieldsValid(IMU_ONLY_FIELDS, sizeof(ImuRecord)),    "bad imu schema");
+static_assert(fieldsValid(STATUS_FIELDS,   sizeof(StatusRecord)), "bad status schema");
+static_assert(fieldsValid(ALERT_FIELDS,    sizeof(AlertRecord)),  "bad alert schema");
+static_assert(fieldsValid(MOTION_FIELDS,   sizeof(MotionRecord)), "bad motion schema");
+
+// Indexed by TelemetryType: the binary tag dispatch
+static constexpr RecordSchema SCHEMAS[TELEMETRY_TYPE_COUNT] = {
+    makeSchema<FullRecord>  (TELEMETRY_FULL,   "full",   FULL_FIELDS),
+    makeSchema<GpsRecord>   (TELEMETRY_GPS,    "gps",    GPS_ONLY_FIELDS),
+    makeSchema<ImuRecord>   (TELEMETRY_IMU,    "imu",    IMU_ONLY_FIELDS),
+    makeSchema<StatusRecord>(TELEMETRY_STATUS, "status", STATUS_FIELDS),
+    makeSchema<AlertRecord> (TELEMETRY_ALERT,  "alert",  ALERT_FIELDS),
+    makeSchema<MotionRecord>(TELEMETRY_MOTION, "motion", MOTION_FIELDS),
+};
+
+static constexpr bool schemasIndexed() {
+    for (uint8_t i = 0; i < TELEMETRY_TYPE_COUNT; i++) {
+        if (SCHEMAS[i].type != i) return false;
+    }
+    return true;
+}
+static_assert(schemasIndexed(), "SCHEMAS must be in TelemetryType order");
+
+// Type names have distinct first letters: one table lookup and one strcmp
+static const int8_t TYPE_BY_INITIAL[26] = {
+    TELEMETRY_ALERT, -1, -1, -1, -1, TELEMETRY_FULL, TELEMETRY_GPS, -1,   // a-h
+    TELEMETRY_IMU,   -1, -1, -1, TELEMETRY_MOTION, -1, -1, -1, -1, -1,    // i-r
+    TELEMETRY_STATUS, -1, -1, -1, -1, -1, -1, -1                          // s-z
+};
+
+// ── Field access ─────────────────────────────────────────────────────────────
+
+static uint32_t loadUInt(const uint8_t* p, uint8_t size) {
+    switch (size) {
+        case 1:  return *p;
+        case 2:  { uint16_t v; memcpy(&v, p, 2); return v; }
+        default: { uint32_t v; memcpy(&v, p, 4); return v; }
+    }
+}
+
+static int32_t loadInt(const uint8_t* p, uint8_t size) {
+    switch (size) {
+        case 1:  return (int8_t)*p;
+        case 2:  { int16_t v; memcpy(&v, p, 2); return v; }
+        default: { int32_t v; memcpy(&v, p, 4); return v; }
+    }
+}
+
+/** Store `v` into a `size`-byte member; false if it does not fit. */
+static bool storeUInt(uint8_t* p, uint8_t size, uint32_t v) {
+    switch (size) {
+        case 1:  if (v > UINT8_MAX)  return false; *p = (uint8_t)v; return true;
+        case 2:  { if (v > UINT16_MAX) return false; uint16_t w = (uint16_t)v; memcpy(p, &w, 2); return true; }
+        default: memcpy(p, &v, 4); return true;
+    }
+}
+
+static bool storeInt(uint8_t* p, uint8_t size, int32_t v) {
+    switch (size) {
+        case 1:  if (v < INT8_MIN || v > INT8_MAX) return false; *p = (uint8_t)(int8_t)v; return true;
+        case 2:  { if (v < INT16_MIN || v > INT16_MAX) return false; int16_t w = (int16_t)v; memcpy(p, &w, 2); return true; }
+        default: memcpy(p, &v, 4); return true;
+    }
+}
+
+// ── Varints ──────────────────────────────────────────────────────────────────
+
+static size_t putVarint(uint8_t* out, size_t pos, size_t cap, uint32_t v) {
+    do {
+        if (pos >= cap) return 0;
+        uint8_t b = v & 0x7F;
+        v >>= 7;
+        out[pos++] = v ? (uint8_t)(b | 0x80) : b;
+    } while (v);
+    return pos;
+}
+
+static size_t getVarint(const uint8_t* in, size_t pos, size_t len, uint32_t& v) {
+    v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (pos >= len) return 0;
+        uint8_t b = in[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return pos;
+    }
+    return 0;   // more than 5 bytes
+}
+
+static inline uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// ── Public API ───────────────────────────────────────────────────────────────
+
+const RecordSchema* TelemetryCodec::schemaFor(uint8_t type) {
+    return type < TELEMETRY_TYPE_COUNT ? &SCHEMAS[type] : nullptr;
+}
+
+static int8_t typeFromSpan(const char* name, size_t len) {
+    if (len == 0) return -1;
+    uint8_t initial = (uint8_t)(name[0] - 'a');
+    if (initial >= 26) return -1;
+    int8_t type = TYPE_BY_INITIAL[initial];
+    if (type < 0) return -1;
+    const char* expect = SCHEMAS[type].name;
+    if (strncmp(name, expect, len) != 0 || expect[len] != '\0') return -1;
+    return type;
+}
+
+int8_t TelemetryCodec::typeFromName(const char* name) {
+    return name ? typeFromSpan(name, strlen(name)) : -1;
+}
+
+size_t TelemetryCodec::encodeBinary(TelemetryType type, const void* record,
+                                    uint8_t* buf, size_t cap) {
+    const RecordSchema* s = schemaFor(type);
+    if (!s || cap == 0) return 0;
+    const uint8_t* rec = (const uint8_t*)record;
+
+    buf[0] = type;
+    size_t pos = putVarint(buf, 1, cap, loadUInt(rec, 4));
+    for (uint8_t i = 0; i < s->fieldCount && pos; i++) {
+        const FieldDesc& f = s->fields[i];
+        const uint8_t*   p = rec + f.offset;
+        switch (f.kind) {
+            case FIELD_BOOL: pos = putVarint(buf, pos, cap, *p ? 1 : 0);                break;
+            case FIELD_UINT: pos = putVarint(buf, pos, cap, loadUInt(p, f.size));      break;
+            case FIELD_INT:  pos = putVarint(buf, pos, cap, zigzag(loadInt(p, f.size))); break;
+            case FIELD_STRING: {
+                size_t n = strnlen((const char*)p, f.size - 1);
+                pos = putVarint(buf, pos, cap, n);
+                if (!pos || pos + n > cap) return 0;
+                memcpy(buf + pos, p, n);
+                pos += n;
+                break;
+            }
+        }
+    }
+    return pos;
+}
+
+size_t TelemetryCodec::decodeBinary(const uint8_t* buf, size_t len, TelemetryType& type,
+                                    TelemetryRecord& out) {
+    if (len < 2) return 0;
+    const RecordSchema* s = schemaFor(buf[0]);
+    if (!s) return 0;
+    uint8_t* rec = (uint8_t*)&out;
+    memset(rec, 0, s->recordSize);
+
+    uint32_t v;
+    size_t   pos = getVarint(buf, 1, len, v);
+    if (!pos) return 0;
+    out.timestamp = v;
+
+    for (uint8_t i = 0; i < s->fieldCount; i++) {
+        const FieldDesc& f = s->fields[i];
+        uint8_t*         p = rec + f.offset;
+        pos = getVarint(buf, pos, len, v);
+        if (!pos) return 0;
+        bool ok = true;
+        switch (f.kind) {
+            case FIELD_BOOL: ok = v <= 1; *p = (uint8_t)v;      break;
+            case FIELD_UINT: ok = storeUInt(p, f.size, v);        break;
+            case FIELD_INT:  ok = storeInt(p, f.size, unzigzag(v)); break;
+            case FIELD_STRING:
+                ok = v < f.size && pos + v <= len;
+                if (ok) {
+                    memcpy(p, buf + pos, v);   // rest of the member is already zero
+                    pos += v;
+                }
+                break;
+        }
+        if (!ok) return 0;
+    }
+    type = s->type;
+    return pos;
+}
+
+bool TelemetryCodec::encodeJson(JsonWriter& w, TelemetryType type, const void* record,
+                                const char* deviceId) {
+    const RecordSchema* s = schemaFor(type);
+    if (!s) return false;
+    const uint8_t* rec = (const uint8_t*)record;
+
+    w.beginObject();
+    w.addString(K_DEVICE_ID, deviceId);
+    w.addUInt(K_TIMESTAMP, loadUInt(rec, 4));
+    w.addString(K_TYPE, s->name);
+
+    // Objects currently open, outermost first
+    const JsonKey* open[2];
+    uint8_t        openDepth = 0;
+
+    for (uint8_t i = 0; i < s->fieldCount; i++) {
+        const FieldDesc& f = s->fields[i];
+
+        const JsonKey* path[2];
+        uint8_t        depth = 0;
+        if (f.group)    path[depth++] = f.group;
+        if (f.subgroup) path[depth++] = f.subgroup;
+
+        uint8_t common = 0;
+        while (common < openDepth && common < depth && open[common] == path[common]) common++;
+        for (; openDepth > common; openDepth--) w.endObject();
+        for (; openDepth < depth; openDepth++) {
+            open[openDepth] = path[openDepth];
+            w.beginObject(*path[openDepth]);
+        }
+
+        const uint8_t* p = rec + f.offset;
+        switch (f.kind) {
+            case FIELD_BOOL:
+                w.addBool(f.key, *p != 0);
+                break;
+            case FIELD_UINT:
+                if (f.decimals) w.addFixed(f.key, (int32_t)loadUInt(p, f.size), f.decimals);
+                else            w.addUInt(f.key, loadUInt(p, f.size));
+                break;
+            case FIELD_INT:
+                if (f.decimals) w.addFixed(f.key, loadInt(p, f.size), f.decimals);
+                else            w.addInt(f.key, loadInt(p, f.size));
+                break;
+            case FIELD_STRING:
+                w.addString(f.key, (const char*)p);
+                break;
+        }
+    }
+    for (; openDepth > 0; openDepth--) w.endObject();
+    w.endObject();
+    return !w.overflowed();
+}
+
+// ── Delta records ────────────────────────────────────────────────────────────
+
+static int64_t loadValue(const uint8_t* p, const FieldDesc& f) {
+    if (f.kind == FIELD_INT) return loadInt(p, f.size);
+    if (f.kind == FIELD_BOOL) return *p != 0;
+    return loadUInt(p, f.size);
+}
+
+/** Store `v` clamped to the member's range; both ends clamp identically. */
+static void storeClamped(uint8_t* p, const FieldDesc& f, int64_t v) {
+    uint8_t bits = (uint8_t)(f.size * 8);
+    int64_t lo, hi;
+    if (f.kind == FIELD_BOOL) {
+        lo = 0;
+        hi = 1;
+    } else if (f.kind == FIELD_INT) {
+        lo = -((int64_t)1 << (bits - 1));
+        hi =  ((int64_t)1 << (bits - 1)) - 1;
+    } else {
+        lo = 0;
+        hi = ((int64_t)1 << bits) - 1;
+    }
+    if (v < lo) v = lo;
+    if (v > hi) v = hi;
+    if (f.kind == FIELD_INT) storeInt(p, f.size, (int32_t)v);
+    else                     storeUInt(p, f.size, (uint32_t)v);
+}
+
+static int64_t roundDiv(int64_t d, uint8_t q) {
+    return d >= 0 ? (d + q / 2) / q : -((-d + q / 2) / q);
+}
+
+size_t TelemetryCodec::encodeDelta(TelemetryType type, void* ref, const void* record,
+                                   uint8_t* buf, size_t cap) {
+    const RecordSchema* s = schemaFor(type);
+    if (!s || cap == 0) return 0;
+
+    // Build the receiver's next state in a copy; commit only if it all fits
+    TelemetryRecord next;
+    memcpy(&next, ref, s->recordSize);
+    uint8_t*       nx  = (uint8_t*)&next;
+    const uint8_t* cur = (const uint8_t*)record;
+
+    uint32_t changed = 0;
+    int32_t  steps[32];
+    for (uint8_t i = 0; i < s->fieldCount; i++) {
+        const FieldDesc& f = s->fields[i];
+        if (f.kind == FIELD_STRING) {
+            if (strncmp((const char*)nx + f.offset, (const char*)cur + f.offset, f.size) != 0) {
+                memcpy(nx + f.offset, cur + f.offset, f.size);
+                changed |= 1UL << i;
+            }
+            continue;
+        }
+        int64_t held = loadValue(nx + f.offset, f);
+        int64_t q    = roundDiv(loadValue(cur + f.offset, f) - held, f.quantum);
+        if (q == 0) continue;
+        if (q > INT32_MAX) q = INT32_MAX;   // the rest follows in the next delta
+        if (q < -INT32_MAX) q = -INT32_MAX;
+        steps[i] = (int32_t)q;
+        storeClamped(nx + f.offset, f, held + q * f.quantum);
+        changed |= 1UL << i;
+    }
+    next.timestamp = ((const TelemetryRecord*)record)->timestamp;
+
+    buf[0] = type;
+    size_t pos = putVarint(buf, 1, cap, next.timestamp - ((TelemetryRecord*)ref)->timestamp);
+    if (pos) pos = putVarint(buf, pos, cap, changed);
+    for (uint8_t i = 0; i < s->fieldCount && pos; i++) {
+        if (!(changed & (1UL << i))) continue;
+        const FieldDesc& f = s->fields[i];
+        if (f.kind != FIELD_STRING) {
+            pos = putVarint(buf, pos, cap, zigzag(steps[i]));
+            continue;
+        }
+        const char* str = (const char*)nx + f.offset;
+        size_t      n   = strnlen(str, f.size - 1);
+        pos = putVarint(buf, pos, cap, n);
+        if (!pos || pos + n > cap) return 0;
+        memcpy(buf + pos, str, n);
+        pos += n;
+    }
+    if (pos) memcpy(ref, &next, s->recordSize);
+    return pos;
+}
+
+size_t TelemetryCodec::applyDelta(TelemetryType type, const uint8_t* buf, size_t len,
+                                  TelemetryRecord& rec) {
+    const RecordSchema* s = schemaFor(type);
+    if (!s || len < 3 || buf[0] != type) return 0;
+
+    TelemetryRecord next;
+    memcpy(&next, &rec, s->recordSize);
+    uint8_t* nx = (uint8_t*)&next;
+
+    uint32_t dt, changed, v;
+    size_t   pos = getVarint(buf, 1, len, dt);
+    if (pos) pos = getVarint(buf, pos, len, changed);
+    if (!pos) return 0;
+    if (s->fieldCount < 32 && (changed >> s->fieldCount)) return 0;
+    next.timestamp += dt;
+
+    for (uint8_t i = 0; i < s->fieldCount; i++) {
+        if (!(changed & (1UL << i))) continue;
+        const FieldDesc& f = s->fields[i];
+        uint8_t*         p = nx + f.offset;
+        pos = getVarint(buf, pos, len, v);
+        if (!pos) return 0;
+        if (f.kind != FIELD_STRING) {
+            storeClamped(p, f, loadValue(p, f) + (int64_t)unzigzag(v) * f.quantum);
+            continue;
+        }
+        if (v >= f.size || pos + v > len) return 0;
+        memset(p, 0, f.size);
+        memcpy(p, buf + pos, v);
+        pos += v;
+    }
+    memcpy(&rec, &next, s->recordSize);
+    return pos;
+}
+
+// ── JSON decoding ────────────────────────────────────────────────────────────
+
+#define JSON_PARSE_MAX_DEPTH 8    // nesting accepted in skipped values
+
+namespace {
+
+struct Cursor {
+    char*       p;
+    const char* end;
+};
+
+struct Span {
+    const char* s;
+    size_t      n;
+};
+
+struct DecodeContext {
+    const RecordSchema* schema;   // nullptr until "type" is known
+    uint32_t            mask;
+    uint8_t             hint;     // field expected next; our own encoder's order
+    TelemetryMessage&   msg;
+};
+
+} // namespace
+
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline bool keyIs(const JsonKey& key, const Span& s) {
+    // key.text is "name": — compare the name part
+    return s.n == (size_t)(key.len - 3) && memcmp(key.text + 1, s.s, s.n) == 0;
+}
+
+static void skipWs(Cursor& c) {
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) c.p++;
+}
+
+static bool consume(Cursor& c, char ch) {
+    skipWs(c);
+    if (c.p >= c.end || *c.p != ch) return false;
+    c.p++;
+    return true;
+}
+
+static bool peek(Cursor& c, char ch) {
+    skipWs(c);
+    return c.p < c.end && *c.p == ch;
+}
+
+/** Read-only scan of a string; `out` is the raw (still escaped) content. */
+static bool scanString(Cursor& c, Span& out) {
+    if (!consume(c, '"')) return false;
+    out.s = c.p;
+    for (; c.p < c.end; c.p++) {
+        uint8_t ch = (uint8_t)*c.p;
+        if (ch == '"') {
+            out.n = (size_t)(c.p++ - out.s);
+            return true;
+        }
+        if (ch < 0x20) return false;
+        if (ch == '\\' && ++c.p >= c.end) return false;
+    }
+    return false;
+}
+
+static int hexValue(char h) {
+    if (isDigit(h))           return h - '0';
+    if (h >= 'a' && h <= 'f') return h - 'a' + 10;
+    if (h >= 'A' && h <= 'F') return h - 'A' + 10;
+    return -1;
+}
+
+/** Unescape a string in place and NUL-terminate it (the output never outgrows the input). */
+static bool parseStringInPlace(Cursor& c, char*& out) {
+    if (!consume(c, '"')) return false;
+    char* w = c.p;
+    out = w;
+    while (c.p < c.end) {
+        char ch = *c.p++;
+        if (ch == '"') {
+            *w = '\0';
+            return true;
+        }
+        if ((uint8_t)ch < 0x20) return false;
+        if (ch != '\\') {
+            *w++ = ch;
+            continue;
+        }
+        if (c.p >= c.end) return false;
+        switch (*c.p++) {
+            case '"':  *w++ = '"';  break;
+            case '\\': *w++ = '\\'; break;
+            case '/':  *w++ = '/';  break;
+            case 'b':  *w++ = '\b'; break;
+            case 'f':  *w++ = '\f'; break;
+            case 'n':  *w++ = '\n'; break;
+            case 'r':  *w++ = '\r'; break;
+            case 't':  *w++ = '\t'; break;
+            case 'u': {
+                if (c.end - c.p < 4) return false;
+                uint32_t cp = 0;
+                for (uint8_t i = 0; i < 4; i++) {
+                    int h = hexValue(*c.p++);
+                    if (h < 0) return false;
+                    cp = (cp << 4) | (uint32_t)h;
+                }
+                if (cp >= 0xD800 && cp <= 0xDFFF) cp = '?';   // no surrogate pairing
+                if (cp < 0x80) {
+                    *w++ = (char)cp;
+                } else if (cp < 0x800) {
+                    *w++ = (char)(0xC0 | (cp >> 6));
+                    *w++ = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    *w++ = (char)(0xE0 | (cp >> 12));
+                    *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *w++ = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+static bool skipValue(Cursor& c, uint8_t depth) {
+    skipWs(c);
+    if (c.p >= c.end || depth > JSON_PARSE_MAX_DEPTH) return false;
+
+    Span s;
+    switch (*c.p) {
+        case '"':
+            return scanString(c, s);
+        case '{':
+            c.p++;
+            if (consume(c, '}')) return true;
+            do {
+                if (!scanString(c, s) || !consume(c, ':') || !skipValue(c, depth + 1)) return false;
+            } while (consume(c, ','));
+            return consume(c, '}');
+        case '[':
+            c.p++;
+            if (consume(c, ']')) return true;
+            do {
+                if (!skipValue(c, depth + 1)) return false;
+            } while (consume(c, ','));
+            return consume(c, ']');
+        default: {
+            // Number or literal
+            const char* start = c.p;
+            while (c.p < c.end && (isalnum((uint8_t)*c.p) || *c.p == '-' || *c.p == '+' || *c.p == '.')) c.p++;
+            return c.p > start;
+        }
+    }
+}
+
+static bool parseLiteral(Cursor& c, const char* word) {
+    size_t n = strlen(word);
+    if ((size_t)(c.end - c.p) < n || memcmp(c.p, word, n) != 0) return false;
+    if (c.p + n < c.end && isalnum((uint8_t)c.p[n])) return false;
+    c.p += n;
+    return true;
+}
+
+/** Parse a number scaled by 10^decimals, rounded half away from zero. */
+static bool parseScaled(Cursor& c, uint8_t decimals, int64_t& out) {
+    skipWs(c);
+    const char* start = c.p;
+    bool neg = c.p < c.end && *c.p == '-';
+    if (neg) c.p++;
+    if (c.p >= c.end || !isDigit(*c.p)) return false;
+
+    int64_t v      = 0;
+    uint8_t digits = 0;
+    while (c.p < c.end && isDigit(*c.p)) {
+        if (++digits + decimals > 18) return false;
+        v = v * 10 + (*c.p++ - '0');
+    }
+
+    uint8_t kept    = 0;
+    bool    roundUp = false;
+    if (c.p < c.end && *c.p == '.') {
+        c.p++;
+        if (c.p >= c.end || !isDigit(*c.p)) return false;
+        bool first = true;
+        for (; c.p < c.end && isDigit(*c.p); c.p++) {
+            if (kept < decimals) {
+                v = v * 10 + (*c.p - '0');
+                kept++;
+            } else if (first) {
+                roundUp = *c.p >= '5';
+                first   = false;
+            }
+        }
+    }
+
+    if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+        // Rare in telemetry: fall back to strtod on a bounded copy
+        c.p++;
+        if (c.p < c.end && (*c.p == '+' || *c.p == '-')) c.p++;
+        if (c.p >= c.end || !isDigit(*c.p)) return false;
+        while (c.p < c.end && isDigit(*c.p)) c.p++;
+        char   tmp[32];
+        size_t n = (size_t)(c.p - start);
+        if (n >= sizeof(tmp)) return false;
+        memcpy(tmp, start, n);
+        tmp[n] = '\0';
+        double d = strtod(tmp, nullptr);
+        for (uint8_t i = 0; i < decimals; i++) d *= 10.0;
+        if (!(d > -9e15 && d < 9e15)) return false;
+        out = llround(d);
+        return true;
+    }
+
+    for (; kept < decimals; kept++) v *= 10;
+    if (roundUp) v++;
+    out = neg ? -v : v;
+    return true;
+}
+
+/** Effective object path of a field (group/subgroup with the nulls dropped). */
+static uint8_t fieldPath(const FieldDesc& f, const JsonKey* path[2]) {
+    uint8_t depth = 0;
+    if (f.group)    path[depth++] = f.group;
+    if (f.subgroup) path[depth++] = f.subgroup;
+    return depth;
+}
+
+static bool pathIs(const FieldDesc& f, const JsonKey* const path[2], uint8_t depth) {
+    const JsonKey* fp[2];
+    if (fieldPath(f, fp) != depth) return false;
+    for (uint8_t i = 0; i < depth; i++) {
+        if (fp[i] != path[i]) return false;
+    }
+    return true;
+}
+
+static int8_t findField(const DecodeContext& ctx, const JsonKey* const path[2], uint8_t depth,
+                        const Span& key) {
+    const RecordSchema& s = *ctx.schema;
+    if (ctx.hint < s.fieldCount) {
+        const FieldDesc& f = s.fields[ctx.hint];
+        if (keyIs(f.key, key) && pathIs(f, path, depth)) return (int8_t)ctx.hint;
+    }
+    for (uint8_t i = 0; i < s.fieldCount; i++) {
+        const FieldDesc& f = s.fields[i];
+        if (keyIs(f.key, key) && pathIs(f, path, depth)) return (int8_t)i;
+    }
+    return -1;
+}
+
+/** Is `key` at `path` an object that contains schema fields? */
+static const JsonKey* findGroup(const DecodeContext& ctx, const JsonKey* const path[2],
+                                uint8_t depth, const Span& key) {
+    const RecordSchema& s = *ctx.schema;
+    for (uint8_t i = 0; i < s.fieldCount; i++) {
+        const JsonKey* fp[2];
+        uint8_t        fd = fieldPath(s.fields[i], fp);
+        if (fd <= depth || !keyIs(*fp[depth], key)) continue;
+        bool same = true;
+        for (uint8_t j = 0; j < depth; j++) same = same && fp[j] == path[j];
+        if (same) return fp[depth];
+    }
+    return nullptr;
+}
+
+/**
+ * "type" has not been seen yet but a schema field has: scan the rest of the
+ * top-level object, read-only, for it.  Our own encoder always writes the
+ * type first, so this only runs for foreign packets.
+ */
+static bool lookaheadType(Cursor c, Span& type) {
+    if (!skipValue(c, 1)) return false;
+    while (consume(c, ',')) {
+        Span key;
+        if (!scanString(c, key) || !consume(c, ':')) return false;
+        if (keyIs(K_TYPE, key)) return scanString(c, type);
+        if (!skipValue(c, 1)) return false;
+    }
+    return false;
+}
+
+static TelemetryParseResult setType(DecodeContext& ctx, const Span& name) {
+    int8_t type = typeFromSpan(name.s, name.n);
+    if (type < 0) return TELEMETRY_PARSE_UNKNOWN_TYPE;
+    if (ctx.schema && ctx.schema->type != type) return TELEMETRY_PARSE_UNKNOWN_TYPE;
+    ctx.schema   = &SCHEMAS[type];
+    ctx.msg.type = (TelemetryType)type;
+    return TELEMETRY_PARSE_OK;
+}
+
+static TelemetryParseResult decodeField(Cursor& c, const FieldDesc& f, uint8_t* rec) {
+    uint8_t* p = rec + f.offset;
+    int64_t  v;
+    switch (f.kind) {
+        case FIELD_BOOL:
+            if      (parseLiteral(c, "true"))  *p = 1;
+            else if (parseLiteral(c, "false")) *p = 0;
+            else return TELEMETRY_PARSE_BAD_VALUE;
+            return TELEMETRY_PARSE_OK;
+        case FIELD_UINT:
+            if (!parseScaled(c, f.decimals, v) || v < 0 || v > (int64_t)UINT32_MAX ||
+                !storeUInt(p, f.size, (uint32_t)v)) return TELEMETRY_PARSE_BAD_VALUE;
+            return TELEMETRY_PARSE_OK;
+        case FIELD_INT:
+            if (!parseScaled(c, f.decimals, v) || v < INT32_MIN || v > INT32_MAX ||
+                !storeInt(p, f.size, (int32_t)v)) return TELEMETRY_PARSE_BAD_VALUE;
+            return TELEMETRY_PARSE_OK;
+        case FIELD_STRING: {
+            char* s;
+            if (!peek(c, '"')) return TELEMETRY_PARSE_BAD_VALUE;
+            if (!parseStringInPlace(c, s)) return TELEMETRY_PARSE_SYNTAX;
+            // Truncate like the encoder side does
+            size_t n = strnlen(s, f.size - 1);
+            memcpy(p, s, n);
+            p[n] = '\0';
+            return TELEMETRY_PARSE_OK;
+        }
+    }
+    return TELEMETRY_PARSE_BAD_VALUE;
+}
+
+/** Members of an object whose '{' has been consumed. */
+static TelemetryParseResult parseMembers(DecodeContext& ctx, Cursor& c,
+                                         const JsonKey* path[2], uint8_t depth) {
+    TelemetryMessage& msg = ctx.msg;
+    uint8_t*          rec = (uint8_t*)&msg.record;
+    TelemetryParseResult r;
+
+    if (consume(c, '}')) return TELEMETRY_PARSE_OK;
+    do {
+        Span key;
+        if (!scanString(c, key) || !consume(c, ':')) return TELEMETRY_PARSE_SYNTAX;
+        skipWs(c);
+        bool isNull = parseLiteral(c, "null");
+
+        if (isNull) {
+            // Treated as absent
+        } else if (depth == 0 && keyIs(K_DEVICE_ID, key)) {
+            char* id;
+            if (!peek(c, '"')) return TELEMETRY_PARSE_BAD_VALUE;
+            if (!parseStringInPlace(c, id)) return TELEMETRY_PARSE_SYNTAX;
+            msg.deviceId = id;
+        } else if (depth == 0 && keyIs(K_TIMESTAMP, key)) {
+            int64_t v;
+            if (!parseScaled(c, 0, v) || v < 0 || v > (int64_t)UINT32_MAX) return TELEMETRY_PARSE_BAD_VALUE;
+            msg.record.timestamp = (uint32_t)v;
+        } else if (depth == 0 && keyIs(K_TYPE, key)) {
+            Span name;
+            if (!scanString(c, name)) return TELEMETRY_PARSE_NO_TYPE;
+            if ((r = setType(ctx, name)) != TELEMETRY_PARSE_OK) return r;
+        } else {
+            if (!ctx.schema) {
+                Span name;
+                if (!lookaheadType(c, name)) return TELEMETRY_PARSE_NO_TYPE;
+                if ((r = setType(ctx, name)) != TELEMETRY_PARSE_OK) return r;
+            }
+
+            const JsonKey* group = depth < 2 && peek(c, '{') ? findGroup(ctx, path, depth, key) : nullptr;
+            int8_t         idx   = group ? -1 : findField(ctx, path, depth, key);
+            if (group) {
+                c.p++;
+                path[depth] = group;
+                if ((r = parseMembers(ctx, c, path, depth + 1)) != TELEMETRY_PARSE_OK) return r;
+            } else if (idx >= 0 && (ctx.mask & (1UL << idx))) {
+                if ((r = decodeField(c, ctx.schema->fields[idx], rec)) != TELEMETRY_PARSE_OK) return r;
+                msg.present |= 1UL << idx;
+                ctx.hint = (uint8_t)(idx + 1);
+            } else if (!skipValue(c, depth + 1)) {
+                return TELEMETRY_PARSE_SYNTAX;
+            }
+        }
+    } while (consume(c, ','));
+
+    return consume(c, '}') ? TELEMETRY_PARSE_OK : TELEMETRY_PARSE_SYNTAX;
+}
+
+TelemetryParseResult TelemetryCodec::decodeJson(char* json, size_t len, uint32_t fieldMask,
+                                                TelemetryMessage& msg) {
+    memset(&msg, 0, sizeof(msg));
+    msg.type = TELEMETRY_TYPE_COUNT;
+    if (!json) return TELEMETRY_PARSE_SYNTAX;
+
+    Cursor         c   = { json, json + len };
+    DecodeContext  ctx = { nullptr, fieldMask, 0, msg };
+    const JsonKey* path[2] = { nullptr, nullptr };
+
+    if (!consume(c, '{')) return TELEMETRY_PARSE_SYNTAX;
+    TelemetryParseResult r = parseMembers(ctx, c, path, 0);
+    if (r != TELEMETRY_PARSE_OK) return r;
+    if (!ctx.schema) return TELEMETRY_PARSE_NO_TYPE;
+
+    skipWs(c);
+    if (c.p < c.end && *c.p != '\0') return TELEMETRY_PARSE_SYNTAX;   // trailing garbage
+    return TELEMETRY_PARSE_OK;
+}
+
+uint32_t TelemetryCodec::fieldMask(TelemetryType type, const char* const* names, uint8_t count) {
+    const RecordSchema* s = schemaFor(type);
+    if (!s) return 0;
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < s->fieldCount; i++) {
+        for (uint8_t j = 0; j < count; j++) {
+            Span name = { names[j], strlen(names[j]) };
+            if (keyIs(s->fields[i].key, name)) mask |= 1UL << i;
+        }
+    }
+    return mask;
+}
+
+const char* TelemetryCodec::resultName(TelemetryParseResult result) {
+    switch (result) {
+        case TELEMETRY_PARSE_OK:           return "ok";
+        case TELEMETRY_PARSE_SYNTAX:       return "syntax error";
+        case TELEMETRY_PARSE_NO_TYPE:      return "missing type";
+        case TELEMETRY_PARSE_UNKNOWN_TYPE: return "unknown type";
+        case TELEMETRY_PARSE_BAD_VALUE:    return "bad value";
+    }
+    return "?";
+}
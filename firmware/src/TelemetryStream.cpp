@@ -0,0 +1,122 @@
+/**
+ * @file TelemetryStream.cpp
+ * @brief Keyframe/delta scheduling and receiver-side resync
+ */
+
+#include "TelemetryStream.h"
+
+// ── Encoder ──────────────────────────────────────────────────────────────────
+
+TelemetryStreamEncoder::TelemetryStreamEncoder(uint8_t keyframeInterval)
+    : interval(keyframeInterval ? keyframeInterval : 1), keyframes(0), deltas(0), bytes(0) {
+    memset(state, 0, sizeof(state));
+}
+
+void TelemetryStreamEncoder::requestKeyframe(TelemetryType type) {
+    if (type < TELEMETRY_TYPE_COUNT) state[type].valid = false;
+}
+
+size_t TelemetryStreamEncoder::encode(TelemetryType type, const void* record,
+                                      uint8_t* buf, size_t cap) {
+    const RecordSchema* s = TelemetryCodec::schemaFor(type);
+    if (!s || cap < 3) return 0;
+    TypeState& st = state[type];
+
+    uint8_t seq = (uint8_t)(st.seq + 1);
+    buf[1] = seq;
+
+    size_t n = 0;
+    if (st.valid && st.sinceKey + 1 < interval) {
+        n = TelemetryCodec::encodeDelta(type, &st.ref, record, buf + 2, cap - 2);
+        if (!n) return 0;
+        buf[0] = STREAM_DELTA;
+        st.sinceKey++;
+        deltas++;
+    } else {
+        n = TelemetryCodec::encodeBinary(type, record, buf + 2, cap - 2);
+        if (!n) return 0;
+        buf[0] = STREAM_KEYFRAME;
+        memcpy(&st.ref, record, s->recordSize);
+        st.sinceKey = 0;
+        st.valid    = true;
+        keyframes++;
+    }
+    st.seq = seq;
+    bytes += n + 2;
+    return n + 2;
+}
+
+// ── Decoder ──────────────────────────────────────────────────────────────────
+
+TelemetryStreamDecoder::TelemetryStreamDecoder() : gaps(0), resyncs(0) {
+    memset(sources, 0, sizeof(sources));
+}
+
+TelemetryStreamDecoder::Source& TelemetryStreamDecoder::sourceFor(uint16_t addr, uint32_t now) {
+    Source* slot = &sources[0];
+    for (uint8_t i = 0; i < TELEMETRY_STREAM_SOURCES; i++) {
+        Source& s = sources[i];
+        if (s.used && s.addr == addr) {
+            slot = &s;
+            break;
+        }
+        if (!s.used) {
+            if (slot->used) slot = &s;
+        } else if (slot->used && now - s.lastHeard > now - slot->lastHeard) {
+            slot = &s;
+        }
+    }
+    if (!slot->used || slot->addr != addr) {
+        memset(slot, 0, sizeof(*slot));
+        slot->addr = addr;
+        slot->used = true;
+    }
+    slot->lastHeard = now;
+    return *slot;
+}
+
+TelemetryStreamResult TelemetryStreamDecoder::lostSync(TypeState& ts, uint32_t now) {
+    ts.valid = false;
+    if (ts.requested && now - ts.requestedAt < TELEMETRY_RESYNC_RETRY_MS) return STREAM_WAITING;
+    ts.requested   = true;
+    ts.requestedAt = now;
+    resyncs++;
+    return STREAM_RESYNC;
+}
+
+TelemetryStreamResult TelemetryStreamDecoder::decode(uint16_t src, const uint8_t* buf, size_t len,
+                                                     uint32_t now, TelemetryType& type,
+                                                     TelemetryRecord& out) {
+    if (len < 3 || buf[2] >= TELEMETRY_TYPE_COUNT) return STREAM_MALFORMED;
+    type = (TelemetryType)buf[2];
+
+    Source&    source = sourceFor(src, now);
+    TypeState& ts     = source.types[type];
+    uint8_t    seq    = buf[1];
+
+    if (buf[0] == STREAM_KEYFRAME) {
+        TelemetryType decoded;
+        if (!TelemetryCodec::decodeBinary(buf + 2, len - 2, decoded, ts.rec)) {
+            ts.valid = false;
+            return STREAM_MALFORMED;
+        }
+        ts.valid     = true;
+        ts.requested = false;
+    } else if (buf[0] == STREAM_DELTA) {
+        if (!ts.valid) return lostSync(ts, now);
+        if (seq != (uint8_t)(ts.seq + 1)) {
+            gaps++;
+            return lostSync(ts, now);
+        }
+        if (!TelemetryCodec::applyDelta(type, buf + 2, len - 2, ts.rec)) {
+            // Reference state is intact but this update is lost: same as a gap
+            return lostSync(ts, now);
+        }
+    } else {
+        return STREAM_MALFORMED;
+    }
+
+    ts.seq = seq;
+    memcpy(&out, &ts.rec, sizeof(out));
+    return STREAM_OK;
+}
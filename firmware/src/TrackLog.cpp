@@ -0,0 +1,223 @@
+/**
+ * @file TrackLog.cpp
+ * @brief Opening-window track simplification and compact track encoding
+ */
+
+#include "TrackLog.h"
+#include "FixedMath.h"
+
+// ── Varint helpers (LEB128, zigzag for signed) ─────────────────────────────
+
+static uint8_t putVarint(uint8_t* p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ── TrackLog ──────────────────────────────────────────────────────────────────
+
+TrackLog::TrackLog(uint32_t toleranceMm) : toleranceMm(toleranceMm) {
+    clear();
+}
+
+void TrackLog::clear() {
+    head = count = 0;
+    totalKept = totalInput = overwritten = 0;
+    haveAnchor   = false;
+    anchorCosQ15 = FM_Q15_ONE - 1;
+    windowLen    = 0;
+    memset(&anchor, 0, sizeof(anchor));
+}
+
+void TrackLog::keep(const TrackPoint& p) {
+    ring[head] = p;
+    head = (uint16_t)((head + 1) % TRACK_CAPACITY);
+    if (count < TRACK_CAPACITY) count++;
+    else                        overwritten++;
+    totalKept++;
+}
+
+void TrackLog::restartWindow(const TrackPoint& newAnchor) {
+    anchor       = newAnchor;
+    anchorCosQ15 = FixedMath::cosLatQ15(newAnchor.latE6);
+    windowLen    = 0;
+}
+
+/**
+ * True if every pending fix lies within toleranceMm of the segment from the
+ * anchor (origin) to the candidate end point (eastMm, northMm).  Distances
+ * are to the segment, not the infinite line, so an out-and-back excursion
+ * is never folded away.
+ */
+bool TrackLog::windowFits(int32_t eastMm, int32_t northMm) const {
+    int64_t  lenSq = (int64_t)eastMm * eastMm + (int64_t)northMm * northMm;
+    int64_t  tolSq = (int64_t)toleranceMm * toleranceMm;
+    uint64_t tolLen = (uint64_t)toleranceMm * FixedMath::isqrt64((uint64_t)lenSq);
+
+    for (uint8_t i = 0; i < windowLen; i++) {
+        int64_t pe  = window[i].eastMm;
+        int64_t pn  = window[i].northMm;
+        int64_t dot = pe * eastMm + pn * northMm;
+
+        if (lenSq == 0 || dot <= 0) {
+            if (pe * pe + pn * pn > tolSq) return false;
+        } else if (dot >= lenSq) {
+            int64_t de = pe - eastMm;
+            int64_t dn = pn - northMm;
+            if (de * de + dn * dn > tolSq) return false;
+        } else {
+            int64_t cross = pe * northMm - pn * eastMm;
+            if (cross < 0) cross = -cross;
+            if ((uint64_t)cross > tolLen) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Drop pending fixes within toleranceMm of the anchor: a segment starting
+ * at the anchor passes within that distance of them whatever its end, so
+ * they no longer constrain the line.  A parked unit's window empties here.
+ * @return true if any were dropped
+ */
+bool TrackLog::collapseWindow() {
+    int64_t tolSq = (int64_t)toleranceMm * toleranceMm;
+    uint8_t kept  = 0;
+    for (uint8_t i = 0; i < windowLen; i++) {
+        int64_t pe = window[i].eastMm;
+        int64_t pn = window[i].northMm;
+        if (pe * pe + pn * pn > tolSq) window[kept++] = window[i];
+    }
+    bool dropped = kept < windowLen;
+    windowLen = kept;
+    return dropped;
+}
+
+void TrackLog::add(int32_t latE6, int32_t lonE6, uint32_t timestamp) {
+    totalInput++;
+    TrackPoint p = { latE6, lonE6, timestamp };
+
+    if (!haveAnchor) {
+        keep(p);
+        restartWindow(p);
+        haveAnchor = true;
+        return;
+    }
+
+    int32_t e, n;
+    FixedMath::toLocalMm(latE6, lonE6, anchor.latE6, anchor.lonE6, anchorCosQ15, e, n);
+
+    if (windowLen > 0 &&
+        (!windowFits(e, n) || (windowLen >= TRACK_WINDOW && !collapseWindow()))) {
+        // The newest fix breaks the line: the previous fix becomes a vertex.
+        TrackPoint vertex = window[windowLen - 1].p;
+        keep(vertex);
+        restartWindow(vertex);
+        FixedMath::toLocalMm(latE6, lonE6, anchor.latE6, anchor.lonE6, anchorCosQ15, e, n);
+    }
+
+    window[windowLen].p       = p;
+    window[windowLen].eastMm  = e;
+    window[windowLen].northMm = n;
+    windowLen++;
+}
+
+void TrackLog::flush() {
+    if (windowLen == 0) return;
+    TrackPoint last = window[windowLen - 1].p;
+    keep(last);
+    restartWindow(last);
+}
+
+bool TrackLog::getBySeq(uint32_t seq, TrackPoint& out) const {
+    if (seq < oldestSeq() || seq >= totalKept) return false;
+    uint32_t offset = seq - oldestSeq();
+    out = ring[(head + TRACK_CAPACITY - count + offset) % TRACK_CAPACITY];
+    return true;
+}
+
+size_t TrackLog::encodeCompact(uint32_t fromSeq, uint8_t* buf, size_t cap,
+                               uint16_t& encoded) const {
+    encoded = 0;
+    if (fromSeq < oldestSeq()) fromSeq = oldestSeq();
+
+    TrackPoint prev;
+    if (cap < 13 || !getBySeq(fromSeq, prev)) return 0;
+
+    putU32(buf + 1, prev.timestamp);
+    putU32(buf + 5, (uint32_t)prev.latE6);
+    putU32(buf + 9, (uint32_t)prev.lonE6);
+    size_t len = 13;
+    encoded = 1;
+
+    TrackPoint p;
+    uint8_t    tmp[15];
+    while (encoded < 255 && getBySeq(fromSeq + encoded, p)) {
+        uint8_t n = 0;
+        n += putVarint(tmp + n, zigzag(p.latE6 - prev.latE6));
+        n += putVarint(tmp + n, zigzag(p.lonE6 - prev.lonE6));
+        n += putVarint(tmp + n, p.timestamp - prev.timestamp);
+        if (len + n > cap) break;
+        memcpy(buf + len, tmp, n);
+        len += n;
+        encoded++;
+        prev = p;
+    }
+    buf[0] = (uint8_t)encoded;
+    return len;
+}
+
+int TrackLog::decodeCompact(const uint8_t* buf, size_t len,
+                            TrackPoint* out, uint16_t maxPoints) {
+    if (len < 13) return -1;
+    const uint8_t* end = buf + len;
+    uint8_t total = buf[0];
+
+    TrackPoint p;
+    p.timestamp = getU32(buf + 1);
+    p.latE6     = (int32_t)getU32(buf + 5);
+    p.lonE6     = (int32_t)getU32(buf + 9);
+    const uint8_t* cur = buf + 13;
+
+    int written = 0;
+    for (uint16_t i = 0; i < total; i++) {
+        if (i > 0) {
+            uint32_t dLat, dLon, dt;
+            if (!getVarint(cur, end, dLat) || !getVarint(cur, end, dLon) ||
+                !getVarint(cur, end, dt)) {
+                return -1;
+            }
+            p.latE6     += unzigzag(dLat);
+            p.lonE6     += unzigzag(dLon);
+            p.timestamp += dt;
+        }
+        if (written < maxPoints) out[written++] = p;
+    }
+    return written;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file TxPolicy.cpp
+ * @brief Dead-band transmit policy implementation
+ */
+
+#include "TxPolicy.h"
+#include "FixedMath.h"
+
+// Default bands: parked / walking / driving / fast.
+static const SpeedBand DEFAULT_BANDS[] = {
+    //  < km/h*10   threshold    keepalive
+    {     10,        15000,      300000 },   // < 1 km/h   : 15 m, 5 min
+    {     80,        10000,       60000 },   // < 8 km/h   : 10 m, 1 min
+    {    500,        25000,       30000 },   // < 50 km/h  : 25 m, 30 s
+    {  65535,        50000,       15000 },   // faster     : 50 m, 15 s
+};
+
+TxPolicy::TxPolicy() : bandCount(0), keepaliveCapMs(0), haveSent(false), lastDeviationMm(0) {
+    memset(&last, 0, sizeof(last));
+    memset(counts, 0, sizeof(counts));
+    setBands(DEFAULT_BANDS, sizeof(DEFAULT_BANDS) / sizeof(DEFAULT_BANDS[0]));
+}
+
+void TxPolicy::setBands(const SpeedBand* newBands, uint8_t count) {
+    if (!newBands || count == 0) return;
+    if (count > TX_POLICY_MAX_BANDS) count = TX_POLICY_MAX_BANDS;
+    memcpy(bands, newBands, count * sizeof(SpeedBand));
+    bandCount = count;
+}
+
+const SpeedBand& TxPolicy::bandFor(float speedKmh) const {
+    uint32_t kmhX10 = speedKmh > 0 ? (uint32_t)(speedKmh * 10.0f) : 0;
+    for (uint8_t i = 0; i < bandCount; i++) {
+        if (kmhX10 < bands[i].maxSpeedKmhX10) return bands[i];
+    }
+    return bands[bandCount - 1];
+}
+
+void TxPolicy::extrapolate(int32_t latE6, int32_t lonE6,
+                           uint16_t speedKmhX10, uint16_t courseDeg,
+                           uint32_t dtMs,
+                           int32_t& outLatE6, int32_t& outLonE6) {
+    if (speedKmhX10 == 0 || dtMs == 0) {
+        outLatE6 = latE6;
+        outLonE6 = lonE6;
+        return;
+    }
+    // km/h*10 → mm/s is ×(1e6 / 36000)
+    int64_t  distMm = (int64_t)speedKmhX10 * 1000000LL / 36000 * dtMs / 1000;
+    uint16_t bam    = (uint16_t)(((uint32_t)courseDeg % 360) * 65536UL / 360);
+    int32_t  east   = (int32_t)((distMm * FixedMath::sinQ15(bam)) >> 15);
+    int32_t  north  = (int32_t)((distMm * FixedMath::cosQ15(bam)) >> 15);
+    FixedMath::fromLocalMm(east, north, latE6, lonE6,
+                           FixedMath::cosLatQ15(latE6), outLatE6, outLonE6);
+}
+
+bool TxPolicy::predictReceiver(uint32_t now, int32_t& latE6, int32_t& lonE6) const {
+    if (!haveSent || !last.valid) return false;
+    extrapolate(last.latE6, last.lonE6, last.speedKmhX10, last.courseDeg,
+                now - last.sentAt, latE6, lonE6);
+    return true;
+}
+
+TxReason TxPolicy::evaluate(int32_t latE6, int32_t lonE6, const GPSData& fix, uint32_t now) {
+    if (!haveSent)                  return tally(TX_FIRST);
+
+    uint32_t sinceLast = now - last.sentAt;
+    if (sinceLast < TX_MIN_INTERVAL_MS) return tally(TX_SUPPRESSED);
+    if (fix.valid != last.valid)    return tally(TX_FIX_CHANGE);
+
+    if (!fix.valid) {
+        uint32_t keepalive = TX_NOFIX_KEEPALIVE_MS;
+        if (keepaliveCapMs && keepalive > keepaliveCapMs) keepalive = keepaliveCapMs;
+        return tally(sinceLast >= keepalive ? TX_KEEPALIVE : TX_SUPPRESSED);
+    }
+
+    const SpeedBand& band = bandFor(fix.speed);
+
+    int32_t predLat, predLon;
+    predictReceiver(now, predLat, predLon);
+    int64_t devSq   = FixedMath::distanceSqMm(predLat, predLon, latE6, lonE6);
+    lastDeviationMm = FixedMath::isqrt64((uint64_t)devSq);
+
+    if (devSq > (int64_t)band.thresholdMm * band.thresholdMm) return tally(TX_DEVIATION);
+    uint32_t keepalive = band.keepaliveMs;
+    if (keepaliveCapMs && keepalive > keepaliveCapMs) keepalive = keepaliveCapMs;
+    if (sinceLast >= keepalive)                               return tally(TX_KEEPALIVE);
+    return tally(TX_SUPPRESSED);
+}
+
+void TxPolicy::markSent(const TxSnapshot& sent) {
+    last     = sent;
+    haveSent = true;
+}
+
+uint32_t TxPolicy::getSentCount() const {
+    uint32_t n = 0;
+    for (uint8_t r = TX_FIRST; r < TX_REASON_COUNT; r++) n += counts[r];
+    return n;
+}
+
+const char* TxPolicy::reasonName(TxReason r) {
+    switch (r) {
+        case TX_SUPPRESSED: return "suppressed";
+        case TX_FIRST:      return "first";
+        case TX_DEVIATION:  return "deviation";
+        case TX_KEEPALIVE:  return "keepalive";
+        case TX_FIX_CHANGE: return "fix-change";
+        default:            return "?";
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * @file UIScheduler.cpp
+ * @brief Per-screen refresh policies and render budgeting
+ */
+
+#include "UIScheduler.h"
+
+UIScheduler::UIScheduler()
+    : count(0), current(0), forced(true), lastRender(0), deferring(false),
+      deferStart(0), budgetUs(UI_RENDER_BUDGET_US), renders(0), deferrals(0) {
+    memset(policies, 0, sizeof(policies));
+    memset(dirty, 0, sizeof(dirty));
+    memset(costUs, 0, sizeof(costUs));
+}
+
+void UIScheduler::setPolicies(const ScreenPolicy* p, uint8_t n) {
+    if (n > UI_MAX_SCREENS) n = UI_MAX_SCREENS;
+    memcpy(policies, p, n * sizeof(ScreenPolicy));
+    count = n;
+    if (current >= count) current = 0;
+}
+
+void UIScheduler::show(uint8_t screen) {
+    if (screen >= count) return;
+    current = screen;
+    forced  = true;
+}
+
+void UIScheduler::notify(uint8_t screen) {
+    if (screen < count) dirty[screen] = true;
+}
+
+bool UIScheduler::due(uint32_t nowMs, uint32_t loopElapsedUs) {
+    if (count == 0) return false;
+    if (forced) return true;   // screen switch: the user is waiting
+
+    const ScreenPolicy& p = policies[current];
+    bool want = false;
+    switch (p.policy) {
+        case REFRESH_PERIODIC:  want = nowMs - lastRender >= p.intervalMs;                   break;
+        case REFRESH_ON_CHANGE: want = dirty[current] && nowMs - lastRender >= p.intervalMs; break;
+        case REFRESH_ON_EVENT:  want = dirty[current];                                       break;
+    }
+    if (!want) {
+        deferring = false;
+        return false;
+    }
+
+    if (loopElapsedUs + costUs[current] > budgetUs) {
+        if (!deferring) {
+            deferring  = true;
+            deferStart = nowMs;
+        }
+        if (nowMs - deferStart < UI_MAX_DEFER_MS) {
+            deferrals++;
+            return false;
+        }
+    }
+    return true;
+}
+
+void UIScheduler::rendered(uint32_t nowMs, uint32_t cost) {
+    // Running average, weight 1/4 on the newest render
+    uint32_t& est = costUs[current];
+    est = est == 0 ? cost : (est * 3 + cost) / 4;
+
+    dirty[current] = false;
+    forced         = false;
+    deferring      = false;
+    lastRender     = nowMs;
+    renders++;
+}
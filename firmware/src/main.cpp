@@ -9,17 +9,42 @@
  *   GP14              — RYLR896 NRESET
  *   GP15              — GPS PPS (1 Hz rising edge)
  *   GP16              — Push-button (INPUT_PULLUP, active LOW)
+ *   I2C1  (GP6/GP7)   — MPU6050 IMU (FIFO sampling, optional)
+ *   GP17              — MPU6050 INT (wake-on-motion, rising edge)
  *   VSYS (pin 39/40)  — 5V input power
  *   Pin 36 (3V3 OUT)  — 3.3V rail for all peripherals
  *
- * Build flags (platformio.ini):
+ * Identity: this unit's LoRa address and the unit it reports to are
+ *   runtime settings (DeviceConfig).  The build flags below only seed them
+ *   on a unit's first boot, so one image serves every unit afterwards:
  *   -D DEVICE_ADDRESS=1   (beacon)
  *   -D TARGET_ADDRESS=2   (relay/other unit)
- *   Swap values on the second unit.
+ *   Swap values for the first flash of the second unit.
  *
- * Button: short press cycles GPS screen → Radio screen → GPS screen.
- * LoRa:   every HEARTBEAT_INTERVAL ms, sends a GPS payload to TARGET_ADDRESS.
- *         Incoming packets are displayed on the radio screen.
+ * Button: short press cycles GPS → Radio → Radar → Link quality screen.
+ * LoRa:   every txCheckInterval ms, TxPolicy decides whether a GPS payload
+ *         must go to the target unit (deviation from what the receiver can
+ *         extrapolate, or a speed-dependent keepalive).
+ *         Incoming packets are displayed on the radio screen; heartbeats
+ *         update the peer table plotted on the radar screen.
+ *         A full GPS record (altitude, satellites, validity) follows every
+ *         TELEMETRY_STREAM_INTERVAL as a keyframe/delta stream; a receiver
+ *         that loses sync asks for a keyframe with FRAME_TELEMETRY_RESYNC.
+ * Log:    every GPS fix and geofence alert is also appended to FlashLog;
+ *         whatever was recorded while the other unit was out of range is
+ *         drained to it in FRAME_LOG_BATCH frames once it is heard again.
+ * Power:  PowerManager steps GPS and radio down while the IMU sees no
+ *         motion (power save, then backup + radio sleep with a periodic
+ *         keepalive wake) and back up on the first motion interrupt.
+ * OTA:    a unit with /ota.bin in LittleFS multicasts it (LoRaOta); every
+ *         unit downloads newer images into a raw flash slot, resumes after
+ *         a reset, verifies the SHA-256 and installs through the bootloader.
+ *         Offers are signed with the network key in /ota.key.
+ * BLE:    PicoBLE (BTstack) takes settings on CONFIG and dumps the neighbour
+ *         table and track to a phone that subscribes to STREAM.
+ * Config: addresses, radio band/parameters/power, GPS rate and heartbeat
+ *         cadence written to CONFIG are applied, saved by DeviceConfig and
+ *         re-applied at boot.
  */
 
 #include <Arduino.h>
@@ -27,35 +52,76 @@
 #include "GPS.h"
 #include "LoRaComm.h"
 #include "Display.h"
-
-// ── Device identity (set via build flags) ────────────────────────────────────
-#ifndef DEVICE_ADDRESS
-#define DEVICE_ADDRESS 1
-#endif
-#ifndef TARGET_ADDRESS
-#define TARGET_ADDRESS 2
-#endif
+#include "PositionFilter.h"
+#include "TxPolicy.h"
+#include "FixedMath.h"
+#include "TrackLog.h"
+#include "Geofence.h"
+#include "PeerTable.h"
+#include "UIScheduler.h"
+#include "TelemetryStream.h"
+#include "Telemetry.h"
+#include "FlashLog.h"
+#include "IMU.h"
+#include "ActivityMonitor.h"
+#include "OrientationFilter.h"
+#include "PowerManager.h"
+#include "LoRaOta.h"
+#include "DeviceConfig.h"
+#include "PicoBLE.h"
 
 // ── Timing ────────────────────────────────────────────────────────────────────
-static const uint32_t HEARTBEAT_INTERVAL  = 5000;  // ms between LoRa TX
-static const uint32_t GPS_SAMPLE_INTERVAL = 1000;  // ms between GPS snapshots
+static uint32_t       txCheckInterval     = CONFIG_DEFAULT_HEARTBEAT_MS;  // ms between TX policy checks (DeviceConfig)
+static const uint32_t GPS_SAMPLE_INTERVAL = 1000;  // ms between GPS snapshots, or the GPS rate if slower
 static const uint32_t DEBOUNCE_MS         = 200;
+static const uint32_t TRACK_UPLOAD_INTERVAL = 30000; // ms between track backlog frames
+static const uint32_t PEER_LINK_TIMEOUT   = 60000;  // peer counts as "in range" this long
+static const uint32_t UI_STATS_INTERVAL   = 60000;  // ms between display traffic reports
+static const uint32_t LOG_STATS_INTERVAL  = 60000;  // ms between flash log reports
+static const uint32_t IMU_STATS_INTERVAL  = 60000;  // ms between IMU sampling reports
+static const uint32_t MOTION_REPORT_INTERVAL = 30000; // ms between activity feature records
+static const uint32_t POWER_STATS_INTERVAL = 60000;  // ms between power state reports
+static const uint32_t OTA_STATS_INTERVAL  = 60000;  // ms between OTA progress reports
+static const uint32_t TELEMETRY_STREAM_INTERVAL = 10000; // ms between streamed GPS records
+
+// ── Geofence ──────────────────────────────────────────────────────────────────
+// A "home" circle is dropped around the first fix so leaving/returning to the
+// deployment site raises an alert out of the box.  Set to 0 to disable.
+#ifndef HOME_FENCE_RADIUS_M
+#define HOME_FENCE_RADIUS_M 200
+#endif
+static const uint16_t HOME_FENCE_ID = 0;
 
 // ── Globals ───────────────────────────────────────────────────────────────────
 GPS      gpsModule;
 LoRaComm lora;
 Display  disp;
 
-enum ScreenMode { SCREEN_GPS = 0, SCREEN_RADIO };
-volatile ScreenMode currentScreen = SCREEN_GPS;
+enum ScreenMode { SCREEN_GPS = 0, SCREEN_RADIO, SCREEN_RADAR, SCREEN_LINK, SCREEN_COUNT };
+
+// How each screen decides it needs a new frame (indexed by ScreenMode)
+static const ScreenPolicy SCREEN_POLICIES[SCREEN_COUNT] = {
+    { REFRESH_ON_CHANGE, 1000 },              // GPS: new snapshot, ≤ 1 Hz
+    { REFRESH_ON_CHANGE, 250  },              // Radio: TX/RX counters
+    { REFRESH_PERIODIC,  RADAR_REFRESH_MS },  // Radar: peers are dead-reckoned
+    { REFRESH_ON_EVENT,  0    },              // Link: one sparkline column per packet
+};
+UIScheduler ui;
+uint32_t    lastUiStats = 0;
 
 // Button state (ISR-safe)
 volatile bool     buttonPressed    = false;
 volatile uint32_t lastDebounceTime = 0;
 
 // GPS state
-GPSData  latestGPS      = {};
-uint32_t lastGpsSample  = 0;
+GPSData        latestGPS      = {};
+uint32_t       lastGpsSample  = 0;
+PositionFilter posFilter;       // Kalman-smoothed own position
+TxPolicy       txPolicy;        // dead-band heartbeat suppression
+TrackLog       track;           // simplified route history
+uint32_t       trackUploadedSeq = 0;
+uint32_t       lastTrackUpload  = 0;
+Geofence       geofence;
 
 // LoRa state
 uint32_t txCount         = 0;
@@ -64,10 +130,52 @@ int      lastRSSI        = 0;
 float    lastSNR         = 0.0f;
 String   lastLoRaMsg     = "(none)";
 uint32_t lastHeartbeat   = 0;
+uint32_t lastPeerHeard   = 0;   // millis() of the last packet from anyone
+PeerTable peers;                // position + link stats per heard unit
+TelemetryStreamDecoder telemetryIn;   // keyframe/delta state per sender
+Telemetry telemetryOut;               // keyframe/delta state of what we stream
+uint32_t  lastTelemetryStream = 0;
+
+// IMU — sampled into the MPU6050 FIFO, drained every loop
+IMU      imu;
+bool     imuReady     = false;
+uint32_t lastImuStats = 0;
+ActivityMonitor activity;       // windowed integer features from the IMU stream
+uint32_t lastMotionReport = 0;
+OrientationFilter orientation;  // fixed-point Mahony roll/pitch/heading
+
+// Power — motion-gated GPS / radio duty cycling
+PowerManager power;
+uint32_t     lastPowerStats = 0;
+
+// Store-and-forward log
+PicoLogFlash logFlash;
+FlashLog     flightLog;
+bool         logReady     = false;
+uint32_t     lastLogStats = 0;
+
+// Firmware distribution — image slot sits just below the flash log
+PicoLogFlash  otaSlot(OTA_SLOT_SIZE, FLASH_LOG_SIZE);
+OtaReceiver   otaRx;
+OtaSender     otaTx;
+FileOtaSource otaFile;
+OtaKey        otaKey;                    // network key, /ota.key
+OtaImageWriter otaWriter;
+bool          otaReady     = false;
+bool          otaInstallTried = false;   // one attempt per boot
+uint32_t      lastOtaStats = 0;
+
+// Runtime settings — retunes lora, gpsModule, txPolicy and txCheckInterval
+DeviceConfig deviceConfig(lora, gpsModule, txPolicy, txCheckInterval);
+
+// BLE — settings and table dumps from a phone (PicoBLE, BTstack)
+PicoBLE ble;
+bool    bleReady = false;
 
 // ── ISR forward declares ─────────────────────────────────────────────────────
 void buttonISR();
 void gpsPPS();
+void imuMotionISR();
 
 // ── ISRs ──────────────────────────────────────────────────────────────────────
 void buttonISR() {
@@ -82,6 +190,296 @@ void gpsPPS() {
     gpsModule.onPPS();
 }
 
+void imuMotionISR() {
+    imu.onMotionInterrupt();
+}
+
+static bool linkUp() {
+    return lastPeerHeard != 0 && millis() - lastPeerHeard < PEER_LINK_TIMEOUT;
+}
+
+// ── Power states ─────────────────────────────────────────────────────────────
+static void applyPowerState() {
+    PowerState st = power.getState();
+    gpsModule.setPowerMode(power.gpsMode());
+    if (power.radioOn()) {
+        if (lora.isSleeping() && !lora.wake()) Serial.println("[Power] LoRa wake failed");
+    } else if (!lora.sleep()) {
+        Serial.println("[Power] LoRa sleep failed");
+    }
+    if (imuReady) imu.setFifoEnabled(power.imuStreaming());
+    Serial.println("[Power] → " + String(PowerManager::stateName(st)));
+}
+
+/**
+ * Motion comes from the MPU6050 detector — the INT pin ISR, or the
+ * INT_STATUS bit pollFifo() reads when the pin is not wired — and, while
+ * the FIFO streams, from the activity monitor's high-passed magnitude.
+ * Without an IMU nothing proves the unit is still, so it stays ACTIVE.
+ */
+static void updatePower() {
+    if (!imuReady) return;
+    uint32_t   now    = millis();
+    PowerState before = power.getState();
+    if (imu.takeMotion() || (power.imuStreaming() && activity.isMovingNow())) {
+        power.onMotion(now);
+    }
+    power.update(now);
+    if (power.getState() != before) applyPowerState();
+}
+
+// ── Track upload ─────────────────────────────────────────────────────────────
+
+/**
+ * Send the next chunk of not-yet-uploaded track points:
+ *   FRAME_TRACK, u16 source address, u32 first sequence, TrackLog compact form
+ */
+static void uploadTrack() {
+    // Only kept vertices go up; the live position travels in heartbeats.
+    if (track.nextSeq() <= trackUploadedSeq) return;
+
+    uint8_t  frame[RYLR_MAX_BINARY];
+    uint32_t fromSeq = max(trackUploadedSeq, track.oldestSeq());
+    uint16_t points  = 0;
+    size_t   len     = track.encodeCompact(fromSeq, frame + 7, sizeof(frame) - 7, points);
+    if (len == 0) return;
+
+    frame[0] = FRAME_TRACK;
+    frame[1] = (uint8_t)(deviceConfig.address() & 0xFF);
+    frame[2] = (uint8_t)(deviceConfig.address() >> 8);
+    for (uint8_t i = 0; i < 4; i++) frame[3 + i] = (uint8_t)(fromSeq >> (8 * i));
+
+    if (lora.sendBinary(deviceConfig.target(), frame, len + 7)) {
+        txCount++;
+        trackUploadedSeq = fromSeq + points;
+        Serial.println("[Track] Uploaded " + String(points) + " pts (" +
+                       String((unsigned)(len + 7)) + " B), kept " +
+                       String(track.getKeptCount()) + "/" + String(track.getInputCount()));
+    }
+}
+
+// ── Store-and-forward log ────────────────────────────────────────────────────
+
+/** Append one TelemetryCodec record; while the link is up it went out live. */
+static void logRecord(TelemetryType type, const void* rec) {
+    if (!logReady) return;
+    uint8_t buf[TELEMETRY_BINARY_MAX];
+    size_t  len = TelemetryCodec::encodeBinary(type, rec, buf, sizeof(buf));
+    if (len == 0) return;
+    if (linkUp()) {
+        flightLog.appendSent(LOG_TELEMETRY, buf, (uint8_t)len);
+    } else {
+        flightLog.append(LOG_TELEMETRY, buf, (uint8_t)len);
+    }
+}
+
+/**
+ * Activity features instead of raw IMU samples: one MotionRecord (~12 B
+ * binary) per interval, sent live while the peer is heard and logged.
+ */
+static void reportMotion() {
+    const ActivityFeatures& f = activity.getFeatures();
+    if (f.samples == 0) return;
+
+    MotionRecord rec;
+    rec.timestamp     = f.timestampMs;
+    rec.level         = f.level;
+    rec.moving        = f.moving;
+    rec.steps         = f.steps;
+    rec.meanMg        = f.meanMg;
+    rec.stdMg         = f.stdMg;
+    rec.accelRmsMg    = f.accelRmsMg;
+    rec.gyroRmsDpsX10 = f.gyroRmsDpsX10;
+
+    if (lora.isReady() && linkUp()) {
+        uint8_t frame[1 + TELEMETRY_BINARY_MAX];
+        frame[0]   = FRAME_TELEMETRY;
+        size_t len = TelemetryCodec::encodeBinary(TELEMETRY_MOTION, &rec, frame + 1, sizeof(frame) - 1);
+        if (len && lora.sendBinary(deviceConfig.target(), frame, len + 1)) txCount++;
+    }
+    logRecord(TELEMETRY_MOTION, &rec);
+}
+
+/**
+ * Stream the current GPS snapshot as a keyframe or delta.  A frame that
+ * does not go out would leave the receiver a sequence gap, so the next
+ * one is keyed instead.
+ */
+static void streamTelemetry() {
+    uint8_t frame[1 + TELEMETRY_STREAM_MAX];
+    frame[0]   = FRAME_TELEMETRY_STREAM;
+    size_t len = telemetryOut.streamGPSTelemetry(frame + 1, sizeof(frame) - 1, latestGPS);
+    if (len && lora.sendBinary(deviceConfig.target(), frame, len + 1)) {
+        txCount++;
+    } else {
+        telemetryOut.requestKeyframe(TELEMETRY_GPS);
+    }
+}
+
+/**
+ * Send the next batch of logged records:
+ *   FRAME_LOG_BATCH, u16 source address, [type][len][data]...
+ * FlashLog paces batches to its share of airtime.
+ */
+static void drainLog() {
+    uint8_t   frame[RYLR_MAX_BINARY];
+    LogCursor next;
+    size_t    len = flightLog.readBatch(frame + 3, sizeof(frame) - 3, next);
+    if (len == 0) return;
+
+    frame[0] = FRAME_LOG_BATCH;
+    frame[1] = (uint8_t)(deviceConfig.address() & 0xFF);
+    frame[2] = (uint8_t)(deviceConfig.address() >> 8);
+    if (lora.sendBinary(deviceConfig.target(), frame, len + 3)) {
+        txCount++;
+        flightLog.onBatchSent(next, LoRaComm::airtimeMs(LORA_BINARY_TEXT_LEN(len + 3)), millis());
+    }
+}
+
+/** Send queued geofence transitions:  ADDR|ALERT|FENCE|<id>|ENTER/EXIT|lat|lon */
+static void sendGeofenceAlerts() {
+    GeofenceEvent ev;
+    while (geofence.pollEvent(ev)) {
+        const char* kind = ev.type == GEOFENCE_ENTER ? "ENTER" : "EXIT";
+        String alert = String(deviceConfig.address()) + "|ALERT|FENCE|" + String(ev.fenceId) +
+                       "|" + kind +
+                       "|" + String(ev.latE6 / 1e6, 5) +
+                       "|" + String(ev.lonE6 / 1e6, 5);
+        Serial.println("[Fence] " + String(kind) + " " + String(ev.fenceId) +
+                       " (" + String(geofence.getLastUpdateMicros()) + " us / " +
+                       String(geofence.getFenceCount()) + " fences)");
+        if (lora.isReady() && lora.sendMessage(deviceConfig.target(), alert)) txCount++;
+
+        AlertRecord rec = {};
+        rec.timestamp = millis();
+        snprintf(rec.alertType, sizeof(rec.alertType), "FENCE_%s", kind);
+        snprintf(rec.message, sizeof(rec.message), "%u %ld %ld", ev.fenceId,
+                 (long)ev.latE6, (long)ev.lonE6);
+        logRecord(TELEMETRY_ALERT, &rec);
+    }
+}
+
+/** Print a received telemetry record as one JSON line for a host-side gateway. */
+static void relayTelemetry(uint16_t src, TelemetryType type, const TelemetryRecord& rec) {
+    char id[6];
+    snprintf(id, sizeof(id), "%u", src);
+    Serial.print("[Telemetry] ");
+    JsonWriter w(Serial);
+    TelemetryCodec::encodeJson(w, type, &rec, id);
+    Serial.println();
+}
+
+static void handleBinaryFrame(const LoRaPacket& pkt) {
+    uint8_t frame[RYLR_MAX_BINARY];
+    int     len = LoRaComm::decodeBinary(pkt.payload, frame, sizeof(frame));
+    if (len < 1) return;
+
+    if (frame[0] == FRAME_TRACK && len > 7) {
+        static TrackPoint pts[TRACK_COMPACT_MAX_POINTS(RYLR_MAX_BINARY - 7)];
+        int n = TrackLog::decodeCompact(frame + 7, len - 7, pts,
+                                        TRACK_COMPACT_MAX_POINTS(RYLR_MAX_BINARY - 7));
+        uint16_t src = frame[1] | (frame[2] << 8);
+        lastLoRaMsg  = "track " + String(n) + " pts";
+        Serial.println("[Track] " + String(n) + " pts from " + String(src));
+    } else if (frame[0] == FRAME_LOG_BATCH && len > 3) {
+        uint16_t src = frame[1] | (frame[2] << 8);
+        int      pos = 3;
+        while (pos + 2 <= len && pos + 2 + frame[pos + 1] <= len) {
+            TelemetryType   type;
+            TelemetryRecord rec;
+            if (frame[pos] == LOG_TELEMETRY &&
+                TelemetryCodec::decodeBinary(frame + pos + 2, frame[pos + 1], type, rec)) {
+                relayTelemetry(src, type, rec);
+            }
+            pos += 2 + frame[pos + 1];
+        }
+        lastLoRaMsg = "log batch from " + String(src);
+    } else if (frame[0] == FRAME_TELEMETRY) {
+        TelemetryType   type;
+        TelemetryRecord rec;
+        if (TelemetryCodec::decodeBinary(frame + 1, len - 1, type, rec)) {
+            relayTelemetry(pkt.srcAddress, type, rec);
+        }
+    } else if (frame[0] == FRAME_TELEMETRY_STREAM) {
+        TelemetryType   type;
+        TelemetryRecord rec;
+        TelemetryStreamResult r = telemetryIn.decode(pkt.srcAddress, frame + 1, len - 1,
+                                                     millis(), type, rec);
+        if (r == STREAM_OK) {
+            relayTelemetry(pkt.srcAddress, type, rec);
+        } else if (r == STREAM_RESYNC) {
+            uint8_t req[2] = { FRAME_TELEMETRY_RESYNC, type };
+            lora.sendBinary(pkt.srcAddress, req, sizeof(req));
+            Serial.println("[Telemetry] Lost sync with " + String(pkt.srcAddress) +
+                           ", keyframe requested");
+        }
+    } else if (frame[0] == FRAME_TELEMETRY_RESYNC && len >= 2) {
+        telemetryOut.requestKeyframe((TelemetryType)frame[1]);
+        Serial.println("[Telemetry] Keyframe requested by " + String(pkt.srcAddress));
+    } else if (frame[0] == FRAME_OTA_NACK) {
+        otaTx.onNack(pkt.srcAddress, frame, len, millis());
+    } else if (otaReady) {
+        otaRx.onFrame(pkt.srcAddress, frame, len, millis());
+    }
+}
+
+/**
+ * Firmware distribution: relay side broadcasts the next paced frame,
+ * receiver side hashes the finished slot, answers polls and installs.
+ */
+static void serviceOta() {
+    uint8_t  frame[RYLR_MAX_BINARY];
+    uint32_t now = millis();
+
+    size_t len = otaTx.isActive() ? otaTx.nextFrame(frame, sizeof(frame), now) : 0;
+    if (len && lora.sendBinary(LORA_BROADCAST_ADDR, frame, len)) {
+        txCount++;
+        otaTx.onSent(LoRaComm::airtimeMs(LORA_BINARY_TEXT_LEN(len)), millis());
+    }
+
+    otaRx.setAddress(deviceConfig.address());   // retuned by DeviceConfig
+    otaRx.service(now);
+    OtaState st = otaRx.getState();
+    if (otaRx.nackDue(now)) {
+        len = otaRx.buildNack(frame, sizeof(frame));
+        if (len && lora.sendBinary(otaRx.getRelay(), frame, len)) {
+            txCount++;
+            otaRx.onNackSent();
+        }
+    } else if (st == OTA_READY && !otaInstallTried) {
+        otaInstallTried = true;
+        otaRx.install(otaWriter);   // reboots on success
+    }
+    // A download in progress keeps the radio out of sleep
+    if (st == OTA_RECEIVING || st == OTA_VERIFYING) power.onMotion(now);
+}
+
+static void renderScreen(uint8_t screen) {
+    switch (screen) {
+        case SCREEN_GPS:
+            disp.showGPSScreen(latestGPS);
+            break;
+        case SCREEN_RADIO:
+            disp.showRadioScreen(txCount, rxCount, lastRSSI, lastSNR, lastLoRaMsg);
+            break;
+        case SCREEN_RADAR: {
+            uint32_t now   = millis();
+            int32_t  latE6 = 0, lonE6 = 0;
+            bool haveFix   = posFilter.predict(now, latE6, lonE6);
+            if (!haveFix && latestGPS.valid) {
+                latE6   = FixedMath::toMicroDeg(latestGPS.latitude);
+                lonE6   = FixedMath::toMicroDeg(latestGPS.longitude);
+                haveFix = true;
+            }
+            disp.showRadarScreen(peers, haveFix, latE6, lonE6, now);
+            break;
+        }
+        case SCREEN_LINK:
+            disp.showLinkScreen(peers);
+            break;
+    }
+}
+
 // ── Setup ─────────────────────────────────────────────────────────────────────
 void setup() {
     Serial.begin(115200);
@@ -107,42 +505,208 @@ void setup() {
     Serial.println(gpsOk ? "[BRAVO] GPS OK" : "[BRAVO] GPS FAIL");
 
     // LoRa
-    bool loraOk = lora.begin(DEVICE_ADDRESS);
+    bool loraOk = lora.begin(deviceConfig.address());
     disp.showInitStatus("LoRa", loraOk);
     Serial.println(loraOk ? "[BRAVO] LoRa OK" : "[BRAVO] LoRa FAIL");
 
+    // Saved identity and retuning (radio, GPS rate, heartbeat) on top of the
+    // build defaults; the first boot saves the defaults as this unit's own
+    deviceConfig.begin();
+
+    // IMU — absent on units without the MPU6050 fitted
+    imuReady = imu.begin() && imu.beginFifo(IMU_FIFO_RATE_HZ);
+    disp.showInitStatus("IMU", imuReady);
+    if (imuReady) {
+        orientation.begin(imu.getSampleRateHz());
+        uint32_t cyc = OrientationFilter::benchmark();
+        // Share of one core at the FIFO rate, in 0.01 %
+        uint32_t load = (uint32_t)((uint64_t)cyc * imu.getSampleRateHz() * 10000 / rp2040.f_cpu());
+        Serial.println("[Orient] " + String(cyc) + " cyc/update, " + String(load / 100) + "." +
+                       String(load % 100 / 10) + String(load % 10) + "% CPU at " +
+                       String(imu.getSampleRateHz()) + " Hz");
+    }
+    if (imuReady && imu.enableMotionInterrupt()) {
+        pinMode(PIN_IMU_INT, INPUT);
+        attachInterrupt(digitalPinToInterrupt(PIN_IMU_INT), imuMotionISR, RISING);
+    }
+    power.begin(millis());
+
+    // Flash log — raw sectors just below the LittleFS partition
+    logReady = logFlash.begin() && flightLog.begin(logFlash);
+    disp.showInitStatus("Log", logReady);
+
+    // OTA — resume a partial download; serve /ota.bin if this unit has one.
+    // Offers are authenticated with the network key: none, no updates.
+    if (otaKey.load()) {
+        otaReady = otaSlot.begin() && otaRx.begin(otaSlot, deviceConfig.address(), otaKey);
+        if (otaFile.open(OTA_FILE)) otaTx.begin(otaFile, otaFile.getVersion(), otaKey);
+    } else {
+        Serial.println("[OTA] No valid " OTA_KEY_FILE ", updates disabled");
+    }
+
+    // BLE — CONFIG/STATUS/COMMAND retune this unit, STREAM dumps the tables;
+    // named after the unit so the app can tell them apart
+    ble.setDeviceConfig(&deviceConfig);
+    ble.setStreamSources(&peers, &track);
+    bleReady = ble.begin(("BRAVO-" + String(deviceConfig.address())).c_str());
+    disp.showInitStatus("BLE", bleReady);
+
     disp.showMessage("Ready!");
     delay(500);
+
+    ui.setPolicies(SCREEN_POLICIES, SCREEN_COUNT);
+    ui.show(SCREEN_GPS);
     Serial.println("[BRAVO] Setup complete");
 }
 
 // ── Loop ──────────────────────────────────────────────────────────────────────
 void loop() {
+    uint32_t loopStartUs = micros();
+
     // 1) Feed GPS parser
     gpsModule.update();
 
-    // 2) Snapshot GPS data periodically
-    if (millis() - lastGpsSample >= GPS_SAMPLE_INTERVAL) {
+    // 1b) IMU — burst-read the sensor FIFO, then consume the samples
+    if (imuReady) {
+        imu.pollFifo();
+        ImuSample        s;
+        ActivityFeatures f;
+        while (imu.popSample(s)) {
+            activity.add(s, f);
+            orientation.update(s);
+        }
+    }
+
+    // 1c) Power state — motion keeps GPS and radio up, stillness steps them down
+    updatePower();
+
+    // 2) Snapshot GPS data periodically — no faster than solutions arrive,
+    //    so a slow configured rate does not log the same fix over and over
+    if (millis() - lastGpsSample >= max(GPS_SAMPLE_INTERVAL, (uint32_t)gpsModule.getRateMs())) {
         lastGpsSample = millis();
+        bool hadFix   = latestGPS.valid;
         latestGPS     = gpsModule.getData();
+        posFilter.update(latestGPS);
+        peers.expire(lastGpsSample);
+        ui.notify(SCREEN_GPS);
+
+        if (latestGPS.valid) {
+            FilterState fs = posFilter.getState();
+            track.add(fs.latE6, fs.lonE6, lastGpsSample / 1000);
+
+            if (HOME_FENCE_RADIUS_M > 0 && geofence.getFenceCount() == 0 &&
+                fs.posSigmaMm < 10000) {
+                int home = geofence.addCircle(HOME_FENCE_ID, fs.latE6, fs.lonE6,
+                                              (uint32_t)HOME_FENCE_RADIUS_M * 1000);
+                geofence.seed(home, fs.latE6, fs.lonE6);   // no ENTER for where we boot
+                Serial.println("[Fence] Home fence set");
+            }
+            if (geofence.update(fs.latE6, fs.lonE6, lastGpsSample) > 0) {
+                sendGeofenceAlerts();
+            }
+        } else if (hadFix) {
+            track.flush();   // close the track where the fix was lost
+        }
+
+        // Log every fix (and the loss of one), heartbeats or not
+        if (latestGPS.valid || hadFix) {
+            GpsRecord rec;
+            Telemetry::toRecord(latestGPS, rec);
+            logRecord(TELEMETRY_GPS, &rec);
+        }
     }
 
-    // 3) LoRa TX heartbeat — send GPS payload to the other unit
-    if (lora.isReady() && (millis() - lastHeartbeat >= HEARTBEAT_INTERVAL)) {
+    // 3) LoRa TX heartbeat — dead-band policy decides whether the receiver's
+    //    extrapolation of our last heartbeat is still good enough.
+    if (lora.isReady() && (millis() - lastHeartbeat >= txCheckInterval)) {
         lastHeartbeat = millis();
 
-        // Compact payload: ADDR|lat|lon|sats
-        String payload = String(DEVICE_ADDRESS) + "|" +
-                         String(latestGPS.latitude,  5) + "|" +
-                         String(latestGPS.longitude, 5) + "|" +
-                         String(latestGPS.satellites);
+        // Use the filtered position dead-reckoned to "now" rather than the
+        // raw (jittery, up to 1 s old) fix.
+        int32_t latE6 = 0, lonE6 = 0;
+        if (!posFilter.predict(lastHeartbeat, latE6, lonE6) && latestGPS.valid) {
+            latE6 = FixedMath::toMicroDeg(latestGPS.latitude);
+            lonE6 = FixedMath::toMicroDeg(latestGPS.longitude);
+        }
 
-        if (lora.sendMessage(TARGET_ADDRESS, payload)) {
-            txCount++;
-            Serial.println("[LoRa] TX → " + payload);
-        } else {
-            Serial.println("[LoRa] TX failed");
+        TxReason reason = txPolicy.evaluate(latE6, lonE6, latestGPS, lastHeartbeat);
+        if (power.getState() == POWER_KEEPALIVE) {
+            // One heartbeat per wake: wait for a fix, send what we have on timeout
+            reason = power.keepaliveDue(lastHeartbeat, latestGPS.valid) ? TX_KEEPALIVE
+                                                                        : TX_SUPPRESSED;
         }
+        if (reason != TX_SUPPRESSED) {
+            // Quantise to what goes on air (5 decimals, 0.1 km/h, 1°) so the
+            // policy extrapolates exactly what the receiver will.
+            TxSnapshot snap;
+            snap.latE6       = (latE6 >= 0 ? latE6 + 5 : latE6 - 5) / 10 * 10;
+            snap.lonE6       = (lonE6 >= 0 ? lonE6 + 5 : lonE6 - 5) / 10 * 10;
+            snap.speedKmhX10 = latestGPS.valid ? (uint16_t)(latestGPS.speed * 10.0f + 0.5f) : 0;
+            snap.courseDeg   = latestGPS.valid ? (uint16_t)(latestGPS.course + 0.5f) % 360 : 0;
+            snap.valid       = latestGPS.valid;
+            snap.sentAt      = lastHeartbeat;
+
+            // Compact payload: ADDR|lat|lon|sats|speed|course
+            String payload = String(deviceConfig.address()) + "|" +
+                             String(snap.latE6 / 1e6, 5) + "|" +
+                             String(snap.lonE6 / 1e6, 5) + "|" +
+                             String(latestGPS.satellites) + "|" +
+                             String(snap.speedKmhX10 / 10.0, 1) + "|" +
+                             String(snap.courseDeg);
+
+            if (lora.sendMessage(deviceConfig.target(), payload)) {
+                txCount++;
+                txPolicy.markSent(snap);
+                power.onKeepaliveSent(lastHeartbeat);
+                ui.notify(SCREEN_RADIO);
+                Serial.println("[LoRa] TX (" + String(TxPolicy::reasonName(reason)) +
+                               ") → " + payload);
+            } else {
+                Serial.println("[LoRa] TX failed");
+            }
+        }
+    }
+
+    // 3b) Track backlog — only while the other unit has been heard recently
+    if (lora.isReady() && lastPeerHeard != 0 &&
+        millis() - lastPeerHeard < PEER_LINK_TIMEOUT &&
+        millis() - lastTrackUpload >= TRACK_UPLOAD_INTERVAL) {
+        lastTrackUpload = millis();
+        uploadTrack();
+    }
+
+    // 3c) Activity summary
+    if (imuReady && power.imuStreaming() &&
+        millis() - lastMotionReport >= MOTION_REPORT_INTERVAL) {
+        lastMotionReport = millis();
+        reportMotion();
+    }
+
+    // 3d) Telemetry stream — only while the other unit is listening
+    if (lora.isReady() && linkUp() &&
+        millis() - lastTelemetryStream >= TELEMETRY_STREAM_INTERVAL) {
+        lastTelemetryStream = millis();
+        streamTelemetry();
+    }
+
+    // 3e) Flash log — timed page flush / erase-ahead, then drain the backlog
+    if (logReady) {
+        flightLog.service(millis());
+        if (lora.isReady() && linkUp() && flightLog.hasBacklog() &&
+            flightLog.drainDue(millis())) {
+            drainLog();
+        }
+    }
+
+    // 3f) Firmware distribution
+    if (otaReady && lora.isReady()) {
+        serviceOta();
+    }
+
+    // 3g) BLE — connection events, CONFIG/COMMAND writes, then stream as
+    //     completions free credits
+    if (bleReady) {
+        ble.update();
     }
 
     // 4) LoRa RX — non-blocking poll
@@ -150,9 +714,19 @@ void loop() {
         LoRaPacket pkt;
         if (lora.receive(pkt)) {
             rxCount++;
-            lastRSSI    = pkt.rssi;
-            lastSNR     = pkt.snr;
-            lastLoRaMsg = pkt.payload;
+            lastRSSI      = pkt.rssi;
+            lastSNR       = pkt.snr;
+            lastPeerHeard = millis();
+            bool binary   = LoRaComm::isBinary(pkt.payload);
+            peers.onPacket(pkt.srcAddress, binary ? nullptr : pkt.payload.c_str(),
+                           pkt.rssi, pkt.snr, lastPeerHeard);
+            if (binary) {
+                handleBinaryFrame(pkt);
+            } else {
+                lastLoRaMsg = pkt.payload;
+            }
+            ui.notify(SCREEN_RADIO);
+            ui.notify(SCREEN_LINK);
             Serial.println("[LoRa] RX from " + String(pkt.srcAddress) +
                            ": " + pkt.payload +
                            " RSSI=" + String(pkt.rssi) +
@@ -160,18 +734,95 @@ void loop() {
         }
     }
 
-    // 5) Button — cycle screen
+    // 5) Button — cycle screen; the new one renders in this iteration
     if (buttonPressed) {
         buttonPressed = false;
-        currentScreen = (currentScreen == SCREEN_GPS) ? SCREEN_RADIO : SCREEN_GPS;
+        ui.next();
     }
 
-    // 6) Refresh display at the Display module's own rate
-    if (disp.shouldUpdate()) {
-        if (currentScreen == SCREEN_GPS) {
-            disp.showGPSScreen(latestGPS);
-        } else {
-            disp.showRadioScreen(txCount, rxCount, lastRSSI, lastSNR, lastLoRaMsg);
+    // 6) Display — the scheduler applies each screen's refresh policy and
+    //    holds frames back while this iteration is over its time budget.
+    //    The transfer itself runs on DMA and is retired by poll().
+    disp.poll();
+    if (ui.due(millis(), micros() - loopStartUs)) {
+        uint32_t t0 = micros();
+        renderScreen(ui.getCurrent());
+        ui.rendered(millis(), micros() - t0);
+    }
+
+    if (millis() - lastUiStats >= UI_STATS_INTERVAL) {
+        lastUiStats = millis();
+        Serial.println("[Display] " + String(ui.getRenderCount()) + " frames, " +
+                       String(disp.getTotalFlushBytes()) + " B total, " +
+                       String(ui.getDeferCount()) + " deferred, last render " +
+                       String(disp.getLastRenderCycles()) + " cyc / transfer " +
+                       String(disp.getLastFlushMicros()) + " us");
+    }
+
+    if (imuReady && millis() - lastImuStats >= IMU_STATS_INTERVAL) {
+        lastImuStats = millis();
+        Serial.println("[IMU] " + String(imu.getSampleCount()) + " samples @ " +
+                       String(imu.getSampleRateHz()) + " Hz in " + String(imu.getBurstCount()) +
+                       " bursts, last poll " + String(imu.getLastPollMicros()) + " us, overflows " +
+                       String(imu.getFifoOverflows()) + " FIFO / " + String(imu.getRingOverflows()) +
+                       " ring");
+        const ActivityFeatures& f = activity.getFeatures();
+        Serial.println("[Activity] level " + String(f.level) + (f.moving ? " moving" : " still") +
+                       ", rms " + String(f.accelRmsMg) + " mg, std " + String(f.stdMg) +
+                       " mg, " + String(activity.getTotalSteps()) + " steps, " +
+                       String(activity.getLastSampleCycles()) + " cyc/sample, " +
+                       String(activity.getLastBlockCycles()) + " cyc/block");
+        EulerBam e = orientation.getEuler();
+        Serial.println("[Orient] roll " + String(e.roll * 360L / 65536) + " pitch " +
+                       String(e.pitch * 360L / 65536) + " heading " +
+                       String(FixedMath::bamToDeg(e.heading)) + " deg, " +
+                       String(orientation.getLastUpdateCycles()) + " cyc (max " +
+                       String(orientation.getMaxUpdateCycles()) + "), " +
+                       String(orientation.getAccelRejected()) + " accel rejected");
+    }
+
+    if (millis() - lastPowerStats >= POWER_STATS_INTERVAL) {
+        lastPowerStats = millis();
+        uint32_t now   = lastPowerStats;
+        String line    = "[Power] " + String(PowerManager::stateName(power.getState()));
+        for (uint8_t st = 0; st < POWER_STATE_COUNT; st++) {
+            line += (st ? ", " : " — ") + String(PowerManager::stateName((PowerState)st)) + " " +
+                    String(power.getTimeInState((PowerState)st, now) / 1000) + " s";
+        }
+        uint32_t avg = power.getAverageCurrentMaX10(now);
+        Serial.println(line + ", " + String(power.getTransitions()) + " transitions, ~" +
+                       String(avg / 10) + "." + String(avg % 10) + " mA avg");
+    }
+
+    if (logReady && millis() - lastLogStats >= LOG_STATS_INTERVAL) {
+        lastLogStats = millis();
+        const FlashLogStats& ls = flightLog.getStats();
+        Serial.println("[Log] " + String(ls.appended) + " recs / " + String(ls.pagesWritten) +
+                       " pages / " + String(ls.segmentsErased) + " erases, backlog " +
+                       String(flightLog.backlogBytes()) + " B, drained " +
+                       String(ls.drainedRecords) + " recs in " + String(ls.batchesSent) +
+                       " batches, lost " + String(ls.segmentsLost) + " seg");
+    }
+
+    if (otaReady && millis() - lastOtaStats >= OTA_STATS_INTERVAL) {
+        lastOtaStats = millis();
+        const OtaImageInfo&     img = otaRx.getImage();
+        const OtaReceiverStats& rs  = otaRx.getStats();
+        if (otaRx.getState() != OTA_IDLE) {
+            Serial.println("[OTA] RX " + String(OtaReceiver::stateName(otaRx.getState())) + " v" +
+                           String(img.version) + ", " + String(otaRx.getReceivedBlocks()) + "/" +
+                           String(img.blocks) + " blocks, " + String(rs.duplicates) + " dup, " +
+                           String(rs.crcErrors) + " bad, " + String(rs.nacksSent) + " NACKs");
+        }
+        if (rs.badOffers) {
+            Serial.println("[OTA] " + String(rs.badOffers) + " offers with a bad MAC dropped");
+        }
+        if (otaTx.isActive()) {
+            const OtaSenderStats& ts = otaTx.getStats();
+            Serial.println("[OTA] TX round " + String(ts.rounds) + ", " + String(ts.blocksSent) +
+                           " blocks / " + String(ts.airtimeMs / 1000) + " s airtime, " +
+                           String(otaTx.getVerifiedCount()) + "/" +
+                           String(otaTx.getReceiverCount()) + " receivers verified");
         }
     }
 }
@@ -0,0 +1,90 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core, for the native test env only
+ *
+ * Just enough of String, Print, Serial and the timing calls for the
+ * hardware-free modules the Unity tests build (build_src_filter in
+ * platformio.ini).  Serial output is discarded; millis()/micros() return
+ * hostMicros, which a test may set.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define DEC 10
+#define HEX 16
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint32_t hostMicros = 0;
+inline uint32_t micros() { return hostMicros; }
+inline uint32_t millis() { return hostMicros / 1000; }
+inline void     delay(uint32_t) {}
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& x) : s(x) {}
+    String(char c) : s(1, c) {}
+    String(int v, int base = DEC)           { fmt(base == HEX ? "%x" : "%d", v); }
+    String(unsigned v, int base = DEC)      { fmt(base == HEX ? "%x" : "%u", v); }
+    String(long v, int base = DEC)          { fmt(base == HEX ? "%lx" : "%ld", v); }
+    String(unsigned long v, int base = DEC) { fmt(base == HEX ? "%lx" : "%lu", v); }
+    String(double v, int digits = 2)        { fmt("%.*f", digits, v); }
+
+    unsigned    length() const { return (unsigned)s.size(); }
+    const char* c_str() const  { return s.c_str(); }
+    String  operator+(const String& o) const { return String(s + o.s); }
+    String& operator+=(const String& o)      { s += o.s; return *this; }
+    bool    operator==(const char* o) const  { return s == o; }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+
+private:
+    std::string s;
+    template <typename... A> void fmt(const char* f, A... a) {
+        char b[48];
+        snprintf(b, sizeof(b), f, a...);
+        s = b;
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* b, size_t n) {
+        size_t r = 0;
+        while (n--) r += write(*b++);
+        return r;
+    }
+    size_t write(const char* str)         { return write((const uint8_t*)str, strlen(str)); }
+    size_t print(const char* str)         { return write(str); }
+    size_t print(const String& str)       { return write(str.c_str()); }
+    size_t println(const char* str = "")  { return print(str) + write("\n"); }
+    size_t println(const String& str)     { return print(str) + write("\n"); }
+};
+
+class HostSerial : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
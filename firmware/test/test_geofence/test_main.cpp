@@ -0,0 +1,171 @@
+/**
+ * @file test_main.cpp
+ * @brief Geofence bounding-box prefilter, point-in-polygon and hysteresis
+ *
+ * Run on the host:  pio test -e native
+ */
+
+#include <unity.h>
+#include "Geofence.h"
+
+// Around 51.5° N one µdeg of latitude is about 111 mm
+#define BASE_LAT    51500000
+#define BASE_LON    -100000
+#define RADIUS_MM   100000          // 100 m, about 898 µdeg north
+#define AT_95_M     (BASE_LAT + 853)
+#define AT_105_M    (BASE_LAT + 943)
+#define AT_115_M    (BASE_LAT + 1033)
+
+static Geofence fence;
+
+/**
+ * Feed `n` identical fixes.
+ * @return events queued, the last of them in `last`
+ */
+static uint8_t feed(int32_t latE6, int32_t lonE6, uint8_t n, GeofenceEvent* last = nullptr) {
+    uint8_t queued = 0;
+    for (uint8_t i = 0; i < n; i++) queued += fence.update(latE6, lonE6, i);
+    GeofenceEvent ev;
+    while (fence.pollEvent(ev)) {
+        if (last) *last = ev;
+    }
+    return queued;
+}
+
+void setUp() {
+    fence = Geofence();
+}
+
+void tearDown() {}
+
+// ── Prefilter ────────────────────────────────────────────────────────────────
+
+void test_only_fences_whose_box_holds_the_fix_get_the_exact_test() {
+    fence.addCircle(1, BASE_LAT, BASE_LON, RADIUS_MM);
+    for (uint16_t k = 0; k < GEOFENCE_MAX_FENCES - 1; k++) {
+        TEST_ASSERT_TRUE(fence.addCircle(100 + k, 40000000 + k * 1000, 10000000, 50000) >= 0);
+    }
+    TEST_ASSERT_EQUAL(-1, fence.addCircle(999, 0, 0, 1000));
+
+    fence.update(BASE_LAT, BASE_LON, 0);
+    TEST_ASSERT_EQUAL(1, fence.getLastExactTests());
+    fence.update(0, 0, 1);
+    TEST_ASSERT_EQUAL(0, fence.getLastExactTests());
+}
+
+void test_box_covers_the_circle_and_exit_margin() {
+    fence.addCircle(1, BASE_LAT, BASE_LON, RADIUS_MM);
+    const Fence& f = fence.getFence(0);
+    // 110 m either way in latitude, more µdeg in longitude (cos 51.5° ≈ 0.62)
+    TEST_ASSERT_TRUE(f.maxLat >= BASE_LAT + 988 && f.maxLat <= BASE_LAT + 1000);
+    TEST_ASSERT_TRUE(f.minLat <= BASE_LAT - 988 && f.minLat >= BASE_LAT - 1000);
+    TEST_ASSERT_TRUE(f.maxLon - BASE_LON > 1550 && f.maxLon - BASE_LON < 1620);
+}
+
+// ── Point in polygon ─────────────────────────────────────────────────────────
+
+void test_concave_polygon_excludes_its_notch() {
+    // An L: a 2000 µdeg square with the north-east quarter cut away
+    const int32_t la[6] = { BASE_LAT, BASE_LAT, BASE_LAT + 1000,
+                            BASE_LAT + 1000, BASE_LAT + 2000, BASE_LAT + 2000 };
+    const int32_t lo[6] = { BASE_LON, BASE_LON + 2000, BASE_LON + 2000,
+                            BASE_LON + 1000, BASE_LON + 1000, BASE_LON };
+    int idx = fence.addPolygon(2, la, lo, 6);
+    TEST_ASSERT_EQUAL(0, idx);
+
+    fence.seed(idx, BASE_LAT + 500, BASE_LON + 1500);    // foot of the L
+    TEST_ASSERT_TRUE(fence.getFence(idx).inside);
+    fence.seed(idx, BASE_LAT + 1500, BASE_LON + 500);    // upright
+    TEST_ASSERT_TRUE(fence.getFence(idx).inside);
+    fence.seed(idx, BASE_LAT + 1500, BASE_LON + 1500);   // the notch
+    TEST_ASSERT_FALSE(fence.getFence(idx).inside);
+    fence.seed(idx, BASE_LAT - 10, BASE_LON + 500);      // just south
+    TEST_ASSERT_FALSE(fence.getFence(idx).inside);
+}
+
+void test_polygon_needs_three_vertices() {
+    const int32_t la[2] = { BASE_LAT, BASE_LAT + 1000 };
+    const int32_t lo[2] = { BASE_LON, BASE_LON };
+    TEST_ASSERT_EQUAL(-1, fence.addPolygon(2, la, lo, 2));
+    TEST_ASSERT_EQUAL(0, fence.getFenceCount());
+}
+
+// ── Hysteresis ───────────────────────────────────────────────────────────────
+
+void test_entry_needs_confirm_fixes_in_a_row() {
+    fence.addCircle(1, BASE_LAT, BASE_LON, RADIUS_MM);
+
+    TEST_ASSERT_EQUAL(0, feed(BASE_LAT, BASE_LON, GEOFENCE_CONFIRM_FIXES - 1));
+    TEST_ASSERT_EQUAL(0, feed(AT_115_M, BASE_LON, 1));              // jitter resets
+    TEST_ASSERT_EQUAL(0, feed(BASE_LAT, BASE_LON, GEOFENCE_CONFIRM_FIXES - 1));
+
+    GeofenceEvent ev;
+    TEST_ASSERT_EQUAL(1, feed(BASE_LAT, BASE_LON, 1, &ev));
+    TEST_ASSERT_EQUAL(1, ev.fenceId);
+    TEST_ASSERT_EQUAL(GEOFENCE_ENTER, ev.type);
+    TEST_ASSERT_TRUE(fence.getFence(0).inside);
+}
+
+void test_exit_waits_for_the_margin() {
+    int idx = fence.addCircle(1, BASE_LAT, BASE_LON, RADIUS_MM);
+    fence.seed(idx, AT_95_M, BASE_LON);
+    TEST_ASSERT_TRUE(fence.getFence(idx).inside);
+
+    // Past the radius but inside the 10 m band: still in
+    TEST_ASSERT_EQUAL(0, feed(AT_105_M, BASE_LON, 20));
+    TEST_ASSERT_TRUE(fence.getFence(idx).inside);
+
+    GeofenceEvent ev;
+    TEST_ASSERT_EQUAL(1, feed(AT_115_M, BASE_LON, GEOFENCE_CONFIRM_FIXES, &ev));
+    TEST_ASSERT_EQUAL(GEOFENCE_EXIT, ev.type);
+
+    // Entry is at the boundary itself, not the band
+    TEST_ASSERT_EQUAL(0, feed(AT_105_M, BASE_LON, 20));
+    TEST_ASSERT_EQUAL(1, feed(AT_95_M, BASE_LON, GEOFENCE_CONFIRM_FIXES));
+}
+
+void test_polygon_exit_waits_for_the_margin() {
+    const int32_t la[4] = { BASE_LAT, BASE_LAT, BASE_LAT + 2000, BASE_LAT + 2000 };
+    const int32_t lo[4] = { BASE_LON, BASE_LON + 2000, BASE_LON + 2000, BASE_LON };
+    int idx = fence.addPolygon(2, la, lo, 4);
+    fence.seed(idx, BASE_LAT + 1000, BASE_LON + 1000);
+
+    TEST_ASSERT_EQUAL(0, feed(BASE_LAT - 45, BASE_LON + 1000, 20));     // 5 m south
+    TEST_ASSERT_EQUAL(1, feed(BASE_LAT - 135, BASE_LON + 1000, GEOFENCE_CONFIRM_FIXES));  // 15 m
+    TEST_ASSERT_FALSE(fence.getFence(idx).inside);
+}
+
+void test_confirm_count_is_clamped_to_what_pending_holds() {
+    fence.addCircle(1, BASE_LAT, BASE_LON, RADIUS_MM);
+    fence.setHysteresis(GEOFENCE_MARGIN_MM, 200);
+
+    TEST_ASSERT_EQUAL(0, feed(BASE_LAT, BASE_LON, GEOFENCE_CONFIRM_MAX - 1));
+    TEST_ASSERT_EQUAL(1, feed(BASE_LAT, BASE_LON, 1));
+}
+
+void test_events_queue_drops_the_oldest() {
+    for (uint16_t k = 0; k < GEOFENCE_EVENT_QUEUE + 2; k++) {
+        fence.addCircle(k, BASE_LAT, BASE_LON, RADIUS_MM);
+    }
+    fence.setHysteresis(GEOFENCE_MARGIN_MM, 1);
+    TEST_ASSERT_EQUAL(GEOFENCE_EVENT_QUEUE + 2, fence.update(BASE_LAT, BASE_LON, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, fence.getDroppedEvents());
+
+    GeofenceEvent ev;
+    TEST_ASSERT_TRUE(fence.pollEvent(ev));
+    TEST_ASSERT_EQUAL(2, ev.fenceId);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_only_fences_whose_box_holds_the_fix_get_the_exact_test);
+    RUN_TEST(test_box_covers_the_circle_and_exit_margin);
+    RUN_TEST(test_concave_polygon_excludes_its_notch);
+    RUN_TEST(test_polygon_needs_three_vertices);
+    RUN_TEST(test_entry_needs_confirm_fixes_in_a_row);
+    RUN_TEST(test_exit_waits_for_the_margin);
+    RUN_TEST(test_polygon_exit_waits_for_the_margin);
+    RUN_TEST(test_confirm_count_is_clamped_to_what_pending_holds);
+    RUN_TEST(test_events_queue_drops_the_oldest);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+/**
+ * @file test_main.cpp
+ * @brief PowerManager state transitions, replayed from simulated motion
+ *
+ * Run on the host:  pio test -e native
+ */
+
+#include <unity.h>
+#include "PowerManager.h"
+
+static PowerManager pm;
+
+/** One state change seen while replaying a trace. */
+struct Transition {
+    uint32_t   at;
+    PowerState to;
+};
+
+/**
+ * Step a 1 s loop from `from` to `to`, with motion wherever `moving(t)`
+ * says so, the way main.cpp feeds the IMU interrupt and update().
+ * @return number of transitions written to `out`
+ */
+static uint8_t replay(uint32_t from, uint32_t to, bool (*moving)(uint32_t),
+                      Transition* out, uint8_t cap) {
+    uint8_t n = 0;
+    for (uint32_t t = from; t <= to; t += 1000) {
+        PowerState before = pm.getState();
+        if (moving && moving(t)) pm.onMotion(t);
+        pm.update(t);
+        if (pm.getState() != before && n < cap) out[n++] = { t, pm.getState() };
+    }
+    return n;
+}
+
+/** Walking for five minutes, still until a single bump at 2000 s. */
+static bool walkThenPark(uint32_t t) {
+    return (t < 300000 && t % 2000 == 0) || t == 2000000;
+}
+
+/** Still since begin(0): through IDLE into SLEEP, one update() per step. */
+static void stillUntilSleep() {
+    pm.update(POWER_IDLE_AFTER_MS);
+    pm.update(POWER_SLEEP_AFTER_MS);
+}
+
+static PowerState stateAfterStill(uint32_t ms) {
+    pm.begin(0);
+    pm.update(ms);
+    return pm.getState();
+}
+
+void setUp() {
+    pm = PowerManager();
+    pm.begin(0);
+}
+
+void tearDown() {}
+
+// ── Stepping down ────────────────────────────────────────────────────────────
+
+void test_still_unit_steps_down() {
+    TEST_ASSERT_EQUAL(POWER_ACTIVE, stateAfterStill(POWER_IDLE_AFTER_MS - 1));
+
+    pm.begin(0);
+    TEST_ASSERT_TRUE(pm.update(POWER_IDLE_AFTER_MS));
+    TEST_ASSERT_EQUAL(POWER_IDLE, pm.getState());
+    TEST_ASSERT_EQUAL(GPS_POWER_SAVE, pm.gpsMode());
+    TEST_ASSERT_TRUE(pm.radioOn());
+    TEST_ASSERT_FALSE(pm.imuStreaming());
+
+    TEST_ASSERT_FALSE(pm.update(POWER_SLEEP_AFTER_MS - 1));
+    TEST_ASSERT_TRUE(pm.update(POWER_SLEEP_AFTER_MS));
+    TEST_ASSERT_EQUAL(POWER_SLEEP, pm.getState());
+    TEST_ASSERT_EQUAL(GPS_POWER_BACKUP, pm.gpsMode());
+    TEST_ASSERT_FALSE(pm.radioOn());
+}
+
+void test_active_state_runs_everything() {
+    TEST_ASSERT_EQUAL(POWER_ACTIVE, pm.getState());
+    TEST_ASSERT_EQUAL(GPS_POWER_CONTINUOUS, pm.gpsMode());
+    TEST_ASSERT_TRUE(pm.radioOn());
+    TEST_ASSERT_TRUE(pm.imuStreaming());
+}
+
+// ── Keepalive ────────────────────────────────────────────────────────────────
+
+void test_keepalive_with_fix_sleeps_after_listen_window() {
+    stillUntilSleep();
+    uint32_t wake = POWER_SLEEP_AFTER_MS + POWER_KEEPALIVE_MS;
+    TEST_ASSERT_FALSE(pm.update(wake - 1));
+    TEST_ASSERT_TRUE(pm.update(wake));
+    TEST_ASSERT_EQUAL(POWER_KEEPALIVE, pm.getState());
+    TEST_ASSERT_EQUAL(GPS_POWER_CONTINUOUS, pm.gpsMode());
+    TEST_ASSERT_TRUE(pm.radioOn());
+
+    TEST_ASSERT_TRUE(pm.keepaliveDue(wake + 8000, true));
+    pm.onKeepaliveSent(wake + 8000);
+    TEST_ASSERT_FALSE(pm.keepaliveDue(wake + 8001, true));
+
+    TEST_ASSERT_FALSE(pm.update(wake + 8000 + POWER_KEEPALIVE_LISTEN_MS - 1));
+    TEST_ASSERT_TRUE(pm.update(wake + 8000 + POWER_KEEPALIVE_LISTEN_MS));
+    TEST_ASSERT_EQUAL(POWER_SLEEP, pm.getState());
+}
+
+void test_keepalive_without_fix_gives_up() {
+    stillUntilSleep();
+    uint32_t wake = POWER_SLEEP_AFTER_MS + POWER_KEEPALIVE_MS;
+    pm.update(wake);
+
+    TEST_ASSERT_FALSE(pm.keepaliveDue(wake + POWER_KEEPALIVE_FIX_MS - 1, false));
+    TEST_ASSERT_TRUE(pm.keepaliveDue(wake + POWER_KEEPALIVE_FIX_MS, false));
+
+    // Heartbeat never went out (radio busy): the wake is still bounded
+    TEST_ASSERT_FALSE(pm.update(wake + POWER_KEEPALIVE_MAX_MS - 1));
+    TEST_ASSERT_TRUE(pm.update(wake + POWER_KEEPALIVE_MAX_MS));
+    TEST_ASSERT_EQUAL(POWER_SLEEP, pm.getState());
+}
+
+// ── Motion ───────────────────────────────────────────────────────────────────
+
+void test_motion_returns_to_active_from_every_state() {
+    const uint32_t reach[] = {
+        POWER_IDLE_AFTER_MS,                                 // IDLE
+        POWER_SLEEP_AFTER_MS,                                // SLEEP
+        POWER_SLEEP_AFTER_MS + POWER_KEEPALIVE_MS            // KEEPALIVE
+    };
+    const PowerState expect[] = { POWER_IDLE, POWER_SLEEP, POWER_KEEPALIVE };
+
+    for (uint8_t i = 0; i < 3; i++) {
+        pm.begin(0);
+        pm.update(POWER_IDLE_AFTER_MS);
+        if (reach[i] > POWER_IDLE_AFTER_MS) pm.update(POWER_SLEEP_AFTER_MS);
+        if (reach[i] > POWER_SLEEP_AFTER_MS) pm.update(reach[i]);
+        TEST_ASSERT_EQUAL(expect[i], pm.getState());
+
+        pm.onMotion(reach[i] + 1);
+        TEST_ASSERT_EQUAL(POWER_ACTIVE, pm.getState());
+        // Stillness is timed from the motion, not from begin()
+        TEST_ASSERT_FALSE(pm.update(reach[i] + POWER_IDLE_AFTER_MS));
+        TEST_ASSERT_TRUE(pm.update(reach[i] + 1 + POWER_IDLE_AFTER_MS));
+    }
+}
+
+void test_continuous_motion_stays_active() {
+    for (uint32_t t = 0; t <= 3 * POWER_SLEEP_AFTER_MS; t += 5000) {
+        pm.onMotion(t);
+        TEST_ASSERT_FALSE(pm.update(t));
+    }
+    TEST_ASSERT_EQUAL(POWER_ACTIVE, pm.getState());
+    TEST_ASSERT_EQUAL_UINT32(0, pm.getTransitions());
+}
+
+// ── Trace replay ─────────────────────────────────────────────────────────────
+
+void test_walk_then_park_trace() {
+    Transition seen[8];
+    uint8_t    n = replay(0, 2100000, walkThenPark, seen, 8);
+
+    // Last step at 298 s; no fix and no heartbeat during the keepalive
+    const Transition want[] = {
+        { 298000 + POWER_IDLE_AFTER_MS,                       POWER_IDLE },
+        { 298000 + POWER_SLEEP_AFTER_MS,                      POWER_SLEEP },
+        { 298000 + POWER_SLEEP_AFTER_MS + POWER_KEEPALIVE_MS, POWER_KEEPALIVE },
+        { 298000 + POWER_SLEEP_AFTER_MS + POWER_KEEPALIVE_MS + POWER_KEEPALIVE_MAX_MS,
+          POWER_SLEEP },
+        { 2000000,                                            POWER_ACTIVE },
+    };
+    TEST_ASSERT_EQUAL_UINT8(sizeof(want) / sizeof(want[0]), n);
+    for (uint8_t i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_UINT32(want[i].at, seen[i].at);
+        TEST_ASSERT_EQUAL(want[i].to, seen[i].to);
+    }
+    TEST_ASSERT_EQUAL_UINT32(n, pm.getTransitions());
+}
+
+void test_time_in_state_adds_up() {
+    Transition seen[8];
+    replay(0, 2100000, walkThenPark, seen, 8);
+
+    uint32_t total = 0;
+    for (uint8_t s = 0; s < POWER_STATE_COUNT; s++) {
+        total += pm.getTimeInState((PowerState)s, 2100000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2100000, total);
+    TEST_ASSERT_EQUAL_UINT32(POWER_KEEPALIVE_MAX_MS, pm.getTimeInState(POWER_KEEPALIVE, 2100000));
+
+    uint32_t avg = pm.getAverageCurrentMaX10(2100000);
+    TEST_ASSERT_TRUE(avg > POWER_CURRENT_SLEEP_MA_X10);
+    TEST_ASSERT_TRUE(avg < POWER_CURRENT_ACTIVE_MA_X10);
+}
+
+void test_millis_wraparound() {
+    const uint32_t start = 0xFFFFFFFFUL - 60000;
+    const uint32_t idle  = (uint32_t)(start + POWER_IDLE_AFTER_MS);   // past the wrap
+    pm.begin(start);
+    TEST_ASSERT_FALSE(pm.update(idle - 1));
+    TEST_ASSERT_TRUE(pm.update(idle));
+    TEST_ASSERT_EQUAL(POWER_IDLE, pm.getState());
+    TEST_ASSERT_EQUAL_UINT32(POWER_IDLE_AFTER_MS, pm.getTimeInState(POWER_ACTIVE, idle));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_still_unit_steps_down);
+    RUN_TEST(test_active_state_runs_everything);
+    RUN_TEST(test_keepalive_with_fix_sleeps_after_listen_window);
+    RUN_TEST(test_keepalive_without_fix_gives_up);
+    RUN_TEST(test_motion_returns_to_active_from_every_state);
+    RUN_TEST(test_continuous_motion_stays_active);
+    RUN_TEST(test_walk_then_park_trace);
+    RUN_TEST(test_time_in_state_adds_up);
+    RUN_TEST(test_millis_wraparound);
+    return UNITY_END();
+}
@@ -0,0 +1,188 @@
+/**
+ * @file test_main.cpp
+ * @brief Telemetry JSON, byte for byte against what ArduinoJson 6 produced
+ *
+ * The expected strings are what the ArduinoJson Telemetry wrote for the
+ * same values (GPSData/IMUData floats chosen to be exact in binary), so a
+ * receiver that parsed the old packets sees the same text.  Motion records
+ * came later and follow the same number format.
+ *
+ * Run on the host:  pio test -e native
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "TelemetryCodec.h"
+
+static char buf[384];
+
+/** Encode `record` as `type` and check it against `expected`, then decode it back. */
+static void checkJson(TelemetryType type, const void* record, size_t size,
+                      const char* deviceId, const char* expected) {
+    JsonWriter w(buf, sizeof(buf));
+    TEST_ASSERT_TRUE(TelemetryCodec::encodeJson(w, type, record, deviceId));
+    TEST_ASSERT_FALSE(w.overflowed());
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL(strlen(expected), w.length());
+
+    TelemetryMessage msg;
+    TEST_ASSERT_EQUAL(TELEMETRY_PARSE_OK,
+                      TelemetryCodec::decodeJson(buf, w.length(), TELEMETRY_ALL_FIELDS, msg));
+    TEST_ASSERT_EQUAL(type, msg.type);
+    TEST_ASSERT_EQUAL(0, memcmp(record, &msg.record, size));
+}
+
+static GpsRecord sampleGps() {
+    GpsRecord g;
+    memset(&g, 0, sizeof(g));
+    g.timestamp  = 123456;
+    g.valid      = true;
+    g.latE6      = 37123456;
+    g.lonE6      = -122500000;
+    g.altCm      = 1234;
+    g.speedX100  = 550;
+    g.courseX100 = 27025;
+    g.satellites = 7;
+    return g;
+}
+
+static ImuRecord sampleImu() {
+    ImuRecord m;
+    memset(&m, 0, sizeof(m));
+    m.timestamp     = 123456;
+    m.accelMilli[0] = 125;
+    m.accelMilli[1] = -9750;
+    m.accelMilli[2] = 500;
+    m.gyroMilli[0]  = 0;
+    m.gyroMilli[1]  = -250;
+    m.gyroMilli[2]  = 1500;
+    m.tempX100      = 2450;
+    return m;
+}
+
+void setUp() {
+    memset(buf, 0, sizeof(buf));
+}
+
+void tearDown() {}
+
+// ── Record types ─────────────────────────────────────────────────────────────
+
+void test_full() {
+    FullRecord r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp = 123456;
+    r.battery   = 87;
+    r.gps       = sampleGps();
+    r.imu       = sampleImu();
+    r.gps.timestamp = r.imu.timestamp = 0;   // only the outer one is written
+    checkJson(TELEMETRY_FULL, &r, sizeof(r), "bravo-1",
+              "{\"device_id\":\"bravo-1\",\"timestamp\":123456,\"type\":\"full\",\"battery\":87,"
+              "\"gps\":{\"valid\":true,\"lat\":37.123456,\"lon\":-122.5,\"alt\":12.34,"
+              "\"speed\":5.5,\"course\":270.25,\"satellites\":7},"
+              "\"imu\":{\"accel\":{\"x\":0.125,\"y\":-9.75,\"z\":0.5},"
+              "\"gyro\":{\"x\":0,\"y\":-0.25,\"z\":1.5},\"temp\":24.5}}");
+}
+
+void test_gps() {
+    GpsRecord r = sampleGps();
+    checkJson(TELEMETRY_GPS, &r, sizeof(r), "bravo-1",
+              "{\"device_id\":\"bravo-1\",\"timestamp\":123456,\"type\":\"gps\","
+              "\"valid\":true,\"lat\":37.123456,\"lon\":-122.5,\"alt\":12.34,"
+              "\"speed\":5.5,\"course\":270.25,\"satellites\":7}");
+
+    // No fix: everything zero, written as bare integers
+    memset(&r, 0, sizeof(r));
+    checkJson(TELEMETRY_GPS, &r, sizeof(r), "bravo-1",
+              "{\"device_id\":\"bravo-1\",\"timestamp\":0,\"type\":\"gps\","
+              "\"valid\":false,\"lat\":0,\"lon\":0,\"alt\":0,"
+              "\"speed\":0,\"course\":0,\"satellites\":0}");
+}
+
+void test_imu() {
+    ImuRecord r = sampleImu();
+    checkJson(TELEMETRY_IMU, &r, sizeof(r), "bravo-1",
+              "{\"device_id\":\"bravo-1\",\"timestamp\":123456,\"type\":\"imu\","
+              "\"accel\":{\"x\":0.125,\"y\":-9.75,\"z\":0.5},"
+              "\"gyro\":{\"x\":0,\"y\":-0.25,\"z\":1.5},\"temp\":24.5}");
+}
+
+void test_status() {
+    StatusRecord r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp = 4000000000UL;
+    r.battery   = 100;
+    r.uptime    = 86400;
+    r.rssi      = -90;
+    checkJson(TELEMETRY_STATUS, &r, sizeof(r), "bravo-1",
+              "{\"device_id\":\"bravo-1\",\"timestamp\":4000000000,\"type\":\"status\","
+              "\"battery\":100,\"uptime\":86400,\"rssi\":-90}");
+}
+
+void test_alert_escapes_like_arduinojson() {
+    AlertRecord r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp = 99;
+    strcpy(r.alertType, "geofence");
+    strcpy(r.message, "left \"yard\"\n\tC:\\gate\b\f/");
+    checkJson(TELEMETRY_ALERT, &r, sizeof(r), "unit \"7\"",
+              "{\"device_id\":\"unit \\\"7\\\"\",\"timestamp\":99,\"type\":\"alert\","
+              "\"alert_type\":\"geofence\","
+              "\"message\":\"left \\\"yard\\\"\\n\\tC:\\\\gate\\b\\f/\"}");
+}
+
+void test_motion() {
+    MotionRecord r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp     = 5000;
+    r.level         = 42;
+    r.moving        = true;
+    r.steps         = 12;
+    r.meanMg        = -50;
+    r.stdMg         = 0;
+    r.accelRmsMg    = 1250;
+    r.gyroRmsDpsX10 = 123;
+    checkJson(TELEMETRY_MOTION, &r, sizeof(r), "bravo-1",
+              "{\"device_id\":\"bravo-1\",\"timestamp\":5000,\"type\":\"motion\","
+              "\"level\":42,\"moving\":true,\"steps\":12,\"mean\":-0.05,\"std\":0,"
+              "\"accel_rms\":1.25,\"gyro_rms\":12.3}");
+}
+
+// ── Writer ───────────────────────────────────────────────────────────────────
+
+void test_fixed_point_drops_trailing_zeros() {
+    static constexpr JsonKey K = JSON_KEY("v");
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject();
+    w.addFixed(K, 1200, 2);
+    w.addFixed(K, 1205, 2);
+    w.addFixed(K, -5, 3);
+    w.addFixed(K, 100000, 3);
+    w.addFloat(K, 2.5f, 3);
+    w.endObject();
+    TEST_ASSERT_EQUAL_STRING("{\"v\":12,\"v\":12.05,\"v\":-0.005,\"v\":100,\"v\":2.5}", buf);
+}
+
+void test_buffer_overflow_is_reported() {
+    StatusRecord r;
+    memset(&r, 0, sizeof(r));
+    char small[40];
+    JsonWriter w(small, sizeof(small));
+    TelemetryCodec::encodeJson(w, TELEMETRY_STATUS, &r, "bravo-1");
+    TEST_ASSERT_TRUE(w.overflowed());
+    TEST_ASSERT_TRUE(w.length() >= sizeof(small));
+    TEST_ASSERT_TRUE(strlen(small) < sizeof(small));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_full);
+    RUN_TEST(test_gps);
+    RUN_TEST(test_imu);
+    RUN_TEST(test_status);
+    RUN_TEST(test_alert_escapes_like_arduinojson);
+    RUN_TEST(test_motion);
+    RUN_TEST(test_fixed_point_drops_trailing_zeros);
+    RUN_TEST(test_buffer_overflow_is_reported);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+/**
+ * @file test_main.cpp
+ * @brief TrackLog simplification and compact encoding on synthetic routes
+ *
+ * Run on the host:  pio test -e native
+ */
+
+#include <unity.h>
+#include "TrackLog.h"
+
+// Around 51.5° N: µdeg per metre north and east
+#define BASE_LAT        51500000
+#define BASE_LON        -100000
+#define UDEG_PER_M_N    9
+#define UDEG_PER_M_E    14
+
+static TrackLog track;
+
+/** A fix `eastM`/`northM` from the base point, with a repeatable ±1 m wobble. */
+static void addFix(int32_t eastM, int32_t northM, uint32_t t) {
+    int32_t wobble = (int32_t)((t * 7) % 3) - 1;
+    track.add(BASE_LAT + (northM + wobble) * UDEG_PER_M_N,
+              BASE_LON + (eastM - wobble) * UDEG_PER_M_E, t);
+}
+
+void setUp() {
+    track.clear();
+}
+
+void tearDown() {}
+
+// ── Simplification ───────────────────────────────────────────────────────────
+
+void test_parked_period_stays_one_segment() {
+    for (uint32_t t = 0; t < 600; t++) addFix(0, 0, t);
+    TEST_ASSERT_EQUAL(1, track.size());
+    track.flush();
+    TEST_ASSERT_EQUAL(2, track.size());
+    TEST_ASSERT_EQUAL_UINT32(600, track.getInputCount());
+
+    TrackPoint last;
+    TEST_ASSERT_TRUE(track.getBySeq(1, last));
+    TEST_ASSERT_EQUAL_UINT32(599, last.timestamp);
+}
+
+void test_parking_after_a_leg_costs_one_vertex() {
+    for (uint32_t t = 0; t < 20; t++) addFix((int32_t)t * 3, 0, t);
+    for (uint32_t t = 20; t < 620; t++) addFix(60, 0, t);
+    track.flush();
+    TEST_ASSERT_TRUE(track.size() <= 4);
+}
+
+void test_moving_leg_is_cut_every_window() {
+    // 1.5 m/s east for 320 s: straight, but only TRACK_WINDOW fixes per segment
+    for (uint32_t t = 0; t < 320; t++) addFix((int32_t)(t * 3 / 2), 0, t);
+    track.flush();
+    TEST_ASSERT_TRUE(track.size() >= 320 / TRACK_WINDOW);
+    TEST_ASSERT_TRUE(track.size() <= 320 / TRACK_WINDOW + 2);
+}
+
+void test_corner_is_kept() {
+    for (uint32_t t = 0; t < 30; t++) addFix((int32_t)t * 3, 0, t);
+    for (uint32_t t = 30; t < 60; t++) addFix(90, (int32_t)(t - 30) * 3, t);
+    track.flush();
+
+    // Some kept point lies within the tolerance of the corner at (90, 0)
+    bool found = false;
+    for (uint32_t s = track.oldestSeq(); s < track.nextSeq(); s++) {
+        TrackPoint p;
+        TEST_ASSERT_TRUE(track.getBySeq(s, p));
+        int32_t dn = (p.latE6 - BASE_LAT) / UDEG_PER_M_N;
+        int32_t de = (p.lonE6 - BASE_LON) / UDEG_PER_M_E - 90;
+        if (dn * dn + de * de <= 25) found = true;
+    }
+    TEST_ASSERT_TRUE(found);
+}
+
+// ── Compact form ─────────────────────────────────────────────────────────────
+
+void test_compact_round_trip() {
+    for (uint32_t t = 0; t < 200; t++) addFix((int32_t)t * 3, (int32_t)(t % 40), t);
+    track.flush();
+
+    uint8_t  buf[128];
+    uint16_t encoded;
+    size_t   len = track.encodeCompact(0, buf, sizeof(buf), encoded);
+    TEST_ASSERT_TRUE(len > 0 && len <= sizeof(buf));
+    TEST_ASSERT_TRUE(encoded <= TRACK_COMPACT_MAX_POINTS(sizeof(buf)));
+
+    TrackPoint out[64];
+    TEST_ASSERT_EQUAL(encoded, TrackLog::decodeCompact(buf, len, out, 64));
+    for (uint16_t i = 0; i < encoded; i++) {
+        TrackPoint p;
+        TEST_ASSERT_TRUE(track.getBySeq(i, p));
+        TEST_ASSERT_EQUAL(p.latE6, out[i].latE6);
+        TEST_ASSERT_EQUAL(p.lonE6, out[i].lonE6);
+        TEST_ASSERT_EQUAL_UINT32(p.timestamp, out[i].timestamp);
+    }
+    TEST_ASSERT_EQUAL(-1, TrackLog::decodeCompact(buf, len - 1, out, 64));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_parked_period_stays_one_segment);
+    RUN_TEST(test_parking_after_a_leg_costs_one_vertex);
+    RUN_TEST(test_moving_leg_is_cut_every_window);
+    RUN_TEST(test_corner_is_kept);
+    RUN_TEST(test_compact_round_trip);
+    return UNITY_END();
+}
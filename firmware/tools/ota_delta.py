@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""
+Binary-delta patches for B.R.A.V.O. firmware updates over LoRa.
+
+    ota_delta.py diff  old.bin new.bin patch.bin   make a patch
+    ota_delta.py apply old.bin patch.bin out.bin   rebuild new.bin (check)
+
+old.bin must be the exact firmware.bin the units are running: they check
+its SHA-256 against their own flash before using the patch.  Put the patch
+where the relay serves images from (data/ota.bin) and upload the filesystem.
+
+The format is documented in include/DeltaPatch.h.  Matching follows bsdiff
+(approximate forward/backward extension around exact matches), with a hash
+index instead of a suffix array, and the diff bytes run-length coded
+instead of bzip2'd so the Pico can apply it without a decompressor.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = 0x544C4442          # "BDLT"
+KEY = 8                     # bytes hashed to find match candidates
+MAX_CANDIDATES = 16         # per key; repeated padding would blow up otherwise
+MAX_MATCH = 4096            # exact-match extension cap (keeps scanning linear)
+MIN_ZERO_RUN = 3            # shorter zero runs stay inside a delta run
+
+
+def varint(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7F
+        v >>= 7
+        if v:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def zigzag(v):
+    return (v << 1) if v >= 0 else ((-v << 1) - 1)
+
+
+def read_varint(buf, pos):
+    v = shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, pos
+
+
+def build_index(old):
+    index = {}
+    for i in range(len(old) - KEY + 1):
+        lst = index.setdefault(old[i:i + KEY], [])
+        if len(lst) < MAX_CANDIDATES:
+            lst.append(i)
+    return index
+
+
+def match_len(old, opos, new, npos):
+    """Length of the exact match old[opos:] / new[npos:], capped at MAX_MATCH."""
+    hi = min(MAX_MATCH, len(old) - opos, len(new) - npos)
+    if old[opos:opos + hi] == new[npos:npos + hi]:
+        return hi
+    lo = 0                                   # old[..lo] matches, [..hi] does not
+    while hi - lo > 1:
+        mid = (lo + hi) // 2
+        if old[opos:opos + mid] == new[npos:npos + mid]:
+            lo = mid
+        else:
+            hi = mid
+    return lo
+
+
+def search(index, old, new, scan, hint):
+    best_len, best_pos = 0, 0
+    if 0 <= hint < len(old):
+        best_len, best_pos = match_len(old, hint, new, scan), hint
+    for pos in index.get(new[scan:scan + KEY], ()):
+        if pos == hint:
+            continue
+        n = match_len(old, pos, new, scan)
+        if n > best_len:
+            best_len, best_pos = n, pos
+    return best_len, best_pos
+
+
+def encode_diff(old, opos, new, npos, length):
+    """old + delta, as (zero run, delta run) pairs."""
+    delta = bytes((new[npos + i] - old[opos + i]) & 0xFF for i in range(length))
+    out = bytearray()
+    i = 0
+    while i < length:
+        z = i
+        while z < length and delta[z] == 0:
+            z += 1
+        # delta run: up to the next zero run long enough to be worth a pair
+        j = z
+        while j < length:
+            if delta[j] == 0:
+                k = j
+                while k < length and delta[k] == 0:
+                    k += 1
+                if k - j >= MIN_ZERO_RUN or k == length:
+                    break
+                j = k
+            else:
+                j += 1
+        out += varint(z - i) + varint(j - z) + delta[z:j]
+        i = j
+    return bytes(out)
+
+
+def make_records(old, new):
+    """bsdiff's scan loop; yields (diff_len, extra_len, seek, old_pos, new_pos)."""
+    index = build_index(old)
+    oldsize, newsize = len(old), len(new)
+    scan = length = pos = 0
+    lastscan = lastpos = lastoffset = 0
+
+    while scan < newsize:
+        oldscore = 0
+        scan += length
+        scsc = scan
+        while scan < newsize:
+            length, pos = search(index, old, new, scan, scan + lastoffset)
+            while scsc < scan + length:
+                if scsc + lastoffset < oldsize and old[scsc + lastoffset] == new[scsc]:
+                    oldscore += 1
+                scsc += 1
+            if (length == oldscore and length != 0) or length > oldscore + 8:
+                break
+            if scan + lastoffset < oldsize and old[scan + lastoffset] == new[scan]:
+                oldscore -= 1
+            scan += 1
+
+        if length != oldscore or scan == newsize:
+            # Extend the previous match forward and the new one backward,
+            # as long as at least half the bytes still agree
+            s = sf = lenf = i = 0
+            while lastscan + i < scan and lastpos + i < oldsize:
+                if old[lastpos + i] == new[lastscan + i]:
+                    s += 1
+                i += 1
+                if s * 2 - i > sf * 2 - lenf:
+                    sf, lenf = s, i
+
+            lenb = 0
+            if scan < newsize:
+                s = sb = 0
+                i = 1
+                while scan >= lastscan + i and pos >= i:
+                    if old[pos - i] == new[scan - i]:
+                        s += 1
+                    if s * 2 - i > sb * 2 - lenb:
+                        sb, lenb = s, i
+                    i += 1
+
+            if lastscan + lenf > scan - lenb:
+                overlap = (lastscan + lenf) - (scan - lenb)
+                s = ss = lens = 0
+                for i in range(overlap):
+                    if new[lastscan + lenf - overlap + i] == old[lastpos + lenf - overlap + i]:
+                        s += 1
+                    if new[scan - lenb + i] == old[pos - lenb + i]:
+                        s -= 1
+                    if s > ss:
+                        ss, lens = s, i + 1
+                lenf += lens - overlap
+                lenb -= lens
+
+            extra = (scan - lenb) - (lastscan + lenf)
+            seek = (pos - lenb) - (lastpos + lenf)
+            yield lenf, extra, seek, lastpos, lastscan
+            lastscan, lastpos = scan - lenb, pos - lenb
+            lastoffset = pos - scan
+
+
+def diff(old, new):
+    out = bytearray(struct.pack("<III", MAGIC, len(old), len(new)))
+    out += hashlib.sha256(old).digest() + hashlib.sha256(new).digest()
+    for dlen, elen, seek, opos, npos in make_records(old, new):
+        out += varint(dlen) + varint(elen) + varint(zigzag(seek))
+        out += encode_diff(old, opos, new, npos, dlen)
+        out += new[npos + dlen:npos + dlen + elen]
+    return bytes(out)
+
+
+def apply(old, patch):
+    magic, oldsize, newsize = struct.unpack_from("<III", patch, 0)
+    if magic != MAGIC:
+        raise ValueError("not a delta patch")
+    if hashlib.sha256(old[:oldsize]).digest() != patch[12:44]:
+        raise ValueError("patch was made against a different image")
+    new = bytearray()
+    pos, opos = 76, 0
+    while len(new) < newsize:
+        dlen, pos = read_varint(patch, pos)
+        elen, pos = read_varint(patch, pos)
+        seek, pos = read_varint(patch, pos)
+        seek = (seek >> 1) ^ -(seek & 1)
+        end = opos + dlen
+        while opos < end:
+            z, pos = read_varint(patch, pos)
+            new += old[opos:opos + z]
+            opos += z
+            n, pos = read_varint(patch, pos)
+            new += bytes((old[opos + i] + patch[pos + i]) & 0xFF for i in range(n))
+            opos += n
+            pos += n
+        new += patch[pos:pos + elen]
+        pos += elen
+        opos += seek
+    if pos != len(patch) or hashlib.sha256(new).digest() != patch[44:76]:
+        raise ValueError("patch did not rebuild the image")
+    return bytes(new)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    d = sub.add_parser("diff", help="make a patch from old.bin to new.bin")
+    d.add_argument("old")
+    d.add_argument("new")
+    d.add_argument("patch")
+    a = sub.add_parser("apply", help="rebuild new.bin from old.bin and a patch")
+    a.add_argument("old")
+    a.add_argument("patch")
+    a.add_argument("out")
+    args = ap.parse_args()
+
+    if args.cmd == "diff":
+        old = open(args.old, "rb").read()
+        new = open(args.new, "rb").read()
+        patch = diff(old, new)
+        if apply(old, patch) != new:
+            sys.exit("internal error: patch does not round-trip")
+        open(args.patch, "wb").write(patch)
+        print("%s: %d B for a %d B image (%.1f %%), %d LoRa blocks instead of %d" % (
+            args.patch, len(patch), len(new), 100.0 * len(patch) / len(new),
+            (len(patch) + 127) // 128, (len(new) + 127) // 128))
+    else:
+        try:
+            new = apply(open(args.old, "rb").read(), open(args.patch, "rb").read())
+        except ValueError as e:
+            sys.exit(str(e))
+        open(args.out, "wb").write(new)
+        print("%s: %d B" % (args.out, len(new)))
+
+
+if __name__ == "__main__":
+    main()